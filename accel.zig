@@ -0,0 +1,429 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! 2D Graphics Operations for PinePhone Framebuffers (ARGB 8888):
+//! Rectangle Fill, Copy (Blit), Porter-Duff Alpha Blend and Rotation.
+//! The Blend Kernels are also used by the Scanline Rasterizer (raster.zig).
+//! Called by the Display Engine Driver (render.zig) for the NuttX Overlay ioctls
+//! FBIOSET_COLOR, FBIOSET_BLIT and FBIOSET_BLEND.
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Framebuffer in ARGB 8888 Format
+pub const Surface = struct {
+    pixels: [*]u32,  // Start of Framebuffer Memory
+    stride: usize,   // Pixels per Row (Length of a line in bytes / 4)
+    width:  usize,   // Horizontal resolution in pixel columns
+    height: usize,   // Vertical resolution in pixel rows
+
+    /// Return Row `y` of the Framebuffer, starting at Column `x`, with `w` pixels
+    fn row(self: Surface, x: usize, y: usize, w: usize) []u32 {
+        const start = y * self.stride + x;
+        return self.pixels[start..(start + w)];
+    }
+};
+
+/// Rectangle within a Framebuffer (pixels)
+pub const Rect = struct {
+    x: usize,  // Column of the Top Left Corner
+    y: usize,  // Row of the Top Left Corner
+    w: usize,  // Width
+    h: usize,  // Height
+};
+
+/// Return true if the Rectangle lies within the Framebuffer
+pub fn contains(surface: Surface, area: Rect) bool {
+    return area.x + area.w <= surface.width
+        and area.y + area.h <= surface.height;
+}
+
+/// Fill the Rectangle with the ARGB 8888 Colour
+pub fn fill(
+    dest: Surface,  // Framebuffer to be filled
+    area: Rect,     // Rectangle to be filled
+    color: u32      // Colour in ARGB 8888 Format
+) void {
+    debug("fill: x={}, y={}, w={}, h={}, color=0x{x}", .{ area.x, area.y, area.w, area.h, color });
+    assert(contains(dest, area));
+
+    // Full-width fills are contiguous, so we fill them in one pass
+    if (area.x == 0 and area.w == dest.stride) {
+        std.mem.set(u32, dest.row(0, area.y, area.w * area.h), color);
+        return;
+    }
+    var y: usize = 0;
+    while (y < area.h) : (y += 1) {
+        std.mem.set(u32, dest.row(area.x, area.y + y, area.w), color);
+    }
+}
+
+/// Copy the Rectangle from the Source Framebuffer to the Destination Framebuffer.
+/// The Source and Destination may be the same Framebuffer, and may overlap.
+pub fn copy(
+    dest: Surface,   // Destination Framebuffer
+    dest_area: Rect, // Destination Rectangle
+    src: Surface,    // Source Framebuffer
+    src_x: usize,    // Column of the Source Rectangle
+    src_y: usize     // Row of the Source Rectangle
+) void {
+    debug("copy: x={}, y={}, w={}, h={}, src_x={}, src_y={}", .{ dest_area.x, dest_area.y, dest_area.w, dest_area.h, src_x, src_y });
+    const src_area = Rect { .x = src_x, .y = src_y, .w = dest_area.w, .h = dest_area.h };
+    assert(contains(dest, dest_area));
+    assert(contains(src, src_area));
+    if (dest_area.w == 0 or dest_area.h == 0) { return; }
+
+    // If Destination is after Source in memory, copy from the last row backwards.
+    // Otherwise the Source Rows would be overwritten before they are copied.
+    const dest_start = @ptrToInt(&dest.row(dest_area.x, dest_area.y, 1)[0]);
+    const src_start  = @ptrToInt(&src.row(src_x, src_y, 1)[0]);
+    const backwards  = dest_start > src_start;
+
+    var i: usize = 0;
+    while (i < dest_area.h) : (i += 1) {
+        const y = if (backwards) dest_area.h - 1 - i else i;
+        const d = dest.row(dest_area.x, dest_area.y + y, dest_area.w);
+        const s = src.row(src_x, src_y + y, dest_area.w);
+        if (backwards) {
+            std.mem.copyBackwards(u32, d, s);
+        } else {
+            std.mem.copy(u32, d, s);
+        }
+    }
+}
+
+/// Blend the Foreground over the Background (Porter-Duff "Source Over")
+/// and write to the Destination. The Destination may be the Foreground or
+/// Background Framebuffer, if the Rectangles are the same.
+pub fn blend(
+    dest: Surface,   // Destination Framebuffer
+    dest_area: Rect, // Destination Rectangle
+    fg: Surface,     // Foreground Framebuffer
+    fg_x: usize,     // Column of the Foreground Rectangle
+    fg_y: usize,     // Row of the Foreground Rectangle
+    bg: Surface,     // Background Framebuffer
+    bg_x: usize,     // Column of the Background Rectangle
+    bg_y: usize      // Row of the Background Rectangle
+) void {
+    debug("blend: x={}, y={}, w={}, h={}", .{ dest_area.x, dest_area.y, dest_area.w, dest_area.h });
+    assert(contains(dest, dest_area));
+    assert(contains(fg, Rect { .x = fg_x, .y = fg_y, .w = dest_area.w, .h = dest_area.h }));
+    assert(contains(bg, Rect { .x = bg_x, .y = bg_y, .w = dest_area.w, .h = dest_area.h }));
+
+    var y: usize = 0;
+    while (y < dest_area.h) : (y += 1) {
+        blendRow(
+            dest.row(dest_area.x, dest_area.y + y, dest_area.w),
+            fg.row(fg_x, fg_y + y, dest_area.w),
+            bg.row(bg_x, bg_y + y, dest_area.w),
+        );
+    }
+}
+
+/// Number of pixels blended at a time
+const LANES = 4;
+
+/// Vector of pixels or channels
+const Pixels = @Vector(LANES, u32);
+
+/// Blend a Row of pixels, 4 pixels at a time
+fn blendRow(dest: []u32, fg: []const u32, bg: []const u32) void {
+    var x: usize = 0;
+    while (x + LANES <= dest.len) : (x += LANES) {
+        const f: Pixels = fg[x..][0..LANES].*;
+        const b: Pixels = bg[x..][0..LANES].*;
+        dest[x..][0..LANES].* = blendPixels(f, b);
+    }
+
+    // Blend the remaining pixels
+    while (x < dest.len) : (x += 1) {
+        const f = @splat(LANES, fg[x]);
+        const b = @splat(LANES, bg[x]);
+        dest[x] = blendPixels(f, b)[0];
+    }
+}
+
+/// Blend the ARGB 8888 Colour over a Row of pixels (Porter-Duff "Source Over"), 4 pixels at a time
+pub fn blendColor(dest: []u32, color: u32) void {
+    const f = @splat(LANES, color);
+    var x: usize = 0;
+    while (x + LANES <= dest.len) : (x += LANES) {
+        const b: Pixels = dest[x..][0..LANES].*;
+        dest[x..][0..LANES].* = blendPixels(f, b);
+    }
+
+    // Blend the remaining pixels
+    while (x < dest.len) : (x += 1) {
+        dest[x] = blendPixels(f, @splat(LANES, dest[x]))[0];
+    }
+}
+
+/// Blend the Foreground Pixels over the Background Pixels (non-premultiplied ARGB 8888):
+///   out_a = fa + ba * (1 - fa)
+///   out_c = (fc * fa + bc * ba * (1 - fa)) / out_a
+/// Alpha and Colour are scaled by 255, so the intermediate values fit in 32 bits.
+fn blendPixels(f: Pixels, b: Pixels) Pixels {
+    const mask  = @splat(LANES, @as(u32, 0xff));
+    const full  = @splat(LANES, @as(u32, 255));
+    const half  = @splat(LANES, @as(u32, 127));
+
+    // Split the Alpha Channels
+    const fa = (f >> @splat(LANES, @as(u5, 24))) & mask;
+    const ba = (b >> @splat(LANES, @as(u5, 24))) & mask;
+
+    // Background Weight = ba * (1 - fa), scaled by 255
+    const bw = ba * (full - fa);
+
+    // Output Alpha, scaled by 255. Avoid division by 0 for transparent pixels.
+    const oa = fa * full + bw;
+    const zero = @splat(LANES, @as(u32, 0));
+    const one  = @splat(LANES, @as(u32, 1));
+    const div  = @select(u32, oa == zero, one, oa);
+
+    // Blend the Red, Green and Blue Channels
+    var out = ((oa + half) / full) << @splat(LANES, @as(u5, 24));
+    comptime var shift: u5 = 0;
+    inline while (shift < 24) : (shift += 8) {
+        const s  = @splat(LANES, shift);
+        const fc = (f >> s) & mask;
+        const bc = (b >> s) & mask;
+        const oc = (fc * fa * full + bc * bw + div / @splat(LANES, @as(u32, 2))) / div;
+        out |= (oc & mask) << s;
+    }
+    return out;
+}
+
+/// Rotation of a Framebuffer (clockwise)
+pub const Rotation = enum {
+    rotate0,
+    rotate90,
+    rotate180,
+    rotate270,
+};
+
+/// Rotate the Damaged Rectangles of the Source Framebuffer into the Destination Framebuffer.
+/// For 90 and 270 degrees, the Destination Width and Height are the Source Height and Width.
+pub fn rotateDamage(
+    dest: Surface,          // Destination Framebuffer (rotated)
+    src: Surface,           // Source Framebuffer (unrotated)
+    damage: []const Rect,   // Rectangles in the Source Framebuffer that have changed
+    rotation: Rotation      // Clockwise Rotation
+) void {
+    for (damage) |area| {
+        rotate(dest, src, area, rotation);
+    }
+}
+
+/// Rotate the Rectangle of the Source Framebuffer into the Destination Framebuffer.
+/// For 90 and 270 degrees, we rotate 8 x 8 Tiles: each Tile is transposed in registers,
+/// so we read 8 Source Rows and write 8 Destination Rows at a time, instead of
+/// writing a single pixel to each Destination Row.
+pub fn rotate(
+    dest: Surface,      // Destination Framebuffer (rotated)
+    src: Surface,       // Source Framebuffer (unrotated)
+    area: Rect,         // Rectangle in the Source Framebuffer to be rotated
+    rotation: Rotation  // Clockwise Rotation
+) void {
+    debug("rotate: x={}, y={}, w={}, h={}, rotation={}", .{ area.x, area.y, area.w, area.h, rotation });
+    assert(contains(src, area));
+    switch (rotation) {
+        .rotate0, .rotate180 => {
+            assert(dest.width == src.width and dest.height == src.height);
+        },
+        .rotate90, .rotate270 => {
+            assert(dest.width == src.height and dest.height == src.width);
+        },
+    }
+    if (area.w == 0 or area.h == 0) { return; }
+
+    switch (rotation) {
+        // No rotation: Copy the Rectangle
+        .rotate0 => copy(dest, area, src, area.x, area.y),
+
+        // 180 degrees: Copy each Row reversed, to the mirrored Row
+        .rotate180 => {
+            var y: usize = 0;
+            while (y < area.h) : (y += 1) {
+                const s = src.row(area.x, area.y + y, area.w);
+                const d = dest.row(
+                    src.width  - area.x - area.w,
+                    src.height - 1 - (area.y + y),
+                    area.w
+                );
+                var x: usize = 0;
+                while (x < area.w) : (x += 1) {
+                    d[area.w - 1 - x] = s[x];
+                }
+            }
+        },
+
+        // 90 and 270 degrees: Rotate the Tiles that overlap the Rectangle
+        .rotate90  => rotateTiles(dest, src, area, .rotate90),
+        .rotate270 => rotateTiles(dest, src, area, .rotate270),
+    }
+}
+
+/// Return the Rectangle of the Destination Framebuffer that `rotate` writes for the
+/// Source Rectangle. For 90 and 270 degrees, this includes the whole Tiles.
+pub fn rotatedRect(
+    src: Surface,       // Source Framebuffer (unrotated)
+    area: Rect,         // Rectangle in the Source Framebuffer
+    rotation: Rotation  // Clockwise Rotation
+) Rect {
+    switch (rotation) {
+        .rotate0 => return area,
+        .rotate180 => return Rect {
+            .x = src.width  - area.x - area.w,
+            .y = src.height - area.y - area.h,
+            .w = area.w,
+            .h = area.h,
+        },
+        .rotate90, .rotate270 => {
+            // Expand to the Tiles, like rotateTiles
+            const x0 = area.x / TILE * TILE;
+            const y0 = area.y / TILE * TILE;
+            const x1 = std.math.min(std.mem.alignForward(area.x + area.w, TILE), src.width);
+            const y1 = std.math.min(std.mem.alignForward(area.y + area.h, TILE), src.height);
+            return if (rotation == .rotate90)
+                Rect { .x = src.height - y1, .y = x0, .w = y1 - y0, .h = x1 - x0 }
+            else
+                Rect { .x = y0, .y = src.width - x1, .w = y1 - y0, .h = x1 - x0 };
+        },
+    }
+}
+
+/// Width and Height of a Rotation Tile (pixels)
+const TILE = 8;
+
+/// 4 pixels in a Vector
+const Quad = @Vector(4, u32);
+
+/// Rotate the Tiles that overlap the Rectangle by 90 or 270 degrees.
+/// The Rectangle is expanded to the Tile Boundaries.
+fn rotateTiles(
+    dest: Surface,      // Destination Framebuffer (rotated)
+    src: Surface,       // Source Framebuffer (unrotated)
+    area: Rect,         // Rectangle in the Source Framebuffer to be rotated
+    comptime rotation: Rotation  // 90 or 270 degrees
+) void {
+    const x_start = area.x / TILE * TILE;
+    const y_start = area.y / TILE * TILE;
+    const x_end = std.math.min(std.mem.alignForward(area.x + area.w, TILE), src.width);
+    const y_end = std.math.min(std.mem.alignForward(area.y + area.h, TILE), src.height);
+
+    var ty = y_start;
+    while (ty < y_end) : (ty += TILE) {
+        var tx = x_start;
+        while (tx < x_end) : (tx += TILE) {
+            if (tx + TILE <= src.width and ty + TILE <= src.height) {
+                // Full Tile: Transpose in registers
+                rotateTile(dest, src, tx, ty, rotation);
+            } else {
+                // Partial Tile at the Right or Bottom Edge: Rotate pixel by pixel
+                const w = std.math.min(TILE, src.width  - tx);
+                const h = std.math.min(TILE, src.height - ty);
+                var y: usize = ty;
+                while (y < ty + h) : (y += 1) {
+                    var x: usize = tx;
+                    while (x < tx + w) : (x += 1) {
+                        const p = src.row(x, y, 1)[0];
+                        switch (rotation) {
+                            .rotate90  => dest.row(src.height - 1 - y, x, 1)[0] = p,
+                            .rotate270 => dest.row(y, src.width - 1 - x, 1)[0] = p,
+                            else => unreachable,
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+/// Rotate an 8 x 8 Tile by 90 or 270 degrees.
+/// The Tile is loaded as four 4 x 4 Blocks, which are transposed with Vector Shuffles.
+fn rotateTile(
+    dest: Surface,  // Destination Framebuffer (rotated)
+    src: Surface,   // Source Framebuffer (unrotated)
+    tx: usize,      // Column of the Tile in the Source Framebuffer
+    ty: usize,      // Row of the Tile in the Source Framebuffer
+    comptime rotation: Rotation  // 90 or 270 degrees
+) void {
+    // Load the Left and Right halves of the 8 Rows
+    var left:  [TILE]Quad = undefined;
+    var right: [TILE]Quad = undefined;
+    comptime var i = 0;
+    inline while (i < TILE) : (i += 1) {
+        const r = src.row(tx, ty + i, TILE);
+        left[i]  = r[0..4].*;
+        right[i] = r[4..8].*;
+    }
+
+    // Transpose the 4 Blocks. Column j of the Tile is (top[j], bottom[j]).
+    const top_left     = transpose4(left[0..4].*);
+    const bottom_left  = transpose4(left[4..8].*);
+    const top_right    = transpose4(right[0..4].*);
+    const bottom_right = transpose4(right[4..8].*);
+
+    comptime var j = 0;
+    inline while (j < TILE) : (j += 1) {
+        const top    = if (j < 4) top_left[j]    else top_right[j - 4];
+        const bottom = if (j < 4) bottom_left[j] else bottom_right[j - 4];
+        switch (rotation) {
+            // 90 degrees: Source Column j becomes Destination Row (tx + j), from bottom to top
+            .rotate90 => {
+                const d = dest.row(src.height - ty - TILE, tx + j, TILE);
+                d[0..4].* = reverse4(bottom);
+                d[4..8].* = reverse4(top);
+            },
+            // 270 degrees: Source Column j becomes Destination Row (width - 1 - tx - j), from top to bottom
+            .rotate270 => {
+                const d = dest.row(ty, src.width - 1 - (tx + j), TILE);
+                d[0..4].* = top;
+                d[4..8].* = bottom;
+            },
+            else => unreachable,
+        }
+    }
+}
+
+/// Transpose a 4 x 4 Block of pixels: Rows become Columns
+fn transpose4(r: [4]Quad) [4]Quad {
+    // Interleave Rows 0 and 1, Rows 2 and 3
+    const t0 = @shuffle(u32, r[0], r[1], [4]i32 { 0, -1, 1, -2 });
+    const t1 = @shuffle(u32, r[0], r[1], [4]i32 { 2, -3, 3, -4 });
+    const t2 = @shuffle(u32, r[2], r[3], [4]i32 { 0, -1, 1, -2 });
+    const t3 = @shuffle(u32, r[2], r[3], [4]i32 { 2, -3, 3, -4 });
+
+    // Combine the interleaved pairs into Columns
+    return [4]Quad {
+        @shuffle(u32, t0, t2, [4]i32 { 0, 1, -1, -2 }),
+        @shuffle(u32, t0, t2, [4]i32 { 2, 3, -3, -4 }),
+        @shuffle(u32, t1, t3, [4]i32 { 0, 1, -1, -2 }),
+        @shuffle(u32, t1, t3, [4]i32 { 2, 3, -3, -4 }),
+    };
+}
+
+/// Reverse the order of 4 pixels
+fn reverse4(v: Quad) Quad {
+    return @shuffle(u32, v, undefined, [4]i32 { 3, 2, 1, 0 });
+}
+
+/// Aliases for Zig Standard Library
+const assert = std.debug.assert;
+const debug  = std.log.debug;
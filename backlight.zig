@@ -24,6 +24,9 @@
 /// Import the Zig Standard Library
 const std = @import("std");
 
+/// Import the Register Access Module
+const mmio = @import("./mmio.zig");
+
 /// Import NuttX Functions from C
 const c = @cImport({
     // NuttX Defines
@@ -140,105 +143,49 @@ pub export fn backlight_enable(
     modreg32(PH10, PH10, PH_DATA_REG);
 }
 
-/// Modify the specified bits in a memory mapped register.
-/// Note: Parameters are different from modifyreg32
-/// Based on https://github.com/apache/nuttx/blob/master/arch/arm64/src/common/arm64_arch.h#L473
-fn modreg32(
-    comptime val: u32,   // Bits to set, like (1 << bit)
-    comptime mask: u32,  // Bits to clear, like (1 << bit)
-    addr: u64  // Address to modify
-) void {
-    comptime { assert(val & mask == val); }
-    debug("  *0x{x}: clear 0x{x}, set 0x{x}", .{ addr, mask, val & mask });
-    putreg32(
-        (getreg32(addr) & ~(mask))
-            | ((val) & (mask)),
-        (addr)
-    );
-}
+/// Turn off PinePhone Display Backlight. The PWM Period is kept,
+/// so that backlight_enable() may turn it on again.
+pub export fn backlight_disable() void {
+    debug("backlight_disable: start", .{});
+    defer { debug("backlight_disable: end", .{}); }
 
-/// Get the 32-bit value at the address
-fn getreg32(addr: u64) u32 {
-    const ptr = @intToPtr(*const volatile u32, addr);
-    return ptr.*;
-}
+    // Set PH10 to Low
+    // Register PH_DATA_REG (PH Data Register)
+    // At PIO Offset 0x10C (A64 Page 403)
+    // Set PH10 (Bit 10) to 0 (Low)
+    debug("Set PH10 to Low", .{});
+    const PH_DATA_REG = PIO_BASE_ADDRESS + 0x10C;
+    comptime { assert(PH_DATA_REG == 0x1c2090c); }
+    const PH10: u11 = 1 << 10;
+    modreg32(0, PH10, PH_DATA_REG);
 
-/// Set the 32-bit value at the address
-fn putreg32(val: u32, addr: u64) void {
-    if (enableLog) { debug("  *0x{x} = 0x{x}", .{ addr, val }); }
-    const ptr = @intToPtr(*volatile u32, addr);
-    ptr.* = val;
+    // Disable R_PWM (Undocumented)
+    // Register R_PWM_CTRL_REG? (R_PWM Control Register?)
+    // At R_PWM Offset 0 (A64 Page 194)
+    // Set SCLK_CH0_GATING (Bit 6) to 0 (Mask)
+    // Set PWM_CH0_EN (Bit 4) to 0 (Disable)
+    debug("Disable R_PWM", .{});
+    const R_PWM_CTRL_REG = R_PWM_BASE_ADDRESS + 0;
+    comptime { assert(R_PWM_CTRL_REG == 0x1f03800); }
+    const SCLK_CH0_GATING: u7 = 1 << 6;
+    const PWM_CH0_EN:      u5 = 1 << 4;
+    modreg32(0, SCLK_CH0_GATING | PWM_CH0_EN, R_PWM_CTRL_REG);
 }
 
-/// Set to False to disable log 
-var enableLog = true;
+/// Read and Write Registers (see mmio.zig)
+const putreg32 = mmio.putreg32;
+const modreg32 = mmio.modreg32;
 
 ///////////////////////////////////////////////////////////////////////////////
-//  Panic Handler
-
-/// Called by Zig when it hits a Panic. We print the Panic Message, Stack Trace and halt. See 
-/// https://andrewkelley.me/post/zig-stack-traces-kernel-panic-bare-bones-os.html
-/// https://github.com/ziglang/zig/blob/master/lib/std/builtin.zig#L763-L847
-pub fn panic(
-    message: []const u8, 
-    _stack_trace: ?*std.builtin.StackTrace
-) noreturn {
-    // Print the Panic Message
-    _ = _stack_trace;
-    _ = puts("\n!ZIG PANIC!");
-    _ = puts(@ptrCast([*c]const u8, message));
-
-    // Print the Stack Trace
-    _ = puts("Stack Trace:");
-    var it = std.debug.StackIterator.init(@returnAddress(), null);
-    while (it.next()) |return_address| {
-        _ = printf("%p\n", return_address);
-    }
-
-    // Halt
-    c.exit(1);
-}
+//  Panic Handler and Logging
 
-///////////////////////////////////////////////////////////////////////////////
-//  Logging
-
-/// Called by Zig for `std.log.debug`, `std.log.info`, `std.log.err`, ...
-/// https://gist.github.com/leecannon/d6f5d7e5af5881c466161270347ce84d
-pub fn log(
-    comptime _message_level: std.log.Level,
-    comptime _scope: @Type(.EnumLiteral),
-    comptime format: []const u8,
-    args: anytype,
-) void {
-    _ = _message_level;
-    _ = _scope;
-
-    // Format the message
-    var buf: [100]u8 = undefined;  // Limit to 100 chars
-    var slice = std.fmt.bufPrint(&buf, format, args)
-        catch { _ = puts("*** log error: buf too small"); return; };
-    
-    // Terminate the formatted message with a null
-    var buf2: [buf.len + 1 : 0]u8 = undefined;
-    std.mem.copy(
-        u8, 
-        buf2[0..slice.len], 
-        slice[0..slice.len]
-    );
-    buf2[slice.len] = 0;
-
-    // Print the formatted message
-    _ = puts(&buf2);
-}
+/// Called by Zig when it hits a Panic, and for `std.log.debug`, `std.log.err`, ... (see mmio.zig)
+pub const panic = mmio.panic;
+pub const log   = mmio.log;
 
 ///////////////////////////////////////////////////////////////////////////////
 //  Imported Functions and Variables
 
-/// For safety, we import these functions ourselves to enforce Null-Terminated Strings.
-/// We changed `[*c]const u8` to `[*:0]const u8`
-extern fn printf(format: [*:0]const u8, ...) c_int;
-extern fn puts(str: [*:0]const u8) c_int;
-
 /// Aliases for Zig Standard Library
 const assert = std.debug.assert;
 const debug  = std.log.debug;
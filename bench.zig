@@ -0,0 +1,622 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! Host Benchmark for the PinePhone Display Stack (runs on Linux, not NuttX).
+//! Measures the MIPI DSI Packet Functions, the Framebuffer Fills and the
+//! Register Writes of the Display Drivers against Stub Registers.
+//! Results are written as JSON, and compared with the Baseline by test/bench.sh.
+//! See test/bench.sh for the build and run commands.
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Import the MIPI Display Serial Interface Module
+const dsi = @import("./display.zig");
+
+/// Import the Display Engine Module
+const render = @import("./render.zig");
+
+/// Import the Timing Controller Module
+const tcon = @import("./tcon.zig");
+
+/// Import the MIPI Display Physical Layer Module
+const dphy = @import("./dphy.zig");
+
+/// Import the 2D Graphics Operations Module
+const accel = @import("./accel.zig");
+
+/// Import the Framebuffer Console Module
+const console = @import("./console.zig");
+
+/// Import the Display Suspend and Resume Module
+const standby = @import("./standby.zig");
+
+/// Import the Hardware Cursor Module
+const cursor = @import("./cursor.zig");
+
+/// Import the Image Enhancement Module
+const enhance = @import("./enhance.zig");
+
+/// Import the Display Writeback Module
+const writeback = @import("./writeback.zig");
+
+/// Import the Dynamic Refresh Rate Module
+const refresh = @import("./refresh.zig");
+
+/// Import the DMA Framebuffer Transfer Module
+const dma = @import("./dma.zig");
+
+/// Import the Scanline Rasterizer Module
+const raster = @import("./raster.zig");
+
+/// Import the Host Framebuffer Backend
+const hostfb = @import("./hostfb.zig");
+
+/// Import the Display Pipeline Health Module
+const health = @import("./health.zig");
+
+/// Import the Boot Splash Screen Module
+const splash = @import("./splash.zig");
+
+/// Import the YUV Conversion Module
+const yuv = @import("./yuv.zig");
+
+/// Import the Atomic Plane Commits Module
+const planes = @import("./planes.zig");
+
+/// Suppress the Debug Logs of the Display Drivers, so that we don't measure `puts`
+pub const log_level: std.log.Level = .err;
+
+///////////////////////////////////////////////////////////////////////////////
+//  Stub Registers
+
+/// Number of Register Reads and Writes since the last reset
+var mmio_reads:  u64 = 0;
+var mmio_writes: u64 = 0;
+
+/// Get the 32-bit value of a Stub Register.
+/// Called by getreg32() in the Display Drivers, instead of reading the A64 Hardware.
+pub fn stub_getreg32(addr: u64) u32 {
+    mmio_reads += 1;
+
+    // PLL_VIDEO0_CTRL_REG (0x1C2 0010), PLL_MIPI_CTRL_REG (0x1C2 0040) and
+    // PLL_DE_CTRL_REG (A64 Page 96, 0x1C2 0048): Always return LOCK (Bit 28)
+    // so that tcon0_init() and de2_init() won't wait for the Timeout
+    if (addr == 0x1C2_0010 or addr == 0x1C2_0040 or addr == 0x1C2_0048) { return 1 << 28; }
+
+    // TCON_GINT0_REG (A64 Page 509, 0x1C0 C004): Always return TCON0_Vb_Int_Flag (Bit 15)
+    // so that the Refresh Rate Governor won't wait for Vertical Blanking
+    if (addr == 0x1C0_C004) { return 1 << 15; }
+
+    // DSI_CMD_CTL_REG (0x1CA 0200): Always return RX_Flag (Bit 25), and
+    // DSI_CMD_RX_REG (0x1CA 0240): Return a DCS Short Read Response (1 byte) with
+    // ECC, Power Mode 0x08 (Sleep In, Display Off), so that DCS Reads succeed
+    if (addr == 0x1CA_0200) { return 1 << 25; }
+    if (addr == 0x1CA_0240) { return 0x3700_0821; }
+
+    // DSI_BASIC_CTL0_REG (0x1CA 0010): Return Instru_En = 0
+    // so that waitForTransmit() completes immediately
+    return 0;
+}
+
+/// Set the 32-bit value of a Stub Register.
+/// Called by putreg32() in the Display Drivers, instead of writing the A64 Hardware.
+pub fn stub_putreg32(val: u32, addr: u64) void {
+    _ = val;
+    _ = addr;
+    mmio_writes += 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Benchmark Cases
+
+/// Result of a Benchmark Case
+const Result = struct {
+    name: []const u8,     // Name of the Benchmark Case
+    iterations: u64,      // Number of times the Case was run
+    ns_per_op: u64,       // Wall Time per iteration (nanoseconds)
+    mmio_reads: u64,      // Register Reads per iteration
+    mmio_writes: u64,     // Register Writes per iteration
+};
+
+/// Run the Benchmark Case `func` for the number of iterations.
+/// Returns the Wall Time and Register Accesses per iteration.
+fn runCase(
+    comptime name: []const u8,  // Name of the Benchmark Case
+    iterations: u64,            // Number of times to run the Case
+    comptime func: fn () void   // Function to be measured
+) !Result {
+    // Warm up the caches before measuring
+    func();
+
+    // Run the Case and measure the Wall Time
+    mmio_reads  = 0;
+    mmio_writes = 0;
+    var timer = try std.time.Timer.start();
+    var i: u64 = 0;
+    while (i < iterations) : (i += 1) {
+        func();
+    }
+    const elapsed = timer.read();
+
+    return Result {
+        .name        = "zig." ++ name,
+        .iterations  = iterations,
+        .ns_per_op   = elapsed / iterations,
+        .mmio_reads  = mmio_reads  / iterations,
+        .mmio_writes = mmio_writes / iterations,
+    };
+}
+
+/// Packet Buffer shared by the MIPI DSI Packet Cases
+var pkt_buf = std.mem.zeroes([128]u8);
+
+/// Compose a Short Packet without parameter: `05 11 00 36`
+fn benchShortPacket() void {
+    const buf = [_]u8 { 0x11 };
+    const pkt = dsi.composeShortPacket(&pkt_buf, 0, 0x05, &buf, buf.len);
+    std.mem.doNotOptimizeAway(pkt.ptr);
+}
+
+/// Compose a Short Packet with parameter: `15 bc 4e 35`
+fn benchShortPacketParam() void {
+    const buf = [_]u8 { 0xbc, 0x4e };
+    const pkt = dsi.composeShortPacket(&pkt_buf, 0, 0x15, &buf, buf.len);
+    std.mem.doNotOptimizeAway(pkt.ptr);
+}
+
+/// Compose the 64-byte Long Packet for ST7703 Command E9 (same as test_zig)
+fn benchLongPacket() void {
+    const pkt = dsi.composeLongPacket(&pkt_buf, 0, 0x39, &long_pkt, long_pkt.len);
+    std.mem.doNotOptimizeAway(pkt.ptr);
+}
+
+/// Transmit FIFO for the Streaming Packet Case
+var fifo_words = std.mem.zeroes([dsi.TX_FIFO_WORDS]u32);
+
+/// Write a Word to fifo_words
+fn writeFifoWord(word: u32, index: usize) void {
+    fifo_words[index] = word;
+}
+
+/// Stream the same Long Packet straight into the Transmit FIFO Words
+fn benchStreamLongPacket() void {
+    const len = dsi.streamLongPacket(writeFifoWord, 0, 0x39, &[0]u8 {}, &long_pkt);
+    std.mem.doNotOptimizeAway(len);
+}
+
+/// Compute the ECC for the Long Packet Header: `39 40 00` => `25`
+fn benchEcc() void {
+    var di_wc = [3]u8 { 0x39, 0x40, 0x00 };
+    std.mem.doNotOptimizeAway(&di_wc);
+    const ecc = dsi.computeEcc(di_wc);
+    std.mem.doNotOptimizeAway(ecc);
+}
+
+/// Compute the CRC for the Long Packet Payload: `65 03`
+fn benchCrc() void {
+    const crc = dsi.crc16ccitt(&long_pkt, 0xffff);
+    std.mem.doNotOptimizeAway(crc);
+}
+
+/// Fill Framebuffers 0, 1 and 2 with the Test Pattern
+fn benchFills() void {
+    render.initFramebuffers();
+}
+
+/// Fullscreen Framebuffers for the 2D Graphics Operations
+var surface_buf = [2][720 * 1440]u32 { std.mem.zeroes([720 * 1440]u32), std.mem.zeroes([720 * 1440]u32) };
+
+/// Return Fullscreen Framebuffer 0 or 1
+fn surface(i: usize) accel.Surface {
+    return accel.Surface { .pixels = &surface_buf[i], .stride = 720, .width = 720, .height = 1440 };
+}
+
+/// Fill a 600 x 600 Rectangle
+fn benchAccelFill() void {
+    accel.fill(surface(0), .{ .x = 52, .y = 52, .w = 600, .h = 600 }, 0x8000_0080);
+}
+
+/// Copy a 600 x 600 Rectangle within the same Framebuffer, overlapping downwards
+fn benchAccelCopy() void {
+    accel.copy(surface(0), .{ .x = 60, .y = 60, .w = 600, .h = 600 }, surface(0), 52, 52);
+}
+
+/// Blend a Fullscreen Framebuffer over another
+fn benchAccelBlend() void {
+    accel.blend(surface(0), .{ .x = 0, .y = 0, .w = 720, .h = 1440 }, surface(1), 0, 0, surface(0), 0, 0);
+}
+
+/// Rotate a Landscape 1440 x 720 Framebuffer into a Portrait 720 x 1440 Framebuffer
+fn benchAccelRotate90() void {
+    const landscape = accel.Surface { .pixels = &surface_buf[1], .stride = 1440, .width = 1440, .height = 720 };
+    accel.rotate(surface(0), landscape, .{ .x = 0, .y = 0, .w = 1440, .h = 720 }, .rotate90);
+}
+
+/// Write a full line of text to the Framebuffer Console, which scrolls once the Screen is full
+fn benchConsoleLine() void {
+    const line = "[    1.234567] a64_mipi_dsi_write: channel=0, cmd=0x39, len=64\n";
+    _ = console.console_write(line, line.len);
+}
+
+/// Render 3 UI Channels: Framebuffer Fills plus Display Engine Registers
+fn benchRenderGraphics() void {
+    render.renderGraphics(3);
+}
+
+/// Init the Display Engine
+fn benchDe2Init() void {
+    render.de2_init();
+}
+
+/// Init the Timing Controller TCON0
+fn benchTcon0Init() void {
+    tcon.tcon0_init();
+}
+
+/// Enable the MIPI Display Physical Layer
+fn benchDphyEnable() void {
+    dphy.dphy_enable();
+}
+
+/// Init the ST7703 LCD Controller (includes the 120 ms wait after Sleep Out)
+fn benchPanelInit() void {
+    dsi.panel_init();
+}
+
+/// Suspend the Display (Backlight, Panel Sleep In, Save Registers, Gate Clocks), then
+/// Resume it (Restore Registers, Panel Sleep Out). Includes the Sleep In and Sleep Out
+/// Delays of the Panel (120 milliseconds each), because Resume follows Suspend immediately.
+fn benchDisplaySuspendResume() void {
+    standby.display_suspend();
+    _ = standby.display_resume();  // Succeeds, because the Stub Registers answer Get Power Mode
+}
+
+/// Position of the Hardware Cursor for the next Move
+var cursor_x: c_int = -1;
+
+/// Move the Hardware Cursor by 1 pixel inside the Screen: Only the Blender Offset and
+/// Double Buffer are written, no pixels are drawn
+fn benchCursorMove() void {
+    if (cursor_x < 0) {
+        _ = cursor.cursor_init(&cursor.arrow, cursor.ARROW_WIDTH, cursor.ARROW_HEIGHT);
+        cursor_x = 0;
+    }
+    cursor_x = @mod(cursor_x + 1, 600);
+    cursor.cursor_move(cursor_x, 100);
+}
+
+/// Image Enhancement Settings for the Benchmark: every Block enabled
+const enhance_settings = enhance.Settings {
+    .contrast = 16, .black_level = 16, .white_level = 235,
+    .lti = 8, .sharpness = 32, .saturation = 8,
+    .hue_saturation = .{ 0, 0, 0, 0, 0, 0 },
+};
+
+/// Program the Image Enhancement Blocks
+fn benchEnhanceSet() void {
+    _ = enhance.enhance_set(&enhance_settings);
+}
+
+/// Render a Row of the Test Pattern with the Reference Model of the Image Enhancement Blocks
+fn benchEnhanceModel() void {
+    const p = enhance.plan(enhance_settings).?;
+    var row: [render.PANEL_WIDTH]u32 = undefined;
+    for (row) |*px, x| { px.* = if (x % 16 < 8) 0xFF20_4080 else 0xFFC0_A060; }
+    enhance.modelRow(p, &row);
+    std.mem.doNotOptimizeAway(row);
+}
+
+/// Buffer for the Writeback Capture, downscaled by 4
+var wb_buf: [(render.PANEL_WIDTH / 4) * (render.PANEL_HEIGHT / 4)]u32 = undefined;
+
+/// Capture the Composited Frame, downscaled by 4: Programs the Writeback
+/// Registers and composes the Layers in software (Host Simulation)
+fn benchWritebackCapture() void {
+    _ = writeback.writeback_start(&wb_buf, @sizeOf(@TypeOf(wb_buf)), @enumToInt(writeback.Format.argb8888), 4, null, null);
+    _ = writeback.writeback_poll();
+    std.mem.doNotOptimizeAway(wb_buf);
+}
+
+/// Simulated Time (microseconds) for the Refresh Rate Governor. Starts after any
+/// real Timestamp recorded by the other Cases (which report Framebuffer Updates).
+var refresh_now: u64 = 1 << 62;
+
+/// Run the Refresh Rate Governor every 100 milliseconds of Simulated Time: Idle for
+/// 10 seconds (stepping down to 30 Hz), then one Framebuffer Update (back to 60 Hz)
+fn benchRefreshGovernor() void {
+    var i: usize = 0;
+    while (i < 100) : (i += 1) {
+        refresh_now += 100_000;
+        refresh.update(refresh_now);
+    }
+    refresh.activity(refresh_now);
+}
+
+/// Simulated Time (microseconds) for the Health Counters, like refresh_now
+var health_now: u64 = 1 << 62;
+
+/// Record 120 Frames at 60 Hz with an Update in every Frame, and
+/// one Vertical Blanking missed every 30 Frames
+fn benchHealthCounters() void {
+    health.reset();
+    var i: usize = 0;
+    while (i < 120) : (i += 1) {
+        health_now += 16_667;
+        health.submit(health_now - 4_000 - (i % 8) * 1_000);
+        if (i % 30 != 29) { health.vblank(health_now); }
+    }
+    std.mem.doNotOptimizeAway(health.get());
+}
+
+/// Commit that moves Plane 1 (First Overlay). Stub Addresses below 4 GB.
+var bench_commit = planes.Commit {
+    .changes = 1 << 1,
+    .state = .{
+        .planes = [_]planes.Plane { .{
+            .addr = 0x4000_0000, .pitch = 600 * 4, .width = 600, .height = 600, .x = 0, .y = 0,
+            .format = planes.FORMAT_ARGB8888, .alpha_mode = 2, .global_alpha = 0xFF, .enable = 1,
+        } } ** planes.PLANES,
+        .zorder = .{ 0, 1, 2 },
+        .background = 0xFF00_0000,
+    },
+};
+
+/// Move the First Overlay diagonally with Atomic Commits: Only BLD_CH_OFFSET and
+/// GLB_DBUFFER are written for each Commit
+fn benchPlaneCommit() void {
+    const p = &bench_commit.state.planes[1];
+    p.x = (p.x + 1) % 120;
+    p.y = p.x;
+    _ = planes.plane_commit(null, &bench_commit);
+}
+
+/// Source and Destination for the Framebuffer Transfers: 720 x 720 pixels
+var xfer_src  = std.mem.zeroes([render.PANEL_WIDTH * render.PANEL_WIDTH]u32);
+var xfer_dest = std.mem.zeroes([render.PANEL_WIDTH * render.PANEL_WIDTH]u32);
+
+/// Queue a Fill and a 2D Copy of the left half, then wait for both (Worker Thread on the Host Computer)
+fn benchXfer() void {
+    _ = dma.fbxfer_fill(&xfer_dest, xfer_dest.len, 0xFF00_8000, null, null);
+    _ = dma.fbxfer_copy2d(&xfer_dest, render.PANEL_WIDTH, &xfer_src, render.PANEL_WIDTH,
+        render.PANEL_WIDTH / 2, render.PANEL_WIDTH, null, null);
+    dma.fbxfer_wait();
+}
+
+/// QOI Splash Screen for the Decoder (720 x 1440), encoded by encodeSplash
+var splash_qoi: [64 * 1024]u8 = undefined;
+var splash_len: usize = 0;
+
+/// Encode a Splash Screen in QOI: Every Row has 6 Segments of 120 pixels. The first
+/// Segment begins with a new Colour (QOI_OP_RGB), the others with a small change of
+/// Colour (QOI_OP_DIFF or QOI_OP_LUMA), and each continues as Runs (QOI_OP_RUN)
+fn encodeSplash() void {
+    var b = std.io.fixedBufferStream(&splash_qoi);
+    const w = b.writer();
+    w.writeAll("qoif") catch unreachable;
+    w.writeIntBig(u32, render.PANEL_WIDTH) catch unreachable;
+    w.writeIntBig(u32, render.PANEL_HEIGHT) catch unreachable;
+    w.writeAll(&[_]u8 { 4, 0 }) catch unreachable;
+    var y: usize = 0;
+    while (y < render.PANEL_HEIGHT) : (y += 1) {
+        var k: usize = 0;
+        while (k < render.PANEL_WIDTH / 120) : (k += 1) {
+            if (k == 0) {
+                w.writeAll(&[_]u8 { 0xFE, @intCast(u8, y / 6), 0x40, 0x80 }) catch unreachable;
+            } else if (k % 2 == 1) {
+                w.writeByte(0x40 | 3 << 4 | 2 << 2 | 1) catch unreachable;  // Red + 1, Blue - 1
+            } else {
+                w.writeAll(&[_]u8 { 0x80 | 34, 0x88 }) catch unreachable;  // Red, Green, Blue + 2
+            }
+            w.writeAll(&[_]u8 { 0xC0 | 61, 0xC0 | 56 }) catch unreachable;  // Runs of 62 + 57 pixels
+        }
+    }
+    w.writeAll(&[_]u8 { 0, 0, 0, 0, 0, 0, 0, 1 }) catch unreachable;  // End Marker
+    splash_len = b.pos;
+}
+
+/// Decode the QOI Splash Screen into Framebuffer 0, fed in chunks of 4 KB like Blocks from Flash
+fn benchSplash() void {
+    if (splash_len == 0) { encodeSplash(); }
+    var d = splash.Decoder.init(render.getPlane());
+    var i: usize = 0;
+    while (i < splash_len) : (i += 4096) {
+        d.feed(splash_qoi[i..std.math.min(i + 4096, splash_len)]) catch unreachable;
+    }
+    d.finish() catch unreachable;
+}
+
+/// NV12 Video Frame (720 x 720) for the YUV Conversion: Y Plane, then interleaved U and V
+var yuv_frame = [_]u8 { 0x80 } ** (render.PANEL_WIDTH * render.PANEL_WIDTH * 3 / 2);
+
+/// Return the NV12 Frame, or the same memory as YUV420p (Y, U and V Planes)
+fn yuvFrame(format: yuv.Format) yuv.Frame {
+    const w = render.PANEL_WIDTH;
+    const luma: [*]const u8 = &yuv_frame;
+    const chroma = luma + w * w;
+    return .{
+        .format = format,
+        .width  = w,
+        .height = w,
+        .planes  = .{ luma, chroma, chroma + w * w / 4 },
+        .strides = if (format == .nv12) [3]u32 { w, w, 0 } else [3]u32 { w, w / 2, w / 2 },
+    };
+}
+
+/// Convert an NV12 Frame to ARGB 8888 (BT.709) in the Transfer Buffer, on one Core
+fn benchYuvNv12() void {
+    const dest = accel.Surface { .pixels = &xfer_dest, .stride = render.PANEL_WIDTH, .width = render.PANEL_WIDTH, .height = render.PANEL_WIDTH };
+    yuv.toArgb(dest, 0, 0, yuvFrame(.nv12), .bt709, false);
+    std.mem.doNotOptimizeAway(xfer_dest);
+}
+
+/// Convert a YUV420p Frame to RGB 565 (BT.601) in the Transfer Buffer, on one Core
+fn benchYuv420pRgb565() void {
+    const dest = yuv.Surface565 { .pixels = @ptrCast([*]u16, &xfer_dest), .stride = render.PANEL_WIDTH, .width = render.PANEL_WIDTH, .height = render.PANEL_WIDTH };
+    yuv.toRgb565(dest, 0, 0, yuvFrame(.yuv420p), .bt601);
+    std.mem.doNotOptimizeAway(xfer_dest);
+}
+
+/// Convert an NV12 Frame to ARGB 8888 (BT.709) in the Transfer Buffer, on 4 Threads
+fn benchYuvThreaded() void {
+    const dest = accel.Surface { .pixels = &xfer_dest, .stride = render.PANEL_WIDTH, .width = render.PANEL_WIDTH, .height = render.PANEL_WIDTH };
+    yuv.toArgb(dest, 0, 0, yuvFrame(.nv12), .bt709, true);
+    std.mem.doNotOptimizeAway(xfer_dest);
+}
+
+/// Widget-style Shapes for the Rasterizer: Button, Knob, Dial and Arrow Head
+const raster_pentagon = [_]raster.Point {
+    .{ .x = 360, .y = 540 }, .{ .x = 500, .y = 600 }, .{ .x = 450, .y = 700 },
+    .{ .x = 270, .y = 700 }, .{ .x = 220, .y = 600 },
+};
+const raster_shapes = [_]raster.Shape {
+    .{ .round_rect = .{ .x = 40.5, .y = 60.25, .w = 640, .h = 120, .r = 24 } },
+    raster.circle(360, 300, 100.5),
+    .{ .ellipse = .{ .cx = 360, .cy = 460, .rx = 300, .ry = 60 } },
+    .{ .polygon = &raster_pentagon },
+    raster.circle(360, 300, 0),  // Empty: Skipped
+};
+
+/// Draw the Shapes with Anti-Aliased Edges into the Transfer Buffer (720 x 720 pixels)
+fn benchRaster() void {
+    const dest = accel.Surface { .pixels = &xfer_dest, .stride = render.PANEL_WIDTH, .width = render.PANEL_WIDTH, .height = render.PANEL_WIDTH };
+    for (raster_shapes) |shape| { raster.fill(dest, shape, 0x8040_C0FF); }
+    std.mem.doNotOptimizeAway(xfer_dest);
+}
+
+/// Payload of the Long Packet for ST7703 Command E9
+const long_pkt = [_]u8 {
+    0xe9, 0x82, 0x10, 0x06, 0x05, 0xa2, 0x0a, 0xa5,
+    0x12, 0x31, 0x23, 0x37, 0x83, 0x04, 0xbc, 0x27,
+    0x38, 0x0c, 0x00, 0x03, 0x00, 0x00, 0x00, 0x0c,
+    0x00, 0x03, 0x00, 0x00, 0x00, 0x75, 0x75, 0x31,
+    0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x13, 0x88,
+    0x64, 0x64, 0x20, 0x88, 0x88, 0x88, 0x88, 0x88,
+    0x88, 0x02, 0x88, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//  Main Function
+
+/// Run the Benchmark Cases and write the results as JSON to the file
+/// specified on the command line (default: bench_zig.json).
+/// If PINEPHONE_HOSTFB is set to a Directory, the Framebuffers are mapped
+/// to Files in the Directory (see hostfb.zig).
+pub fn main() !void {
+    var arena = std.heap.ArenaAllocator.init(std.heap.page_allocator);
+    defer arena.deinit();
+    const args = try std.process.argsAlloc(arena.allocator());
+    const path = if (args.len > 1) args[1] else "bench_zig.json";
+
+    // Map the Framebuffers to Files if requested, so that the rendered Frames can be inspected
+    if (std.os.getenv("PINEPHONE_HOSTFB")) |dir| { try hostfb.open(dir); }
+    defer { if (std.os.getenv("PINEPHONE_HOSTFB") != null) { hostfb.sync(); } }
+
+    // Turn on the Refresh Rate Governor, which is off by default
+    _ = refresh.refresh_force(0);
+
+    // Run the Benchmark Cases
+    const results = [_]Result {
+        // MIPI DSI Packets
+        try runCase("composeShortPacket",      1_000_000, benchShortPacket),
+        try runCase("composeShortPacketParam", 1_000_000, benchShortPacketParam),
+        try runCase("composeLongPacket",       1_000_000, benchLongPacket),
+        try runCase("streamLongPacket",        1_000_000, benchStreamLongPacket),
+        try runCase("computeEcc",              1_000_000, benchEcc),
+        try runCase("crc16ccitt",              1_000_000, benchCrc),
+
+        // Framebuffers
+        try runCase("initFramebuffers",        20, benchFills),
+        try runCase("renderGraphics",          20, benchRenderGraphics),
+        try runCase("splash.decode",           20, benchSplash),
+
+        // 2D Graphics Operations
+        try runCase("accel.fill",              100, benchAccelFill),
+        try runCase("accel.copy",              100, benchAccelCopy),
+        try runCase("accel.blend",             20,  benchAccelBlend),
+        try runCase("accel.rotate90",          20,  benchAccelRotate90),
+        try runCase("raster.shapes",           100, benchRaster),
+
+        // YUV Conversion
+        try runCase("yuv.nv12_argb",           100, benchYuvNv12),
+        try runCase("yuv.yuv420p_rgb565",      100, benchYuv420pRgb565),
+        try runCase("yuv.nv12_argb_threaded",  100, benchYuvThreaded),
+
+        // Framebuffer Console
+        try runCase("console.line",            10_000, benchConsoleLine),
+
+        // Hardware Cursor
+        try runCase("cursor.move",             100_000, benchCursorMove),
+
+        // Image Enhancement
+        try runCase("enhance_set",             1_000, benchEnhanceSet),
+        try runCase("enhance.modelRow",        10_000, benchEnhanceModel),
+
+        // Display Writeback
+        try runCase("writeback.capture",       20, benchWritebackCapture),
+
+        // Refresh Rate Governor
+        try runCase("refresh.governor",        10_000, benchRefreshGovernor),
+
+        // Display Pipeline Health
+        try runCase("health.counters",         10_000, benchHealthCounters),
+
+        // Atomic Plane Commits
+        try runCase("planes.commit",           10_000, benchPlaneCommit),
+
+        // DMA Framebuffer Transfers
+        try runCase("fbxfer.fill_copy2d",      100, benchXfer),
+
+        // Display Drivers against Stub Registers
+        try runCase("de2_init",                20, benchDe2Init),
+        try runCase("tcon0_init",              20, benchTcon0Init),
+        try runCase("dphy_enable",             20, benchDphyEnable),
+        try runCase("panel_init",              3,  benchPanelInit),
+        try runCase("display_suspend_resume",  5,  benchDisplaySuspendResume),
+    };
+
+    // Write the results as a JSON Array
+    const file = try std.fs.cwd().createFile(path, .{});
+    defer file.close();
+    const writer = file.writer();
+    try writer.writeAll("[\n");
+    for (results) |r, i| {
+        try writer.print(
+            "  {{ \"name\": \"{s}\", \"iterations\": {}, \"ns_per_op\": {}, \"mmio_reads\": {}, \"mmio_writes\": {} }}{s}\n",
+            .{ r.name, r.iterations, r.ns_per_op, r.mmio_reads, r.mmio_writes, if (i + 1 < results.len) "," else "" }
+        );
+    }
+    try writer.writeAll("]\n");
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Stub Functions
+
+/// The Display Drivers export Test Functions that call the NuttX Drivers in C.
+/// The Host Benchmark doesn't call them, but we need these symbols for linking.
+export fn a64_de_init() c_int { return 0; }
+export fn a64_mipi_dphy_enable() c_int { return 0; }
+export fn a64_mipi_dsi_enable() c_int { return 0; }
+export fn a64_mipi_dsi_start() c_int { return 0; }
+export fn a64_tcon0_init(width: u16, height: u16) c_int { _ = width; _ = height; return 0; }
+export fn pinephone_lcd_panel_init() c_int { return 0; }
+export fn pinephone_pmic_init() c_int { return 0; }
+export fn pinephone_render_graphics() c_int { return 0; }
+export fn up_mdelay(milliseconds: c_uint) void { _ = milliseconds; }
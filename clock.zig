@@ -0,0 +1,61 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! Monotonic Clock for the PinePhone Display Drivers on Apache NuttX RTOS.
+//! Timestamps are in microseconds (or nanoseconds) since boot, from CLOCK_MONOTONIC.
+
+/// Import NuttX Functions from C
+const c = @cImport({
+    // NuttX Defines
+    @cDefine("__NuttX__",  "");
+    @cDefine("NDEBUG",     "");
+    @cDefine("FAR",        "");
+
+    // NuttX Header Files
+    @cInclude("arch/types.h");
+    @cInclude("../../nuttx/include/limits.h");
+    @cInclude("nuttx/config.h");
+    @cInclude("time.h");
+    @cInclude("unistd.h");
+});
+
+/// Return the Monotonic Time in microseconds
+pub fn now_us() u64 {
+    return now_ns() / 1_000;
+}
+
+/// Return the Monotonic Time in nanoseconds
+pub fn now_ns() u64 {
+    var ts: c.struct_timespec = undefined;
+    _ = c.clock_gettime(c.CLOCK_MONOTONIC, &ts);
+    return @intCast(u64, ts.tv_sec) * 1_000_000_000 + @intCast(u64, ts.tv_nsec);
+}
+
+/// Sleep until the Timestamp `deadline` (microseconds). Returns at once if it has passed.
+pub fn sleepUntil(deadline: u64) void {
+    const now = now_us();
+    if (now < deadline) {
+        _ = c.usleep(@intCast(c.useconds_t, deadline - now));
+    }
+}
+
+/// Sleep until `delay_us` microseconds have passed since the Timestamp `since` (microseconds)
+pub fn waitSince(since: u64, delay_us: u64) void {
+    sleepUntil(since + delay_us);
+}
@@ -0,0 +1,343 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! Framebuffer Text Console for Apache NuttX RTOS on PinePhone.
+//! Renders NSH and Log Output on the Base UI Channel with a Glyph Atlas that's
+//! pre-rendered at Compile Time. Text is drawn into a Virtual Framebuffer that's
+//! twice the height of the Panel, and we scroll by panning the Base UI Channel
+//! (like FBIOPAN_DISPLAY), instead of moving the pixels.
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Import the Display Engine Module
+const render = @import("./render.zig");
+
+/// Import the Parallel Rendering Module, for flushing the Data Cache
+const parallel = @import("./parallel.zig");
+
+/// Import the Dynamic Refresh Rate Module
+const refresh = @import("./refresh.zig");
+
+/// Import the Atomic Plane Commit Module, for waiting until the Pan is latched
+const planes = @import("./planes.zig");
+
+/// Size of a Character Cell (pixels): 8 x 8 Font scaled 2 times
+const FONT_SCALE  = 2;
+const CELL_WIDTH  = 8 * FONT_SCALE;
+const CELL_HEIGHT = 8 * FONT_SCALE;
+
+/// Size of the Console (characters): 45 Columns x 90 Rows
+const COLS = render.PANEL_WIDTH  / CELL_WIDTH;
+const ROWS = render.PANEL_HEIGHT / CELL_HEIGHT;
+
+/// Console Colours (XRGB 8888): Light Grey on Black
+const FOREGROUND = 0xFFC0_C0C0;
+const BACKGROUND = 0xFF00_0000;
+
+/// Spacing of the Tab Stops (characters)
+const TAB_SIZE = 8;
+
+///////////////////////////////////////////////////////////////////////////////
+//  Console Output
+
+/// Init the Framebuffer Console: Clear the Virtual Framebuffer and
+/// show it on the Base UI Channel. Call this after `de2_init` and `renderGraphics`.
+pub export fn console_init() void {
+    debug("console_init: start", .{});
+    defer { debug("console_init: end", .{}); }
+
+    std.mem.set(u32, &fbConsole, BACKGROUND);
+    parallel.flushBand(&fbConsole);
+    col = 0;
+    row = 0;
+    top = 0;
+    dirty = DirtyRows.initEmpty();
+    scrolled = DirtyRows.initEmpty();
+    pan();
+}
+
+/// Write the characters to the Framebuffer Console. Handles Newline, Carriage Return,
+/// Backspace and Tab, and wraps long lines. Returns the number of characters written.
+pub export fn console_write(
+    buf: [*c]const u8,  // Characters to be written
+    len: usize          // Number of characters
+) isize {
+    const top_before = top;
+    shown_top = top;
+    var i: usize = 0;
+    while (i < len) : (i += 1) {
+        putChar(buf[i]);
+    }
+
+    // Flush the updated Text Rows from the Data Cache, then scroll if necessary
+    var it = dirty.iterator(.{});
+    while (it.next()) |r| {
+        parallel.flushBand(textRow(r, 0));
+        parallel.flushBand(textRow(r, 1));
+    }
+    dirty = DirtyRows.initEmpty();
+    if (top != top_before) {
+        pan();
+        if (!planes.waitLatch()) { std.log.err("console_write: pan not latched", .{}); }
+    }
+
+    // The old position of the Scrolled Text Rows is off the Screen now: Copy them over
+    var it_scrolled = scrolled.iterator(.{});
+    while (it_scrolled.next()) |r| {
+        const shown = shownCopy(r);
+        std.mem.copy(u32, textRow(r, shown), textRow(r, 1 - shown));
+        parallel.flushBand(textRow(r, shown));
+    }
+    scrolled = DirtyRows.initEmpty();
+    refresh.refresh_activity();
+    return @intCast(isize, len);
+}
+
+/// Write a character to the Framebuffer Console
+fn putChar(ch: u8) void {
+    switch (ch) {
+        '\n' => newLine(),
+        '\r' => col = 0,
+        0x08 => {  // Backspace
+            if (col > 0) { col -= 1; }
+        },
+        '\t' => {
+            col = std.math.min((col / TAB_SIZE + 1) * TAB_SIZE, COLS);
+        },
+        else => {
+            // Wrap to the next line
+            if (col >= COLS) { newLine(); }
+            drawGlyph(ch, col, (top + row) % ROWS);
+            col += 1;
+        },
+    }
+}
+
+/// Move the Cursor to the start of the next line. At the bottom of the Screen,
+/// we scroll up by one Text Row: The Top Row wraps around to become the
+/// Bottom Row, and we clear it. The Top Row stays on the Screen until the Pan
+/// is latched at Vertical Blanking, so we clear only the copy that's off the Screen.
+fn newLine() void {
+    col = 0;
+    if (row + 1 < ROWS) { row += 1; return; }
+    top = (top + 1) % ROWS;
+    const r = (top + ROWS - 1) % ROWS;
+    scrolled.set(r);
+    std.mem.set(u32, textRow(r, 1 - shownCopy(r)), BACKGROUND);
+    dirty.set(r);
+}
+
+/// Pan the Base UI Channel so that Text Row `top` is at the top of the Screen
+fn pan() void {
+    render.panPlane(&fbConsole, top * CELL_HEIGHT);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Virtual Framebuffer
+
+/// Virtual Framebuffer: Every Text Row `r` is drawn twice, at Row `r` and at Row `r + ROWS`.
+/// Whichever Text Row is at the top of the Screen, the next 90 Text Rows are always
+/// contiguous in memory. So we may pan to any `yoffset` up to PANEL_HEIGHT, and the
+/// Text Rows wrap around without copying. (4 bytes per XRGB 8888 pixel)
+var fbConsole align(0x1000) = std.mem.zeroes([render.PANEL_WIDTH * render.PANEL_HEIGHT * 2] u32);
+
+/// Cursor Position: Column and Row on the Screen
+var col: usize = 0;
+var row: usize = 0;
+
+/// Text Row in the Virtual Framebuffer that's at the top of the Screen
+var top: usize = 0;
+
+/// Text Rows that need to be flushed from the Data Cache
+const DirtyRows = std.StaticBitSet(ROWS);
+var dirty = DirtyRows.initEmpty();
+
+/// Text Rows that scrolled in during `console_write`. Until the Pan is latched, they are
+/// drawn only in the copy that's off the Screen, and copied to the other copy after.
+var scrolled = DirtyRows.initEmpty();
+
+/// Text Row that was at the top of the Screen when `console_write` started
+var shown_top: usize = 0;
+
+/// Return the copy (0 or 1) of Text Row `r` that's on the Screen before the Pan
+fn shownCopy(r: usize) usize {
+    return if (r >= shown_top) 0 else 1;
+}
+
+/// Return the pixels of Text Row `r` in the first (`copy` = 0) or second (`copy` = 1)
+/// half of the Virtual Framebuffer
+fn textRow(r: usize, copy: usize) []u32 {
+    const y = (r + copy * ROWS) * CELL_HEIGHT;
+    return fbConsole[(y * render.PANEL_WIDTH)..((y + CELL_HEIGHT) * render.PANEL_WIDTH)];
+}
+
+/// Draw the character at Column `x` of Text Row `r`. Each row of the Glyph is
+/// selected between the Foreground and Background Colours with a 16-pixel Vector Mask,
+/// then written to both copies of the Text Row (only the off-screen copy if the Row
+/// just scrolled in).
+fn drawGlyph(ch: u8, x: usize, r: usize) void {
+    // Unprintable characters are shown as `?`
+    const glyph = if (ch >= FIRST_CHAR and ch < FIRST_CHAR + font8x8.len) ch - FIRST_CHAR else '?' - FIRST_CHAR;
+    const fg = @splat(CELL_WIDTH, @as(u32, FOREGROUND));
+    const bg = @splat(CELL_WIDTH, @as(u32, BACKGROUND));
+    const zero = @splat(CELL_WIDTH, @as(u8, 0));
+    const hidden = scrolled.isSet(r);
+    for (atlas[glyph]) |mask, y| {
+        const pixels: [CELL_WIDTH]u32 = @select(u32, mask != zero, fg, bg);
+        const offset = y * render.PANEL_WIDTH + x * CELL_WIDTH;
+        if (!hidden or shownCopy(r) != 0) { textRow(r, 0)[offset..][0..CELL_WIDTH].* = pixels; }
+        if (!hidden or shownCopy(r) != 1) { textRow(r, 1)[offset..][0..CELL_WIDTH].* = pixels; }
+    }
+    dirty.set(r);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Glyph Atlas
+
+/// Glyph Atlas: For every character, one 16-pixel Alpha Mask (0 or 0xFF) per Cell Row,
+/// scaled up from the 8 x 8 Font at Compile Time
+const atlas = blk: {
+    @setEvalBranchQuota(200_000);
+    var a: [font8x8.len][CELL_HEIGHT]@Vector(CELL_WIDTH, u8) = undefined;
+    for (font8x8) |bitmap, g| {
+        var y = 0;
+        while (y < CELL_HEIGHT) : (y += 1) {
+            var mask: [CELL_WIDTH]u8 = undefined;
+            var x = 0;
+            while (x < CELL_WIDTH) : (x += 1) {
+                // Bit 0 is the leftmost pixel of the Font Row
+                const bit = (bitmap[y / FONT_SCALE] >> (x / FONT_SCALE)) & 1;
+                mask[x] = if (bit != 0) 0xFF else 0;
+            }
+            a[g][y] = mask;
+        }
+    }
+    break :blk a;
+};
+
+/// First character in the Font (Space)
+const FIRST_CHAR = 0x20;
+
+/// 8 x 8 Font for Printable ASCII `0x20` to `0x7E`: 8 Rows per character, Bit 0 is the
+/// leftmost pixel. From the Public Domain font8x8_basic by Daniel Hepper.
+const font8x8 = [_][8]u8 {
+    .{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // U+0020 ' '
+    .{ 0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00 },  // U+0021 '!'
+    .{ 0x36, 0x36, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // U+0022 '"'
+    .{ 0x36, 0x36, 0x7F, 0x36, 0x7F, 0x36, 0x36, 0x00 },  // U+0023 '#'
+    .{ 0x0C, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x0C, 0x00 },  // U+0024 '$'
+    .{ 0x00, 0x63, 0x33, 0x18, 0x0C, 0x66, 0x63, 0x00 },  // U+0025 '%'
+    .{ 0x1C, 0x36, 0x1C, 0x6E, 0x3B, 0x33, 0x6E, 0x00 },  // U+0026 '&'
+    .{ 0x06, 0x06, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00 },  // U+0027 "'"
+    .{ 0x18, 0x0C, 0x06, 0x06, 0x06, 0x0C, 0x18, 0x00 },  // U+0028 '('
+    .{ 0x06, 0x0C, 0x18, 0x18, 0x18, 0x0C, 0x06, 0x00 },  // U+0029 ')'
+    .{ 0x00, 0x66, 0x3C, 0xFF, 0x3C, 0x66, 0x00, 0x00 },  // U+002A '*'
+    .{ 0x00, 0x0C, 0x0C, 0x3F, 0x0C, 0x0C, 0x00, 0x00 },  // U+002B '+'
+    .{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x06 },  // U+002C ','
+    .{ 0x00, 0x00, 0x00, 0x3F, 0x00, 0x00, 0x00, 0x00 },  // U+002D '-'
+    .{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C, 0x00 },  // U+002E '.'
+    .{ 0x60, 0x30, 0x18, 0x0C, 0x06, 0x03, 0x01, 0x00 },  // U+002F '/'
+    .{ 0x3E, 0x63, 0x73, 0x7B, 0x6F, 0x67, 0x3E, 0x00 },  // U+0030 '0'
+    .{ 0x0C, 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x3F, 0x00 },  // U+0031 '1'
+    .{ 0x1E, 0x33, 0x30, 0x1C, 0x06, 0x33, 0x3F, 0x00 },  // U+0032 '2'
+    .{ 0x1E, 0x33, 0x30, 0x1C, 0x30, 0x33, 0x1E, 0x00 },  // U+0033 '3'
+    .{ 0x38, 0x3C, 0x36, 0x33, 0x7F, 0x30, 0x78, 0x00 },  // U+0034 '4'
+    .{ 0x3F, 0x03, 0x1F, 0x30, 0x30, 0x33, 0x1E, 0x00 },  // U+0035 '5'
+    .{ 0x1C, 0x06, 0x03, 0x1F, 0x33, 0x33, 0x1E, 0x00 },  // U+0036 '6'
+    .{ 0x3F, 0x33, 0x30, 0x18, 0x0C, 0x0C, 0x0C, 0x00 },  // U+0037 '7'
+    .{ 0x1E, 0x33, 0x33, 0x1E, 0x33, 0x33, 0x1E, 0x00 },  // U+0038 '8'
+    .{ 0x1E, 0x33, 0x33, 0x3E, 0x30, 0x18, 0x0E, 0x00 },  // U+0039 '9'
+    .{ 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x00 },  // U+003A ':'
+    .{ 0x00, 0x0C, 0x0C, 0x00, 0x00, 0x0C, 0x0C, 0x06 },  // U+003B ';'
+    .{ 0x18, 0x0C, 0x06, 0x03, 0x06, 0x0C, 0x18, 0x00 },  // U+003C '<'
+    .{ 0x00, 0x00, 0x3F, 0x00, 0x00, 0x3F, 0x00, 0x00 },  // U+003D '='
+    .{ 0x06, 0x0C, 0x18, 0x30, 0x18, 0x0C, 0x06, 0x00 },  // U+003E '>'
+    .{ 0x1E, 0x33, 0x30, 0x18, 0x0C, 0x00, 0x0C, 0x00 },  // U+003F '?'
+    .{ 0x3E, 0x63, 0x7B, 0x7B, 0x7B, 0x03, 0x1E, 0x00 },  // U+0040 '@'
+    .{ 0x0C, 0x1E, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x00 },  // U+0041 'A'
+    .{ 0x3F, 0x66, 0x66, 0x3E, 0x66, 0x66, 0x3F, 0x00 },  // U+0042 'B'
+    .{ 0x3C, 0x66, 0x03, 0x03, 0x03, 0x66, 0x3C, 0x00 },  // U+0043 'C'
+    .{ 0x1F, 0x36, 0x66, 0x66, 0x66, 0x36, 0x1F, 0x00 },  // U+0044 'D'
+    .{ 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x46, 0x7F, 0x00 },  // U+0045 'E'
+    .{ 0x7F, 0x46, 0x16, 0x1E, 0x16, 0x06, 0x0F, 0x00 },  // U+0046 'F'
+    .{ 0x3C, 0x66, 0x03, 0x03, 0x73, 0x66, 0x7C, 0x00 },  // U+0047 'G'
+    .{ 0x33, 0x33, 0x33, 0x3F, 0x33, 0x33, 0x33, 0x00 },  // U+0048 'H'
+    .{ 0x1E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },  // U+0049 'I'
+    .{ 0x78, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E, 0x00 },  // U+004A 'J'
+    .{ 0x67, 0x66, 0x36, 0x1E, 0x36, 0x66, 0x67, 0x00 },  // U+004B 'K'
+    .{ 0x0F, 0x06, 0x06, 0x06, 0x46, 0x66, 0x7F, 0x00 },  // U+004C 'L'
+    .{ 0x63, 0x77, 0x7F, 0x7F, 0x6B, 0x63, 0x63, 0x00 },  // U+004D 'M'
+    .{ 0x63, 0x67, 0x6F, 0x7B, 0x73, 0x63, 0x63, 0x00 },  // U+004E 'N'
+    .{ 0x1C, 0x36, 0x63, 0x63, 0x63, 0x36, 0x1C, 0x00 },  // U+004F 'O'
+    .{ 0x3F, 0x66, 0x66, 0x3E, 0x06, 0x06, 0x0F, 0x00 },  // U+0050 'P'
+    .{ 0x1E, 0x33, 0x33, 0x33, 0x3B, 0x1E, 0x38, 0x00 },  // U+0051 'Q'
+    .{ 0x3F, 0x66, 0x66, 0x3E, 0x36, 0x66, 0x67, 0x00 },  // U+0052 'R'
+    .{ 0x1E, 0x33, 0x07, 0x0E, 0x38, 0x33, 0x1E, 0x00 },  // U+0053 'S'
+    .{ 0x3F, 0x2D, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },  // U+0054 'T'
+    .{ 0x33, 0x33, 0x33, 0x33, 0x33, 0x33, 0x3F, 0x00 },  // U+0055 'U'
+    .{ 0x33, 0x33, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 },  // U+0056 'V'
+    .{ 0x63, 0x63, 0x63, 0x6B, 0x7F, 0x77, 0x63, 0x00 },  // U+0057 'W'
+    .{ 0x63, 0x63, 0x36, 0x1C, 0x1C, 0x36, 0x63, 0x00 },  // U+0058 'X'
+    .{ 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x0C, 0x1E, 0x00 },  // U+0059 'Y'
+    .{ 0x7F, 0x63, 0x31, 0x18, 0x4C, 0x66, 0x7F, 0x00 },  // U+005A 'Z'
+    .{ 0x1E, 0x06, 0x06, 0x06, 0x06, 0x06, 0x1E, 0x00 },  // U+005B '['
+    .{ 0x03, 0x06, 0x0C, 0x18, 0x30, 0x60, 0x40, 0x00 },  // U+005C '\\'
+    .{ 0x1E, 0x18, 0x18, 0x18, 0x18, 0x18, 0x1E, 0x00 },  // U+005D ']'
+    .{ 0x08, 0x1C, 0x36, 0x63, 0x00, 0x00, 0x00, 0x00 },  // U+005E '^'
+    .{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF },  // U+005F '_'
+    .{ 0x0C, 0x0C, 0x18, 0x00, 0x00, 0x00, 0x00, 0x00 },  // U+0060 '`'
+    .{ 0x00, 0x00, 0x1E, 0x30, 0x3E, 0x33, 0x6E, 0x00 },  // U+0061 'a'
+    .{ 0x07, 0x06, 0x06, 0x3E, 0x66, 0x66, 0x3B, 0x00 },  // U+0062 'b'
+    .{ 0x00, 0x00, 0x1E, 0x33, 0x03, 0x33, 0x1E, 0x00 },  // U+0063 'c'
+    .{ 0x38, 0x30, 0x30, 0x3E, 0x33, 0x33, 0x6E, 0x00 },  // U+0064 'd'
+    .{ 0x00, 0x00, 0x1E, 0x33, 0x3F, 0x03, 0x1E, 0x00 },  // U+0065 'e'
+    .{ 0x1C, 0x36, 0x06, 0x0F, 0x06, 0x06, 0x0F, 0x00 },  // U+0066 'f'
+    .{ 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x1F },  // U+0067 'g'
+    .{ 0x07, 0x06, 0x36, 0x6E, 0x66, 0x66, 0x67, 0x00 },  // U+0068 'h'
+    .{ 0x0C, 0x00, 0x0E, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },  // U+0069 'i'
+    .{ 0x30, 0x00, 0x30, 0x30, 0x30, 0x33, 0x33, 0x1E },  // U+006A 'j'
+    .{ 0x07, 0x06, 0x66, 0x36, 0x1E, 0x36, 0x67, 0x00 },  // U+006B 'k'
+    .{ 0x0E, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x1E, 0x00 },  // U+006C 'l'
+    .{ 0x00, 0x00, 0x33, 0x7F, 0x7F, 0x6B, 0x63, 0x00 },  // U+006D 'm'
+    .{ 0x00, 0x00, 0x1F, 0x33, 0x33, 0x33, 0x33, 0x00 },  // U+006E 'n'
+    .{ 0x00, 0x00, 0x1E, 0x33, 0x33, 0x33, 0x1E, 0x00 },  // U+006F 'o'
+    .{ 0x00, 0x00, 0x3B, 0x66, 0x66, 0x3E, 0x06, 0x0F },  // U+0070 'p'
+    .{ 0x00, 0x00, 0x6E, 0x33, 0x33, 0x3E, 0x30, 0x78 },  // U+0071 'q'
+    .{ 0x00, 0x00, 0x3B, 0x6E, 0x66, 0x06, 0x0F, 0x00 },  // U+0072 'r'
+    .{ 0x00, 0x00, 0x3E, 0x03, 0x1E, 0x30, 0x1F, 0x00 },  // U+0073 's'
+    .{ 0x08, 0x0C, 0x3E, 0x0C, 0x0C, 0x2C, 0x18, 0x00 },  // U+0074 't'
+    .{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x33, 0x6E, 0x00 },  // U+0075 'u'
+    .{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x1E, 0x0C, 0x00 },  // U+0076 'v'
+    .{ 0x00, 0x00, 0x63, 0x6B, 0x7F, 0x7F, 0x36, 0x00 },  // U+0077 'w'
+    .{ 0x00, 0x00, 0x63, 0x36, 0x1C, 0x36, 0x63, 0x00 },  // U+0078 'x'
+    .{ 0x00, 0x00, 0x33, 0x33, 0x33, 0x3E, 0x30, 0x1F },  // U+0079 'y'
+    .{ 0x00, 0x00, 0x3F, 0x19, 0x0C, 0x26, 0x3F, 0x00 },  // U+007A 'z'
+    .{ 0x38, 0x0C, 0x0C, 0x07, 0x0C, 0x0C, 0x38, 0x00 },  // U+007B '{'
+    .{ 0x18, 0x18, 0x18, 0x00, 0x18, 0x18, 0x18, 0x00 },  // U+007C '|'
+    .{ 0x07, 0x0C, 0x0C, 0x38, 0x0C, 0x0C, 0x07, 0x00 },  // U+007D '}'
+    .{ 0x6E, 0x3B, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // U+007E '~'
+};
+
+// Font must cover Printable ASCII
+comptime{ assert(font8x8.len == 0x7F - FIRST_CHAR); }
+
+/// Aliases for Zig Standard Library
+const assert = std.debug.assert;
+const debug  = std.log.debug;
@@ -0,0 +1,376 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! Hardware Cursor for Apache NuttX RTOS on PinePhone.
+//! Dedicates UI Channel 3 (Blender Pipe 2) to a small ARGB 8888 Sprite, like
+//! a Pointer. The Sprite is copied once by `cursor_init`. After that,
+//! `cursor_move` only rewrites the Blender Input Offset and latches it with
+//! GLB_DBUFFER, so moving the Cursor draws no pixels at all. At the edges of
+//! the Screen we clip the Sprite by advancing its Start Address and shrinking
+//! its Size, because the Blender won't take negative coordinates.
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Import the Register Access Module
+const mmio = @import("./mmio.zig");
+
+/// Import the Display Engine Module, for the Panel Size and the Reserved Overlay
+const render = @import("./render.zig");
+
+/// Import the Parallel Rendering Module, for flushing the Data Cache
+const parallel = @import("./parallel.zig");
+
+/// Import the Dynamic Refresh Rate Module
+const refresh = @import("./refresh.zig");
+
+/// Import the Atomic Plane Commits Module
+const planes = @import("./planes.zig");
+
+/// Import NuttX Functions from C
+const c = @cImport({
+    // NuttX Defines
+    @cDefine("__NuttX__",  "");
+    @cDefine("NDEBUG",     "");
+    @cDefine("FAR",        "");
+
+    // NuttX Header Files
+    @cInclude("arch/types.h");
+    @cInclude("../../nuttx/include/limits.h");
+    @cInclude("nuttx/config.h");
+    @cInclude("errno.h");
+});
+
+/// Maximum Size of the Cursor Image (pixels)
+pub const MAX_WIDTH  = 64;
+pub const MAX_HEIGHT = 64;
+
+/// Cursor Image in ARGB 8888 with Pixel Alpha, MAX_WIDTH pixels per Row
+var fbCursor align(0x1000) = std.mem.zeroes([MAX_WIDTH * MAX_HEIGHT] u32);
+
+/// Size of the Cursor Image (pixels), set by cursor_init
+var cursorWidth:  i32 = 0;
+var cursorHeight: i32 = 0;
+
+/// Load the Cursor Image and show it at the top left of the Screen on UI Channel 3,
+/// replacing the Second Overlay. `image` is ARGB 8888, `width` pixels per Row.
+/// The Second Overlay is reserved for the Cursor: 2D Graphics Operations, Transparency
+/// and Atomic Commits will no longer touch it.
+/// Call this after `renderGraphics`. Returns 0 if OK, or -EINVAL if the Image is too big.
+pub export fn cursor_init(
+    image: [*c]const u32,  // Cursor Image (ARGB 8888)
+    width: c_int,          // Width of the Cursor Image (pixels)
+    height: c_int          // Height of the Cursor Image (pixels)
+) c_int {
+    debug("cursor_init: start, width={}, height={}", .{ width, height });
+    defer { debug("cursor_init: end", .{}); }
+    if (image == null or
+        width  <= 0 or width  > MAX_WIDTH or
+        height <= 0 or height > MAX_HEIGHT) { return -c.EINVAL; }
+
+    // Copy the Image into the Cursor Framebuffer and flush it for the Display Engine
+    const w = @intCast(usize, width);
+    const h = @intCast(usize, height);
+    std.mem.set(u32, &fbCursor, 0);
+    var y: usize = 0;
+    while (y < h) : (y += 1) {
+        std.mem.copy(u32, fbCursor[(y * MAX_WIDTH)..][0..w], image[(y * w)..((y + 1) * w)]);
+    }
+    parallel.flushBand(&fbCursor);
+    render.reserveOverlay(render.CURSOR_OVERLAY);
+    cursorWidth  = width;
+    cursorHeight = height;
+
+    // Set Overlay: ARGB 8888, Pixel Alpha, Enable Layer.
+    // Pitch is fixed, because clipping only moves the Start Address.
+    // Scaler is disabled, Blender uses Source-Over like the other Pipes.
+    mmio.commit(&.{
+        OVL_UI_ATTR_CTL.init(.{
+            .LAY_EN         = 1,  // Enable Layer
+            .LAY_ALPHA_MODE = 0,  // Pixel Alpha
+            .LAY_FBFMT      = 0,  // ARGB 8888
+            .LAY_GLBALPHA   = 0xFF,
+        }),
+        OVL_UI_PITCH.init(.{ .PITCH = MAX_WIDTH * 4 }),
+        OVL_UI_COOR.init(.{}),
+        BLD_FILL_COLOR.init(.{ .ALPHA = 0xFF }),
+        BLD_CTL.init(.{
+            .BLEND_PFS = 1,  // Coefficient for source pixel data F[s] is 1
+            .BLEND_PFD = 3,  // Coefficient for destination pixel data F[d] is 1-A[s]
+            .BLEND_AFS = 1,  // Coefficient for source alpha data Q[s] is 1
+            .BLEND_AFD = 3,  // Coefficient for destination alpha data Q[d] is 1-A[s]
+        }),
+        UIS_CTRL_REG.init(.{ .EN = 0 }),
+        BLD_CH_RTCTL.set(.{ .P2_RTCTL = 3 }),  // Pipe 2 from UI Channel 3
+    });
+
+    // Program the whole Window, then apply the settings
+    window = clip(0, 0);
+    writeWindow(window, null);
+    latch();
+    return c.OK;
+}
+
+/// Move the top left of the Cursor to (x, y) on the Screen. The Cursor may lie partly
+/// or entirely outside the Screen. Takes effect at the next Vertical Blanking.
+/// While the Cursor is fully inside the Screen, this costs 2 Register Writes.
+pub export fn cursor_move(
+    x: c_int,  // Column, may be negative
+    y: c_int   // Row, may be negative
+) void {
+    if (cursorWidth == 0) { return; }
+    const next = clip(x, y);
+    if (std.meta.eql(next, window)) { return; }
+    writeWindow(next, window);
+    window = next;
+    latch();
+    refresh.refresh_activity();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Clipping
+
+/// Part of the Cursor that's visible on the Screen, in the Register Values for the Display Engine
+const Window = struct {
+    visible: bool,  // False if the Cursor is entirely outside the Screen
+    ladd:   u32,    // Address of the first Visible Pixel in the Cursor Framebuffer
+    size:   Size,   // Visible Width and Height
+    offset: Coord,  // Position of the first Visible Pixel on the Screen
+};
+
+/// Window last written to the Display Engine
+var window = Window { .visible = false, .ladd = 0, .size = .{}, .offset = .{} };
+
+/// Clip the Cursor at (x, y) to the Screen
+fn clip(x: i32, y: i32) Window {
+    const x0 = std.math.max(x, 0);
+    const y0 = std.math.max(y, 0);
+    const x1 = std.math.min(x +| cursorWidth,  render.PANEL_WIDTH);
+    const y1 = std.math.min(y +| cursorHeight, render.PANEL_HEIGHT);
+    if (x1 <= x0 or y1 <= y0) {
+        // Keep the last Window, so that only the Pipe is disabled
+        var hidden = window;
+        hidden.visible = false;
+        return hidden;
+    }
+
+    // Skip the Rows and Columns that are above or left of the Screen
+    const skip = @intCast(usize, y0 - y) * MAX_WIDTH + @intCast(usize, x0 - x);
+    return Window {
+        .visible = true,
+        .ladd    = @intCast(u32, @ptrToInt(&fbCursor[skip])),
+        .size    = .{ .WIDTH  = @intCast(u13, x1 - x0 - 1), .HEIGHT = @intCast(u13, y1 - y0 - 1) },
+        .offset  = .{ .XCOOR  = @intCast(u16, x0), .YCOOR = @intCast(u16, y0) },
+    };
+}
+
+/// Write the Registers that differ from the `old` Window, or all Registers if `old` is null
+fn writeWindow(new: Window, old: ?Window) void {
+    if (new.visible) {
+        if (old == null or new.ladd != old.?.ladd) {
+            OVL_UI_TOP_LADD.write(.{ .LADD = new.ladd });
+        }
+        if (old == null or !std.meta.eql(new.size, old.?.size)) {
+            OVL_UI_MBSIZE.write(new.size);
+            OVL_UI_SIZE.write(new.size);
+            BLD_CH_ISIZE.write(new.size);
+        }
+        if (old == null or !std.meta.eql(new.offset, old.?.offset)) {
+            BLD_CH_OFFSET.write(new.offset);
+        }
+    }
+    if (old == null or new.visible != old.?.visible) {
+        // Enable or disable Pipe 2
+        if (new.visible) {
+            mmio.commit(&.{ BLD_FILL_COLOR_CTL.set(.{ .P2_EN = 1 }) });
+        } else {
+            mmio.commit(&.{ BLD_FILL_COLOR_CTL.set(.{ .P2_EN = 0 }) });
+        }
+    }
+}
+
+/// Apply the Settings at the next Vertical Blanking
+fn latch() void {
+    mmio.commit(&.{ GLB_DBUFFER.init(.{ .DOUBLE_BUFFER_RDY = 1 }) });  // TODO: DMB
+    planes.invalidate();  // UI Channel 3 is no longer as committed
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Display Engine Registers for UI Channel 3 and Blender Pipe 2
+
+/// Width and Height minus 1, for OVL_UI_MBSIZE, OVL_UI_SIZE and BLD_CH_ISIZE
+const Size = packed struct {
+    WIDTH:  u13 = 0,  // Bits 0 to 12: Width - 1
+    _13:    u3  = 0,
+    HEIGHT: u13 = 0,  // Bits 16 to 28: Height - 1
+    _29:    u3  = 0,
+};
+
+/// Screen Position, for BLD_CH_OFFSET
+const Coord = packed struct {
+    XCOOR: u16 = 0,  // Bits 0 to 15
+    YCOOR: u16 = 0,  // Bits 16 to 31
+};
+
+/// OVL_UI(CH3) (UI Overlay 3) is at MIXER0 Offset 0x5000 (DE Page 102, 0x110 5000)
+const OVL_UI_CH3_BASE_ADDRESS = 0x110_5000;
+
+/// BLD (Blender) is at MIXER0 Offset 0x1000 (DE Page 90, 0x110 1000)
+const BLD_BASE_ADDRESS = 0x110_1000;
+
+/// Blender Pipe 2 takes UI Channel 3
+const PIPE = 2;
+
+/// OVL_UI_ATTR_CTL: OVL_UI Offset 0x00 (DE Page 102, 0x110 5000)
+const OVL_UI_ATTR_CTL = mmio.Register(packed struct {
+    LAY_EN:         u1 = 0,  // Bit 0
+    LAY_ALPHA_MODE: u2 = 0,  // Bits 1 to 2
+    _3:             u5 = 0,
+    LAY_FBFMT:      u5 = 0,  // Bits 8 to 12
+    _13:            u11 = 0,
+    LAY_GLBALPHA:   u8 = 0,  // Bits 24 to 31
+}, OVL_UI_CH3_BASE_ADDRESS + 0x00);
+
+/// OVL_UI_MBSIZE: OVL_UI Offset 0x04 (DE Page 104, 0x110 5004)
+const OVL_UI_MBSIZE = mmio.Register(Size, OVL_UI_CH3_BASE_ADDRESS + 0x04);
+
+/// OVL_UI_COOR: OVL_UI Offset 0x08 (DE Page 104, 0x110 5008)
+const OVL_UI_COOR = mmio.Register(Coord, OVL_UI_CH3_BASE_ADDRESS + 0x08);
+
+/// OVL_UI_PITCH: OVL_UI Offset 0x0C (DE Page 104, 0x110 500C)
+const OVL_UI_PITCH = mmio.Register(packed struct {
+    PITCH: u32 = 0,  // Bytes per Row
+}, OVL_UI_CH3_BASE_ADDRESS + 0x0C);
+
+/// OVL_UI_TOP_LADD: OVL_UI Offset 0x10 (DE Page 104, 0x110 5010)
+const OVL_UI_TOP_LADD = mmio.Register(packed struct {
+    LADD: u32 = 0,  // Start Address
+}, OVL_UI_CH3_BASE_ADDRESS + 0x10);
+
+/// OVL_UI_SIZE: OVL_UI Offset 0x88 (DE Page 106, 0x110 5088)
+const OVL_UI_SIZE = mmio.Register(Size, OVL_UI_CH3_BASE_ADDRESS + 0x88);
+
+/// BLD_FILL_COLOR_CTL: BLD Offset 0x000 (DE Page 106, 0x110 1000)
+const BLD_FILL_COLOR_CTL = mmio.Register(packed struct {
+    P0_FCEN: u1 = 0,  // Bit 0
+    P1_FCEN: u1 = 0,  // Bit 1
+    P2_FCEN: u1 = 0,  // Bit 2
+    P3_FCEN: u1 = 0,  // Bit 3
+    P4_FCEN: u1 = 0,  // Bit 4
+    _5:      u3 = 0,
+    P0_EN:   u1 = 0,  // Bit 8
+    P1_EN:   u1 = 0,  // Bit 9
+    P2_EN:   u1 = 0,  // Bit 10
+    P3_EN:   u1 = 0,  // Bit 11
+    P4_EN:   u1 = 0,  // Bit 12
+    _13:     u19 = 0,
+}, BLD_BASE_ADDRESS + 0x000);
+
+/// BLD_FILL_COLOR: BLD Offset 0x004 + N*0x10 (DE Page 107, 0x110 1024)
+const BLD_FILL_COLOR = mmio.Register(packed struct {
+    BLUE:  u8 = 0,  // Bits 0 to 7
+    GREEN: u8 = 0,  // Bits 8 to 15
+    RED:   u8 = 0,  // Bits 16 to 23
+    ALPHA: u8 = 0,  // Bits 24 to 31
+}, BLD_BASE_ADDRESS + 0x004 + PIPE * 0x10);
+
+/// BLD_CH_ISIZE: BLD Offset 0x008 + N*0x10 (DE Page 108, 0x110 1028)
+const BLD_CH_ISIZE = mmio.Register(Size, BLD_BASE_ADDRESS + 0x008 + PIPE * 0x10);
+
+/// BLD_CH_OFFSET: BLD Offset 0x00C + N*0x10 (DE Page 108, 0x110 102C)
+const BLD_CH_OFFSET = mmio.Register(Coord, BLD_BASE_ADDRESS + 0x00C + PIPE * 0x10);
+
+/// BLD_CH_RTCTL: BLD Offset 0x080 (DE Page 108, 0x110 1080)
+const BLD_CH_RTCTL = mmio.Register(packed struct {
+    P0_RTCTL: u4 = 0,  // Bits 0 to 3
+    P1_RTCTL: u4 = 0,  // Bits 4 to 7
+    P2_RTCTL: u4 = 0,  // Bits 8 to 11
+    P3_RTCTL: u4 = 0,  // Bits 12 to 15
+    _16:      u16 = 0,
+}, BLD_BASE_ADDRESS + 0x080);
+
+/// BLD_CTL: BLD Offset 0x090 + N*4 (DE Page 110, 0x110 1098)
+const BLD_CTL = mmio.Register(packed struct {
+    BLEND_PFS: u4 = 0,  // Bits 0 to 3
+    _4:        u4 = 0,
+    BLEND_PFD: u4 = 0,  // Bits 8 to 11
+    _12:       u4 = 0,
+    BLEND_AFS: u4 = 0,  // Bits 16 to 19
+    _20:       u4 = 0,
+    BLEND_AFD: u4 = 0,  // Bits 24 to 27
+    _28:       u4 = 0,
+}, BLD_BASE_ADDRESS + 0x090 + PIPE * 4);
+
+/// UIS_CTRL_REG: UI_SCALER3(CH3) Offset 0 (DE Page 66, 0x116 0000)
+const UIS_CTRL_REG = mmio.Register(packed struct {
+    EN:  u1  = 0,  // Bit 0
+    _1:  u31 = 0,
+}, 0x116_0000);
+
+/// GLB_DBUFFER: GLB Offset 0x008 (DE Page 93, 0x110 0008)
+const GLB_DBUFFER = mmio.Register(packed struct {
+    DOUBLE_BUFFER_RDY: u1  = 0,  // Bit 0
+    _1:                u31 = 0,
+}, 0x110_0008);
+
+comptime {
+    assert(OVL_UI_TOP_LADD.addr == 0x110_5010);
+    assert(OVL_UI_SIZE.addr     == 0x110_5088);
+    assert(BLD_FILL_COLOR.addr  == 0x110_1024);
+    assert(BLD_CH_ISIZE.addr    == 0x110_1028);
+    assert(BLD_CH_OFFSET.addr   == 0x110_102C);
+    assert(BLD_CTL.addr         == 0x110_1098);
+    assert(BLD_CTL.init(.{ .BLEND_PFS = 1, .BLEND_PFD = 3, .BLEND_AFS = 1, .BLEND_AFD = 3 }).val == 0x0301_0301);
+    assert(OVL_UI_ATTR_CTL.init(.{ .LAY_EN = 1, .LAY_GLBALPHA = 0xFF }).val == 0xFF00_0001);
+    assert(BLD_FILL_COLOR_CTL.set(.{ .P2_EN = 1 }).mask == 1 << 10);
+    assert(BLD_CH_RTCTL.set(.{ .P2_RTCTL = 3 }).val == 0x300);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Cursor Images
+
+/// Arrow Pointer, 16 x 24 pixels: White with Black Outline on Transparent (ARGB 8888)
+pub const ARROW_WIDTH  = 16;
+pub const ARROW_HEIGHT = 24;
+pub const arrow = blk: {
+    @setEvalBranchQuota(10_000);
+    var img = std.mem.zeroes([ARROW_WIDTH * ARROW_HEIGHT] u32);
+    var y: usize = 0;
+    while (y < ARROW_HEIGHT) : (y += 1) {
+        // Triangle that widens by 1 pixel per Row, up to Row 16
+        const span = if (y < ARROW_WIDTH) y + 1 else 0;
+        var x: usize = 0;
+        while (x < span) : (x += 1) {
+            const edge = (x == 0 or x == span - 1 or y == ARROW_WIDTH - 1);
+            img[y * ARROW_WIDTH + x] = if (edge) 0xFF00_0000 else 0xFFFF_FFFF;
+        }
+        // Tail of the Arrow below the Triangle
+        if (y >= ARROW_WIDTH) {
+            img[y * ARROW_WIDTH + 5] = 0xFF00_0000;
+            img[y * ARROW_WIDTH + 6] = 0xFFFF_FFFF;
+            img[y * ARROW_WIDTH + 7] = 0xFFFF_FFFF;
+            img[y * ARROW_WIDTH + 8] = 0xFF00_0000;
+        }
+    }
+    break :blk img;
+};
+
+/// Aliases for Zig Standard Library
+const assert = std.debug.assert;
+const debug  = std.log.debug;
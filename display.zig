@@ -26,6 +26,15 @@
 /// Import the Zig Standard Library
 const std = @import("std");
 
+/// Import the Register Access Module
+const mmio = @import("./mmio.zig");
+
+/// Import the Readiness Waits Module
+const ready = @import("./ready.zig");
+
+/// Import the Monotonic Clock Module
+const clock = @import("./clock.zig");
+
 /// Import NuttX Functions from C
 const c = @cImport({
     // NuttX Defines
@@ -41,13 +50,14 @@ const c = @cImport({
     @cInclude("unistd.h");
     @cInclude("stdlib.h");
     @cInclude("stdio.h");
+    @cInclude("errno.h");
 });
 
 ///////////////////////////////////////////////////////////////////////////////
 //  MIPI DSI Long and Short Packets
 
 // Compose MIPI DSI Long Packet. See https://lupyuen.github.io/articles/dsi#long-packet-for-mipi-dsi
-fn composeLongPacket(
+pub fn composeLongPacket(
     pkt: []u8,    // Buffer for the Returned Long Packet
     channel: u8,  // Virtual Channel ID
     cmd: u8,      // DCS Command
@@ -113,7 +123,7 @@ fn composeLongPacket(
 }
 
 // Compose MIPI DSI Short Packet. See https://lupyuen.github.io/articles/dsi#appendix-short-packet-for-mipi-dsi
-fn composeShortPacket(
+pub fn composeShortPacket(
     pkt: []u8,    // Buffer for the Returned Short Packet
     channel: u8,  // Virtual Channel ID
     cmd: u8,      // DCS Command
@@ -169,53 +179,229 @@ fn composeShortPacket(
     return result;
 }
 
+/// Compose the Packet Header (4 bytes) as a 32-bit Word (little endian):
+/// Data Identifier + Word Count (or 2 bytes of Data) + Error Correction Code
+pub fn packetHeader(
+    channel: u8,  // Virtual Channel ID
+    cmd: u8,      // DCS Command
+    b1: u8,       // Word Count (Low Byte) or First Data Byte
+    b2: u8        // Word Count (High Byte) or Second Data Byte
+) u32 {
+    assert(channel < 4);
+    assert(cmd < (1 << 6));
+    const di_wc = [3]u8 { (channel << 6) | cmd, b1, b2 };
+    const ecc = computeEcc(di_wc);
+    return @intCast(u32, di_wc[0])
+        | (@intCast(u32, b1)  << 8)
+        | (@intCast(u32, b2)  << 16)
+        | (@intCast(u32, ecc) << 24);
+}
+
+/// Stream a MIPI DSI Long Packet as 32-bit Words (little endian) to `writeWord`, without
+/// a Packet Buffer. The Payload is `prefix` followed by `payload`. The CRC is computed
+/// while the Payload is packed into Words. Returns the Packet Length in bytes.
+pub fn streamLongPacket(
+    comptime writeWord: fn (word: u32, index: usize) void,  // Writes Word `index` of the Packet
+    channel: u8,  // Virtual Channel ID
+    cmd: u8,      // DCS Command
+    prefix: []const u8,  // Start of Payload (may be empty)
+    payload: []const u8  // Rest of Payload
+) usize {
+    debug("streamLongPacket: channel={}, cmd=0x{x}, len={}", .{ channel, cmd, prefix.len + payload.len });
+    const len = prefix.len + payload.len;
+    assert(len <= 65_535);
+
+    // Packet Header (4 bytes): Data Identifier + Word Count + ECC
+    writeWord(packetHeader(channel, cmd, @truncate(u8, len), @truncate(u8, len >> 8)), 0);
+
+    // Packet Payload, followed by Packet Footer (2 bytes): Checksum of the Payload
+    var packer = WordPacker(writeWord) { .index = 1 };
+    packer.write(prefix);
+    packer.write(payload);
+    packer.finish();
+    return 4 + len + 2;
+}
+
+/// Stream a MIPI DSI Short Packet (4 bytes) as a 32-bit Word to `writeWord`.
+/// Returns the Packet Length in bytes.
+pub fn streamShortPacket(
+    comptime writeWord: fn (word: u32, index: usize) void,  // Writes Word `index` of the Packet
+    channel: u8,  // Virtual Channel ID
+    cmd: u8,      // DCS Command
+    buf: []const u8  // 1 or 2 bytes of Data
+) usize {
+    debug("streamShortPacket: channel={}, cmd=0x{x}, len={}", .{ channel, cmd, buf.len });
+    assert(buf.len == 1 or buf.len == 2);
+    writeWord(packetHeader(channel, cmd, buf[0], if (buf.len == 2) buf[1] else 0), 0);
+    return 4;
+}
+
+/// Packs the Payload bytes into 32-bit Words (little endian) and computes the CRC.
+/// Whole Words are packed directly when the Payload is aligned to a Word.
+fn WordPacker(comptime writeWord: fn (word: u32, index: usize) void) type {
+    return struct {
+        index: usize,         // Index of the next Word in the Packet
+        word: u32 = 0,        // Word being packed
+        nbytes: usize = 0,    // Number of bytes in `word`
+        crc: u16 = 0xffff,    // CRC-16-CCITT of the Payload so far
+
+        /// Pack the bytes
+        fn write(self: *@This(), data: []const u8) void {
+            var i: usize = 0;
+            if (self.nbytes == 0) {
+                while (i + 4 <= data.len) : (i += 4) {
+                    const bytes = data[i..][0..4];
+                    self.crc = crc16ccitt(bytes, self.crc);
+                    writeWord(std.mem.readIntLittle(u32, bytes), self.index);
+                    self.index += 1;
+                }
+            }
+            while (i < data.len) : (i += 1) {
+                self.crc = crc16ccitt(data[i..(i + 1)], self.crc);
+                self.putByte(data[i]);
+            }
+        }
+
+        /// Append the Checksum and write the last Word, filled with 0
+        fn finish(self: *@This()) void {
+            const cs = self.crc;
+            self.putByte(@truncate(u8, cs));
+            self.putByte(@truncate(u8, cs >> 8));
+            if (self.nbytes > 0) {
+                writeWord(self.word, self.index);
+                self.index += 1;
+            }
+        }
+
+        /// Pack a byte, write the Word when full
+        fn putByte(self: *@This(), b: u8) void {
+            self.word |= @intCast(u32, b) << @intCast(u5, self.nbytes * 8);
+            self.nbytes += 1;
+            if (self.nbytes == 4) {
+                writeWord(self.word, self.index);
+                self.index += 1;
+                self.word = 0;
+                self.nbytes = 0;
+            }
+        }
+    };
+}
+
+/// MIPI DSI Packet as Transmit FIFO Words (little endian), filled with 0
+pub const FifoPacket = struct {
+    words: [TX_FIFO_WORDS]u32,  // FIFO Words
+    len: usize,                 // Packet Length in bytes
+};
+
+/// Compose the DCS Write Packet for `buf` as Transmit FIFO Words at Compile Time:
+/// Short Packet for 1 or 2 bytes, Long Packet otherwise
+pub fn composeFifoPacket(comptime buf: []const u8) FifoPacket {
+    comptime {
+        assert(buf.len > 0 and buf.len <= MAX_LONG_PAYLOAD);
+        var pkt = FifoPacket { .words = std.mem.zeroes([TX_FIFO_WORDS]u32), .len = 0 };
+        switch (buf.len) {
+            // DCS Short Write (without and with parameter)
+            1, 2 => {
+                const cmd = if (buf.len == 1) MIPI_DSI_DCS_SHORT_WRITE else MIPI_DSI_DCS_SHORT_WRITE_PARAM;
+                pkt.words[0] = packetHeader(VIRTUAL_CHANNEL, cmd, buf[0], if (buf.len == 2) buf[1] else 0);
+                pkt.len = 4;
+            },
+            // DCS Long Write: Header, Payload, then Checksum
+            else => {
+                pkt.words[0] = packetHeader(VIRTUAL_CHANNEL, MIPI_DSI_DCS_LONG_WRITE, buf.len & 0xff, buf.len >> 8);
+                for (buf) |b, i| {
+                    pkt.words[1 + i / 4] |= @intCast(u32, b) << ((i % 4) * 8);
+                }
+                const cs = crc16ccitt(buf, 0xffff);
+                const footer = [2]u8 { cs & 0xff, cs >> 8 };
+                for (footer) |b, j| {
+                    const i = buf.len + j;
+                    pkt.words[1 + i / 4] |= @intCast(u32, b) << ((i % 4) * 8);
+                }
+                pkt.len = 4 + buf.len + footer.len;
+            },
+        }
+        return pkt;
+    }
+}
+
 /// Compute the Error Correction Code (ECC) (1 byte):
 /// Allow single-bit errors to be corrected and 2-bit errors to be detected in the Packet Header
 /// See "12.3.6.12: Error Correction Code", Page 208 of BL808 Reference Manual:
 /// https://files.pine64.org/doc/datasheet/ox64/BL808_RM_en_1.0(open).pdf
-fn computeEcc(
+pub fn computeEcc(
     di_wc: [3]u8  // Data Identifier + Word Count (3 bytes)
 ) u8 {
     // Combine DI and WC into a 24-bit word
-    var di_wc_word: u32 = 
-        di_wc[0] 
+    const di_wc_word: u32 =
+        di_wc[0]
         | (@intCast(u32, di_wc[1]) << 8)
         | (@intCast(u32, di_wc[2]) << 16);
 
-    // Extract the 24 bits from the word
-    var d = std.mem.zeroes([24]u1);
-    var i: usize = 0;
-    while (i < 24) : (i += 1) {
-        d[i] = @intCast(u1, di_wc_word & 1);
-        di_wc_word >>= 1;
+    // Each ECC bit is the Parity (XOR) of the Data Bits selected by its mask,
+    // ECC bits 6 and 7 are always 0:
+    // ecc[0] = d[0]^d[1]^d[2]^d[4]^d[5]^d[7]^d[10]^d[11]^d[13]^d[16]^d[20]^d[21]^d[22]^d[23]
+    // ecc[1] = d[0]^d[1]^d[3]^d[4]^d[6]^d[8]^d[10]^d[12]^d[14]^d[17]^d[20]^d[21]^d[22]^d[23]
+    // ecc[2] = d[0]^d[2]^d[3]^d[5]^d[6]^d[9]^d[11]^d[12]^d[15]^d[18]^d[20]^d[21]^d[22]
+    // ecc[3] = d[1]^d[2]^d[3]^d[7]^d[8]^d[9]^d[13]^d[14]^d[15]^d[19]^d[20]^d[21]^d[23]
+    // ecc[4] = d[4]^d[5]^d[6]^d[7]^d[8]^d[9]^d[16]^d[17]^d[18]^d[19]^d[20]^d[22]^d[23]
+    // ecc[5] = d[10]^d[11]^d[12]^d[13]^d[14]^d[15]^d[16]^d[17]^d[18]^d[19]^d[21]^d[22]^d[23]
+    var ecc: u8 = 0;
+    inline for (ecc_masks) |mask, i| {
+        const parity = @popCount(u32, di_wc_word & mask) & 1;
+        ecc |= @intCast(u8, parity) << i;
     }
+    return ecc;
+}
+
+/// Data Bits that are covered by ECC bits 0 to 5
+const ecc_masks = [6]u32 {
+    0xF1_2CB7, 0xF2_555B, 0x74_9A6D, 0xB8_E38E, 0xDF_03F0, 0xEF_FC00,
+};
 
-    // Compute the ECC bits
-    var ecc = std.mem.zeroes([8]u1);
-    ecc[7] = 0;
-    ecc[6] = 0;
-    ecc[5] = d[10] ^ d[11] ^ d[12] ^ d[13] ^ d[14] ^ d[15] ^ d[16] ^ d[17] ^ d[18] ^ d[19] ^ d[21] ^ d[22] ^ d[23];
-    ecc[4] = d[4]  ^ d[5]  ^ d[6]  ^ d[7]  ^ d[8]  ^ d[9]  ^ d[16] ^ d[17] ^ d[18] ^ d[19] ^ d[20] ^ d[22] ^ d[23];
-    ecc[3] = d[1]  ^ d[2]  ^ d[3]  ^ d[7]  ^ d[8]  ^ d[9]  ^ d[13] ^ d[14] ^ d[15] ^ d[19] ^ d[20] ^ d[21] ^ d[23];
-    ecc[2] = d[0]  ^ d[2]  ^ d[3]  ^ d[5]  ^ d[6]  ^ d[9]  ^ d[11] ^ d[12] ^ d[15] ^ d[18] ^ d[20] ^ d[21] ^ d[22];
-    ecc[1] = d[0]  ^ d[1]  ^ d[3]  ^ d[4]  ^ d[6]  ^ d[8]  ^ d[10] ^ d[12] ^ d[14] ^ d[17] ^ d[20] ^ d[21] ^ d[22] ^ d[23];
-    ecc[0] = d[0]  ^ d[1]  ^ d[2]  ^ d[4]  ^ d[5]  ^ d[7]  ^ d[10] ^ d[11] ^ d[13] ^ d[16] ^ d[20] ^ d[21] ^ d[22] ^ d[23];
-
-    // Merge the ECC bits
-    return @intCast(u8, ecc[0])
-        | (@intCast(u8, ecc[1]) << 1)
-        | (@intCast(u8, ecc[2]) << 2)
-        | (@intCast(u8, ecc[3]) << 3)
-        | (@intCast(u8, ecc[4]) << 4)
-        | (@intCast(u8, ecc[5]) << 5)
-        | (@intCast(u8, ecc[6]) << 6)
-        | (@intCast(u8, ecc[7]) << 7);
+/// Check the ECC of a Packet Header received from the Peripheral (4 bytes, little endian).
+/// Returns the Packet Header with a single-bit error corrected,
+/// or null if there are 2 or more bit errors.
+pub fn correctEcc(header: u32) ?u32 {
+    const di_wc = [3]u8 {
+        @truncate(u8, header),
+        @truncate(u8, header >> 8),
+        @truncate(u8, header >> 16),
+    };
+    const ecc = computeEcc(di_wc);
+    const syndrome = ecc ^ @truncate(u8, header >> 24);
+    const data = header & 0xff_ffff;
+
+    // No error, or a single-bit error in the ECC itself
+    if (syndrome == 0) { return header; }
+    if (@popCount(u8, syndrome) == 1) { return data | (@intCast(u32, ecc) << 24); }
+
+    // Single-bit error in the Data: The Syndrome identifies the Data Bit
+    for (ecc_syndromes) |s, bit| {
+        if (s == syndrome) {
+            const fixed = data ^ (@as(u32, 1) << @intCast(u5, bit));
+            return fixed | (@intCast(u32, ecc ^ syndrome) << 24);
+        }
+    }
+    return null;
 }
 
+/// ECC Syndrome for an error in each of the 24 Data Bits
+const ecc_syndromes = blk: {
+    var syndromes: [24]u8 = undefined;
+    for (syndromes) |*s, bit| {
+        s.* = 0;
+        for (ecc_masks) |mask, i| {
+            if ((mask >> bit) & 1 != 0) { s.* |= 1 << i; }
+        }
+    }
+    break :blk syndromes;
+};
+
 /// Compute 16-bit Cyclic Redundancy Check (CRC).
 /// See "12.3.6.13: Packet Footer", Page 210 of BL808 Reference Manual:
 /// https://files.pine64.org/doc/datasheet/ox64/BL808_RM_en_1.0(open).pdf
-fn computeCrc(
+pub fn computeCrc(
     data: []const u8
 ) u16 {
     // Use CRC-16-CCITT (x^16 + x^12 + x^5 + 1)
@@ -228,7 +414,7 @@ fn computeCrc(
 
 /// Return a 16-bit CRC-CCITT of the contents of the `src` buffer.
 /// Based on https://github.com/lupyuen/incubator-nuttx/blob/pinephone/libs/libc/misc/lib_crc16.c
-fn crc16ccitt(src: []const u8, crc16val: u16) u16 {
+pub fn crc16ccitt(src: []const u8, crc16val: u16) u16 {
     var i: usize = 0;
     var v = crc16val;
     while (i < src.len) : (i += 1) {
@@ -290,6 +476,28 @@ const MIPI_DSI_DCS_SHORT_WRITE = 0x05;
 /// DCS Short Write (With Parameter)
 const MIPI_DSI_DCS_SHORT_WRITE_PARAM = 0x15;
 
+/// DCS Read Request (Short Packet), answered by the Peripheral after Bus Turnaround
+const MIPI_DSI_DCS_READ = 0x06;
+
+/// Set Maximum Return Packet Size (Short Packet): Number of bytes that the
+/// Peripheral may return for the next Read Request
+const MIPI_DSI_SET_MAXIMUM_RETURN_PACKET_SIZE = 0x37;
+
+/// Peripheral-to-Processor transaction types, returned by a Read Request
+const MIPI_DSI_RX_ACKNOWLEDGE_AND_ERROR_REPORT = 0x02;
+const MIPI_DSI_RX_DCS_LONG_READ_RESPONSE       = 0x1C;
+const MIPI_DSI_RX_DCS_SHORT_READ_RESPONSE_1BYTE = 0x21;
+const MIPI_DSI_RX_DCS_SHORT_READ_RESPONSE_2BYTE = 0x22;
+
+/// DCS Commands for reading the Panel State
+const MIPI_DCS_GET_POWER_MODE  = 0x0A;
+const MIPI_DCS_READ_DISPLAY_ID = 0x04;
+
+/// DCS Commands for writing Display Memory. A Write Memory Start that's too big for
+/// the Transmit FIFO is split into Write Memory Continue Packets.
+const MIPI_DCS_WRITE_MEMORY_START    = 0x2C;
+const MIPI_DCS_WRITE_MEMORY_CONTINUE = 0x3C;
+
 /// Base Address of Allwinner A64 CCU Controller (A64 Page 82)
 const CCU_BASE_ADDRESS = 0x01C2_0000;
 
@@ -301,32 +509,29 @@ const DSI_BASE_ADDRESS = 0x01CA_0000;
 const DSI_BASIC_CTL0_REG = DSI_BASE_ADDRESS + 0x10;
 const Instru_En = 1 << 0;
 
-/// Write the DCS Command to MIPI DSI
-fn writeDcs(buf: []const u8) void {
-    debug("writeDcs: len={}", .{ buf.len });
-    dump_buffer(buf);
-    assert(buf.len > 0);
-
-    // Do DCS Short Write or Long Write depending on command length
-    const res = switch (buf.len) {
-
-        // DCS Short Write (without parameter)
-        1 => nuttx_mipi_dsi_dcs_write(null, VIRTUAL_CHANNEL, 
-            MIPI_DSI_DCS_SHORT_WRITE, 
-            &buf[0], buf.len),
-
-        // DCS Short Write (with parameter)
-        2 => nuttx_mipi_dsi_dcs_write(null, VIRTUAL_CHANNEL, 
-            MIPI_DSI_DCS_SHORT_WRITE_PARAM, 
-            &buf[0], buf.len),
-
-        // DCS Long Write
-        else => nuttx_mipi_dsi_dcs_write(null, VIRTUAL_CHANNEL, 
-            MIPI_DSI_DCS_LONG_WRITE, 
-            &buf[0], buf.len),
-    };
-    assert(res == buf.len);
-}
+/// DSI_CMD_CTL_REG (DSI Low Power Control Register) at Offset 0x200
+const DSI_CMD_CTL_REG = DSI_BASE_ADDRESS + 0x200;
+
+/// DSI_CMD_TX_REG (DSI Low Power Transmit Package Register) at Offset 0x300 to 0x3FC.
+/// The Transmit FIFO holds 64 Words (256 bytes), and TX_Size (8 bits) in DSI_CMD_CTL_REG
+/// allows a Packet to fill the entire FIFO.
+const DSI_CMD_TX_REG = DSI_BASE_ADDRESS + 0x300;
+pub const TX_FIFO_WORDS = 64;
+
+/// DSI_CMD_RX_REG (DSI Low Power Receive Package Register) at Offset 0x240 to 0x25C.
+/// The Receive FIFO holds 8 Words (32 bytes).
+const DSI_CMD_RX_REG = DSI_BASE_ADDRESS + 0x240;
+const RX_FIFO_WORDS = 8;
+
+/// DSI_BASIC_SIZE1_REG (Undocumented) at Offset 0x1c: Video_VT (Bits 16 to 28) is the
+/// Vertical Total (Lines per Frame) and Video_VACT (Bits 0 to 11) the Active Lines.
+/// VIDEO_VT gives 60 Hz, more Lines of Vertical Blanking give a lower Refresh Rate.
+pub const DSI_BASIC_SIZE1_REG = DSI_BASE_ADDRESS + 0x1c;
+pub const VIDEO_VT = 1485;
+
+/// Largest Payload of a Long Packet in the Transmit FIFO:
+/// 256 bytes minus Packet Header (4 bytes) and Packet Footer (2 bytes)
+pub const MAX_LONG_PAYLOAD = TX_FIFO_WORDS * 4 - 6;
 
 /// Write to MIPI DSI. See https://lupyuen.github.io/articles/dsi#transmit-packet-over-mipi-dsi
 pub export fn nuttx_mipi_dsi_dcs_write(
@@ -340,37 +545,96 @@ pub export fn nuttx_mipi_dsi_dcs_write(
     debug("mipi_dsi_dcs_write: channel={}, cmd=0x{x}, len={}", .{ channel, cmd, len });
     if (cmd == MIPI_DSI_DCS_SHORT_WRITE)       { assert(len == 1); }
     if (cmd == MIPI_DSI_DCS_SHORT_WRITE_PARAM) { assert(len == 2); }
+    const data = buf[0..len];
+
+    switch (cmd) {
+        // For DCS Long Write: Transmit Long Packet
+        MIPI_DSI_DCS_LONG_WRITE => {
+            // If the Long Packet fits in the Transmit FIFO, transmit it
+            if (len <= MAX_LONG_PAYLOAD) {
+                const res = transmitPacket(channel, cmd, &[0]u8 {}, data);
+                if (res < 0) { return res; }
+                return @intCast(isize, len);
+            }
 
-    // Allocate Packet Buffer
-    var pkt_buf = std.mem.zeroes([128]u8);
-
-    // Compose Short or Long Packet depending on DCS Command
-    const pkt = switch (cmd) {
-
-        // For DCS Long Write: Compose Long Packet
-        MIPI_DSI_DCS_LONG_WRITE =>
-            composeLongPacket(&pkt_buf, channel, cmd, buf, len),
+            // Otherwise we transmit in chunks: Only Write Memory may be split,
+            // by sending the rest of the pixels with Write Memory Continue
+            if (data[0] != MIPI_DCS_WRITE_MEMORY_START and
+                data[0] != MIPI_DCS_WRITE_MEMORY_CONTINUE) {
+                std.log.err("mipi_dsi_dcs_write: DCS Command 0x{x} too long, len={}", .{ data[0], len });
+                return -c.E2BIG;
+            }
+            var res = transmitPacket(channel, cmd, &[0]u8 {}, data[0..MAX_LONG_PAYLOAD]);
+            var offset: usize = MAX_LONG_PAYLOAD;
+            while (res >= 0 and offset < len) {
+                const n = std.math.min(len - offset, MAX_LONG_PAYLOAD - 1);
+                res = transmitPacket(channel, cmd,
+                    &[1]u8 { MIPI_DCS_WRITE_MEMORY_CONTINUE },
+                    data[offset..(offset + n)]);
+                offset += n;
+            }
+            if (res < 0) { return res; }
+        },
 
         // For DCS Short Write (with and without parameter):
-        // Compose Short Packet
+        // Transmit Short Packet
         MIPI_DSI_DCS_SHORT_WRITE,
-        MIPI_DSI_DCS_SHORT_WRITE_PARAM =>
-            composeShortPacket(&pkt_buf, channel, cmd, buf, len),
+        MIPI_DSI_DCS_SHORT_WRITE_PARAM => {
+            const res = transmitPacket(channel, cmd, &[0]u8 {}, data);
+            if (res < 0) { return res; }
+        },
 
         // DCS Command not supported
         else => unreachable,
+    }
+
+    // Return number of written bytes
+    return @intCast(isize, len);
+}
+
+/// Transmit a Short or Long Packet in Low Power Mode. The Packet is streamed into
+/// the Transmit FIFO, a Word at a time, without a Packet Buffer. For Long Packets,
+/// the Payload is `prefix` followed by `payload`.
+/// Returns 0 if transmitted, -1 if timeout.
+fn transmitPacket(
+    channel: u8,  // Virtual Channel ID
+    cmd: u8,      // DCS Command
+    prefix: []const u8,  // Start of Payload (may be empty)
+    payload: []const u8  // Rest of Payload, or Data for Short Packet
+) isize {
+    beginTransmit();
+
+    // Write the Packet to DSI_CMD_TX_REG 
+    // (DSI Low Power Transmit Package Register) at Offset 0x300 to 0x3FC
+    const pktlen = switch (cmd) {
+        MIPI_DSI_DCS_LONG_WRITE =>
+            streamLongPacket(writeTxFifo, channel, cmd, prefix, payload),
+        else =>
+            streamShortPacket(writeTxFifo, channel, cmd, payload),
     };
+    debug("packet: len={}", .{ pktlen });
+    return endTransmit(pktlen, false);
+}
 
-    // Dump the packet
-    debug("packet: len={}", .{ pkt.len });
-    dump_buffer(pkt);
+/// Transmit a Packet that was composed at Compile Time: Copy the FIFO Words
+/// to the Transmit FIFO and start the transmission.
+/// Returns 0 if transmitted, -1 if timeout.
+fn transmitFifoPacket(pkt: *const FifoPacket) isize {
+    beginTransmit();
+    const nwords = (pkt.len + 3) / 4;
+    for (pkt.words[0..nwords]) |word, i| {
+        writeTxFifo(word, i);
+    }
+    return endTransmit(pkt.len, false);
+}
 
+/// Prepare for transmitting a Packet in Low Power Mode
+fn beginTransmit() void {
     // Set the following bits to 1 in DSI_CMD_CTL_REG (DSI Low Power Control Register) at Offset 0x200:
     // RX_Overflow (Bit 26): Clear flag for "Receive Overflow"
     // RX_Flag (Bit 25): Clear flag for "Receive has started"
     // TX_Flag (Bit 9): Clear flag for "Transmit has started"
     // All other bits must be set to 0.
-    const DSI_CMD_CTL_REG = DSI_BASE_ADDRESS + 0x200;
     const RX_Overflow = 1 << 26;
     const RX_Flag     = 1 << 25;
     const TX_Flag     = 1 << 9;
@@ -378,49 +642,36 @@ pub export fn nuttx_mipi_dsi_dcs_write(
         RX_Overflow | RX_Flag | TX_Flag,
         DSI_CMD_CTL_REG
     );
+}
 
-    // Write the Long Packet to DSI_CMD_TX_REG 
-    // (DSI Low Power Transmit Package Register) at Offset 0x300 to 0x3FC
-    const DSI_CMD_TX_REG = DSI_BASE_ADDRESS + 0x300;
-    var addr: u64 = DSI_CMD_TX_REG;
-    var i: usize = 0;
-    while (i < pkt.len) : (i += 4) {
-        // Fetch the next 4 bytes, fill with 0 if not available
-        const b = [4]u32 {
-            pkt[i],
-            if (i + 1 < pkt.len) pkt[i + 1] else 0,
-            if (i + 2 < pkt.len) pkt[i + 2] else 0,
-            if (i + 3 < pkt.len) pkt[i + 3] else 0,
-        };
-
-        // Merge the next 4 bytes into a 32-bit value
-        const v: u32 =
-            b[0]
-            + (b[1] << 8)
-            + (b[2] << 16)
-            + (b[3] << 24);
-
-        // Write the 32-bit value
-        assert(addr <= DSI_BASE_ADDRESS + 0x3FC);
-        modreg32(v, 0xFFFF_FFFF, addr);  // TODO: DMB
-        addr += 4;
-    }
+/// Start transmitting the Packet in the Transmit FIFO and wait for it to complete.
+/// If `bta` is true, the Bus is turned around after the Packet, so that the
+/// Peripheral may respond to a Read Request.
+/// Returns 0 if transmitted, -1 if timeout.
+fn endTransmit(pktlen: usize, bta: bool) isize {
+    assert(pktlen <= TX_FIFO_WORDS * 4);
 
     // Set Packet Length - 1 in Bits 0 to 7 (TX_Size) of
     // DSI_CMD_CTL_REG (DSI Low Power Control Register) at Offset 0x200
-    modreg32(@intCast(u32, pkt.len) - 1, 0xFF, DSI_CMD_CTL_REG);  // TODO: DMB
+    modreg32(@intCast(u32, pktlen) - 1, 0xFF, DSI_CMD_CTL_REG);  // TODO: DMB
 
     // Set DSI_INST_JUMP_SEL_REG (Offset 0x48, undocumented) 
-    // to begin the Low Power Transmission (LPTX)
+    // to begin the Low Power Transmission (LPTX):
+    // LP11 jumps to LPDT, then LPDT jumps to END.
+    // For Bus Turnaround: LPDT jumps to TBA, then TBA jumps to END.
     const DSI_INST_JUMP_SEL_REG = DSI_BASE_ADDRESS + 0x48;
     const DSI_INST_ID_LPDT = 4;
     const DSI_INST_ID_LP11 = 0;
+    const DSI_INST_ID_TBA  = 1;
     const DSI_INST_ID_END  = 15;
-    putreg32(
+    const jump: u32 = if (bta)
         DSI_INST_ID_LPDT << (4 * DSI_INST_ID_LP11) |
-        DSI_INST_ID_END  << (4 * DSI_INST_ID_LPDT),
-        DSI_INST_JUMP_SEL_REG
-    );
+        DSI_INST_ID_TBA  << (4 * DSI_INST_ID_LPDT) |
+        DSI_INST_ID_END  << (4 * DSI_INST_ID_TBA)
+    else
+        DSI_INST_ID_LPDT << (4 * DSI_INST_ID_LP11) |
+        DSI_INST_ID_END  << (4 * DSI_INST_ID_LPDT);
+    putreg32(jump, DSI_INST_JUMP_SEL_REG);
 
     // Disable DSI Processing then Enable DSI Processing
     disableDsiProcessing();
@@ -432,9 +683,156 @@ pub export fn nuttx_mipi_dsi_dcs_write(
         disableDsiProcessing();
         return res;
     }
+    return 0;
+}
 
-    // Return number of written bytes
-    return @intCast(isize, len);
+/// Write Word `index` of the Packet to the Transmit FIFO
+fn writeTxFifo(word: u32, index: usize) void {
+    assert(index < TX_FIFO_WORDS);
+    putreg32(word, DSI_CMD_TX_REG + index * 4);  // TODO: DMB
+}
+
+/// Read from MIPI DSI: Send a DCS Read Request, turn the Bus around and
+/// decode the Response in the Receive FIFO. The Packet Header of the Response
+/// is checked with its ECC, and a single-bit error is corrected.
+/// Must be called while MIPI DSI is in Low Power Mode (before `start_dsi`).
+pub export fn nuttx_mipi_dsi_dcs_read(
+    dev: [*c]const mipi_dsi_device,  // MIPI DSI Host Device
+    channel: u8,  // Virtual Channel ID
+    cmd: u8,      // DCS Command, like MIPI_DCS_GET_POWER_MODE
+    buf: [*c]u8,  // Receive Buffer
+    len: usize    // Buffer Length
+) isize {  // On Success: Return number of read bytes. On Error: Return negative error code
+    _ = dev;
+    debug("mipi_dsi_dcs_read: channel={}, cmd=0x{x}, len={}", .{ channel, cmd, len });
+    assert(len > 0 and len <= (RX_FIFO_WORDS * 4) - 6);
+
+    // If we expect more than 1 byte, allow the Peripheral to return them
+    if (len > 1) {
+        const size = [2]u8 { @intCast(u8, len), 0 };
+        const res = transmitPacket(channel, MIPI_DSI_SET_MAXIMUM_RETURN_PACKET_SIZE, &[0]u8 {}, &size);
+        if (res < 0) { return res; }
+    }
+
+    // Send the DCS Read Request and turn the Bus around
+    beginTransmit();
+    writeTxFifo(packetHeader(channel, MIPI_DSI_DCS_READ, cmd, 0), 0);
+    const res = endTransmit(4, true);
+    if (res < 0) { return res; }
+
+    // Check RX_Flag (Bit 25) and RX_Overflow (Bit 26) of
+    // DSI_CMD_CTL_REG (DSI Low Power Control Register) at Offset 0x200
+    const ctl = getreg32(DSI_CMD_CTL_REG);
+    const RX_Overflow = 1 << 26;
+    const RX_Flag     = 1 << 25;
+    if ((ctl & RX_Flag) == 0 or (ctl & RX_Overflow) != 0) {
+        logError("mipi_dsi_dcs_read: no response, ctl=0x{x}", .{ ctl });
+        return -c.EIO;
+    }
+
+    // Check the Packet Header of the Response
+    const header = correctEcc(getreg32(DSI_CMD_RX_REG)) orelse {
+        logError("mipi_dsi_dcs_read: uncorrectable header", .{});
+        return -c.EIO;
+    };
+    const dt = @truncate(u8, header) & 0x3f;
+    const b1 = @truncate(u8, header >> 8);
+    const b2 = @truncate(u8, header >> 16);
+
+    switch (dt) {
+        // Peripheral reports an error
+        MIPI_DSI_RX_ACKNOWLEDGE_AND_ERROR_REPORT => {
+            logError("mipi_dsi_dcs_read: error report=0x{x}", .{ @intCast(u16, b2) << 8 | b1 });
+            return -c.EIO;
+        },
+
+        // Short Read Response: Data is in the Packet Header
+        MIPI_DSI_RX_DCS_SHORT_READ_RESPONSE_1BYTE => {
+            buf[0] = b1;
+            return 1;
+        },
+        MIPI_DSI_RX_DCS_SHORT_READ_RESPONSE_2BYTE => {
+            buf[0] = b1;
+            if (len > 1) { buf[1] = b2; }
+            return @intCast(isize, std.math.min(len, 2));
+        },
+
+        // Long Read Response: Payload and Checksum follow the Packet Header
+        MIPI_DSI_RX_DCS_LONG_READ_RESPONSE => {
+            const wc = @intCast(usize, b2) << 8 | b1;
+            if (wc + 6 > RX_FIFO_WORDS * 4) { return -c.EIO; }
+
+            // Fetch the Payload and Checksum from the Receive FIFO
+            var words: [RX_FIFO_WORDS - 1]u32 = undefined;
+            const nwords = (wc + 2 + 3) / 4;
+            for (words[0..nwords]) |*w, i| {
+                w.* = getreg32(DSI_CMD_RX_REG + (i + 1) * 4);
+            }
+            const bytes = std.mem.sliceAsBytes(words[0..nwords]);
+            const cs = @intCast(u16, bytes[wc + 1]) << 8 | bytes[wc];
+            if (computeCrc(bytes[0..wc]) != cs) {
+                logError("mipi_dsi_dcs_read: checksum error", .{});
+                return -c.EIO;
+            }
+            const n = std.math.min(len, wc);
+            std.mem.copy(u8, buf[0..n], bytes[0..n]);
+            return @intCast(isize, n);
+        },
+
+        else => {
+            logError("mipi_dsi_dcs_read: unknown response=0x{x}", .{ dt });
+            return -c.EIO;
+        },
+    }
+}
+
+/// Read the Power Mode of the Panel (DCS Get Power Mode).
+/// Returns the Power Mode, or null if the Panel didn't respond.
+pub fn getPowerMode() ?u8 {
+    var mode: [1]u8 = undefined;
+    const res = nuttx_mipi_dsi_dcs_read(null, VIRTUAL_CHANNEL, MIPI_DCS_GET_POWER_MODE, &mode, mode.len);
+    if (res != mode.len) { return null; }
+    return mode[0];
+}
+
+/// Read the Power Mode of the Panel like `getPowerMode`, while the Panel is starting up.
+/// Failed Reads are expected, so they are logged as Debug Messages instead of Errors.
+/// The Caller logs an Error if the Panel never answers.
+pub fn pollPowerMode() ?u8 {
+    polling = true;
+    defer { polling = false; }
+    return getPowerMode();
+}
+
+/// True while `pollPowerMode` is polling the Panel
+var polling = false;
+
+/// Log an Error in a MIPI DSI Transfer, or a Debug Message while polling the Panel
+fn logError(comptime format: []const u8, args: anytype) void {
+    if (polling) { debug(format, args); } else { std.log.err(format, args); }
+}
+
+/// Read the 3-byte Display ID of the Panel (DCS Read Display ID).
+/// Returns null if the Panel didn't respond.
+pub fn readDisplayId() ?[3]u8 {
+    var id: [3]u8 = undefined;
+    const res = nuttx_mipi_dsi_dcs_read(null, VIRTUAL_CHANNEL, MIPI_DCS_READ_DISPLAY_ID, &id, id.len);
+    if (res != id.len) { return null; }
+    return id;
+}
+
+/// Return true if the Panel is still configured by `panel_init`: Booster On,
+/// Sleep Out, Normal Mode and Display On, according to DCS Get Power Mode.
+/// Takes a few hundred microseconds, compared with 120 milliseconds for `panel_init`.
+pub export fn panel_is_configured() bool {
+    const BOOSTER_ON  = 1 << 7;
+    const SLEEP_OUT   = 1 << 4;
+    const NORMAL_MODE = 1 << 3;
+    const DISPLAY_ON  = 1 << 2;
+    const expected = BOOSTER_ON | SLEEP_OUT | NORMAL_MODE | DISPLAY_ON;
+    const mode = getPowerMode() orelse return false;
+    debug("panel_is_configured: power_mode=0x{x}", .{ mode });
+    return (mode & expected) == expected;
 }
 
 /// Wait for transmit to complete. Returns 0 if completed, -1 if timeout.
@@ -452,7 +850,7 @@ fn waitForTransmit() isize {
         _ = c.usleep(1);
     }
     // Return Timeout
-    std.log.err("waitForTransmit: timeout", .{});
+    logError("waitForTransmit: timeout", .{});
     return -1;
 }
 
@@ -468,61 +866,88 @@ fn enableDsiProcessing() void {
     modreg32(Instru_En, Instru_En, DSI_BASIC_CTL0_REG);  // TODO: DMB
 }
 
-/// Modify the specified bits in a memory mapped register.
-/// Based on https://github.com/apache/nuttx/blob/master/arch/arm64/src/common/arm64_arch.h#L473
-fn modreg32(
-    val: u32,   // Bits to set, like (1 << bit)
-    comptime mask: u32,  // Bits to clear, like (1 << bit)
-    addr: u64  // Address to modify
-) void {
-    debug("  *0x{x}: clear 0x{x}, set 0x{x}", .{ addr, mask, val & mask });
-    assert(val & mask == val);
-    putreg32(
-        (getreg32(addr) & ~(mask))
-            | ((val) & (mask)),
-        (addr)
-    );
-}
-
-/// Get the 32-bit value at the address
-fn getreg32(addr: u64) u32 {
-    const ptr = @intToPtr(*const volatile u32, addr);
-    return ptr.*;
-}
-
-/// Set the 32-bit value at the address
-fn putreg32(val: u32, addr: u64) void {
-    if (enableLog) { debug("  *0x{x} = 0x{x}", .{ addr, val }); }
-    const ptr = @intToPtr(*volatile u32, addr);
-    ptr.* = val;
-}
-
-/// Set to False to disable log 
-var enableLog = true;
+/// Read and Write Registers (see mmio.zig)
+const getreg32 = mmio.getreg32;
+const putreg32 = mmio.putreg32;
+const modreg32 = mmio.modreg32;
 
 ///////////////////////////////////////////////////////////////////////////////
 //  ST7703 LCD Controller
 
 /// Initialise the ST7703 LCD Controller in Xingbangda XBD599 LCD Panel.
+/// The Packets were composed at Compile Time (see panel_init_packets),
+/// so we only copy the FIFO Words and start each transmission.
 /// See https://lupyuen.github.io/articles/dsi#initialise-lcd-controller
 pub export fn panel_init() void {
     debug("panel_init: start", .{});
     defer { debug("panel_init: end", .{}); }
-    enableLog = false;  // Disable putreg32 log
+    mmio.enableLog = false;  // Disable putreg32 log
+
+    for (panel_init_packets) |*pkt, i| {
+        const res = transmitFifoPacket(pkt);
+        assert(res == 0);
+
+        // Wait if required. Only Sleep Out has a delay: ST7703 has no Status
+        // that tells us when it's awake, so we wait the Spec Minimum.
+        const delay_ms = panel_init_cmds[i].delay_ms;
+        if (delay_ms > 0) { ready.waitMin(.sleep_out, clock.now_us(), delay_ms * 1000); }
+    }
+}
+
+/// Milliseconds to wait after Sleep Out, before Display On
+pub const SLEEP_OUT_DELAY_MS = 120;
+
+/// Milliseconds to wait after Sleep In, before the next Command
+pub const SLEEP_IN_DELAY_MS = 5;
+
+/// Put the ST7703 LCD Controller to sleep: Display Off, then Sleep In.
+/// MIPI DSI must be in Low Power Mode (see stop_dsi).
+pub export fn panel_sleep() void {
+    debug("panel_sleep", .{});
+    writeDcsCommand(0x28);  // Display Off (Page 97): Blank the display (MIPI_DCS_SET_DISPLAY_OFF)
+    writeDcsCommand(0x10);  // SLPIN (Page 88): Turns on sleep mode (MIPI_DCS_ENTER_SLEEP_MODE)
+}
+
+/// Wake the ST7703 LCD Controller with Sleep Out. Display On must wait
+/// SLEEP_OUT_DELAY_MS after Sleep Out (see panel_display_on).
+pub export fn panel_sleep_out() void {
+    debug("panel_sleep_out", .{});
+    writeDcsCommand(0x11);  // SLPOUT (Page 89): Turns off sleep mode (MIPI_DCS_EXIT_SLEEP_MODE)
+}
+
+/// Turn on the ST7703 LCD Controller after Sleep Out
+pub export fn panel_display_on() void {
+    debug("panel_display_on", .{});
+    writeDcsCommand(0x29);  // Display On (Page 97): Recover from DISPLAY OFF mode (MIPI_DCS_SET_DISPLAY_ON)
+}
+
+/// Write a DCS Command without parameter (DCS Short Write)
+fn writeDcsCommand(cmd: u8) void {
+    const buf = [1]u8 { cmd };
+    const res = nuttx_mipi_dsi_dcs_write(null, VIRTUAL_CHANNEL, MIPI_DSI_DCS_SHORT_WRITE, &buf, buf.len);
+    assert(res == buf.len);
+}
 
-    // Most of these commands are documented in the ST7703 Datasheet:
-    // https://files.pine64.org/doc/datasheet/pinephone/ST7703_DS_v01_20160128.pdf
+/// DCS Command in the ST7703 Init Sequence
+const PanelCommand = struct {
+    data: []const u8,     // DCS Command and Parameters
+    delay_ms: u32 = 0,    // Milliseconds to wait after the Command
+};
 
+/// ST7703 Init Sequence.
+/// Most of these commands are documented in the ST7703 Datasheet:
+/// https://files.pine64.org/doc/datasheet/pinephone/ST7703_DS_v01_20160128.pdf
+const panel_init_cmds = [_]PanelCommand {
     // Command #1
-    writeDcs(&[_]u8 { 
+    .{ .data = &[_]u8 {
         0xB9,  // SETEXTC (Page 131): Enable USER Command
         0xF1,  // Enable User command
         0x12,  // (Continued)
         0x83   // (Continued)
-    });
+    } },
 
     // Command #2
-    writeDcs(&[_]u8 { 
+    .{ .data = &[_]u8 {
         0xBA,  // SETMIPI (Page 144): Set MIPI related register
         0x33,  // Virtual Channel = 0 (VC_Main = 0) ; Number of Lanes = 4 (Lane_Number = 3)
         0x81,  // LDO = 1.7 V (DSI_LDO_SEL = 4) ; Terminal Resistance = 90 Ohm (RTERM = 1)
@@ -551,19 +976,19 @@ pub export fn panel_init() void {
         0x00,  // Undocumented
         0x00,  // Undocumented
         0x37   // Undocumented
-    });
+    } },
 
     // Command #3
-    writeDcs(&[_]u8 { 
+    .{ .data = &[_]u8 {
         0xB8,  // SETPOWER_EXT (Page 142): Set display related register
         0x25,  // External power IC or PFM: VSP = FL1002, VSN = FL1002 (PCCS = 2) ; VCSW1 / VCSW2 Frequency for Pumping VSP / VSN = 1/4 Hsync (ECP_DC_DIV = 5)
         0x22,  // VCSW1/VCSW2 soft start time = 15 ms (DT = 2) ; Pumping ratio of VSP / VSN with VCI = x2 (XDK_ECP = 1)
         0x20,  // PFM operation frequency FoscD = Fosc/1 (PFM_DC_DIV = 0)
         0x03   // Enable power IC pumping frequency synchronization = Synchronize with external Hsync (ECP_SYNC_EN = 1) ; Enable VGH/VGL pumping frequency synchronization = Synchronize with external Hsync (VGX_SYNC_EN = 1)
-    });
+    } },
 
     // Command #4
-    writeDcs(&[_]u8 { 
+    .{ .data = &[_]u8 {
         0xB3,  // SETRGBIF (Page 134): Control RGB I/F porch timing for internal use
         0x10,  // Vertical back porch HS number in Blank Frame Period  = Hsync number 16 (VBP_RGB_GEN = 16)
         0x10,  // Vertical front porch HS number in Blank Frame Period = Hsync number 16 (VFP_RGB_GEN = 16)
@@ -575,10 +1000,10 @@ pub export fn panel_init() void {
         0x00,  // Undocumented
         0x00,  // Undocumented
         0x00   // Undocumented
-    });
+    } },
 
     // Command #5
-    writeDcs(&[_]u8 { 
+    .{ .data = &[_]u8 {
         0xC0,  // SETSCR (Page 147): Set related setting of Source driving
         0x73,  // Source OP Amp driving period for positive polarity in Normal Mode: Source OP Period = 115*4/Fosc (N_POPON = 115)
         0x73,  // Source OP Amp driving period for negative polarity in Normal Mode: Source OP Period = 115*4/Fosc (N_NOPON = 115)
@@ -589,36 +1014,36 @@ pub export fn panel_init() void {
         0x08,  // Gamma bias current fine tune: Current xIbias   = 4 (SCR Bits 9-13 = 4) ; (SCR Bits  8-15 = 0x08) 
         0x70,  // Source and Gamma bias current core tune: Ibias = 1 (SCR Bits 0-3 = 0) ; Source bias current fine tune: Current xIbias = 7 (SCR Bits 4-8 = 7) ; (SCR Bits  0-7  = 0x70)
         0x00   // Undocumented
-    });
+    } },
 
     // Command #6
-    writeDcs(&[_]u8 { 
+    .{ .data = &[_]u8 {
         0xBC,  // SETVDC (Page 146): Control NVDDD/VDDD Voltage
         0x4E   // NVDDD voltage = -1.8 V (NVDDD_SEL = 4) ; VDDD voltage = 1.9 V (VDDD_SEL = 6)
-    });
+    } },
 
     // Command #7
-    writeDcs(&[_]u8 { 
+    .{ .data = &[_]u8 {
         0xCC,  // SETPANEL (Page 154): Set display related register
         0x0B   // Enable reverse the source scan direction (SS_PANEL = 1) ; Normal vertical scan direction (GS_PANEL = 0) ; Normally black panel (REV_PANEL = 1) ; S1:S2:S3 = B:G:R (BGR_PANEL = 1)
-    });
+    } },
 
     // Command #8
-    writeDcs(&[_]u8 { 
+    .{ .data = &[_]u8 {
         0xB4,  // SETCYC (Page 135): Control display inversion type
         0x80   // Extra source for Zig-Zag Inversion = S2401 (ZINV_S2401_EN = 1) ; Row source data dislocates = Even row (ZINV_G_EVEN_EN = 0) ; Disable Zig-Zag Inversion (ZINV_EN = 0) ; Enable Zig-Zag1 Inversion (ZINV2_EN = 0) ; Normal mode inversion type = Column inversion (N_NW = 0)
-    });
+    } },
 
     // Command #9
-    writeDcs(&[_]u8 {
+    .{ .data = &[_]u8 {
         0xB2,  // SETDISP (Page 132): Control the display resolution
         0xF0,  // Gate number of vertical direction = 480 + (240*4) (NL = 240)
         0x12,  // (RES_V_LSB = 0) ; Non-display area source output control: Source output = VSSD (BLK_CON = 1) ; Channel number of source direction = 720RGB (RESO_SEL = 2)
         0xF0   // Source voltage during Blanking Time when accessing Sleep-Out / Sleep-In command = GND (WHITE_GND_EN = 1) ; Blank timing control when access sleep out command: Blank Frame Period = 7 Frames (WHITE_FRAME_SEL = 7) ; Source output refresh control: Refresh Period = 0 Frames (ISC = 0)
-    });
+    } },
 
     // Command #10
-    writeDcs(&[_]u8 { 
+    .{ .data = &[_]u8 {
         0xE3,  // SETEQ (Page 159): Set EQ related register
         0x00,  // Temporal spacing between HSYNC and PEQGND = 0*4/Fosc (PNOEQ = 0)
         0x00,  // Temporal spacing between HSYNC and NEQGND = 0*4/Fosc (NNOEQ = 0)
@@ -634,20 +1059,20 @@ pub export fn panel_init() void {
         0x00,  // (Reserved)
         0xC0,  // White pattern to protect GOA glass (ESD_DET_DATA_WHITE = 1) ; Enable ESD detection function to protect GOA glass (ESD_WHITE_EN = 1)
         0x10   // No Need VSYNC (additional frame) after Sleep-In command to display sleep-in blanking frame then into Sleep-In State (SLPIN_OPTION = 1) ; Enable video function detection (VEDIO_NO_CHECK_EN = 0) ; Disable ESD white pattern scanning voltage pull ground (ESD_WHITE_GND_EN = 0) ; ESD detection function period = 0 Frames (ESD_DET_TIME_SEL = 0)
-    });
+    } },
 
     // Command #11
-    writeDcs(&[_]u8 { 
+    .{ .data = &[_]u8 {
         0xC6,  // Undocumented
         0x01,  // Undocumented
         0x00,  // Undocumented
         0xFF,  // Undocumented
         0xFF,  // Undocumented
         0x00   // Undocumented
-    });
+    } },
 
     // Command #12
-    writeDcs(&[_]u8 { 
+    .{ .data = &[_]u8 {
         0xC1,  // SETPOWER (Page 149): Set related setting of power
         0x74,  // VGH Voltage Adjustment = 17 V (VBTHS = 7) ; VGL Voltage Adjustment = -11 V (VBTLS = 4)
         0x00,  // Enable VGH feedback voltage detection. Output voltage = VBTHS (FBOFF_VGH = 0) ; Enable VGL feedback voltage detection. Output voltage = VBTLS (FBOFF_VGL = 0)
@@ -661,32 +1086,32 @@ pub export fn panel_init() void {
         0xCC,  // Right side VGH stage 2 pumping frequency = 2.6 MHz (VGH2_R_DIV = 12) ; Right side VGL stage 2 pumping frequency = 2.6 MHz (VGL2_R_DIV = 12)
         0x77,  // Left side VGH stage 3 pumping frequency  = 4.5 MHz (VGH3_L_DIV = 7)  ; Left side VGL stage 3 pumping frequency  = 4.5 MHz (VGL3_L_DIV = 7)
         0x77   // Right side VGH stage 3 pumping frequency = 4.5 MHz (VGH3_R_DIV = 7)  ; Right side VGL stage 3 pumping frequency = 4.5 MHz (VGL3_R_DIV = 7)
-    });
+    } },
 
     // Command #13
-    writeDcs(&[_]u8 { 
+    .{ .data = &[_]u8 {
         0xB5,  // SETBGP (Page 136): Internal reference voltage setting
         0x07,  // VREF Voltage: 4.2 V (VREF_SEL = 7)
         0x07   // NVREF Voltage: 4.2 V (NVREF_SEL = 7)
-    });
+    } },
 
     // Command #14
-    writeDcs(&[_]u8 { 
+    .{ .data = &[_]u8 {
         0xB6,  // SETVCOM (Page 137): Set VCOM Voltage
         0x2C,  // VCOMDC voltage at "GS_PANEL=0" = -0.67 V (VCOMDC_F = 0x2C)
         0x2C   // VCOMDC voltage at "GS_PANEL=1" = -0.67 V (VCOMDC_B = 0x2C)
-    });
+    } },
 
     // Command #15
-    writeDcs(&[_]u8 { 
+    .{ .data = &[_]u8 {
         0xBF,  // Undocumented
         0x02,  // Undocumented
         0x11,  // Undocumented
         0x00   // Undocumented
-    });
+    } },
 
     // Command #16
-    writeDcs(&[_]u8 { 
+    .{ .data = &[_]u8 {
         0xE9,  // SETGIP1 (Page 163): Set forward GIP timing
         0x82,  // SHR0, SHR1, CHR, CHR2 refer to Internal DE (REF_EN = 1) ; (PANEL_SEL = 2)
         0x10,  // Starting position of GIP STV group 0 = 4102 HSYNC (SHR0 Bits 8-12 = 0x10)
@@ -751,10 +1176,10 @@ pub export fn panel_init() void {
         0x00,  // (CKS Bits  0-7  = 0x00)
         0x00,  // (COFF Bits 8-9 = 0) ; (CON Bits 8-9 = 0) ; (SPOFF Bits 8-9 = 0) ; (SPON Bits 8-9 = 0)
         0x00   // (COFF2 Bits 8-9 = 0) ; (CON2 Bits 8-9 = 0)
-    });
+    } },
 
     // Command #17
-    writeDcs(&[_]u8 { 
+    .{ .data = &[_]u8 {
         0xEA,  // SETGIP2 (Page 170): Set backward GIP timing
         0x02,  // YS2 Signal Mode = INYS1/INYS2 (YS2_SEL = 0) ; YS2 Signal Mode = INYS1/INYS2 (YS1_SEL = 0) ; Don't reverse YS2 signal (YS2_XOR = 0) ; Don't reverse YS1 signal (YS1_XOR = 0) ; Enable YS signal function (YS_FLAG_EN = 1) ; Disable ALL ON function (ALL_ON_EN = 0)
         0x21,  // (GATE = 0x21)
@@ -817,10 +1242,10 @@ pub export fn panel_init() void {
         0x00,  // Undocumented (Parameter 59)
         0x00,  // Undocumented (Parameter 60)
         0x00   // Undocumented (Parameter 61)
-    });
+    } },
 
     // Command #18
-    writeDcs(&[_]u8 { 
+    .{ .data = &[_]u8 {
         0xE0,  // SETGAMMA (Page 158): Set the gray scale voltage to adjust the gamma characteristics of the TFT panel
         0x00,  // (PVR0 = 0x00)
         0x09,  // (PVR1 = 0x09)
@@ -856,20 +1281,49 @@ pub export fn panel_init() void {
         0x12,  // (NPK6 = 0x12)
         0x12,  // (NPK7 = 0x12)
         0x18   // (NPK8 = 0x18)
-    });
+    } },
 
-    // Command #19    
-    writeDcs(&[_]u8 {
+    // Command #19, then wait 120 milliseconds
+    .{ .data = &[_]u8 {
         0x11  // SLPOUT (Page 89): Turns off sleep mode (MIPI_DCS_EXIT_SLEEP_MODE)
-    });
-
-    // Wait 120 milliseconds
-    _ = c.usleep(120 * 1000);
+    }, .delay_ms = SLEEP_OUT_DELAY_MS },
 
     // Command #20
-    writeDcs(&[_]u8 {
+    .{ .data = &[_]u8 {
         0x29  // Display On (Page 97): Recover from DISPLAY OFF mode (MIPI_DCS_SET_DISPLAY_ON)
-    });    
+    } },
+};
+
+/// Transmit FIFO Word images of the ST7703 Init Sequence, with ECC and CRC
+/// already embedded. Composed at Compile Time.
+const panel_init_packets = blk: {
+    @setEvalBranchQuota(100_000);
+    var packets: [panel_init_cmds.len]FifoPacket = undefined;
+    for (panel_init_cmds) |cmd, i| {
+        packets[i] = composeFifoPacket(cmd.data);
+    }
+    break :blk packets;
+};
+
+// Validate the Packets against the Expected Packets in test/test_mipi_dsi.c
+comptime {
+    // Command #6: DCS Short Write (With Parameter)
+    assert(panel_init_packets[5].len == 4);
+    assert(panel_init_packets[5].words[0] == 0x354e_bc15);
+
+    // Command #16: DCS Long Write (64 bytes of Payload)
+    assert(panel_init_packets[15].len == 70);
+    assert(std.mem.eql(u32, panel_init_packets[15].words[0..18], &[_]u32 {
+        0x25004039, 0x061082e9, 0xa50aa205, 0x37233112,
+        0x27bc0483, 0x03000c38, 0x0c000000, 0x00000300,
+        0x31757500, 0x88888888, 0x88138888, 0x88206464,
+        0x88888888, 0x00880288, 0x00000000, 0x00000000,
+        0x00000000, 0x00000365,
+    }));
+
+    // Command #19: DCS Short Write (Without Parameter)
+    assert(panel_init_packets[18].len == 4);
+    assert(panel_init_packets[18].words[0] == 0x3600_1105);
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -880,7 +1334,7 @@ pub export fn panel_init() void {
 pub export fn enable_dsi_block() void {
     debug("enable_dsi_block: start", .{});
     defer { debug("enable_dsi_block: end", .{}); }
-    enableLog = true;  // Enable putreg32 log
+    mmio.enableLog = true;  // Enable putreg32 log
 
     // Enable MIPI DSI Bus
     // BUS_CLK_GATING_REG0: CCU Offset 0x60 (A64 Page 100)
@@ -1234,10 +1688,9 @@ pub export fn enable_dsi_block() void {
     // DSI_BASIC_SIZE1_REG: DSI Offset 0x1c
     // Set Video_VT (Bits 16 to 28) to 1485
     // Set Video_VACT (Bits 0 to 11) to 1440
-    const DSI_BASIC_SIZE1_REG = DSI_BASE_ADDRESS + 0x1c;
     comptime{ assert(DSI_BASIC_SIZE1_REG == 0x1ca001c); }
 
-    const Video_VT:   u28 = 1485 << 16;
+    const Video_VT:   u28 = VIDEO_VT << 16;
     const Video_VACT: u12 = 1440 << 0;
     const DSI_BASIC_SIZE1 = Video_VT
         | Video_VACT;
@@ -1371,7 +1824,7 @@ fn DSI_INST_LOOP_NUM_REG(n: u8) u64 {
 pub export fn start_dsi() void {
     debug("start_dsi: start", .{});
     defer { debug("start_dsi: end", .{}); }
-    enableLog = true;  // Enable putreg32 log
+    mmio.enableLog = true;  // Enable putreg32 log
 
     // Start HSC (Undocumented)
     // DSI_INST_JUMP_SEL_REG: DSI Offset 0x48
@@ -1421,6 +1874,28 @@ pub export fn start_dsi() void {
     modreg32(Instru_En, Instru_En, DSI_BASIC_CTL0_REG);  // TODO: DMB
 }
 
+/// Stop MIPI DSI HSC and HSD, and return to Low Power Mode for DCS Commands.
+/// Reverses start_dsi.
+pub export fn stop_dsi() void {
+    debug("stop_dsi: start", .{});
+    defer { debug("stop_dsi: end", .{}); }
+
+    // Stop DSI Processing
+    // DSI_BASIC_CTL0_REG: DSI Offset 0x10 (A31 Page 845)
+    // Set Instru_En (Bit 0) to 0 (Disable DSI Processing)
+    debug("Stop DSI Processing", .{});
+    disableDsiProcessing();
+
+    // Instruction Function Lane (Undocumented)
+    // DSI_INST_FUNC_REG(0): DSI Offset 0x20
+    // Set DSI_INST_FUNC_LANE_CEN (Bit 4) to 1, like enable_dsi_block
+    // Index 0 is DSI_INST_ID_LP11
+    debug("Instruction Function Lane", .{});
+    comptime{ assert(DSI_INST_FUNC_REG(0) == 0x1ca0020); }
+    const DSI_INST_FUNC_LANE_CEN: u5 = 1 << 4;
+    modreg32(DSI_INST_FUNC_LANE_CEN, DSI_INST_FUNC_LANE_CEN, DSI_INST_FUNC_REG(0));  // TODO: DMB
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 //  MIPI DSI Types
 
@@ -1487,6 +1962,14 @@ fn dump_buffer(data: []const u8) void {
     _ = printf("\n");
 }
 
+/// Transmit FIFO Words for Testing
+var test_words = std.mem.zeroes([TX_FIFO_WORDS]u32);
+
+/// Write Word `index` of the Packet to test_words
+fn writeTestWord(word: u32, index: usize) void {
+    test_words[index] = word;
+}
+
 /// Main Function for Null App
 pub export fn null_main(_argc: c_int, _argv: [*]const [*]const u8) c_int {
     _ = _argc;
@@ -1609,6 +2092,40 @@ pub export fn test_zig() void {
         )
     );
 
+    // Test Stream Long Packet: Same Packet, as Transmit FIFO Words
+    debug("Testing Stream Long Packet...", .{});
+    const long_pkt_len = streamLongPacket(
+        writeTestWord,  // Write to test_words
+        0,              // Virtual Channel
+        MIPI_DSI_DCS_LONG_WRITE, // DCS Command
+        &[0]u8 {},      // No Prefix
+        &long_pkt       // Payload
+    );
+    assert(long_pkt_len == long_pkt_result.len);
+    assert(  //  Verify result
+        std.mem.eql(
+            u32,
+            test_words[0..18],
+            &[_]u32 {
+                0x25004039, 0x061082e9, 0xa50aa205, 0x37233112,
+                0x27bc0483, 0x03000c38, 0x0c000000, 0x00000300,
+                0x31757500, 0x88888888, 0x88138888, 0x88206464,
+                0x88888888, 0x00880288, 0x00000000, 0x00000000,
+                0x00000000, 0x00000365,
+            }
+        )
+    );
+
+    // Test ECC Correction: Flip every bit of the Long Packet Header `39 40 00 25`
+    debug("Testing ECC Correction...", .{});
+    const long_header: u32 = 0x25004039;
+    var bit: u5 = 0;
+    while (bit < 30) : (bit += 1) {
+        const corrupted = long_header ^ (@as(u32, 1) << bit);
+        assert(correctEcc(corrupted).? == long_header);
+    }
+    assert(correctEcc(long_header ^ 0b11) == null);  // 2-bit error
+
     // Write to MIPI DSI
     // _ = nuttx_mipi_dsi_dcs_write(
     //     null,  //  Device
@@ -1717,62 +2234,11 @@ pub export fn test_zig() void {
 // modifyreg32: addr=0x200, val=0x00000045
 
 ///////////////////////////////////////////////////////////////////////////////
-//  Panic Handler
-
-/// Called by Zig when it hits a Panic. We print the Panic Message, Stack Trace and halt. See 
-/// https://andrewkelley.me/post/zig-stack-traces-kernel-panic-bare-bones-os.html
-/// https://github.com/ziglang/zig/blob/master/lib/std/builtin.zig#L763-L847
-pub fn panic(
-    message: []const u8, 
-    _stack_trace: ?*std.builtin.StackTrace
-) noreturn {
-    // Print the Panic Message
-    _ = _stack_trace;
-    _ = puts("\n!ZIG PANIC!");
-    _ = puts(@ptrCast([*c]const u8, message));
-
-    // Print the Stack Trace
-    _ = puts("Stack Trace:");
-    var it = std.debug.StackIterator.init(@returnAddress(), null);
-    while (it.next()) |return_address| {
-        _ = printf("%p\n", return_address);
-    }
+//  Panic Handler and Logging
 
-    // Halt
-    c.exit(1);
-}
-
-///////////////////////////////////////////////////////////////////////////////
-//  Logging
-
-/// Called by Zig for `std.log.debug`, `std.log.info`, `std.log.err`, ...
-/// https://gist.github.com/leecannon/d6f5d7e5af5881c466161270347ce84d
-pub fn log(
-    comptime _message_level: std.log.Level,
-    comptime _scope: @Type(.EnumLiteral),
-    comptime format: []const u8,
-    args: anytype,
-) void {
-    _ = _message_level;
-    _ = _scope;
-
-    // Format the message
-    var buf: [100]u8 = undefined;  // Limit to 100 chars
-    var slice = std.fmt.bufPrint(&buf, format, args)
-        catch { _ = puts("*** log error: buf too small"); return; };
-    
-    // Terminate the formatted message with a null
-    var buf2: [buf.len + 1 : 0]u8 = undefined;
-    std.mem.copy(
-        u8, 
-        buf2[0..slice.len], 
-        slice[0..slice.len]
-    );
-    buf2[slice.len] = 0;
-
-    // Print the formatted message
-    _ = puts(&buf2);
-}
+/// Called by Zig when it hits a Panic, and for `std.log.debug`, `std.log.err`, ... (see mmio.zig)
+pub const panic = mmio.panic;
+pub const log   = mmio.log;
 
 ///////////////////////////////////////////////////////////////////////////////
 //  Imported Functions and Variables
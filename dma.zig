@@ -0,0 +1,507 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! Framebuffer Transfers with the DMA Controller for Apache NuttX RTOS on PinePhone.
+//! Fills, Copies and 2D Strided Copies of Framebuffers are queued and run by the
+//! General-Purpose DMA Controller of Allwinner A64, while the CPU renders the
+//! next Frame. Completion Callbacks are called by `fbxfer_poll` and `fbxfer_wait`
+//! in the Calling Thread, in the order that the Transfers were queued.
+//! Transfers that the DMA Controller shouldn't do (small, overlapping or too many
+//! Rows) are done by the CPU with the 2D Graphics Operations, after the earlier
+//! Transfers have completed, so the order of Transfers is always preserved.
+//! On the Host Computer, a Worker Thread stands in for the DMA Controller.
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Import the Zig Compiler Info, to check whether we're running on PinePhone
+const builtin = @import("builtin");
+
+/// Import the Register Access Module
+const mmio = @import("./mmio.zig");
+
+/// Import the 2D Graphics Operations Module, for the CPU Fallback
+const accel = @import("./accel.zig");
+
+/// Import the Framebuffer Memory Types Module, for Write-Combining Framebuffers
+const fbcache = @import("./fbcache.zig");
+
+/// Import NuttX Functions from C
+const c = @cImport({
+    // NuttX Defines
+    @cDefine("__NuttX__",  "");
+    @cDefine("NDEBUG",     "");
+    @cDefine("FAR",        "");
+
+    // NuttX Header Files
+    @cInclude("arch/types.h");
+    @cInclude("../../nuttx/include/limits.h");
+    @cInclude("nuttx/config.h");
+    @cInclude("errno.h");
+    @cInclude("pthread.h");
+    @cInclude("unistd.h");
+});
+
+/// Completion Callback: `result` is 0 when the Transfer is complete
+pub const Callback = *const fn (arg: ?*anyopaque, result: c_int) callconv(.C) void;
+
+/// Maximum number of queued Transfers
+pub const MAX_TRANSFERS = 8;
+
+/// Transfers smaller than this (bytes) are done by the CPU, which is quicker than
+/// setting up the DMA Controller and flushing the Data Cache
+const MIN_DMA_BYTES = 16 * 1024;
+
+/// Fill or Copy `height` Rows of `width` pixels. Strides are in pixels.
+const Transfer = struct {
+    dest: [*]u32,           // Destination Pixels
+    dest_stride: usize,     // Pixels per Destination Row
+    src: ?[*]const u32,     // Source Pixels, or null for a Fill
+    src_stride: usize,      // Pixels per Source Row
+    color: u32,             // Fill Colour
+    width: usize,           // Pixels per Row
+    height: usize,          // Number of Rows
+    callback: ?Callback,    // Called when the Transfer is complete
+    arg: ?*anyopaque,       // Argument for the Callback
+};
+
+/// Fill `len` pixels at `dest` with `color`. Returns 0 if the Transfer was queued
+/// (or done), or -EINVAL if `dest` is null.
+pub export fn fbxfer_fill(
+    dest: [*c]u32,         // Destination Pixels
+    len: usize,            // Number of pixels
+    color: u32,            // Fill Colour
+    callback: ?Callback,   // Called when the Transfer is complete (optional)
+    arg: ?*anyopaque       // Argument for the Callback
+) c_int {
+    if (dest == null) { return -c.EINVAL; }
+    return submit(.{
+        .dest = @ptrCast([*]u32, dest), .dest_stride = len,
+        .src  = null, .src_stride = len,
+        .color = color, .width = len, .height = 1,
+        .callback = callback, .arg = arg,
+    });
+}
+
+/// Copy `len` pixels from `src` to `dest`. Returns 0 if the Transfer was queued
+/// (or done), or -EINVAL if `dest` or `src` is null.
+pub export fn fbxfer_copy(
+    dest: [*c]u32,         // Destination Pixels
+    src: [*c]const u32,    // Source Pixels
+    len: usize,            // Number of pixels
+    callback: ?Callback,   // Called when the Transfer is complete (optional)
+    arg: ?*anyopaque       // Argument for the Callback
+) c_int {
+    return fbxfer_copy2d(dest, len, src, len, len, 1, callback, arg);
+}
+
+/// Copy a Rectangle of `width` x `height` pixels from `src` to `dest`, like a Window of
+/// a Framebuffer. Returns 0 if the Transfer was queued (or done), or -EINVAL if invalid.
+pub export fn fbxfer_copy2d(
+    dest: [*c]u32,         // Top Left of the Destination Rectangle
+    dest_stride: usize,    // Pixels per Destination Row
+    src: [*c]const u32,    // Top Left of the Source Rectangle
+    src_stride: usize,     // Pixels per Source Row
+    width: usize,          // Width of the Rectangle (pixels)
+    height: usize,         // Height of the Rectangle (pixels)
+    callback: ?Callback,   // Called when the Transfer is complete (optional)
+    arg: ?*anyopaque       // Argument for the Callback
+) c_int {
+    if (dest == null or src == null or
+        dest_stride < width or src_stride < width) { return -c.EINVAL; }
+    return submit(.{
+        .dest = @ptrCast([*]u32, dest), .dest_stride = dest_stride,
+        .src  = @ptrCast([*]const u32, src), .src_stride = src_stride,
+        .color = 0, .width = width, .height = height,
+        .callback = callback, .arg = arg,
+    });
+}
+
+/// Call the Completion Callbacks of the Transfers that have completed, and start the next
+/// Transfer on the DMA Controller. Returns the number of Transfers that are still queued.
+pub export fn fbxfer_poll() c_int {
+    var done: usize = undefined;
+    if (builtin.os.tag == .freestanding) {
+        if (finished < tail and dmaDone()) {
+            finishDma(queue[finished % MAX_TRANSFERS]);
+            finished += 1;
+            if (finished < tail) { startDma(queue[finished % MAX_TRANSFERS]); }
+        }
+        done = finished;
+    } else {
+        if (!started) { return 0; }
+        _ = c.pthread_mutex_lock(&mutex);
+        done = finished;
+        _ = c.pthread_mutex_unlock(&mutex);
+    }
+
+    // Callbacks may queue more Transfers, so we update `head` first
+    while (head < done) {
+        const t = queue[head % MAX_TRANSFERS];
+        head += 1;
+        if (t.callback) |cb| { cb(t.arg, c.OK); }
+    }
+    return @intCast(c_int, tail - head);
+}
+
+/// Wait for all queued Transfers to complete, and call their Completion Callbacks
+pub export fn fbxfer_wait() void {
+    while (head < tail) {
+        if (builtin.os.tag == .freestanding) {
+            if (fbxfer_poll() > 0) { _ = c.usleep(POLL_US); }
+        } else {
+            _ = c.pthread_mutex_lock(&mutex);
+            while (finished < tail) {
+                _ = c.pthread_cond_wait(&work_done, &mutex);
+            }
+            _ = c.pthread_mutex_unlock(&mutex);
+            _ = fbxfer_poll();
+        }
+    }
+}
+
+/// Microseconds between polls while waiting for the DMA Controller
+const POLL_US = 100;
+
+///////////////////////////////////////////////////////////////////////////////
+//  Transfer Queue
+
+/// Queued Transfers. Transfer `i` is at `queue[i % MAX_TRANSFERS]`.
+var queue: [MAX_TRANSFERS]Transfer = undefined;
+
+/// Oldest Transfer whose Callback hasn't been called. Only changed by the Calling Thread.
+var head: usize = 0;
+
+/// Transfers before this one have been completed by the DMA Controller (or Worker Thread).
+/// On the Host Computer, protected by `mutex`.
+var finished: usize = 0;
+
+/// Next Transfer to be queued. On the Host Computer, protected by `mutex`.
+var tail: usize = 0;
+
+/// Queue the Transfer, or do it with the CPU if the DMA Controller shouldn't
+fn submit(transfer: Transfer) c_int {
+    // Rows that are next to each other become one Row, so it takes one DMA Descriptor
+    var t = transfer;
+    if (t.width == t.dest_stride and t.width == t.src_stride) {
+        t.width *= t.height;
+        t.dest_stride = t.width;
+        t.src_stride  = t.width;
+        t.height = 1;
+    }
+    debug("submit: width={}, height={}, fill={}", .{ t.width, t.height, t.src == null });
+
+    // Fall back to the CPU, after the earlier Transfers have completed
+    if (!useDma(t)) {
+        fbxfer_wait();
+        runOnCpu(t);
+        if (t.callback) |cb| { cb(t.arg, c.OK); }
+        return c.OK;
+    }
+
+    // Wait for a free slot in the Queue
+    while (tail - head == MAX_TRANSFERS) {
+        if (builtin.os.tag == .freestanding) {
+            if (fbxfer_poll() == MAX_TRANSFERS) { _ = c.usleep(POLL_US); }
+        } else {
+            fbxfer_wait();
+        }
+    }
+
+    // Queue the Transfer. Start it if the DMA Controller is idle.
+    if (builtin.os.tag == .freestanding) {
+        queue[tail % MAX_TRANSFERS] = t;
+        tail += 1;
+        if (finished + 1 == tail) { startDma(t); }
+    } else {
+        _ = c.pthread_mutex_lock(&mutex);
+        queue[tail % MAX_TRANSFERS] = t;
+        tail += 1;
+        _ = c.pthread_cond_signal(&work_ready);
+        _ = c.pthread_mutex_unlock(&mutex);
+    }
+    return c.OK;
+}
+
+/// Return true if the Transfer should be done by the DMA Controller (or the Worker Thread)
+fn useDma(t: Transfer) bool {
+    if (t.width == 0 or t.height == 0) { return false; }
+    if (builtin.os.tag != .freestanding) {
+        if (!started) { startWorker(); }
+        return worker_ok;
+    }
+    if (t.width * t.height * 4 < MIN_DMA_BYTES) { return false; }
+    if (t.height > MAX_DESCRIPTORS or t.width * 4 > MAX_BCNT) { return false; }
+
+    // Display Engine and DMA Controller take 32-bit addresses
+    const dest = span(t.dest, t.dest_stride, t);
+    if (dest.end > 0xFFFF_FFFF) { return false; }
+
+    // DMA Controller copies forwards, so the Source and Destination must not overlap
+    if (t.src) |src| {
+        const s = span(src, t.src_stride, t);
+        if (s.end > 0xFFFF_FFFF) { return false; }
+        if (s.start < dest.end and dest.start < s.end) { return false; }
+    }
+    return true;
+}
+
+/// Range of memory addresses touched by a Transfer
+const Span = struct { start: usize, end: usize };
+
+/// Return the addresses from the first to the last pixel of the Transfer at `pixels`
+fn span(pixels: [*]const u32, stride: usize, t: Transfer) Span {
+    const start = @ptrToInt(pixels);
+    return .{ .start = start, .end = start + ((t.height - 1) * stride + t.width) * 4 };
+}
+
+/// Do the Transfer with the CPU. The Source and Destination may overlap.
+fn runOnCpu(t: Transfer) void {
+    if (t.width == 0 or t.height == 0) { return; }
+    const area = accel.Rect { .x = 0, .y = 0, .w = t.width, .h = t.height };
+    const dest = accel.Surface { .pixels = t.dest, .stride = t.dest_stride, .width = t.width, .height = t.height };
+    if (t.src) |src| {
+        // accel.copy won't write to the Source
+        const s = accel.Surface { .pixels = @intToPtr([*]u32, @ptrToInt(src)), .stride = t.src_stride, .width = t.width, .height = t.height };
+        accel.copy(dest, area, s, 0, 0);
+    } else {
+        accel.fill(dest, area, t.color);
+    }
+
+    // Clean the Data Cache, so that the Display Engine will see the pixels
+    const d = span(t.dest, t.dest_stride, t);
+    flushRange(d.start, d.end);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  DMA Controller
+
+/// Base Address of Allwinner A64 DMA Controller (A64 Page 198)
+const DMA_BASE_ADDRESS = 0x01C0_2000;
+
+/// DMA Channel for Framebuffer Transfers. The other NuttX Drivers for PinePhone don't use Channel 7.
+const DMA_CHANNEL = 7;
+
+/// DMA_STA_REG (DMA Status Register) at DMA Offset 0x30 (A64 Page 205):
+/// For Channel N, DMA_STATUS is Bit N. 1 while the Channel is busy.
+/// We poll this instead of DMA_IRQ_PEND_REG0, because the Pending Bits are set only when
+/// the IRQ is enabled in DMA_IRQ_EN_REG0, and the DMA IRQ belongs to the NuttX DMA Driver.
+const DMA_STA_REG = DMA_BASE_ADDRESS + 0x30;
+const DMA_STATUS: u32 = 1 << DMA_CHANNEL;
+
+/// DMA_EN_REG (DMA Channel Enable Register) at DMA Offset 0x100 + N * 0x40 (A64 Page 206):
+/// DMA_EN (Bit 0) starts the Channel
+const DMA_EN_REG = DMA_BASE_ADDRESS + 0x100 + DMA_CHANNEL * 0x40;
+
+/// DMA_DESC_ADDR_REG (DMA Channel Descriptor Address Register) at DMA Offset 0x108 + N * 0x40 (A64 Page 207)
+const DMA_DESC_ADDR_REG = DMA_BASE_ADDRESS + 0x108 + DMA_CHANNEL * 0x40;
+
+comptime {
+    assert(DMA_STA_REG == 0x1c02030);
+    assert(DMA_EN_REG == 0x1c022c0);
+    assert(DMA_DESC_ADDR_REG == 0x1c022c8);
+}
+
+/// DMA Descriptor in RAM, read by the DMA Controller (A64 Page 196)
+const Descriptor = extern struct {
+    config: u32,  // Configuration (DescConfig)
+    src:    u32,  // Source Address
+    dest:   u32,  // Destination Address
+    bcnt:   u32,  // Byte Count
+    para:   u32,  // Parameter: Wait Clock Cycles (Bits 0 to 7)
+    link:   u32,  // Address of the next Descriptor, or LINK_END
+};
+
+/// Configuration of a DMA Descriptor
+const DescConfig = packed struct {
+    SRC_DRQ:        u5 = 0,  // Bits 0 to 4: Source DRQ Type
+    SRC_ADDR_MODE:  u1 = 0,  // Bit 5: 0 for Linear Mode, 1 for IO Mode (Address is fixed)
+    _6:             u1 = 0,
+    SRC_BURST:      u2 = 0,  // Bits 7 to 8: Burst Length
+    SRC_WIDTH:      u2 = 0,  // Bits 9 to 10: Data Width
+    _11:            u5 = 0,
+    DEST_DRQ:       u5 = 0,  // Bits 16 to 20: Destination DRQ Type
+    DEST_ADDR_MODE: u1 = 0,  // Bit 21
+    _22:            u1 = 0,
+    DEST_BURST:     u2 = 0,  // Bits 23 to 24
+    DEST_WIDTH:     u2 = 0,  // Bits 25 to 26
+    _27:            u5 = 0,
+};
+
+/// DRQ Type for SDRAM, Burst of 8 Transfers, Data Width of 32 Bits
+const DRQ_SDRAM = 1;
+const BURST_8   = 2;
+const WIDTH_32  = 2;
+
+/// Last Descriptor in the Linked List
+const LINK_END = 0xFFFF_F800;
+
+/// Byte Count has 25 Bits
+const MAX_BCNT = (1 << 25) - 1;
+
+/// One Descriptor per Row of the Transfer in progress
+const MAX_DESCRIPTORS = 2048;
+var descriptors: [MAX_DESCRIPTORS]Descriptor align(64) = undefined;
+
+/// Source of a Fill, read repeatedly in IO Mode
+var fill_word: u32 align(64) = 0;
+
+/// True if the DMA Clock is enabled
+var dma_enabled = false;
+
+/// Start the Transfer on the DMA Channel
+fn startDma(t: Transfer) void {
+    debug("startDma: width={}, height={}", .{ t.width, t.height });
+    if (!dma_enabled) { enableDma(); }
+
+    // Describe each Row of the Transfer
+    const config = @bitCast(u32, DescConfig {
+        .SRC_DRQ = DRQ_SDRAM, .SRC_ADDR_MODE = @boolToInt(t.src == null),
+        .SRC_BURST = BURST_8, .SRC_WIDTH = WIDTH_32,
+        .DEST_DRQ = DRQ_SDRAM, .DEST_BURST = BURST_8, .DEST_WIDTH = WIDTH_32,
+    });
+    fill_word = t.color;
+    var y: usize = 0;
+    while (y < t.height) : (y += 1) {
+        const src = if (t.src) |s| @ptrToInt(s + y * t.src_stride) else @ptrToInt(&fill_word);
+        descriptors[y] = .{
+            .config = config,
+            .src    = @intCast(u32, src),
+            .dest   = @intCast(u32, @ptrToInt(t.dest + y * t.dest_stride)),
+            .bcnt   = @intCast(u32, t.width * 4),
+            .para   = 8,  // Normal Wait: 8 Clock Cycles
+            .link   = if (y + 1 == t.height) LINK_END else @intCast(u32, @ptrToInt(&descriptors[y + 1])),
+        };
+    }
+
+    // Write the Descriptors, Fill Word and Source to RAM. Clean the Destination too,
+    // so that no dirty Cache Lines will be written over the Transfer later.
+    flushRange(@ptrToInt(&descriptors), @ptrToInt(&descriptors) + t.height * @sizeOf(Descriptor));
+    flushRange(@ptrToInt(&fill_word), @ptrToInt(&fill_word) + 4);
+    if (t.src) |src| {
+        const s = span(src, t.src_stride, t);
+        flushRange(s.start, s.end);
+    }
+    const d = span(t.dest, t.dest_stride, t);
+    flushRange(d.start, d.end);
+
+    // Start the Channel
+    putreg32(@intCast(u32, @ptrToInt(&descriptors)), DMA_DESC_ADDR_REG);
+    putreg32(1, DMA_EN_REG);  // TODO: DMB
+}
+
+/// Return true if the DMA Channel has finished the last Descriptor and is idle
+fn dmaDone() bool {
+    return getreg32(DMA_STA_REG) & DMA_STATUS == 0;
+}
+
+/// Stop the DMA Channel after the Transfer, and discard stale Cache Lines of the Destination
+fn finishDma(t: Transfer) void {
+    putreg32(0, DMA_EN_REG);
+    const d = span(t.dest, t.dest_stride, t);
+    up_invalidate_dcache(d.start, d.end);
+}
+
+/// Pass the DMA Clock and deassert the DMA Reset
+fn enableDma() void {
+    debug("enableDma", .{});
+    dma_enabled = true;
+
+    // BUS_CLK_GATING_REG0 at CCU Offset 0x0060 (A64 Page 100): DMA_GATING (Bit 6)
+    // BUS_SOFT_RST_REG0 at CCU Offset 0x02C0 (A64 Page 138): DMA_RST (Bit 6)
+    const DMA_GATING: u32 = 1 << 6;
+    const DMA_RST:    u32 = 1 << 6;
+    modreg32(DMA_RST,    DMA_RST,    0x1C2_02C0);
+    modreg32(DMA_GATING, DMA_GATING, 0x1C2_0060);
+}
+
+/// Clean and Invalidate the Data Cache for the addresses. Write-Combining Framebuffers aren't cached.
+/// On the Host Computer, the caches are coherent and there's nothing to do.
+fn flushRange(start: usize, end: usize) void {
+    if (builtin.os.tag == .freestanding and !fbcache.isWriteCombining(start, end)) { up_flush_dcache(start, end); }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Worker Thread
+
+/// True if the Worker Thread has been started, and if it's running
+var started   = false;
+var worker_ok = false;
+
+/// Mutex and Condition Variables for the Worker Thread
+var mutex:      c.pthread_mutex_t = undefined;
+var work_ready: c.pthread_cond_t  = undefined;
+var work_done:  c.pthread_cond_t  = undefined;
+
+/// Worker Thread that does the Transfers, like the DMA Controller
+var worker: c.pthread_t = undefined;
+
+/// Start the Worker Thread. If it can't be started, the Transfers are done by the Calling Thread.
+fn startWorker() void {
+    debug("startWorker", .{});
+    started = true;
+    _ = c.pthread_mutex_init(&mutex, null);
+    _ = c.pthread_cond_init(&work_ready, null);
+    _ = c.pthread_cond_init(&work_done, null);
+    const ret = c.pthread_create(&worker, null, workerMain, null);
+    if (ret != 0) {
+        std.log.err("startWorker: pthread_create failed, ret={}", .{ ret });
+        return;
+    }
+    worker_ok = true;
+}
+
+/// Main Loop for the Worker Thread: Wait for a Transfer, do it, repeat
+fn workerMain(arg: ?*anyopaque) callconv(.C) ?*anyopaque {
+    _ = arg;
+    while (true) {
+        _ = c.pthread_mutex_lock(&mutex);
+        while (finished == tail) {
+            _ = c.pthread_cond_wait(&work_ready, &mutex);
+        }
+        const t = queue[finished % MAX_TRANSFERS];
+        _ = c.pthread_mutex_unlock(&mutex);
+
+        runOnCpu(t);
+
+        _ = c.pthread_mutex_lock(&mutex);
+        finished += 1;
+        _ = c.pthread_cond_signal(&work_done);
+        _ = c.pthread_mutex_unlock(&mutex);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Read and Write Registers
+
+/// Read and Write Registers (see mmio.zig)
+const getreg32 = mmio.getreg32;
+const putreg32 = mmio.putreg32;
+const modreg32 = mmio.modreg32;
+
+///////////////////////////////////////////////////////////////////////////////
+//  Imported Functions and Variables
+
+/// Clean and Invalidate, or Invalidate the Data Cache. From NuttX nuttx/cache.h
+extern fn up_flush_dcache(start: usize, end: usize) void;
+extern fn up_invalidate_dcache(start: usize, end: usize) void;
+
+/// Aliases for Zig Standard Library
+const assert = std.debug.assert;
+const debug  = std.log.debug;
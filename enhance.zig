@@ -0,0 +1,353 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! Image Enhancement for Apache NuttX RTOS on PinePhone.
+//! Programs the Post-Processing Blocks of the A64 Display Engine (MIXER0):
+//! Fresh and Contrast Enhancement (FCE), Black and White Stretch (BWS),
+//! Luminance Transient Improvement (LTI), Luma Peaking (PEAKING), Adaptive
+//! Saturation Enhancement (ASE) and Fancy Color Curvature Change (FCC).
+//! The Settings are validated and turned into Register Values (a Plan). The
+//! Reference Model renders a Row of pixels from the same Register Values, so
+//! the programming can be checked on the Host Computer without a Display.
+//! "DE Page ???" refers to Allwinner Display Engine 2.0 Specification: https://linux-sunxi.org/images/7/7b/Allwinner_DE2.0_Spec_V1.0.pdf
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Import the Register Access Module
+const mmio = @import("./mmio.zig");
+
+/// Import the Display Engine Module, for the Panel Size
+const render = @import("./render.zig");
+
+/// Import NuttX Functions from C
+const c = @cImport({
+    // NuttX Defines
+    @cDefine("__NuttX__",  "");
+    @cDefine("NDEBUG",     "");
+    @cDefine("FAR",        "");
+
+    // NuttX Header Files
+    @cInclude("arch/types.h");
+    @cInclude("../../nuttx/include/limits.h");
+    @cInclude("nuttx/config.h");
+    @cInclude("errno.h");
+});
+
+/// Image Enhancement Settings. Zero for a field turns off its Block.
+pub const Settings = extern struct {
+    contrast:    u8 = 0,    // FCE Contrast Gain: 0 (Off) to 63
+    black_level: u8 = 0,    // BWS Black Level: Input Level that becomes 0
+    white_level: u8 = 255,  // BWS White Level: Input Level that becomes 255. BWS is Off for 0 and 255.
+    lti:         u8 = 0,    // LTI Edge Gain: 0 (Off) to 31
+    sharpness:   u8 = 0,    // PEAKING Gain: 0 (Off) to 255
+    saturation:  u8 = 0,    // ASE Gain: 0 (Off) to 31
+    hue_saturation: [NUM_HUES]i8 = [_]i8{ 0 } ** NUM_HUES,  // FCC Saturation Gain for each Hue, see Hue
+};
+
+/// Hues for the FCC Saturation Gain
+pub const Hue = enum(u3) { red, yellow, green, cyan, blue, magenta };
+pub const NUM_HUES = 6;
+
+/// Apply the Image Enhancement Settings at the next Vertical Blanking.
+/// Returns 0 if OK, or -EINVAL if the Settings are out of range.
+/// The Dynamic Range Controller (DRC) stays disabled: it adjusts the Backlight
+/// together with the pixels, which needs the Backlight Driver in the loop.
+pub export fn enhance_set(
+    settings: [*c]const Settings  // Image Enhancement Settings
+) c_int {
+    debug("enhance_set: start", .{});
+    defer { debug("enhance_set: end", .{}); }
+    if (settings == null) { return -c.EINVAL; }
+    const p = plan(settings.*) orelse return -c.EINVAL;
+    apply(p);
+    return c.OK;
+}
+
+/// Turn off all Image Enhancement Blocks, as after de2_init
+pub export fn enhance_disable() void {
+    debug("enhance_disable", .{});
+    apply(plan(.{}).?);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Register Values
+
+/// Register Values for the Image Enhancement Blocks, computed from the Settings
+pub const Plan = struct {
+    fce_gctrl:  u32,  // FCE GCTRL_REG
+    fce_gain:   u32,  // FCE LCE_GAIN_REG
+    bws_gctrl:  u32,  // BWS GCTRL_REG
+    bws_black:  u32,  // BWS LS_THR0
+    bws_white:  u32,  // BWS LS_THR1
+    bws_slope:  u32,  // BWS LS_SLP0
+    lti_ctl:    u32,  // LTI_CTL
+    lti_gain:   u32,  // LTI_EDGE_GAIN
+    lp_ctrl:    u32,  // PEAKING LP_CTRL_REG
+    lp_gain:    u32,  // PEAKING LP_GAIN_REG
+    ase_ctl:    u32,  // ASE_CTL_REG
+    ase_gain:   u32,  // ASE_GAIN_REG
+    fcc_ctl:    u32,  // FCC_CTL_REG
+    fcc_gain:   [NUM_HUES]u32,  // FCC_SAT_GAIN_REG for each Hue
+};
+
+/// Validate the Settings and compute the Register Values.
+/// Returns null if the Settings are out of range.
+pub fn plan(s: Settings) ?Plan {
+    if (s.contrast > 63 or s.lti > 31 or s.saturation > 31) { return null; }
+    const bws_on = !(s.black_level == 0 and (s.white_level == 0 or s.white_level == 255));
+    if (bws_on and s.black_level >= s.white_level) { return null; }
+
+    var p = Plan {
+        .fce_gctrl = @boolToInt(s.contrast != 0),  // EN (Bit 0)
+        .fce_gain  = s.contrast,                   // LCE_GAIN (Bits 0 to 5)
+        .bws_gctrl = @boolToInt(bws_on),           // EN (Bit 0)
+        .bws_black = if (bws_on) s.black_level else 0,
+        .bws_white = if (bws_on) s.white_level else 255,
+        .bws_slope = 1 << 8,                       // Slope 1.0 in 8.8 Fixed Point
+        .lti_ctl   = @boolToInt(s.lti != 0),       // LTI_EN (Bit 0)
+        .lti_gain  = s.lti,                        // EDGE_GAIN (Bits 0 to 4)
+        .lp_ctrl   = @boolToInt(s.sharpness != 0), // EN (Bit 0)
+        .lp_gain   = s.sharpness,                  // GAIN (Bits 0 to 7)
+        .ase_ctl   = @boolToInt(s.saturation != 0),  // ASE_EN (Bit 0)
+        .ase_gain  = s.saturation,                 // ASE_GAIN (Bits 0 to 4)
+        .fcc_ctl   = 0,
+        .fcc_gain  = undefined,
+    };
+    if (bws_on) {
+        // Slope = 255 / (White - Black), rounded, in 8.8 Fixed Point
+        const range: u32 = s.white_level - s.black_level;
+        p.bws_slope = (255 * 256 + range / 2) / range;
+    }
+    for (s.hue_saturation) |gain, i| {
+        // SAT_GAIN (Bits 0 to 7) is Signed. Enable (Bit 0) if any Hue has a Gain.
+        p.fcc_gain[i] = @bitCast(u8, gain);
+        if (gain != 0) { p.fcc_ctl = 1; }
+    }
+    return p;
+}
+
+/// Write the Register Values to the Image Enhancement Blocks and apply them at the next Vertical Blanking.
+/// Each Block covers the whole Panel.
+fn apply(p: Plan) void {
+    const size = (PANEL_HEIGHT - 1) << 16 | (PANEL_WIDTH - 1);
+
+    // FCE (Fresh and Contrast Enhancement) at MIXER0 Offset 0x0A 0000 (DE Page 61, 0x11A 0000)
+    putreg32(size,        FCE_BASE_ADDRESS + 0x04);  // FCE_SIZE
+    putreg32(p.fce_gain,  FCE_BASE_ADDRESS + 0x1C);  // LCE_GAIN_REG
+    putreg32(p.fce_gctrl, FCE_BASE_ADDRESS + 0x00);  // GCTRL_REG
+
+    // BWS (Black and White Stretch) at MIXER0 Offset 0x0A 2000 (DE Page 42, 0x11A 2000)
+    putreg32(size,        BWS_BASE_ADDRESS + 0x04);  // BWS_SIZE
+    putreg32(p.bws_black, BWS_BASE_ADDRESS + 0x20);  // LS_THR0
+    putreg32(p.bws_white, BWS_BASE_ADDRESS + 0x24);  // LS_THR1
+    putreg32(p.bws_slope, BWS_BASE_ADDRESS + 0x28);  // LS_SLP0
+    putreg32(p.bws_gctrl, BWS_BASE_ADDRESS + 0x00);  // GCTRL_REG
+
+    // LTI (Luminance Transient Improvement) at MIXER0 Offset 0x0A 4000 (DE Page 71, 0x11A 4000)
+    putreg32(size,        LTI_BASE_ADDRESS + 0x0C);  // LTI_SIZE
+    putreg32(p.lti_gain,  LTI_BASE_ADDRESS + 0x28);  // LTI_EDGE_GAIN
+    putreg32(p.lti_ctl,   LTI_BASE_ADDRESS + 0x00);  // LTI_CTL
+
+    // PEAKING (Luma Peaking) at MIXER0 Offset 0x0A 6000 (DE Page 80, 0x11A 6000)
+    putreg32(size,        PEAKING_BASE_ADDRESS + 0x04);  // LP_SIZE_REG
+    putreg32(p.lp_gain,   PEAKING_BASE_ADDRESS + 0x20);  // LP_GAIN_REG
+    putreg32(p.lp_ctrl,   PEAKING_BASE_ADDRESS + 0x00);  // LP_CTRL_REG
+
+    // ASE (Adaptive Saturation Enhancement) at MIXER0 Offset 0x0A 8000 (DE Page 40, 0x11A 8000)
+    putreg32(size,        ASE_BASE_ADDRESS + 0x04);  // ASE_SIZE_REG
+    putreg32(p.ase_gain,  ASE_BASE_ADDRESS + 0x10);  // ASE_GAIN_REG
+    putreg32(p.ase_ctl,   ASE_BASE_ADDRESS + 0x00);  // ASE_CTL_REG
+
+    // FCC (Fancy Color Curvature Change) at MIXER0 Offset 0x0A A000 (DE Page 56, 0x11A A000)
+    putreg32(size, FCC_BASE_ADDRESS + 0x04);  // FCC_INPUT_SIZE
+    for (p.fcc_gain) |gain, i| {
+        putreg32(gain, FCC_BASE_ADDRESS + 0x30 + i * 4);  // FCC_SAT_GAIN_REG
+    }
+    putreg32(p.fcc_ctl, FCC_BASE_ADDRESS + 0x00);  // FCC_CTL_REG
+
+    // Apply Settings
+    // GLB_DBUFFER (Global Double Buffer Control) at GLB Offset 0x008
+    // DOUBLE_BUFFER_RDY (Bit 0) = 1 (Register Value is ready for update)
+    // (DE Page 93, 0x110 0008)
+    const GLB_DBUFFER = 0x110_0008;
+    putreg32(1, GLB_DBUFFER);  // TODO: DMB
+}
+
+/// Base Addresses of the Image Enhancement Blocks (same as de2_init)
+const FCE_BASE_ADDRESS     = 0x011A_0000;
+const BWS_BASE_ADDRESS     = 0x011A_2000;
+const LTI_BASE_ADDRESS     = 0x011A_4000;
+const PEAKING_BASE_ADDRESS = 0x011A_6000;
+const ASE_BASE_ADDRESS     = 0x011A_8000;
+const FCC_BASE_ADDRESS     = 0x011A_A000;
+
+/// Panel Size (pixels)
+const PANEL_WIDTH  = render.PANEL_WIDTH;
+const PANEL_HEIGHT = render.PANEL_HEIGHT;
+
+///////////////////////////////////////////////////////////////////////////////
+//  Reference Model
+
+/// Render a Row of XRGB 8888 pixels in place, the way the Image Enhancement Blocks
+/// would with the Register Values: FCE, BWS, LTI, PEAKING, ASE then FCC.
+/// The Blocks work on the Row only, so this approximates LCE and LTI, which
+/// use a 2D Window in the Hardware.
+pub fn modelRow(p: Plan, row: []u32) void {
+    assert(row.len <= PANEL_WIDTH);
+
+    // FCE and BWS change each pixel by itself
+    for (row) |*px| {
+        var rgb = unpack(px.*);
+        for (rgb) |*ch| {
+            // FCE: Stretch the Contrast around the Mid Level by Gain / 64
+            if (p.fce_gctrl & 1 != 0) {
+                ch.* += @divTrunc((ch.* - 128) * @intCast(i32, p.fce_gain & 0x3F), 64);
+            }
+            // BWS: Black Level becomes 0, White Level becomes 255
+            if (p.bws_gctrl & 1 != 0) {
+                ch.* = ((ch.* - @intCast(i32, p.bws_black)) * @intCast(i32, p.bws_slope) + 128) >> 8;
+            }
+        }
+        px.* = pack(rgb);
+    }
+
+    // LTI and PEAKING boost the Edges of the Luma, found by a High-Pass Filter
+    if ((p.lti_ctl | p.lp_ctrl) & 1 != 0 and row.len >= 3) {
+        var orig: [PANEL_WIDTH]u32 = undefined;
+        std.mem.copy(u32, orig[0..row.len], row);
+        var x: usize = 1;
+        while (x + 1 < row.len) : (x += 1) {
+            const l = unpack(orig[x - 1]);
+            const m = unpack(orig[x]);
+            const r = unpack(orig[x + 1]);
+            const hp = 2 * luma(m) - luma(l) - luma(r);
+            var rgb = m;
+            for (rgb) |*ch, i| {
+                // LTI: Sharpen by Gain / 16, without Overshoot beyond the Neighbours
+                if (p.lti_ctl & 1 != 0) {
+                    const lo = std.math.min3(l[i], m[i], r[i]);
+                    const hi = std.math.max3(l[i], m[i], r[i]);
+                    ch.* = std.math.clamp(ch.* + @divTrunc(hp * @intCast(i32, p.lti_gain & 0x1F), 16), lo, hi);
+                }
+                // PEAKING: Sharpen by Gain / 64, Overshoot allowed
+                if (p.lp_ctrl & 1 != 0) {
+                    ch.* += @divTrunc(hp * @intCast(i32, p.lp_gain & 0xFF), 64);
+                }
+            }
+            row[x] = pack(rgb);
+        }
+    }
+
+    // ASE and FCC scale the Chroma (distance from Luma) of each pixel
+    for (row) |*px| {
+        var rgb = unpack(px.*);
+        const y = luma(rgb);
+
+        // ASE: Saturation * (32 + Gain) / 32
+        var scale: i32 = 32 * 4;
+        if (p.ase_ctl & 1 != 0) { scale = (32 + @intCast(i32, p.ase_gain & 0x1F)) * 4; }
+
+        // FCC: Saturation * (128 + Gain of the Hue) / 128
+        if (p.fcc_ctl & 1 != 0) {
+            const gain = @bitCast(i8, @truncate(u8, p.fcc_gain[@enumToInt(hueOf(rgb))]));
+            scale = @divTrunc(scale * (128 + @as(i32, gain)), 128);
+        }
+        for (rgb) |*ch| {
+            ch.* = y + @divTrunc((ch.* - y) * scale, 32 * 4);
+        }
+        px.* = pack(rgb);
+    }
+}
+
+/// Return the nearest Hue of the pixel, by its strongest and weakest Channels
+fn hueOf(rgb: [3]i32) Hue {
+    const r = rgb[0];
+    const g = rgb[1];
+    const b = rgb[2];
+    if (r >= g and r >= b) {  // Red is strongest
+        return if (2 * g > r + b) .yellow else if (2 * b > r + g) .magenta else .red;
+    } else if (g >= b) {      // Green is strongest
+        return if (2 * r > g + b) .yellow else if (2 * b > r + g) .cyan else .green;
+    } else {                  // Blue is strongest
+        return if (2 * g > r + b) .cyan else if (2 * r > g + b) .magenta else .blue;
+    }
+}
+
+/// Luma of the pixel (BT.601)
+fn luma(rgb: [3]i32) i32 {
+    return (77 * rgb[0] + 150 * rgb[1] + 29 * rgb[2]) >> 8;
+}
+
+/// Split an XRGB 8888 pixel into Red, Green and Blue
+fn unpack(px: u32) [3]i32 {
+    return .{
+        @intCast(i32, (px >> 16) & 0xFF),
+        @intCast(i32, (px >> 8)  & 0xFF),
+        @intCast(i32, px & 0xFF),
+    };
+}
+
+/// Clamp Red, Green and Blue to 0 to 255 and combine them into an Opaque XRGB 8888 pixel
+fn pack(rgb: [3]i32) u32 {
+    var px: u32 = 0xFF00_0000;
+    for (rgb) |ch, i| {
+        const v = @intCast(u32, std.math.clamp(ch, 0, 255));
+        px |= v << @intCast(u5, 16 - 8 * i);
+    }
+    return px;
+}
+
+comptime {
+    @setEvalBranchQuota(100_000);
+
+    // Default Settings turn off every Block, and the Model leaves the pixels untouched
+    const off = plan(.{}).?;
+    assert(off.fce_gctrl | off.bws_gctrl | off.lti_ctl | off.lp_ctrl | off.ase_ctl | off.fcc_ctl == 0);
+    var row = [_]u32 { 0xFF10_2030, 0xFFEB_8040, 0xFF00_FF00, 0xFF80_8080 };
+    const orig = row;
+    modelRow(off, &row);
+    assert(std.mem.eql(u32, &row, &orig));
+
+    // Out of range Settings are rejected
+    assert(plan(.{ .contrast = 64 }) == null);
+    assert(plan(.{ .black_level = 200, .white_level = 100 }) == null);
+
+    // BWS for Video Levels: 16 becomes 0, 235 becomes 255
+    const bws = plan(.{ .black_level = 16, .white_level = 235 }).?;
+    var levels = [_]u32 { 0xFF10_1010, 0xFFEB_EBEB };
+    modelRow(bws, &levels);
+    assert(levels[0] == 0xFF00_0000 and levels[1] == 0xFFFF_FFFF);
+
+    // ASE and FCC don't change Grey
+    const sat = plan(.{ .saturation = 31, .hue_saturation = .{ 127, 0, 0, 0, 0, -128 } }).?;
+    var grey = [_]u32 { 0xFF80_8080 };
+    modelRow(sat, &grey);
+    assert(grey[0] == 0xFF80_8080);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Read and Write Registers
+
+/// Read and Write Registers (see mmio.zig)
+const putreg32 = mmio.putreg32;
+
+/// Aliases for Zig Standard Library
+const assert = std.debug.assert;
+const debug  = std.log.debug;
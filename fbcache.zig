@@ -0,0 +1,230 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! Framebuffer Memory Types for PinePhone on Apache NuttX RTOS.
+//! By default the Framebuffers are Cacheable, so the pixels must be flushed from
+//! the Data Cache before the Display Engine reads them (or we see Black Rows).
+//! A Framebuffer may instead be mapped by the MMU as Normal Non-Cacheable Memory:
+//! Cortex-A53 gathers the writes in its Write Buffers and sends them to DRAM in
+//! Bursts (Write-Combining), and no Cache Maintenance is needed, only a Barrier.
+//! Best for Framebuffers that are written but never read by the CPU. Reads
+//! (like Alpha Blending over the Framebuffer) become very slow.
+//! The Memory Type is selected for each Layer with fb_setcachemode.
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Import the Zig Compiler Info, to check whether we're running on PinePhone
+const builtin = @import("builtin");
+
+/// Import the Display Engine Module, for the Framebuffers
+const render = @import("./render.zig");
+
+/// Import the Parallel Rendering Module, for flushing the Data Cache
+const parallel = @import("./parallel.zig");
+
+/// Import the Monotonic Clock Module
+const clock = @import("./clock.zig");
+
+/// Import NuttX Functions from C
+const c = @cImport({
+    // NuttX Defines
+    @cDefine("__NuttX__",  "");
+    @cDefine("NDEBUG",     "");
+    @cDefine("FAR",        "");
+
+    // NuttX Header Files
+    @cInclude("arch/types.h");
+    @cInclude("../../nuttx/include/limits.h");
+    @cInclude("nuttx/config.h");
+    @cInclude("errno.h");
+});
+
+/// Memory Type of a Framebuffer
+pub const Mode = enum(c_int) {
+    /// Normal Cacheable Memory: Pixels are flushed from the Data Cache after rendering
+    cached = 0,
+    /// Normal Non-Cacheable Memory: Writes are combined into Bursts, no Cache Maintenance
+    write_combining = 1,
+};
+
+/// Memory Type of each Layer's Framebuffer
+var modes = [_]Mode { .cached } ** render.MAX_LAYERS;
+
+/// Return the Memory Type of the Layer's Framebuffer
+pub fn getMode(plane: usize) Mode {
+    return modes[plane];
+}
+
+/// Map the Framebuffer of Layer `plane` (0 for the Base UI Channel, 1 and 2 for the
+/// Overlays) with the Memory Type. The Framebuffers are padded to whole Pages (render.zig),
+/// so the new Memory Type won't affect any other variables.
+/// NuttX maps all of DRAM as Cacheable, so until the old Translations are discarded,
+/// any Core may still allocate Cache Lines through that Cacheable mapping (even by
+/// Speculative Reads). Hence the order: Remap, invalidate the TLB, then clean and
+/// invalidate the Data Cache. If a Page still translates with the old Memory Type
+/// afterwards, the Framebuffer stays Cacheable, so that its pixels are still flushed.
+pub fn setMode(plane: usize, mode: Mode) void {
+    debug("setMode: plane={}, mode={s}", .{ plane, @tagName(mode) });
+    if (modes[plane] == mode) { return; }
+    const fb = render.getFramebuffers()[plane];
+    const start = @ptrToInt(fb.mem.ptr);
+    assert(start % render.FB_PAGE_SIZE == 0 and fb.mem.len % render.FB_PAGE_SIZE == 0);
+
+    if (builtin.os.tag == .freestanding) {
+        // Remap the Pages (Virtual Address = Physical Address in NuttX)
+        const region = ArmMmuRegion {
+            .base_pa = start,
+            .base_va = start,
+            .size    = fb.mem.len,
+            .name    = fb.name.ptr,
+            .attrs   = MT_RW | MT_SECURE | MT_EXECUTE_NEVER |
+                (if (mode == .write_combining) MT_NORMAL_NC else MT_NORMAL),
+        };
+        const ret = arm64_mmu_set_memregion(&region);
+        if (ret < 0) { std.log.err("setMode: arm64_mmu_set_memregion failed: {}", .{ ret }); return; }
+
+        // Discard the old Translations
+        asm volatile (
+            \\ dsb ishst
+            \\ tlbi vmalle1is
+            \\ dsb ish
+            \\ isb
+            ::: "memory"
+        );
+
+        // Write back and discard the Cache Lines allocated through the old mapping, so that
+        // no Dirty Cache Line will be evicted later over the Non-Cacheable writes, and
+        // no Stale Cache Line will be read after returning to Cacheable
+        up_flush_dcache(start, start + fb.mem.len);
+
+        // Every Page must now translate with the new Memory Type
+        const attr: u64 = if (mode == .write_combining) MAIR_NORMAL_NC else MAIR_NORMAL;
+        var page = start;
+        while (page < start + fb.mem.len) : (page += render.FB_PAGE_SIZE) {
+            if (translateAttr(page) != attr) {
+                std.log.err("setMode: page 0x{x} not remapped, keeping plane {} cacheable", .{ page, plane });
+                modes[plane] = .cached;
+                return;
+            }
+        }
+    }
+    modes[plane] = mode;
+}
+
+/// Translate the Virtual Address with the current Stage 1 Translation (AT S1E1R) and
+/// return its Memory Attributes (PAR_EL1 Bits 56 to 63), or null if it doesn't translate
+fn translateAttr(va: usize) ?u64 {
+    const par = asm volatile (
+        \\ at s1e1r, %[va]
+        \\ isb
+        \\ mrs %[par], par_el1
+        : [par] "=r" (-> u64)
+        : [va] "r" (va)
+        : "memory"
+    );
+    if (par & 1 != 0) { return null; }  // PAR_EL1.F: Translation failed
+    return par >> 56;
+}
+
+/// Return true if the Address Range lies within a Write-Combining Framebuffer.
+/// Called before Cache Maintenance, which isn't needed for these Framebuffers.
+pub fn isWriteCombining(start: usize, end: usize) bool {
+    for (modes) |mode, i| {
+        if (mode != .write_combining) { continue; }
+        const fb = render.getFramebuffers()[i];
+        const fb_start = @ptrToInt(fb.mem.ptr);
+        if (start >= fb_start and end <= fb_start + fb.mem.len) { return true; }
+    }
+    return false;
+}
+
+/// Wait for the Write Buffers to drain to DRAM, so that the Display Engine will see the pixels
+pub fn drain() void {
+    if (builtin.os.tag == .freestanding) {
+        asm volatile ("dsb st" ::: "memory");
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Exported Functions
+
+/// Select the Memory Type of the Framebuffer for Layer `plane` (0, 1 or 2):
+/// 0 for Cacheable, 1 for Write-Combining. Returns 0 if OK, or -EINVAL if invalid.
+pub export fn fb_setcachemode(plane: c_int, mode: c_int) c_int {
+    debug("fb_setcachemode: plane={}, mode={}", .{ plane, mode });
+    if (plane < 0 or plane >= render.MAX_LAYERS or mode < 0 or mode > 1) { return -c.EINVAL; }
+    setMode(@intCast(usize, plane), @intToEnum(Mode, mode));
+    return c.OK;
+}
+
+/// Number of Full-Screen Fills for each Memory Type in test_fbcache
+const TEST_FILLS = 20;
+
+/// Compare the Memory Types on PinePhone: Fill Framebuffer 2 (Second Overlay) with
+/// the Cacheable Path (Fill, then flush the Data Cache) and the Write-Combining Path
+/// (Fill, then Barrier). Prints the time per Fill. Framebuffer 2 is Cacheable afterwards.
+pub export fn test_fbcache() void {
+    const fb = render.getFramebuffers()[2];
+    const pixels = @ptrCast([*]u32, fb.mem.ptr)[0..(fb.stride / 4 * fb.height)];
+    for ([_]Mode { .cached, .write_combining }) |mode| {
+        setMode(2, mode);
+        const start = clock.now_ns();
+        var i: u32 = 0;
+        while (i < TEST_FILLS) : (i += 1) {
+            std.mem.set(u32, pixels, 0x8000_0080 + i);
+            parallel.flushBand(pixels);  // Flush or Barrier, depending on the Memory Type
+        }
+        std.log.info("test_fbcache: {s}: {} us per fill", .{ @tagName(mode), (clock.now_ns() - start) / TEST_FILLS / 1000 });
+    }
+    setMode(2, .cached);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Imported Functions and Variables
+
+/// MMU Region for arm64_mmu_set_memregion. From NuttX arch/arm64/src/common/arm64_mmu.h
+const ArmMmuRegion = extern struct {
+    base_pa: u64,          // Physical Address
+    base_va: u64,          // Virtual Address
+    size:    u64,          // Size (bytes)
+    name:    [*]const u8,  // Region Name (String Literals are null-terminated)
+    attrs:   u32,          // Memory Type and Permissions
+};
+
+/// Region Attributes. From NuttX arch/arm64/src/common/arm64_mmu.h
+const MT_NORMAL_NC: u32 = 3;  // Normal Non-Cacheable (MAIR Index 3)
+const MT_NORMAL:    u32 = 4;  // Normal Write-Back Cacheable (MAIR Index 4)
+const MT_RW:        u32 = 1 << 3;  // Read / Write
+const MT_SECURE:    u32 = 0 << 4;  // Secure
+const MT_EXECUTE_NEVER: u32 = 1 << 5;  // Execute Never
+
+/// Memory Attributes in MAIR_EL1 for MT_NORMAL_NC and MT_NORMAL. From NuttX arch/arm64/src/common/arm64_mmu.h
+const MAIR_NORMAL_NC: u64 = 0x44;  // Normal Non-Cacheable, Inner and Outer
+const MAIR_NORMAL:    u64 = 0xFF;  // Normal Write-Back Read / Write Allocate, Inner and Outer
+
+/// Map a Memory Region with the Attributes. From NuttX arch/arm64/src/common/arm64_mmu.c
+extern fn arm64_mmu_set_memregion(region: *const ArmMmuRegion) c_int;
+
+/// Clean and Invalidate the Data Cache. From NuttX nuttx/cache.h
+extern fn up_flush_dcache(start: usize, end: usize) void;
+
+/// Aliases for Zig Standard Library
+const assert = std.debug.assert;
+const debug  = std.log.debug;
@@ -0,0 +1,273 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! Display Pipeline Health Counters for PinePhone on Apache NuttX RTOS.
+//! When the Display Engine runs short of Memory Bandwidth (like 3 Full-Screen ARGB
+//! Channels), TCON0 runs out of pixels and the Panel shows Black Rows. These
+//! Counters measure it: TCON0 FIFO Underflows, DSI Receive FIFO Overflows, Missed
+//! and Late Vertical Blanking, and a Histogram of the Latency from Framebuffer Update
+//! (Submission) to the Vertical Blanking that starts its Scanout.
+//! Read the Counters with health_getstats (ioctl FBIOGET_HEALTH), or let health_poll
+//! dump them to the Log every DUMP_INTERVAL_MS.
+//! This Module owns the TCON0 Vertical Blanking Flag: Only `pollVblank` clears it.
+//! Other Modules wait for Vertical Blanking by watching the Count that it returns.
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Import the Register Access Module
+const mmio = @import("./mmio.zig");
+
+/// Import the Dynamic Refresh Rate Module, for the Frame Period
+const refresh = @import("./refresh.zig");
+
+/// Import the Monotonic Clock Module
+const clock = @import("./clock.zig");
+
+/// Import NuttX Functions from C
+const c = @cImport({
+    // NuttX Defines
+    @cDefine("__NuttX__",  "");
+    @cDefine("NDEBUG",     "");
+    @cDefine("FAR",        "");
+
+    // NuttX Header Files
+    @cInclude("arch/types.h");
+    @cInclude("../../nuttx/include/limits.h");
+    @cInclude("nuttx/config.h");
+    @cInclude("errno.h");
+});
+
+/// Upper Bounds (milliseconds) of the Latency Histogram Buckets. The last Bucket
+/// counts everything from 100 ms. At 60 Hz a Frame is 16.7 ms, so an Update
+/// normally lands in the 17 ms Bucket or below.
+pub const LATENCY_MS = [_]u32 { 2, 4, 8, 17, 33, 50, 100 };
+
+/// Health Counters of the Display Pipeline since the last reset.
+/// Same layout as `struct fb_health_s` in C, for ioctl.
+pub const Stats = extern struct {
+    /// Vertical Blanking Periods seen (Frames scanned out)
+    vblanks: u32,
+    /// Frames without Vertical Blanking: Gap of more than 1.5 Frame Periods
+    missed_vblanks: u32,
+    /// Vertical Blanking more than 1.1 Frame Periods after the previous one
+    late_vblanks: u32,
+    /// TCON0 ran out of pixels (TCON0_FIFO_Under_Flow was set)
+    tcon0_underflows: u32,
+    /// DSI Receive FIFO overflowed (RX_Overflow was set)
+    dsi_rx_overflows: u32,
+    /// Framebuffer Updates reported by the Display Drivers
+    submissions: u32,
+    /// Latency Histogram: Bucket i counts Frames whose oldest Update waited less than
+    /// LATENCY_MS[i] (and at least LATENCY_MS[i - 1]) for Vertical Blanking
+    latency: [LATENCY_MS.len + 1]u32,
+};
+
+/// Current Counters
+var stats = std.mem.zeroes(Stats);
+
+/// Timestamp (microseconds) of the oldest Update not yet scanned out, or null if none
+var pending_us: ?u64 = null;
+
+/// Timestamp (microseconds) of the last Vertical Blanking, or null after reset
+var last_vblank_us: ?u64 = null;
+
+/// RX_Overflow was set at the last poll. display.zig clears it before every Transmit,
+/// so we count the rising edges instead of clearing it ourselves.
+var dsi_overflow = false;
+
+/// TCON0_FIFO_Under_Flow was set at the last poll. The A64 User Manual doesn't say how
+/// the Flag is cleared, so we don't clear it: We count the rising edges. If the Flag stays
+/// set until TCON0 is initialised again, only the first Underflow is counted.
+var tcon0_underflow = false;
+
+/// Vertical Blanking Periods seen since boot. Unlike `stats.vblanks`, never reset:
+/// refresh.zig and render.zig wait for it to change.
+var vblank_count: u32 = 0;
+
+/// True while `pollVblank` owns the Vertical Blanking Flag, so that concurrent Callers
+/// (like health_poll and refresh.zig) won't count the same Vertical Blanking twice
+var vblank_busy = false;
+
+/// Dump the Counters to the Log at this interval (milliseconds)
+const DUMP_INTERVAL_MS = 10_000;
+
+/// Timestamp (microseconds) of the last Dump
+var last_dump_us: u64 = 0;
+
+/// Gaps between Vertical Blanking longer than this (microseconds) mean that the Display
+/// was off or the Counters weren't polled, so they are not counted as Missed Frames
+const MAX_GAP_US = 1_000_000;
+
+/// Record a Framebuffer Update (Submission) at Time `now` (microseconds). Called by refresh_activity.
+/// Only the oldest Update before each Vertical Blanking goes into the Histogram.
+pub fn submit(now: u64) void {
+    stats.submissions +%= 1;
+    if (pending_us == null) { pending_us = now; }
+}
+
+/// Record a Vertical Blanking at Time `now` (microseconds): Check the Gap since the
+/// previous one, and complete the Latency of the pending Update
+pub fn vblank(now: u64) void {
+    stats.vblanks +%= 1;
+    if (last_vblank_us) |last| {
+        const period: u64 = 1_000_000 / @intCast(u64, refresh.refresh_rate());
+        const gap = now -| last;
+        if (gap <= MAX_GAP_US) {
+            if (gap * 2 > period * 3) {
+                stats.missed_vblanks +%= @intCast(u32, (gap + period / 2) / period - 1);
+            } else if (gap * 10 > period * 11) {
+                stats.late_vblanks +%= 1;
+            }
+        }
+    }
+    last_vblank_us = now;
+
+    if (pending_us) |submitted| {
+        const ms = (now -| submitted) / 1000;
+        var bucket: usize = 0;
+        while (bucket < LATENCY_MS.len and ms >= LATENCY_MS[bucket]) : (bucket += 1) {}
+        stats.latency[bucket] +%= 1;
+        pending_us = null;
+    }
+}
+
+/// Check the TCON0 Vertical Blanking Flag. If TCON0 has raised it, clear it and record
+/// the Vertical Blanking. Returns the number of Vertical Blanking Periods since boot.
+/// This is the only function that clears the Flag: To wait for Vertical Blanking,
+/// call it until the Count changes.
+pub fn pollVblank() u32 {
+    if (!@atomicRmw(bool, &vblank_busy, .Xchg, true, .Acquire)) {
+        if (getreg32(TCON_GINT0_REG) & TCON0_Vb_Int_Flag != 0) {
+            modreg32(0, TCON0_Vb_Int_Flag, TCON_GINT0_REG);  // Write 0 to clear
+            vblank(clock.now_us());
+            @atomicStore(u32, &vblank_count, vblank_count +% 1, .Release);
+        }
+        @atomicStore(bool, &vblank_busy, false, .Release);
+    }
+    return @atomicLoad(u32, &vblank_count, .Acquire);
+}
+
+/// Return a copy of the Counters
+pub fn get() Stats {
+    return stats;
+}
+
+/// Reset the Counters and forget the pending Update
+pub fn reset() void {
+    stats = std.mem.zeroes(Stats);
+    pending_us = null;
+    last_vblank_us = null;
+}
+
+/// Write the Counters to the Log
+pub fn dump() void {
+    const s = stats;
+    std.log.info("health: vblanks={} missed={} late={} tcon0_underflows={} dsi_rx_overflows={} submissions={}", .{
+        s.vblanks, s.missed_vblanks, s.late_vblanks, s.tcon0_underflows, s.dsi_rx_overflows, s.submissions
+    });
+    std.log.info("health: latency_ms <2:{} <4:{} <8:{} <17:{} <33:{} <50:{} <100:{} >=100:{}", .{
+        s.latency[0], s.latency[1], s.latency[2], s.latency[3],
+        s.latency[4], s.latency[5], s.latency[6], s.latency[7]
+    });
+}
+
+comptime {
+    assert(@sizeOf(Stats) == (6 + LATENCY_MS.len + 1) * 4);
+    assert(LATENCY_MS.len + 1 == 8);  // dump() prints 8 Buckets
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Exported Functions
+
+/// Sample the Status Registers of TCON0 and DSI, and record a Vertical Blanking if TCON0
+/// has signalled one. Dumps the Counters every DUMP_INTERVAL_MS.
+/// Call from the TCON0 Vertical Blanking Interrupt, or poll every few milliseconds:
+/// a poll that's slower than one Frame will see Missed Frames that weren't missed.
+pub export fn health_poll() void {
+    const now = clock.now_us();
+
+    // TCON0 raised the Vertical Blanking Flag since the last poll
+    _ = pollVblank();
+
+    // TCON0 ran out of pixels during Scanout
+    const underflow = getreg32(TCON_DEBUG_REG) & TCON0_FIFO_Under_Flow != 0;
+    if (underflow and !tcon0_underflow) { stats.tcon0_underflows +%= 1; }
+    tcon0_underflow = underflow;
+
+    // DSI Receive FIFO overflowed
+    const overflow = getreg32(DSI_CMD_CTL_REG) & RX_Overflow != 0;
+    if (overflow and !dsi_overflow) { stats.dsi_rx_overflows +%= 1; }
+    dsi_overflow = overflow;
+
+    if (now -| last_dump_us >= DUMP_INTERVAL_MS * 1000) {
+        last_dump_us = now;
+        dump();
+    }
+}
+
+/// Copy the Health Counters to `out`.
+/// Called by the NuttX Framebuffer Driver for ioctl FBIOGET_HEALTH.
+/// Returns 0 if OK, or -EINVAL if `out` is null.
+pub export fn health_getstats(
+    vtable: ?*anyopaque,  // Framebuffer Driver (Unused)
+    out: ?*Stats          // Returned Counters
+) c_int {
+    _ = vtable;
+    const p = out orelse return -c.EINVAL;
+    p.* = get();
+    return c.OK;
+}
+
+/// Reset the Health Counters, like before a Load Test.
+/// Called by the NuttX Framebuffer Driver for ioctl FBIORESET_HEALTH.
+pub export fn health_reset() void {
+    debug("health_reset", .{});
+    reset();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Status Registers
+
+/// TCON_GINT0_REG (TCON Global Interrupt Register 0) at TCON0 Offset 0x04 (A64 Page 509):
+/// TCON0_Vb_Int_Flag (Bit 15) is set at Vertical Blanking. Write 0 to clear.
+const TCON_GINT0_REG = 0x1C0_C004;
+const TCON0_Vb_Int_Flag: u32 = 1 << 15;
+
+/// TCON_DEBUG_REG (TCON Debug Register) at TCON0 Offset 0xFC:
+/// TCON0_FIFO_Under_Flow (Bit 31) is set when TCON0 runs out of pixels. We only read it.
+const TCON_DEBUG_REG = 0x1C0_C0FC;
+const TCON0_FIFO_Under_Flow: u32 = 1 << 31;
+
+/// DSI_CMD_CTL_REG (DSI Low Power Control Register) at DSI Offset 0x200:
+/// RX_Overflow (Bit 26) is set when the Receive FIFO overflows.
+/// The Video FIFO of the A64 DSI has no documented Error Flags.
+const DSI_CMD_CTL_REG = 0x1CA_0200;
+const RX_Overflow: u32 = 1 << 26;
+
+///////////////////////////////////////////////////////////////////////////////
+//  Read and Write Registers
+
+/// Read and Write Registers (see mmio.zig)
+const getreg32 = mmio.getreg32;
+const modreg32 = mmio.modreg32;
+
+/// Aliases for Zig Standard Library
+const assert = std.debug.assert;
+const debug  = std.log.debug;
@@ -0,0 +1,138 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! Host Framebuffer Backend for the PinePhone Display Drivers (runs on Linux, not NuttX).
+//! Maps the Pages of Framebuffers 0, 1 and 2 (render.zig) to Files with `mmap`, so the
+//! Rendering Code runs unmodified at native speed and writes its pixels straight into
+//! the Files. External Viewers and Diff Tools may read the Files while the program runs.
+//! No Display Server is needed.
+//!
+//! Each Framebuffer becomes a File `fb0.pam`, `fb1.pam` or `fb2.pam`: A Netpbm PAM Header,
+//! padded with a Comment Line to HEADER_SIZE (4096) bytes, followed by the pixels exactly
+//! as in the Framebuffer:
+//!
+//!     P7
+//!     WIDTH 720
+//!     HEIGHT 1440
+//!     DEPTH 4
+//!     MAXVAL 255
+//!     TUPLTYPE BGR_ALPHA
+//!     #   (padded with spaces)
+//!     ENDHDR
+//!
+//! Every pixel is 4 bytes: Blue, Green, Red, Alpha (ARGB 8888 in Little Endian).
+//! The Alpha of Framebuffer 0 is unused (XRGB 8888). Rows are WIDTH * 4 bytes, without
+//! padding. The File may end with up to 4 KB of zeros, the padding of the Framebuffer Pages.
+//! To convert a Frame to PNG:
+//!     ffmpeg -f rawvideo -pixel_format bgra -video_size 720x1440 \
+//!         -skip_initial_bytes 4096 -i fb0.pam -frames:v 1 fb0.png
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Import the Display Engine Module, for the Framebuffers
+const render = @import("./render.zig");
+
+/// Pixels begin at this File Offset, so that the File Pages can be mapped to the Framebuffer
+pub const HEADER_SIZE = render.FB_PAGE_SIZE;
+
+/// Map the Framebuffers to Files in the Directory `dir_path`. The current pixels are
+/// copied to the Files, then the Framebuffers are replaced by the mapped Files at the
+/// same addresses. The Files stay mapped until the program exits.
+pub fn open(dir_path: []const u8) !void {
+    debug("open: {s}", .{ dir_path });
+    if (HEADER_SIZE % std.mem.page_size != 0) { return error.PageSizeTooLarge; }
+    var dir = try std.fs.cwd().openDir(dir_path, .{});
+    defer dir.close();
+    for (render.getFramebuffers()) |fb| {
+        try mapFramebuffer(dir, fb);
+    }
+}
+
+/// Write the pixels of the mapped Framebuffers to the Files, so that other programs
+/// will see a complete Frame. Not needed for correctness: the Kernel writes them eventually.
+pub fn sync() void {
+    for (render.getFramebuffers()) |fb| {
+        std.os.msync(@alignCast(std.mem.page_size, fb.mem), std.os.MSF.SYNC) catch |err| {
+            std.log.err("sync: {s} failed: {}", .{ fb.name, err });
+        };
+    }
+}
+
+/// Map the Framebuffer to the File `<dir>/<name>.pam`
+fn mapFramebuffer(dir: std.fs.Dir, fb: render.Framebuffer) !void {
+    debug("mapFramebuffer: {s}, {} x {}", .{ fb.name, fb.width, fb.height });
+    assert(fb.stride == fb.width * 4);
+    assert(fb.mem.len >= fb.stride * fb.height);
+
+    var name_buf: [16]u8 = undefined;
+    const name = try std.fmt.bufPrint(&name_buf, "{s}.pam", .{ fb.name });
+    const file = try dir.createFile(name, .{ .read = true, .truncate = true });
+    defer file.close();  // Mapping stays after the File is closed
+
+    // Write the Header and the current pixels
+    var header: [HEADER_SIZE]u8 = undefined;
+    writeHeader(&header, fb.width, fb.height);
+    try file.pwriteAll(&header, 0);
+    try file.pwriteAll(fb.mem, HEADER_SIZE);
+
+    // Replace the Framebuffer Pages by the File Pages. The Rendering Code keeps the same addresses.
+    _ = try std.os.mmap(
+        @alignCast(std.mem.page_size, fb.mem.ptr),
+        fb.mem.len,
+        std.os.PROT.READ | std.os.PROT.WRITE,
+        std.os.MAP.SHARED | std.os.MAP.FIXED,
+        file.handle,
+        HEADER_SIZE
+    );
+}
+
+/// Write the PAM Header for the Framebuffer, padded to HEADER_SIZE with a Comment Line
+fn writeHeader(header: *[HEADER_SIZE]u8, width: usize, height: usize) void {
+    const head = std.fmt.bufPrint(
+        header,
+        "P7\nWIDTH {}\nHEIGHT {}\nDEPTH 4\nMAXVAL 255\nTUPLTYPE BGR_ALPHA\n#",
+        .{ width, height }
+    ) catch unreachable;
+    const end = "\nENDHDR\n";
+    std.mem.set(u8, header[head.len..(HEADER_SIZE - end.len)], ' ');
+    std.mem.copy(u8, header[(HEADER_SIZE - end.len)..], end);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Exported Functions
+
+/// Map the Framebuffers to Files in the Directory. For C Programs on the Host Computer.
+/// Returns 0 if OK, or -1 if the Files couldn't be created or mapped.
+pub export fn hostfb_open(dir_path: [*:0]const u8) c_int {
+    open(std.mem.span(dir_path)) catch |err| {
+        std.log.err("hostfb_open: {}", .{ err });
+        return -1;
+    };
+    return 0;
+}
+
+/// Write the pixels of the mapped Framebuffers to the Files
+pub export fn hostfb_sync() void {
+    sync();
+}
+
+/// Aliases for Zig Standard Library
+const assert = std.debug.assert;
+const debug  = std.log.debug;
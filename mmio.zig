@@ -0,0 +1,329 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! Register Access for the PinePhone Display Drivers on Apache NuttX RTOS.
+//! Provides getreg32 / putreg32 / modreg32 (with Stub Registers on the Host
+//! Computer), Register Layouts as Packed Structs, Transactions that merge
+//! consecutive Field Updates into a single Store, plus the Panic Handler
+//! and Logging shared by the Driver Modules.
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Import the Root Module, which provides Stub Registers when running on a Host Computer (see bench.zig)
+const root = @import("root");
+
+/// Import NuttX Functions from C
+const c = @cImport({
+    // NuttX Defines
+    @cDefine("__NuttX__",  "");
+    @cDefine("NDEBUG",     "");
+    @cDefine("FAR",        "");
+
+    // NuttX Header Files
+    @cInclude("arch/types.h");
+    @cInclude("../../nuttx/include/limits.h");
+    @cInclude("nuttx/config.h");
+    @cInclude("stdlib.h");
+    @cInclude("unistd.h");
+});
+
+///////////////////////////////////////////////////////////////////////////////
+//  Register Layouts
+
+/// Define a 32-bit Register at `address` whose Fields are given by the
+/// Packed Struct `Layout` (Bit 0 first). Every Field of `Layout` must have a
+/// Default Value, usually 0, so that Reserved Bits may be left out.
+pub fn Register(comptime Layout: type, comptime address: u64) type {
+    comptime { assert(@bitSizeOf(Layout) == 32); }
+    return struct {
+        /// Fields of the Register
+        pub const Fields = Layout;
+
+        /// Address of the Register
+        pub const addr = address;
+
+        /// Read all Fields of the Register
+        pub fn read() Layout {
+            return @bitCast(Layout, getreg32(address));
+        }
+
+        /// Write all Fields of the Register, computed at Runtime.
+        /// Fields not given take their Default Values.
+        pub fn write(fields: Layout) void {
+            putreg32(@bitCast(u32, fields), address);
+        }
+
+        /// Update that stores all Fields. Fields not given take their
+        /// Default Values, so the Register won't be read.
+        pub fn init(comptime fields: anytype) Update {
+            var val = Layout {};
+            inline for (std.meta.fields(@TypeOf(fields))) |f| {
+                @field(val, f.name) = @field(fields, f.name);
+            }
+            return .{ .addr = address, .mask = 0xFFFF_FFFF, .val = @bitCast(u32, val) };
+        }
+
+        /// Update that modifies only the Fields given, the other Fields are preserved
+        pub fn set(comptime fields: anytype) Update {
+            var val  = @bitCast(Layout, @as(u32, 0));
+            var mask = @bitCast(Layout, @as(u32, 0));
+            inline for (std.meta.fields(@TypeOf(fields))) |f| {
+                @field(val, f.name) = @field(fields, f.name);
+                @field(mask, f.name) = std.math.maxInt(@TypeOf(@field(mask, f.name)));
+            }
+            return .{ .addr = address, .mask = @bitCast(u32, mask), .val = @bitCast(u32, val) };
+        }
+    };
+}
+
+/// Update to the Fields of a Register: Bits in `mask` are set to `val`.
+/// Or a Delay between Updates, if `delay_us` is non-zero.
+pub const Update = struct {
+    addr: u64,  // Address of the Register
+    mask: u32,  // Bits to be updated
+    val:  u32,  // New value of the Bits
+    delay_us: u32 = 0,  // Microseconds to wait
+    modify: bool = false,  // Always read-modify-write, never coalesced
+};
+
+/// Update that stores `val` into the Register at `addr`. For Undocumented Registers without a Layout.
+pub fn store(comptime addr: u64, comptime val: u32) Update {
+    return .{ .addr = addr, .mask = 0xFFFF_FFFF, .val = val };
+}
+
+/// Update that sets the Bits in `mask` to `val` with a read-modify-write, even if the
+/// Transaction has stored the Register. For Undocumented Registers whose other Bits
+/// may be changed by the Hardware, so we don't own the full word.
+pub fn modify(comptime addr: u64, comptime mask: u32, comptime val: u32) Update {
+    return .{ .addr = addr, .mask = mask, .val = val, .modify = true };
+}
+
+/// Wait `us` microseconds before the next Update
+pub fn delay(comptime us: u32) Update {
+    assert(us > 0);
+    return .{ .addr = 0, .mask = 0, .val = 0, .delay_us = us };
+}
+
+/// Apply the Updates in order, as a Transaction. Consecutive Updates to the
+/// same Register are merged at Compile Time into one Store. If the Transaction
+/// has already stored all Bits of a Register, later Updates to the Register
+/// are Stores too, without reading it back. So this costs no more than the
+/// hand-written putreg32 and modreg32, and often less.
+/// Registers that are changed by the Hardware (like PLL LOCK) should be
+/// updated in separate Transactions, or with `modify`.
+pub fn commit(comptime updates: []const Update) void {
+    const stores = comptime coalesce(updates);
+    inline for (stores) |u| {
+        if (u.delay_us > 0) {
+            _ = c.usleep(u.delay_us);
+        } else if (u.mask == 0xFFFF_FFFF and !u.modify) {
+            putreg32(u.val, u.addr);  // TODO: DMB
+        } else {
+            modreg32(u.val, u.mask, u.addr);  // TODO: DMB
+        }
+    }
+}
+
+/// Merge consecutive Updates to the same Register, and turn Updates to a
+/// Register with known value into Stores. Updates are never reordered,
+/// because the Hardware may depend on the order.
+fn coalesce(comptime updates: []const Update) []const Update {
+    var merged: [updates.len]Update = undefined;
+    var n: usize = 0;
+    for (updates) |u| {
+        if (u.delay_us > 0 or u.modify) {
+            assert(u.val & ~u.mask == 0);
+            merged[n] = u;
+            n += 1;
+            continue;
+        }
+        assert(u.val & ~u.mask == 0);
+
+        // Find the last Update to the Register. If it was a Store, we know the value.
+        var update = u;
+        var i = n;
+        while (i > 0) {
+            i -= 1;
+            if (merged[i].delay_us > 0 or merged[i].addr != u.addr) { continue; }
+            if (merged[i].mask == 0xFFFF_FFFF and !merged[i].modify) {
+                update.val  = (merged[i].val & ~u.mask) | u.val;
+                update.mask = 0xFFFF_FFFF;
+            }
+            break;
+        }
+
+        // Merge with the previous Update if it's the same Register
+        if (n > 0 and merged[n - 1].delay_us == 0 and !merged[n - 1].modify and merged[n - 1].addr == u.addr) {
+            merged[n - 1].val  = (merged[n - 1].val & ~update.mask) | update.val;
+            merged[n - 1].mask |= update.mask;
+        } else {
+            merged[n] = update;
+            n += 1;
+        }
+    }
+    const result = merged[0..n].*;
+    return &result;
+}
+
+comptime {
+    // Consecutive Updates are merged, and become a Store once all Bits are covered.
+    // After a Delay, a Register with known value is stored without reading it.
+    const R = Register(packed struct { lo: u16 = 0, hi: u16 = 0 }, 0x1c0c040);
+    const S = Register(packed struct { all: u32 = 0 }, 0x1c0c044);
+    const stores = coalesce(&.{
+        R.set(.{ .lo = 0x1234 }), R.set(.{ .hi = 0x8000 }),
+        S.set(.{ .all = 5 }),
+        delay(1),
+        R.set(.{ .lo = 1 }),
+        S.set(.{ .all = 6 }),
+    });
+    assert(stores.len == 5);
+    assert(stores[0].mask == 0xFFFF_FFFF and stores[0].val == 0x8000_1234);
+    assert(stores[1].addr == S.addr and stores[1].mask == 0xFFFF_FFFF);
+    assert(stores[2].delay_us == 1);
+    assert(stores[3].mask == 0xFFFF_FFFF and stores[3].val == 0x8000_0001);
+    assert(stores[4].mask == 0xFFFF_FFFF and stores[4].val == 6);
+
+    // Modify is never merged into a Store, even after the Register was stored
+    const mods = coalesce(&.{
+        store(S.addr, 0x2),
+        modify(S.addr, 0x10, 0x10),
+        modify(S.addr, 0xf00_0000, 0xf00_0000),
+        S.set(.{ .all = 7 }),
+    });
+    assert(mods.len == 4);
+    assert(mods[0].mask == 0xFFFF_FFFF and !mods[0].modify);
+    assert(mods[1].modify and mods[1].mask == 0x10);
+    assert(mods[2].modify and mods[2].mask == 0xf00_0000);
+    assert(mods[3].mask == 0xFFFF_FFFF and mods[3].val == 7);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Read and Write Registers
+
+/// Modify the specified bits in a memory mapped register.
+/// Based on https://github.com/apache/nuttx/blob/master/arch/arm64/src/common/arm64_arch.h#L473
+pub fn modreg32(
+    val: u32,   // Bits to set, like (1 << bit)
+    comptime mask: u32,  // Bits to clear, like (1 << bit)
+    addr: u64  // Address to modify
+) void {
+    debug("  *0x{x}: clear 0x{x}, set 0x{x}", .{ addr, mask, val & mask });
+    assert(val & mask == val);
+    putreg32(
+        (getreg32(addr) & ~(mask))
+            | ((val) & (mask)),
+        (addr)
+    );
+}
+
+/// Get the 8-bit value at the address
+pub fn getreg8(addr: u64) u8 {
+    const ptr = @intToPtr(*const volatile u8, addr);
+    return ptr.*;
+}
+
+/// Get the 32-bit value at the address
+pub fn getreg32(addr: u64) u32 {
+    if (@hasDecl(root, "stub_getreg32")) { return root.stub_getreg32(addr); }
+    const ptr = @intToPtr(*const volatile u32, addr);
+    return ptr.*;
+}
+
+/// Set the 32-bit value at the address
+pub fn putreg32(val: u32, addr: u64) void {
+    if (enableLog) { debug("  *0x{x} = 0x{x}", .{ addr, val }); }
+    if (@hasDecl(root, "stub_putreg32")) { return root.stub_putreg32(val, addr); }
+    const ptr = @intToPtr(*volatile u32, addr);
+    ptr.* = val;
+}
+
+/// Set to False to disable log
+pub var enableLog = true;
+
+///////////////////////////////////////////////////////////////////////////////
+//  Panic Handler
+
+/// Called by Zig when it hits a Panic. We print the Panic Message, Stack Trace and halt. See
+/// https://andrewkelley.me/post/zig-stack-traces-kernel-panic-bare-bones-os.html
+/// https://github.com/ziglang/zig/blob/master/lib/std/builtin.zig#L763-L847
+pub fn panic(
+    message: []const u8,
+    _stack_trace: ?*std.builtin.StackTrace
+) noreturn {
+    // Print the Panic Message
+    _ = _stack_trace;
+    _ = puts("\n!ZIG PANIC!");
+    _ = puts(@ptrCast([*c]const u8, message));
+
+    // Print the Stack Trace
+    _ = puts("Stack Trace:");
+    var it = std.debug.StackIterator.init(@returnAddress(), null);
+    while (it.next()) |return_address| {
+        _ = printf("%p\n", return_address);
+    }
+
+    // Halt
+    c.exit(1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Logging
+
+/// Called by Zig for `std.log.debug`, `std.log.info`, `std.log.err`, ...
+/// https://gist.github.com/leecannon/d6f5d7e5af5881c466161270347ce84d
+pub fn log(
+    comptime _message_level: std.log.Level,
+    comptime _scope: @Type(.EnumLiteral),
+    comptime format: []const u8,
+    args: anytype,
+) void {
+    _ = _message_level;
+    _ = _scope;
+
+    // Format the message
+    var buf: [100]u8 = undefined;  // Limit to 100 chars
+    var slice = std.fmt.bufPrint(&buf, format, args)
+        catch { _ = puts("*** log error: buf too small"); return; };
+
+    // Terminate the formatted message with a null
+    var buf2: [buf.len + 1 : 0]u8 = undefined;
+    std.mem.copy(
+        u8,
+        buf2[0..slice.len],
+        slice[0..slice.len]
+    );
+    buf2[slice.len] = 0;
+
+    // Print the formatted message
+    _ = puts(&buf2);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Imported Functions and Variables
+
+/// For safety, we import these functions ourselves to enforce Null-Terminated Strings.
+/// We changed `[*c]const u8` to `[*:0]const u8`
+extern fn printf(format: [*:0]const u8, ...) c_int;
+extern fn puts(str: [*:0]const u8) c_int;
+
+/// Aliases for Zig Standard Library
+const assert = std.debug.assert;
+const debug  = std.log.debug;
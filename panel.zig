@@ -24,6 +24,21 @@
 /// Import the Zig Standard Library
 const std = @import("std");
 
+/// Import the Register Access Module
+const mmio = @import("./mmio.zig");
+
+/// Import the MIPI Display Serial Interface Module, to ask the Panel
+const dsi = @import("./display.zig");
+
+/// Import the PMIC Module, for the DLDO2 Power Supply
+const pmic = @import("./pmic.zig");
+
+/// Import the Readiness Waits Module
+const ready = @import("./ready.zig");
+
+/// Import the Monotonic Clock Module
+const clock = @import("./clock.zig");
+
 /// Import NuttX Functions from C
 const c = @cImport({
     // NuttX Defines
@@ -70,6 +85,9 @@ pub export fn panel_reset() void {
     comptime { assert(PD23_MASK   == 0x70000000); }
     modreg32(PD23_SELECT, PD23_MASK, PD_CFG2_REG);  // TODO: DMB
 
+    // Wait for DLDO2 (MIPI DSI Connector) to settle after display_board_init
+    ready.waitMin(.dldo2, pmic.dldo2_on_us, pmic.DLDO2_SETTLE_US);
+
     // Set PD23 to High
     // Register PD_DATA_REG (PD Data Register)
     // At PIO Offset 0x7C (A64 Page 388)
@@ -82,112 +100,40 @@ pub export fn panel_reset() void {
     comptime { assert(PD_DATA_REG == 0x1c2087c); }
     const PD23: u24 = 1 << 23;
     modreg32(PD23, PD23, PD_DATA_REG);  // TODO: DMB
+    const reset_at = clock.now_us();
 
-    // wait for initialization
-    // udelay 15000    
+    // Wait for initialization: Previously we waited 15 milliseconds (udelay 15000).
+    // ST7703 needs RESET_MIN_US after Reset (in Sleep In Mode), then we ask the Panel
+    // for its Power Mode until it answers, up to RESET_TIMEOUT_US
     debug("wait for initialization", .{});
-    _ = c.usleep(15000);
+    _ = ready.pollUntil(.panel_reset, reset_at, RESET_MIN_US, RESET_TIMEOUT_US, isPanelReady);
 }
 
-/// Modify the specified bits in a memory mapped register.
-/// Note: Parameters are different from modifyreg32
-/// Based on https://github.com/apache/nuttx/blob/master/arch/arm64/src/common/arm64_arch.h#L473
-fn modreg32(
-    comptime val: u32,   // Bits to set, like (1 << bit)
-    comptime mask: u32,  // Bits to clear, like (1 << bit)
-    addr: u64  // Address to modify
-) void {
-    comptime { assert(val & mask == val); }
-    debug("  *0x{x}: clear 0x{x}, set 0x{x}", .{ addr, mask, val & mask });
-    putreg32(
-        (getreg32(addr) & ~(mask))
-            | ((val) & (mask)),
-        (addr)
-    );
-}
+/// Microseconds to wait after Reset (in Sleep In Mode) before sending Commands to ST7703
+const RESET_MIN_US = 5_000;
 
-/// Get the 32-bit value at the address
-fn getreg32(addr: u64) u32 {
-    const ptr = @intToPtr(*const volatile u32, addr);
-    return ptr.*;
-}
+/// Give up waiting for the LCD Panel at this time (microseconds) after Reset
+const RESET_TIMEOUT_US = 15_000;
 
-/// Set the 32-bit value at the address
-fn putreg32(val: u32, addr: u64) void {
-    if (enableLog) { debug("  *0x{x} = 0x{x}", .{ addr, val }); }
-    const ptr = @intToPtr(*volatile u32, addr);
-    ptr.* = val;
+/// Return true if the LCD Panel answers DCS Get Power Mode.
+/// Failed attempts aren't logged: ready.pollUntil logs the Timeout.
+fn isPanelReady() bool {
+    return dsi.pollPowerMode() != null;
 }
 
-/// Set to False to disable log 
-var enableLog = true;
+/// Read and Write Registers (see mmio.zig)
+const modreg32 = mmio.modreg32;
 
 ///////////////////////////////////////////////////////////////////////////////
-//  Panic Handler
-
-/// Called by Zig when it hits a Panic. We print the Panic Message, Stack Trace and halt. See 
-/// https://andrewkelley.me/post/zig-stack-traces-kernel-panic-bare-bones-os.html
-/// https://github.com/ziglang/zig/blob/master/lib/std/builtin.zig#L763-L847
-pub fn panic(
-    message: []const u8, 
-    _stack_trace: ?*std.builtin.StackTrace
-) noreturn {
-    // Print the Panic Message
-    _ = _stack_trace;
-    _ = puts("\n!ZIG PANIC!");
-    _ = puts(@ptrCast([*c]const u8, message));
-
-    // Print the Stack Trace
-    _ = puts("Stack Trace:");
-    var it = std.debug.StackIterator.init(@returnAddress(), null);
-    while (it.next()) |return_address| {
-        _ = printf("%p\n", return_address);
-    }
-
-    // Halt
-    c.exit(1);
-}
+//  Panic Handler and Logging
 
-///////////////////////////////////////////////////////////////////////////////
-//  Logging
-
-/// Called by Zig for `std.log.debug`, `std.log.info`, `std.log.err`, ...
-/// https://gist.github.com/leecannon/d6f5d7e5af5881c466161270347ce84d
-pub fn log(
-    comptime _message_level: std.log.Level,
-    comptime _scope: @Type(.EnumLiteral),
-    comptime format: []const u8,
-    args: anytype,
-) void {
-    _ = _message_level;
-    _ = _scope;
-
-    // Format the message
-    var buf: [100]u8 = undefined;  // Limit to 100 chars
-    var slice = std.fmt.bufPrint(&buf, format, args)
-        catch { _ = puts("*** log error: buf too small"); return; };
-    
-    // Terminate the formatted message with a null
-    var buf2: [buf.len + 1 : 0]u8 = undefined;
-    std.mem.copy(
-        u8, 
-        buf2[0..slice.len], 
-        slice[0..slice.len]
-    );
-    buf2[slice.len] = 0;
-
-    // Print the formatted message
-    _ = puts(&buf2);
-}
+/// Called by Zig when it hits a Panic, and for `std.log.debug`, `std.log.err`, ... (see mmio.zig)
+pub const panic = mmio.panic;
+pub const log   = mmio.log;
 
 ///////////////////////////////////////////////////////////////////////////////
 //  Imported Functions and Variables
 
-/// For safety, we import these functions ourselves to enforce Null-Terminated Strings.
-/// We changed `[*c]const u8` to `[*:0]const u8`
-extern fn printf(format: [*:0]const u8, ...) c_int;
-extern fn puts(str: [*:0]const u8) c_int;
-
 /// Aliases for Zig Standard Library
 const assert = std.debug.assert;
 const debug  = std.log.debug;
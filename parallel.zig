@@ -0,0 +1,288 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! Parallel Framebuffer Rendering for Apache NuttX RTOS on PinePhone.
+//! Splits a Framebuffer into Bands of Rows and renders the Bands on the
+//! 4 Cortex-A53 Cores of Allwinner A64, with a pool of POSIX Threads
+//! (NuttX SMP Threads on PinePhone, pthreads on the Host Computer).
+//! Idle Workers steal Bands from busy Workers, and each Worker flushes
+//! the Data Cache for the Bands that it has rendered.
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Import the Zig Compiler Info, to check whether we're running on PinePhone
+const builtin = @import("builtin");
+
+/// Import the Framebuffer Memory Types Module, for Write-Combining Framebuffers
+const fbcache = @import("./fbcache.zig");
+
+/// Import NuttX Functions from C
+const c = @cImport({
+    // NuttX Defines
+    @cDefine("__NuttX__",  "");
+    @cDefine("NDEBUG",     "");
+    @cDefine("FAR",        "");
+
+    // NuttX Header Files
+    @cInclude("arch/types.h");
+    @cInclude("../../nuttx/include/limits.h");
+    @cInclude("nuttx/config.h");
+    @cInclude("pthread.h");
+    @cInclude("sched.h");
+});
+
+/// Number of Workers: One per Cortex-A53 Core in Allwinner A64.
+/// Worker 0 is the Calling Thread, Workers 1 to 3 are in the Thread Pool.
+pub const NUM_WORKERS = 4;
+
+/// Size of a Cortex-A53 Data Cache Line (bytes)
+const CACHE_LINE_SIZE = 64;
+
+/// Preferred number of Rows in a Band. 16 Rows of 720 pixels = 45 KB,
+/// small enough for Work Stealing to balance the load across the Workers
+const BAND_ROWS = 16;
+
+/// Spinlock that yields to other Threads while waiting. Needs no initialisation,
+/// so it may be used before the Thread Pool and its Mutex exist.
+pub const SpinLock = struct {
+    busy: bool = false,  // Set while a Thread holds the Lock
+
+    /// Wait until the Lock is free, then take it
+    pub fn lock(self: *SpinLock) void {
+        while (!self.tryLock()) {
+            _ = c.sched_yield();
+        }
+    }
+
+    /// Take the Lock if it's free. Returns false if another Thread holds it.
+    pub fn tryLock(self: *SpinLock) bool {
+        return !@atomicRmw(bool, &self.busy, .Xchg, true, .Acquire);
+    }
+
+    /// Release the Lock
+    pub fn unlock(self: *SpinLock) void {
+        @atomicStore(bool, &self.busy, false, .Release);
+    }
+};
+
+/// Render a Row of Pixels: `row` is the Row in the Framebuffer, `y` is the Row Number
+pub const RowFn = *const fn (row: []u32, y: usize) void;
+
+/// Render every Row of the Framebuffer by calling `rowFn`, in parallel across the Workers.
+/// Returns after all Rows have been rendered and flushed from the Data Cache.
+/// Callers on other Threads wait for the current Job to finish. `rowFn` must not
+/// call renderRows, because the Job would wait for itself.
+pub fn renderRows(
+    fb: []u32,      // Framebuffer to be rendered
+    width: usize,   // Width of the Framebuffer (pixels)
+    height: usize,  // Height of the Framebuffer (pixels)
+    rowFn: RowFn    // Function that renders a Row
+) void {
+    debug("renderRows: start, width={}, height={}", .{ width, height });
+    defer { debug("renderRows: end", .{}); }
+    assert(fb.len >= width * height);
+
+    // One Job at a time: The Workers share the global Job
+    job_lock.lock();
+    defer job_lock.unlock();
+
+    // Start the Thread Pool on first use
+    if (!started) { startWorkers(); }
+
+    // Split the Framebuffer into Bands that begin and end on a Cache Line,
+    // so that no two Workers will write or flush the same Cache Line
+    // (assuming the Framebuffer is aligned to a Cache Line)
+    var align_rows: usize = 1;
+    while ((width * 4 * align_rows) % CACHE_LINE_SIZE != 0) : (align_rows += 1) {}
+    const band_rows = std.mem.alignForward(BAND_ROWS, align_rows);
+    const num_bands = (height + band_rows - 1) / band_rows;
+
+    // Give each Worker a contiguous range of Bands
+    const per_worker = (num_bands + NUM_WORKERS - 1) / NUM_WORKERS;
+    job.fb     = fb;
+    job.width  = width;
+    job.height = height;
+    job.band_rows = band_rows;
+    job.rowFn  = rowFn;
+    for (job.queues) |*q, i| {
+        q.next = std.math.min(i * per_worker, num_bands);
+        q.end  = std.math.min((i + 1) * per_worker, num_bands);
+    }
+
+    // Wake up the Workers in the Thread Pool
+    _ = c.pthread_mutex_lock(&mutex);
+    generation += 1;
+    pending = num_threads;
+    _ = c.pthread_cond_broadcast(&job_ready);
+    _ = c.pthread_mutex_unlock(&mutex);
+
+    // Calling Thread works as Worker 0. If the Thread Pool couldn't be started,
+    // Worker 0 will steal all the Bands and render everything by itself.
+    runWorker(0);
+
+    // Wait for the Workers to finish
+    _ = c.pthread_mutex_lock(&mutex);
+    while (pending > 0) {
+        _ = c.pthread_cond_wait(&job_done, &mutex);
+    }
+    _ = c.pthread_mutex_unlock(&mutex);
+}
+
+/// Render the Bands in our own Queue, then steal Bands from the other Workers
+fn runWorker(id: usize) void {
+    var n: usize = 0;
+    while (n < NUM_WORKERS) : (n += 1) {
+        // n = 0 is our own Queue, n > 0 are the Queues of other Workers
+        const q = &job.queues[(id + n) % NUM_WORKERS];
+        while (true) {
+            // Take the next Band from the Queue, shared with the Queue Owner and other Thieves
+            const band = @atomicRmw(usize, &q.next, .Add, 1, .Monotonic);
+            if (band >= q.end) { break; }
+            renderBand(band);
+        }
+    }
+}
+
+/// Render the Rows in the Band and flush them from the Data Cache
+fn renderBand(band: usize) void {
+    const y_start = band * job.band_rows;
+    const y_end   = std.math.min(y_start + job.band_rows, job.height);
+    var y = y_start;
+    while (y < y_end) : (y += 1) {
+        const row = job.fb[(y * job.width)..((y + 1) * job.width)];
+        job.rowFn(row, y);
+    }
+
+    // Flush the Band from the Data Cache, so that the Display Engine will see the pixels
+    flushBand(job.fb[(y_start * job.width)..(y_end * job.width)]);
+}
+
+/// Clean the Data Cache for the Band, so that the pixels are written to RAM.
+/// Write-Combining Framebuffers aren't cached, so we only wait for the Writes to drain.
+/// On the Host Computer, the caches are coherent and there's nothing to do.
+pub fn flushBand(pixels: []u32) void {
+    if (builtin.os.tag == .freestanding) {
+        const start = @ptrToInt(pixels.ptr);
+        const end   = start + pixels.len * 4;
+        if (fbcache.isWriteCombining(start, end)) { fbcache.drain(); return; }
+        up_flush_dcache(start, end);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Thread Pool
+
+/// Bands waiting to be rendered by a Worker. `next` is advanced atomically
+/// by the Worker that owns the Queue and by the Workers that steal from it.
+const Queue = struct {
+    next: usize,  // Next Band to be rendered
+    end:  usize,  // Last Band + 1
+};
+
+/// Rendering Job for the Workers
+const Job = struct {
+    fb: []u32,         // Framebuffer to be rendered
+    width: usize,      // Width of the Framebuffer (pixels)
+    height: usize,     // Height of the Framebuffer (pixels)
+    band_rows: usize,  // Number of Rows per Band
+    rowFn: RowFn,      // Function that renders a Row
+    queues: [NUM_WORKERS]Queue,  // Bands for each Worker
+};
+
+/// Current Rendering Job
+var job: Job = undefined;
+
+/// Incremented for every Rendering Job, to wake up the Workers
+var generation: usize = 0;
+
+/// Number of Workers in the Thread Pool that are still rendering the Job
+var pending: usize = 0;
+
+/// Number of Workers that were started in the Thread Pool
+var num_threads: usize = 0;
+
+/// True if the Thread Pool has been started
+var started = false;
+
+/// Held while a Job is running. The Job and the Thread Pool belong to the Thread that holds it.
+/// A Spinlock, because the Thread Pool's Mutex doesn't exist before the first Job.
+var job_lock: SpinLock = .{};
+
+/// Mutex and Condition Variables for the Thread Pool
+var mutex:     c.pthread_mutex_t = undefined;
+var job_ready: c.pthread_cond_t  = undefined;
+var job_done:  c.pthread_cond_t  = undefined;
+
+/// Worker Threads 1 to 3 (Worker 0 is the Calling Thread)
+var threads: [NUM_WORKERS - 1]c.pthread_t = undefined;
+
+/// Start Workers 1 to 3 in the Thread Pool
+fn startWorkers() void {
+    debug("startWorkers", .{});
+    started = true;
+    _ = c.pthread_mutex_init(&mutex, null);
+    _ = c.pthread_cond_init(&job_ready, null);
+    _ = c.pthread_cond_init(&job_done, null);
+
+    var i: usize = 1;
+    while (i < NUM_WORKERS) : (i += 1) {
+        const ret = c.pthread_create(&threads[i - 1], null, workerMain, @intToPtr(?*anyopaque, i));
+        if (ret != 0) {
+            // Continue with fewer Workers. The other Workers will steal the Bands.
+            std.log.err("startWorkers: pthread_create failed, ret={}", .{ ret });
+            break;
+        }
+        num_threads += 1;
+    }
+}
+
+/// Main Loop for Workers 1 to 3: Wait for a Job, render the Bands, repeat
+fn workerMain(arg: ?*anyopaque) callconv(.C) ?*anyopaque {
+    const id = @ptrToInt(arg);
+    var seen: usize = 0;
+    while (true) {
+        // Wait for the next Job
+        _ = c.pthread_mutex_lock(&mutex);
+        while (generation == seen) {
+            _ = c.pthread_cond_wait(&job_ready, &mutex);
+        }
+        seen = generation;
+        _ = c.pthread_mutex_unlock(&mutex);
+
+        // Render our Bands and steal the rest
+        runWorker(id);
+
+        // Tell the Calling Thread when all Workers are done
+        _ = c.pthread_mutex_lock(&mutex);
+        pending -= 1;
+        if (pending == 0) { _ = c.pthread_cond_signal(&job_done); }
+        _ = c.pthread_mutex_unlock(&mutex);
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Imported Functions and Variables
+
+/// Clean and Invalidate the Data Cache. From NuttX nuttx/cache.h
+extern fn up_flush_dcache(start: usize, end: usize) void;
+
+/// Aliases for Zig Standard Library
+const assert = std.debug.assert;
+const debug  = std.log.debug;
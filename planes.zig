@@ -0,0 +1,636 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! Atomic Plane Commits for the Display Engine on Apache NuttX RTOS.
+//! A Commit describes the complete State of the 3 UI Channels (Planes): Framebuffer
+//! Address, Geometry, Z-Order, Alpha and Enable. The Caller builds the State off-line,
+//! we check it against the Hardware Limits, then write only the Registers that differ
+//! from the last Commit and latch them once with GLB_DBUFFER at Vertical Blanking.
+//! The Display Engine never scans out a half-applied State.
+//!
+//! Independent Producers (like a Video Player and the UI) submit Commits through a
+//! Lock-Free Queue. Each Commit changes only the Planes in its `changes` Mask, so the
+//! Producers don't overwrite each other. Commits waiting in the Queue are merged
+//! in order and applied together.
+//!
+//! Registers changed outside this module (renderGraphics, Pan, Transparency, Solid
+//! Overlays, Cursor, Standby) are read back from the Hardware at the next Commit
+//! (see `invalidate`), so a Commit changes only what it was asked to change.
+//! Bits that Commits don't describe, like the Fill Colour of a Solid Overlay, are kept.
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Import the Register Access Module
+const mmio = @import("./mmio.zig");
+
+/// Import the Display Engine Module, for the Framebuffers
+const render = @import("./render.zig");
+
+/// Import the Monotonic Clock Module
+const clock = @import("./clock.zig");
+
+/// Import the Parallel Rendering Module, for the Spinlock
+const parallel = @import("./parallel.zig");
+
+/// Import NuttX Functions from C
+const c = @cImport({
+    // NuttX Defines
+    @cDefine("__NuttX__",  "");
+    @cDefine("NDEBUG",     "");
+    @cDefine("FAR",        "");
+
+    // NuttX Header Files
+    @cInclude("arch/types.h");
+    @cInclude("../../nuttx/include/limits.h");
+    @cInclude("nuttx/config.h");
+    @cInclude("errno.h");
+    @cInclude("unistd.h");
+});
+
+/// Number of Planes: UI Channels 1 to 3
+pub const PLANES = render.MAX_LAYERS;
+
+/// Input Data Formats of a Plane (LAY_FBFMT). Only 32-bit Formats are supported.
+pub const FORMAT_ARGB8888 = 0;
+pub const FORMAT_XRGB8888 = 4;
+
+/// State of a Plane (UI Channel).
+/// Same layout as `struct fb_plane_s` in C.
+pub const Plane = extern struct {
+    addr:   u32,  // Framebuffer Address, 4-byte aligned
+    pitch:  u32,  // Length of a line in bytes
+    width:  u16,  // Horizontal resolution in pixel columns
+    height: u16,  // Vertical resolution in pixel rows
+    x:      u16,  // Position on the Screen (Blender Input Offset)
+    y:      u16,
+    format: u8,   // FORMAT_ARGB8888 or FORMAT_XRGB8888
+    alpha_mode:   u8,  // 0 for Pixel Alpha, 1 for Global Alpha, 2 for Global Alpha mixed with Pixel Alpha
+    global_alpha: u8,  // Global Alpha Value
+    enable: u8,   // 1 to show the Plane, 0 to hide it
+};
+
+/// Complete State of the Planes.
+/// Same layout as `struct fb_planestate_s` in C.
+pub const State = extern struct {
+    planes: [PLANES]Plane,  // UI Channels 1 to 3
+    zorder: [PLANES]u8,     // Plane of each Blender Pipe (0 to 2), from bottom to top
+    _pad:   u8 = 0,
+    background: u32,        // Background Colour (XRGB 8888)
+};
+
+/// Bits of `Commit.changes`: Bit `i` for Plane `i`, plus these
+pub const CHANGE_ZORDER     = 1 << PLANES;
+pub const CHANGE_BACKGROUND = 1 << (PLANES + 1);
+pub const CHANGE_ALL        = (1 << (PLANES + 2)) - 1;
+
+/// Commit submitted by a Producer: The parts of `state` selected by `changes`.
+/// Same layout as `struct fb_commit_s` in C.
+pub const Commit = extern struct {
+    changes: u32,  // Plane Bits, CHANGE_ZORDER and CHANGE_BACKGROUND
+    state:   State,
+};
+
+/// Check the State against the Hardware Limits. Returns true if the Display Engine can show it.
+pub fn check(state: *const State) bool {
+    // Z-Order must use every Plane once
+    var seen: u32 = 0;
+    for (state.zorder) |p| {
+        if (p >= PLANES) { return false; }
+        seen |= @as(u32, 1) << @intCast(u5, p);
+    }
+    if (seen != (1 << PLANES) - 1) { return false; }
+
+    for (state.planes) |plane| {
+        if (plane.enable > 1) { return false; }
+        if (plane.enable == 0) { continue; }
+        if (plane.format != FORMAT_ARGB8888 and plane.format != FORMAT_XRGB8888) { return false; }
+        if (plane.alpha_mode > 2) { return false; }
+        if (plane.addr == 0 or plane.addr % 4 != 0) { return false; }
+        if (plane.width == 0 or plane.height == 0) { return false; }
+        if (plane.pitch % 4 != 0 or plane.pitch < @as(u32, plane.width) * 4) { return false; }
+
+        // Framebuffer must end below 4 GB
+        if (@as(u64, plane.addr) + @as(u64, plane.pitch) * plane.height > 0x1_0000_0000) { return false; }
+
+        // Blender takes no negative coordinates and nothing beyond the Panel
+        if (@as(u32, plane.x) + plane.width  > render.PANEL_WIDTH)  { return false; }
+        if (@as(u32, plane.y) + plane.height > render.PANEL_HEIGHT) { return false; }
+    }
+    return true;
+}
+
+/// Merge the Commit into the State: Copy the parts selected by `changes`
+fn merge(state: *State, commit: *const Commit) void {
+    for (state.planes) |*plane, i| {
+        if (commit.changes & (@as(u32, 1) << @intCast(u5, i)) != 0) { plane.* = commit.state.planes[i]; }
+    }
+    if (commit.changes & CHANGE_ZORDER != 0) { state.zorder = commit.state.zorder; }
+    if (commit.changes & CHANGE_BACKGROUND != 0) { state.background = commit.state.background; }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Register Image
+
+/// Registers of each Plane, at the same Offsets in OVL_UI(CH1), OVL_UI(CH2) and OVL_UI(CH3)
+const OVL_REGS = [_]u64 {
+    0x00,  // OVL_UI_ATTR_CTL (UI Overlay Attribute Control) (DE Page 102)
+    0x10,  // OVL_UI_TOP_LADD (UI Overlay Top Field Memory Block Low Address) (DE Page 104)
+    0x0C,  // OVL_UI_PITCH (UI Overlay Memory Pitch) (DE Page 104)
+    0x04,  // OVL_UI_MBSIZE (UI Overlay Memory Block Size) (DE Page 104)
+    0x88,  // OVL_UI_SIZE (UI Overlay Overlay Window Size) (DE Page 106)
+};
+
+/// Registers of each Blender Pipe (DE Page 108)
+const PIPE_REGS = [_]u64 {
+    0x008,  // BLD_CH_ISIZE (Blender Input Memory Size) at BLD Offset 0x008 + N*0x10
+    0x00C,  // BLD_CH_OFFSET (Blender Input Memory Offset) at BLD Offset 0x00C + N*0x10
+};
+
+/// Index of the Blender Registers in the Register Image
+const REG_PIPES      = PLANES * OVL_REGS.len;
+const REG_RTCTL      = REG_PIPES + PLANES * PIPE_REGS.len;
+const REG_FILL_CTL   = REG_RTCTL + 1;
+const REG_BK_COLOR   = REG_RTCTL + 2;
+const REG_COUNT      = REG_RTCTL + 3;
+
+/// Addresses of the Registers in the Register Image, in the order they are written
+const REGS = blk: {
+    var regs: [REG_COUNT]u64 = undefined;
+    var i: usize = 0;
+    while (i < PLANES) : (i += 1) {
+        // OVL_UI(CH1), OVL_UI(CH2), OVL_UI(CH3) at MIXER0 Offset 0x3000, 0x4000, 0x5000 (DE Page 102)
+        for (OVL_REGS) |offset, r| {
+            regs[i * OVL_REGS.len + r] = OVL_UI_CH1_BASE_ADDRESS + @as(u64, i) * 0x1000 + offset;
+        }
+        // Note: Pipe Registers are N*0x10 apart (DE Page 108), not N*0x14 (DE Page 91)
+        for (PIPE_REGS) |offset, r| {
+            regs[REG_PIPES + i * PIPE_REGS.len + r] = BLD_BASE_ADDRESS + @as(u64, i) * 0x10 + offset;
+        }
+    }
+    regs[REG_RTCTL]    = BLD_BASE_ADDRESS + 0x080;  // BLD_CH_RTCTL (Blender Routing Control) (DE Page 108)
+    regs[REG_FILL_CTL] = BLD_BASE_ADDRESS + 0x000;  // BLD_FILL_COLOR_CTL (Blender Fill Color Control) (DE Page 106)
+    regs[REG_BK_COLOR] = BLD_BASE_ADDRESS + 0x088;  // BLD_BK_COLOR (Blender Background Color) (DE Page 109)
+    break :blk regs;
+};
+
+/// Values of the Registers in REGS
+const Image = [REG_COUNT]u32;
+
+/// Compute the Register Values for the State
+fn encode(state: *const State, image: *Image) void {
+    for (state.planes) |plane, i| {
+        const regs = image[(i * OVL_REGS.len)..((i + 1) * OVL_REGS.len)];
+        const size = @as(u32, plane.height -| 1) << 16 | (plane.width -| 1);
+        regs[0] = @as(u32, plane.global_alpha) << 24   // LAY_GLBALPHA (Bits 24 to 31)
+            | @as(u32, plane.format) << 8        // LAY_FBFMT (Bits 8 to 12)
+            | @as(u32, plane.alpha_mode) << 1    // LAY_ALPHA_MODE (Bits 1 to 2)
+            | plane.enable;                      // LAY_EN (Bit 0)
+        regs[1] = plane.addr;
+        regs[2] = plane.pitch;
+        regs[3] = size;
+        regs[4] = size;
+    }
+
+    // Blender Pipe N takes the Plane zorder[N]
+    var route: u32 = 0;
+    var fill: u32 = 1 << 0;  // P0_FCEN (Bit 0): Fill Pipe 0 with the Fill Color (Opaque Black) under the Plane
+    for (state.zorder) |p, pipe| {
+        const plane = state.planes[p];
+        const regs = image[(REG_PIPES + pipe * PIPE_REGS.len)..(REG_PIPES + (pipe + 1) * PIPE_REGS.len)];
+        regs[0] = @as(u32, plane.height -| 1) << 16 | (plane.width -| 1);
+        regs[1] = @as(u32, plane.y) << 16 | plane.x;
+        route |= @as(u32, p + 1) << @intCast(u5, pipe * 4);  // Pn_RTCTL (Bits 4n to 4n+3): UI Channel
+        if (plane.enable != 0) { fill |= @as(u32, 1) << @intCast(u5, pipe + 8); }  // Pn_EN (Bit n+8)
+    }
+    image[REG_RTCTL]    = route;
+    image[REG_FILL_CTL] = fill;
+    image[REG_BK_COLOR] = state.background;
+}
+
+/// Bits of OVL_UI_ATTR_CTL that are set by Commits: LAY_GLBALPHA, LAY_FBFMT, LAY_ALPHA_MODE
+/// and LAY_EN. The other Bits are kept as they are.
+const ATTR_OWNED: u32 = 0xFF00_1F07;
+
+/// Return the State described by the Register Values. The inverse of `encode`.
+/// Blender Pipes without a valid UI Channel take the remaining Planes in order.
+fn decode(image: *const Image) State {
+    var state = State { .planes = undefined, .zorder = undefined, .background = image[REG_BK_COLOR] };
+
+    // Blender Pipe N takes UI Channel Pn_RTCTL (1 to 3)
+    var used: u32 = 0;
+    var assigned: u32 = 0;
+    for (state.zorder) |*p, pipe| {
+        const ch = (image[REG_RTCTL] >> @intCast(u5, pipe * 4)) & 0xF;
+        if (ch >= 1 and ch <= PLANES and used & (@as(u32, 1) << @intCast(u5, ch - 1)) == 0) {
+            p.* = @intCast(u8, ch - 1);
+            used |= @as(u32, 1) << @intCast(u5, ch - 1);
+            assigned |= @as(u32, 1) << @intCast(u5, pipe);
+        }
+    }
+    for (state.zorder) |*p, pipe| {
+        if (assigned & (@as(u32, 1) << @intCast(u5, pipe)) != 0) { continue; }
+        var plane: u8 = 0;
+        while (used & (@as(u32, 1) << @intCast(u5, plane)) != 0) : (plane += 1) {}
+        p.* = plane;
+        used |= @as(u32, 1) << @intCast(u5, plane);
+    }
+
+    for (state.planes) |*plane, i| {
+        const regs = image[(i * OVL_REGS.len)..((i + 1) * OVL_REGS.len)];
+        plane.* = Plane {
+            .addr   = regs[1],
+            .pitch  = regs[2],
+            .width  = @intCast(u16, (regs[3] & 0x1FFF) + 1),
+            .height = @intCast(u16, ((regs[3] >> 16) & 0x1FFF) + 1),
+            .x = 0,
+            .y = 0,
+            .format       = @intCast(u8, (regs[0] >> 8) & 0x1F),
+            .alpha_mode   = @intCast(u8, (regs[0] >> 1) & 0x3),
+            .global_alpha = @intCast(u8, regs[0] >> 24),
+            .enable       = @intCast(u8, regs[0] & 1),
+        };
+    }
+    for (state.zorder) |p, pipe| {
+        const offset = image[REG_PIPES + pipe * PIPE_REGS.len + 1];
+        state.planes[p].x = @truncate(u16, offset);
+        state.planes[p].y = @truncate(u16, offset >> 16);
+    }
+    return state;
+}
+
+comptime {
+    @setEvalBranchQuota(10_000);
+    assert(@sizeOf(Plane) == 20);
+    assert(@sizeOf(State) == PLANES * 20 + 4 + 4);
+    assert(REGS[0] == 0x110_3000 and REGS[OVL_REGS.len + 1] == 0x110_4010);
+    assert(REGS[REG_PIPES] == 0x110_1008 and REGS[REG_PIPES + 5] == 0x110_102C);
+    assert(REGS[REG_RTCTL] == 0x110_1080);
+
+    // Fullscreen Planes like UI Channels 1 and 3 of renderGraphics(3) give the same Registers
+    var state = State {
+        .planes = [_]Plane { .{
+            .addr = 0x4000_0000, .pitch = 720 * 4, .width = 720, .height = 1440, .x = 0, .y = 0,
+            .format = FORMAT_XRGB8888, .alpha_mode = 2, .global_alpha = 0xFF, .enable = 1,
+        } } ** PLANES,
+        .zorder = .{ 0, 1, 2 },
+        .background = 0xFF00_0000,
+    };
+    state.planes[2].format = FORMAT_ARGB8888;
+    state.planes[2].global_alpha = 0x7F;
+    var image: Image = undefined;
+    encode(&state, &image);
+    assert(image[0] == 0xFF00_0405 and image[2 * OVL_REGS.len] == 0x7F00_0005);
+    assert(image[3] == 0x59F_02CF);
+    assert(image[REG_RTCTL] == 0x321 and image[REG_FILL_CTL] == 0x701);
+
+    // Registers read back give the same State
+    state.planes[1].x = 20;
+    state.planes[1].width = 600;
+    state.zorder = .{ 1, 0, 2 };
+    encode(&state, &image);
+    const back = decode(&image);
+    assert(back.zorder[0] == 1 and back.planes[1].x == 20 and back.planes[1].width == 600);
+    assert(back.planes[2].global_alpha == 0x7F and back.planes[0].format == FORMAT_XRGB8888);
+
+    // Only UI Channel 1 routed, like renderGraphics(1): The other Planes take the other Pipes
+    image[REG_RTCTL] = 0x1;
+    const single = decode(&image);
+    assert(single.zorder[0] == 0 and single.zorder[1] == 1 and single.zorder[2] == 2);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Apply a State
+
+/// State of the last Commit applied to the Registers, valid unless `stale`
+var current: State = undefined;
+
+/// Register Values of the last Commit, valid unless `stale`
+var shadow: Image = undefined;
+
+/// Set if the Registers may have been changed outside this module, so `current` and `shadow`
+/// must be read back from the Hardware. Initially set: We don't know the State yet.
+var stale = true;
+
+/// Number of Registers written by the last Commit, including GLB_DBUFFER
+pub var last_writes: usize = 0;
+
+/// Give up waiting for the previous Commit to be latched after this time (microseconds).
+/// Two Frames at 60 Hz.
+const LATCH_TIMEOUT_US = 34_000;
+
+/// Poll the Latch every 100 microseconds, so the Commit Lock holder doesn't hog the CPU
+const LATCH_POLL_US = 100;
+
+/// Return the State of the last Commit, or the State in the Registers if they were changed
+/// outside this module. Waits for a Commit in progress.
+pub fn getState() State {
+    flushing.lock();
+    const state = currentState();
+    flushing.unlock();
+
+    // A Commit submitted while we held the Lock would be left behind
+    if (pending()) { flush(); }
+    return state;
+}
+
+/// Forget the State of the last Commit, because the Registers were changed elsewhere.
+/// The next Commit reads back the State from the Registers.
+pub fn invalidate() void {
+    @atomicStore(bool, &stale, true, .Release);
+}
+
+/// Return the State of the last Commit. If `stale`, read back the Registers first.
+/// Caller must hold the Commit Lock.
+fn currentState() State {
+    if (@atomicRmw(bool, &stale, .Xchg, false, .Acquire)) {
+        for (shadow) |*val, i| { val.* = getreg32(REGS[i]); }
+        current = decode(&shadow);
+    }
+    return current;
+}
+
+/// Wait until the Display Engine has latched the Registers from the last write of
+/// DOUBLE_BUFFER_RDY, at Vertical Blanking. Returns false if not latched
+/// after LATCH_TIMEOUT_US.
+pub fn waitLatch() bool {
+    const start = clock.now_us();
+    while (getreg32(GLB_DBUFFER) & DOUBLE_BUFFER_RDY != 0) {
+        if (clock.now_us() - start >= LATCH_TIMEOUT_US) { return false; }
+        _ = c.usleep(LATCH_POLL_US);
+    }
+    return true;
+}
+
+/// Write the Registers that differ from the last Commit, then latch them at the next
+/// Vertical Blanking. Called only by `flush`, which allows one Caller at a time.
+fn apply(state: *const State) void {
+    var image: Image = undefined;
+    encode(state, &image);
+
+    // Don't write while the previous Commit is waiting for Vertical Blanking, or it
+    // might be latched half-applied. After that, the Registers are latched only
+    // when we set DOUBLE_BUFFER_RDY.
+    if (!waitLatch()) {
+        std.log.err("apply: previous commit not latched", .{});
+    }
+
+    // Leave the Hardware Cursor alone: Keep the Routing and Enable Bits of its Blender Pipe
+    const cursor = cursorActive();
+    if (cursor) {
+        const route_mask: u32 = 0xF << (CURSOR_PLANE * 4);  // Pn_RTCTL
+        const fill_mask:  u32 = (1 << CURSOR_PLANE) | (1 << (CURSOR_PLANE + 8));  // Pn_FCEN, Pn_EN
+        image[REG_RTCTL]    = (image[REG_RTCTL] & ~route_mask) | (getreg32(REGS[REG_RTCTL]) & route_mask);
+        image[REG_FILL_CTL] = (image[REG_FILL_CTL] & ~fill_mask) | (getreg32(REGS[REG_FILL_CTL]) & fill_mask);
+    }
+
+    // Keep the Bits that Commits don't describe: The other Bits of OVL_UI_ATTR_CTL, and the
+    // Fill Colour Enables (Pn_FCEN). Pipes 1 and up that are filled show Solid Overlays,
+    // so they stay enabled (Pn_EN) even though their UI Channels are disabled.
+    var i: usize = 0;
+    while (i < PLANES) : (i += 1) {
+        const attr = i * OVL_REGS.len;
+        image[attr] = (image[attr] & ATTR_OWNED) | (shadow[attr] & ~ATTR_OWNED);
+    }
+    const fcen = shadow[REG_FILL_CTL] & 0xF;          // Pn_FCEN (Bits 0 to 3)
+    const fill_kept = 0xF | ((fcen & ~@as(u32, 1)) << 8);  // Pn_FCEN, and Pn_EN (Bits 9 to 11) of Solid Overlays
+    image[REG_FILL_CTL] = (image[REG_FILL_CTL] & ~fill_kept) | (shadow[REG_FILL_CTL] & fill_kept);
+
+    var writes: usize = 0;
+    for (image) |val, r| {
+        if (cursor and isCursorReg(r)) { continue; }
+        if (shadow[r] == val) { continue; }
+        putreg32(val, REGS[r]);  // TODO: DMB
+        writes += 1;
+    }
+    shadow = image;
+    if (writes > 0) {
+        putreg32(DOUBLE_BUFFER_RDY, GLB_DBUFFER);  // TODO: DMB
+        writes += 1;
+    }
+    last_writes = writes;
+}
+
+/// Plane of the Hardware Cursor (UI Channel 3, see cursor.zig), which is also its Blender Pipe
+const CURSOR_PLANE = render.CURSOR_OVERLAY + 1;
+
+/// Return true if the Hardware Cursor has taken over its Plane
+fn cursorActive() bool {
+    return render.isOverlayReserved(render.CURSOR_OVERLAY);
+}
+
+/// Return true if Register `i` of the Register Image belongs to the Plane or
+/// Blender Pipe of the Hardware Cursor
+fn isCursorReg(i: usize) bool {
+    const ovl  = CURSOR_PLANE * OVL_REGS.len;
+    const pipe = REG_PIPES + CURSOR_PLANE * PIPE_REGS.len;
+    return (i >= ovl  and i < ovl  + OVL_REGS.len) or
+           (i >= pipe and i < pipe + PIPE_REGS.len);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Lock-Free Queue
+
+/// Number of Commits that may wait in the Queue (Power of 2)
+const QUEUE_SIZE = 8;
+
+/// Slot of the Queue. `seq` tells whose turn it is: the Producer at position `seq`,
+/// or the Consumer at position `seq - 1` (Bounded Queue by Dmitry Vyukov).
+const Slot = struct {
+    seq:    usize,
+    commit: Commit,
+};
+
+/// Queue of submitted Commits: Many Producers, one Consumer (`flush`)
+var slots = blk: {
+    var s: [QUEUE_SIZE]Slot = undefined;
+    for (s) |*slot, i| { slot.seq = i; }
+    break :blk s;
+};
+
+/// Next position for the Producers and for the Consumer
+var head: usize = 0;
+var tail: usize = 0;
+
+/// Held while a Caller is flushing the Queue or reading the State (Commit Lock).
+/// A Caller that takes it with `lock` must flush the Queue after unlocking, if a Commit is pending.
+var flushing: parallel.SpinLock = .{};
+
+/// Add the Commit to the Queue. Returns false if the Queue is full.
+fn push(commit: *const Commit) bool {
+    var pos = @atomicLoad(usize, &head, .Monotonic);
+    while (true) {
+        const slot = &slots[pos % QUEUE_SIZE];
+        const seq = @atomicLoad(usize, &slot.seq, .Acquire);
+        const diff = @bitCast(isize, seq -% pos);
+        if (diff == 0) {
+            // Slot is free: Claim the position, or retry at the position claimed by another Producer
+            if (@cmpxchgWeak(usize, &head, pos, pos +% 1, .Monotonic, .Monotonic)) |actual| {
+                pos = actual;
+                continue;
+            }
+            slot.commit = commit.*;
+            @atomicStore(usize, &slot.seq, pos +% 1, .Release);
+            return true;
+        } else if (diff < 0) {
+            return false;  // Queue is full
+        } else {
+            pos = @atomicLoad(usize, &head, .Monotonic);
+        }
+    }
+}
+
+/// Remove the oldest Commit from the Queue into `commit`. Returns false if the Queue is empty.
+/// Must be called by one Consumer at a time.
+fn pop(commit: *Commit) bool {
+    const slot = &slots[tail % QUEUE_SIZE];
+    if (@atomicLoad(usize, &slot.seq, .Acquire) != tail +% 1) { return false; }
+    commit.* = slot.commit;
+    @atomicStore(usize, &slot.seq, tail +% QUEUE_SIZE, .Release);
+    tail +%= 1;
+    return true;
+}
+
+/// Return true if a Commit is waiting in the Queue
+fn pending() bool {
+    const slot = &slots[tail % QUEUE_SIZE];
+    return @atomicLoad(usize, &slot.seq, .Acquire) == tail +% 1;
+}
+
+/// Check the Commit and add it to the Queue. Returns 0 if OK, -EINVAL if the changed
+/// Planes won't work on the Hardware, -EBUSY if the Commit would change the Plane or
+/// Blender Pipe of the Hardware Cursor, or -EAGAIN if the Queue is full.
+pub fn submit(commit: *const Commit) c_int {
+    if (commit.changes & ~@as(u32, CHANGE_ALL) != 0) { return -c.EINVAL; }
+
+    // While the Hardware Cursor is active, its Plane stays on its own Blender Pipe
+    if (cursorActive()) {
+        if (commit.changes & (1 << CURSOR_PLANE) != 0) { return -c.EBUSY; }
+        if (commit.changes & CHANGE_ZORDER != 0 and
+            commit.state.zorder[CURSOR_PLANE] != CURSOR_PLANE) { return -c.EBUSY; }
+    }
+
+    // Check only the parts to be changed: Each part is valid on its own,
+    // so merging with other Producers' Commits won't break the State
+    var state = commit.state;
+    for (state.planes) |*plane, i| {
+        if (commit.changes & (@as(u32, 1) << @intCast(u5, i)) == 0) { plane.enable = 0; }
+    }
+    if (commit.changes & CHANGE_ZORDER == 0) { state.zorder = .{ 0, 1, 2 }; }
+    if (!check(&state)) { return -c.EINVAL; }
+
+    if (!push(commit)) { return -c.EAGAIN; }
+    return c.OK;
+}
+
+/// Merge the Commits in the Queue and apply them with one Latch.
+/// If another Caller is flushing, it applies our Commits too.
+pub fn flush() void {
+    while (true) {
+        // Only one Consumer at a time
+        if (!flushing.tryLock()) { return; }
+
+        var state = currentState();
+        var commit: Commit = undefined;
+        var merged: usize = 0;
+        while (pop(&commit)) : (merged += 1) {
+            merge(&state, &commit);
+        }
+        if (merged > 0) {
+            apply(&state);
+            current = state;
+        }
+        flushing.unlock();
+
+        // A Commit submitted while we were releasing the Queue would be left behind
+        if (!pending()) { return; }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Exported Functions
+
+/// Copy the State of the last Commit to `out`, so that the Caller can build the next State.
+/// Called by the NuttX Framebuffer Driver for ioctl FBIOGET_PLANESTATE.
+/// Returns 0 if OK, or -EINVAL if `out` is null.
+pub export fn plane_getstate(
+    vtable: ?*anyopaque,  // Framebuffer Driver (Unused)
+    out: ?*State          // Returned State
+) c_int {
+    _ = vtable;
+    const p = out orelse return -c.EINVAL;
+    p.* = getState();
+    return c.OK;
+}
+
+/// Check the complete State against the Hardware Limits, without applying it.
+/// Returns 0 if the State is OK, or -EINVAL if not.
+pub export fn plane_check(
+    vtable: ?*anyopaque,      // Framebuffer Driver (Unused)
+    state: ?*const State      // State to be checked
+) c_int {
+    _ = vtable;
+    const s = state orelse return -c.EINVAL;
+    if (!check(s)) { return -c.EINVAL; }
+    return c.OK;
+}
+
+/// Submit the Commit and apply it (with any other Commits in the Queue) at the next
+/// Vertical Blanking. Safe to call from multiple Threads.
+/// Called by the NuttX Framebuffer Driver for ioctl FBIOSET_COMMIT.
+/// Returns 0 if OK, -EINVAL if the Commit is invalid, -EBUSY if it changes the Plane
+/// of the Hardware Cursor, or -EAGAIN if the Queue is full.
+pub export fn plane_commit(
+    vtable: ?*anyopaque,     // Framebuffer Driver (Unused)
+    commit: ?*const Commit   // Planes to be changed
+) c_int {
+    _ = vtable;
+    const cm = commit orelse return -c.EINVAL;
+    debug("plane_commit: changes=0x{x}", .{ cm.changes });
+    const ret = submit(cm);
+    if (ret != c.OK) { return ret; }
+    flush();
+    return c.OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Display Engine Registers
+
+/// BLD (Blender) is at MIXER0 Offset 0x1000 (DE Page 90, 0x110 1000)
+const BLD_BASE_ADDRESS = 0x110_1000;
+
+/// OVL_UI(CH1) (UI Overlay 1) is at MIXER0 Offset 0x3000 (DE Page 102, 0x110 3000)
+const OVL_UI_CH1_BASE_ADDRESS = 0x110_3000;
+
+/// GLB_DBUFFER (Global Double Buffer Control) at GLB Offset 0x008 (DE Page 93, 0x110 0008):
+/// DOUBLE_BUFFER_RDY (Bit 0) = 1 (Register Value is ready for update).
+/// Cleared by the Display Engine when the Registers are latched.
+const GLB_DBUFFER = 0x110_0008;
+const DOUBLE_BUFFER_RDY: u32 = 1 << 0;
+
+///////////////////////////////////////////////////////////////////////////////
+//  Read and Write Registers
+
+/// Read and Write Registers (see mmio.zig)
+const getreg32 = mmio.getreg32;
+const putreg32 = mmio.putreg32;
+
+/// Aliases for Zig Standard Library
+const assert = std.debug.assert;
+const debug  = std.log.debug;
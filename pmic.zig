@@ -26,6 +26,12 @@
 /// Import the Zig Standard Library
 const std = @import("std");
 
+/// Import the Register Access Module
+const mmio = @import("./mmio.zig");
+
+/// Import the Monotonic Clock Module
+const clock = @import("./clock.zig");
+
 /// Import NuttX Functions from C
 const c = @cImport({
     // NuttX Defines
@@ -160,11 +166,21 @@ pub export fn display_board_init() void {
     const ret6 = pmic_clrsetbits(Output_Power_On_Off_Control2, 0x0, DLDO2);
     assert(ret6 == 0);
 
-    // Wait for power supply and power-on init
-    debug("Wait for power supply and power-on init", .{});
-    _ = c.usleep(15000);
+    // Read back DLDO2 On-Off Control, to be sure that DLDO2 is powering up.
+    // AXP803 has no Power-Good Status for DLDO2, so we don't wait here for the
+    // power supply: panel_reset waits until DLDO2_SETTLE_US after `dldo2_on_us`,
+    // while MIPI DSI and D-PHY are enabled
+    const ret7 = pmic_read(Output_Power_On_Off_Control2);
+    assert(ret7 >= 0 and ret7 & DLDO2 != 0);
+    dldo2_on_us = clock.now_us();
 }
 
+/// Timestamp (microseconds) when DLDO2 was powered on, or 0 if not powered on by display_board_init
+pub var dldo2_on_us: u64 = 0;
+
+/// Microseconds for DLDO2 to settle after power on, before the LCD Panel is reset
+pub const DLDO2_SETTLE_US = 15_000;
+
 /// Write value to PMIC Register
 fn pmic_write(
     reg: u8,
@@ -334,111 +350,22 @@ fn rsb_wait_bit(
     return 0;
 }
 
-/// Modify the specified bits in a memory mapped register.
-/// Note: Parameters are different from modifyreg32
-/// Based on https://github.com/apache/nuttx/blob/master/arch/arm64/src/common/arm64_arch.h#L473
-fn modreg32(
-    comptime val: u32,   // Bits to set, like (1 << bit)
-    comptime mask: u32,  // Bits to clear, like (1 << bit)
-    addr: u64  // Address to modify
-) void {
-    comptime { assert(val & mask == val); }
-    debug("  *0x{x}: clear 0x{x}, set 0x{x}", .{ addr, mask, val & mask });
-    putreg32(
-        (getreg32(addr) & ~(mask))
-            | ((val) & (mask)),
-        (addr)
-    );
-}
-
-/// Get the 8-bit value at the address
-fn getreg8(addr: u64) u8 {
-    const ptr = @intToPtr(*const volatile u8, addr);
-    return ptr.*;
-}
-
-/// Get the 32-bit value at the address
-fn getreg32(addr: u64) u32 {
-    const ptr = @intToPtr(*const volatile u32, addr);
-    return ptr.*;
-}
-
-/// Set the 32-bit value at the address
-fn putreg32(val: u32, addr: u64) void {
-    if (enableLog) { debug("  *0x{x} = 0x{x}", .{ addr, val }); }
-    const ptr = @intToPtr(*volatile u32, addr);
-    ptr.* = val;
-}
-
-/// Set to False to disable log 
-var enableLog = true;
+/// Read and Write Registers (see mmio.zig)
+const getreg8 = mmio.getreg8;
+const getreg32 = mmio.getreg32;
+const putreg32 = mmio.putreg32;
+const modreg32 = mmio.modreg32;
 
 ///////////////////////////////////////////////////////////////////////////////
-//  Panic Handler
-
-/// Called by Zig when it hits a Panic. We print the Panic Message, Stack Trace and halt. See 
-/// https://andrewkelley.me/post/zig-stack-traces-kernel-panic-bare-bones-os.html
-/// https://github.com/ziglang/zig/blob/master/lib/std/builtin.zig#L763-L847
-pub fn panic(
-    message: []const u8, 
-    _stack_trace: ?*std.builtin.StackTrace
-) noreturn {
-    // Print the Panic Message
-    _ = _stack_trace;
-    _ = puts("\n!ZIG PANIC!");
-    _ = puts(@ptrCast([*c]const u8, message));
-
-    // Print the Stack Trace
-    _ = puts("Stack Trace:");
-    var it = std.debug.StackIterator.init(@returnAddress(), null);
-    while (it.next()) |return_address| {
-        _ = printf("%p\n", return_address);
-    }
+//  Panic Handler and Logging
 
-    // Halt
-    c.exit(1);
-}
-
-///////////////////////////////////////////////////////////////////////////////
-//  Logging
-
-/// Called by Zig for `std.log.debug`, `std.log.info`, `std.log.err`, ...
-/// https://gist.github.com/leecannon/d6f5d7e5af5881c466161270347ce84d
-pub fn log(
-    comptime _message_level: std.log.Level,
-    comptime _scope: @Type(.EnumLiteral),
-    comptime format: []const u8,
-    args: anytype,
-) void {
-    _ = _message_level;
-    _ = _scope;
-
-    // Format the message
-    var buf: [100]u8 = undefined;  // Limit to 100 chars
-    var slice = std.fmt.bufPrint(&buf, format, args)
-        catch { _ = puts("*** log error: buf too small"); return; };
-    
-    // Terminate the formatted message with a null
-    var buf2: [buf.len + 1 : 0]u8 = undefined;
-    std.mem.copy(
-        u8, 
-        buf2[0..slice.len], 
-        slice[0..slice.len]
-    );
-    buf2[slice.len] = 0;
-
-    // Print the formatted message
-    _ = puts(&buf2);
-}
+/// Called by Zig when it hits a Panic, and for `std.log.debug`, `std.log.err`, ... (see mmio.zig)
+pub const panic = mmio.panic;
+pub const log   = mmio.log;
 
 ///////////////////////////////////////////////////////////////////////////////
 //  Imported Functions and Variables
 
-/// For safety, we import these functions ourselves to enforce Null-Terminated Strings.
-/// We changed `[*c]const u8` to `[*:0]const u8`
-extern fn printf(format: [*:0]const u8, ...) c_int;
-extern fn puts(str: [*:0]const u8) c_int;
-
 /// Aliases for Zig Standard Library
 const assert = std.debug.assert;
 const debug  = std.log.debug;
@@ -0,0 +1,277 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! Scanline Rasterizer for PinePhone Framebuffers (ARGB 8888).
+//! Draws filled Circles, Ellipses, Rounded Rectangles and Convex Polygons with
+//! Anti-Aliased Edges. For every Row we compute where the Shape begins and ends
+//! on a few Sub-Scanlines, instead of testing every pixel: Pixels that are
+//! covered on all Sub-Scanlines are blended as one Span by the Vector Kernel
+//! (accel.blendColor), and only the few pixels on the Edges get a Coverage.
+//! Rows may be drawn independently, so Shapes can be rendered in parallel
+//! with parallel.renderRows.
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Import the 2D Graphics Operations Module, for the Blend Kernel
+const accel = @import("./accel.zig");
+
+/// Point on the Screen (pixels). Pixel (x, y) covers (x, y) to (x + 1, y + 1).
+pub const Point = struct {
+    x: f32,
+    y: f32,
+};
+
+/// Shape to be filled
+pub const Shape = union(enum) {
+    /// Ellipse with Centre (cx, cy) and Radii rx, ry
+    ellipse: struct { cx: f32, cy: f32, rx: f32, ry: f32 },
+
+    /// Rectangle with Top Left (x, y), Size w x h and Corner Radius r
+    round_rect: struct { x: f32, y: f32, w: f32, h: f32, r: f32 },
+
+    /// Convex Polygon with the Vertices in either order (clockwise or anticlockwise)
+    polygon: []const Point,
+};
+
+/// Return a Circle with Centre (cx, cy) and Radius r
+pub fn circle(cx: f32, cy: f32, r: f32) Shape {
+    return .{ .ellipse = .{ .cx = cx, .cy = cy, .rx = r, .ry = r } };
+}
+
+/// Number of Sub-Scanlines per Row for Anti-Aliasing. Edges are exact horizontally.
+const SUBSAMPLES = 4;
+
+/// Fill the Shape with the ARGB 8888 Colour, blended over the Framebuffer (Source Over).
+/// Parts of the Shape outside the Framebuffer are clipped. Empty Shapes are skipped.
+pub fn fill(
+    dest: accel.Surface,  // Framebuffer to be drawn
+    shape: Shape,         // Shape to be filled
+    color: u32            // Colour in ARGB 8888 Format
+) void {
+    debug("fill: {s}", .{ @tagName(shape) });
+    if (isEmpty(shape)) { return; }
+    const rows = bounds(shape);
+    const top    = @floatToInt(usize, std.math.clamp(@floor(rows.top), 0, @intToFloat(f32, dest.height)));
+    const bottom = @floatToInt(usize, std.math.clamp(@ceil(rows.bottom), 0, @intToFloat(f32, dest.height)));
+    var y = top;
+    while (y < bottom) : (y += 1) {
+        fillRow(dest.pixels[(y * dest.stride)..][0..dest.width], y, shape, color);
+    }
+}
+
+/// Fill Row `y` of the Shape with the ARGB 8888 Colour, blended over the Row.
+/// Called by `fill`, or by parallel.renderRows to render the Rows in parallel.
+/// Empty Shapes are skipped.
+pub fn fillRow(
+    row: []u32,    // Row of the Framebuffer
+    y: usize,      // Row Number
+    shape: Shape,  // Shape to be filled
+    color: u32     // Colour in ARGB 8888 Format
+) void {
+    if (isEmpty(shape)) { return; }
+
+    // Find the Span of the Shape on each Sub-Scanline
+    var spans: [SUBSAMPLES]?Span = undefined;
+    var outer = Span { .l = std.math.inf(f32), .r = -std.math.inf(f32) };  // Union of Spans
+    var inner = Span { .l = -std.math.inf(f32), .r = std.math.inf(f32) };  // Intersection of Spans
+    var all = true;
+    for (spans) |*s, i| {
+        const sy = @intToFloat(f32, y) + (@intToFloat(f32, i) + 0.5) / SUBSAMPLES;
+        s.* = span(shape, sy);
+        if (s.*) |sp| {
+            outer = .{ .l = std.math.min(outer.l, sp.l), .r = std.math.max(outer.r, sp.r) };
+            inner = .{ .l = std.math.max(inner.l, sp.l), .r = std.math.min(inner.r, sp.r) };
+        } else {
+            all = false;
+        }
+    }
+    if (!(outer.l < outer.r)) { return; }
+
+    // Pixels touched by the Shape, clipped to the Row
+    const width = @intToFloat(f32, row.len);
+    const x_start = toColumn(@floor(outer.l), width);
+    const x_end   = toColumn(@ceil(outer.r), width);
+
+    // Pixels fully covered on every Sub-Scanline. Or none, if a Sub-Scanline misses the Shape.
+    var in_start = x_end;
+    var in_end   = x_end;
+    if (all and @ceil(inner.l) < @floor(inner.r)) {
+        in_start = toColumn(@ceil(inner.l), width);
+        in_end   = toColumn(@floor(inner.r), width);
+    }
+
+    // Blend the Edges with their Coverage, and the Interior as one Span
+    edgeRun(row, x_start, std.math.min(in_start, x_end), &spans, color);
+    if (in_start < in_end) {
+        if (color >> 24 == 0xFF) {
+            std.mem.set(u32, row[in_start..in_end], color);  // Opaque
+        } else {
+            accel.blendColor(row[in_start..in_end], color);
+        }
+    }
+    edgeRun(row, std.math.max(in_end, x_start), x_end, &spans, color);
+}
+
+/// Blend the Colour over the Edge Pixels from Column `start` to `end - 1`,
+/// with the Alpha scaled by the Coverage of each pixel
+fn edgeRun(row: []u32, start: usize, end: usize, spans: []const ?Span, color: u32) void {
+    var x = start;
+    while (x < end) : (x += 1) {
+        const cov = coverage(spans, @intToFloat(f32, x));
+        const alpha = @floatToInt(u32, @round(@intToFloat(f32, color >> 24) * cov));
+        if (alpha == 0) { continue; }
+        accel.blendColor(row[x..(x + 1)], (alpha << 24) | (color & 0xFF_FFFF));
+    }
+}
+
+/// Return the fraction (0 to 1) of pixel column `x` that's covered by the Spans
+fn coverage(spans: []const ?Span, x: f32) f32 {
+    var sum: f32 = 0;
+    for (spans) |s| {
+        if (s) |sp| {
+            sum += std.math.max(0, std.math.min(x + 1, sp.r) - std.math.max(x, sp.l));
+        }
+    }
+    return sum / SUBSAMPLES;
+}
+
+/// Convert the whole number `x` to a Column, clipped to the Row Width
+fn toColumn(x: f32, width: f32) usize {
+    return @floatToInt(usize, std.math.clamp(x, 0, width));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Shape Geometry
+
+/// Horizontal Span of a Shape from `l` to `r` (pixels)
+const Span = struct {
+    l: f32,  // Left Edge
+    r: f32,  // Right Edge
+};
+
+/// Return the Span of the Shape on the Scanline `y`, or null if the Scanline misses the Shape
+fn span(shape: Shape, y: f32) ?Span {
+    switch (shape) {
+        .ellipse => |e| {
+            const dy = (y - e.cy) / e.ry;
+            if (dy * dy >= 1) { return null; }
+            const half = e.rx * @sqrt(1 - dy * dy);
+            return Span { .l = e.cx - half, .r = e.cx + half };
+        },
+        .round_rect => |rr| {
+            if (y < rr.y or y >= rr.y + rr.h) { return null; }
+
+            // Inside a Corner, the Edge is inset by the Corner Circle
+            const r = std.math.min3(rr.r, rr.w / 2, rr.h / 2);
+            const dy = std.math.max3(rr.y + r - y, y - (rr.y + rr.h - r), 0);
+            const inset = r - @sqrt(std.math.max(r * r - dy * dy, 0));
+            return Span { .l = rr.x + inset, .r = rr.x + rr.w - inset };
+        },
+        .polygon => |points| {
+            // A Convex Polygon crosses the Scanline at the leftmost and rightmost Edges
+            var s = Span { .l = std.math.inf(f32), .r = -std.math.inf(f32) };
+            for (points) |p, i| {
+                const q = points[(i + 1) % points.len];
+                const lo = std.math.min(p.y, q.y);
+                const hi = std.math.max(p.y, q.y);
+                if (y < lo or y >= hi) { continue; }  // Horizontal Edges never cross
+                const x = p.x + (y - p.y) * (q.x - p.x) / (q.y - p.y);
+                s = .{ .l = std.math.min(s.l, x), .r = std.math.max(s.r, x) };
+            }
+            return if (s.l < s.r) s else null;
+        },
+    }
+}
+
+/// Return true if the Shape has no Area, or a Coordinate that's not finite.
+/// Their Spans would be NaN (like Radius 0), which can't be converted to Columns.
+fn isEmpty(shape: Shape) bool {
+    return switch (shape) {
+        .ellipse    => |e|  !(finite(&.{ e.cx, e.cy, e.rx, e.ry }) and e.rx > 0 and e.ry > 0),
+        .round_rect => |rr| !(finite(&.{ rr.x, rr.y, rr.w, rr.h, rr.r }) and rr.w > 0 and rr.h > 0 and rr.r >= 0),
+        .polygon    => |points| blk: {
+            if (points.len < 3) { break :blk true; }
+            for (points) |p| {
+                if (!finite(&.{ p.x, p.y })) { break :blk true; }
+            }
+            break :blk false;
+        },
+    };
+}
+
+/// Return true if all the numbers are finite (not NaN or Infinity)
+fn finite(xs: []const f32) bool {
+    for (xs) |x| {
+        if (!std.math.isFinite(x)) { return false; }
+    }
+    return true;
+}
+
+/// Top and Bottom of a Shape (pixels)
+const Bounds = struct {
+    top: f32,
+    bottom: f32,
+};
+
+/// Return the Top and Bottom of the Shape
+fn bounds(shape: Shape) Bounds {
+    return switch (shape) {
+        .ellipse    => |e|  .{ .top = e.cy - e.ry, .bottom = e.cy + e.ry },
+        .round_rect => |rr| .{ .top = rr.y, .bottom = rr.y + rr.h },
+        .polygon    => |points| blk: {
+            var b = Bounds { .top = std.math.inf(f32), .bottom = -std.math.inf(f32) };
+            for (points) |p| {
+                b = .{ .top = std.math.min(b.top, p.y), .bottom = std.math.max(b.bottom, p.y) };
+            }
+            break :blk b;
+        },
+    };
+}
+
+comptime {
+    // Circle of Radius 10 at (10, 10) spans the full width at its centre
+    const s = span(circle(10, 10, 10), 10).?;
+    assert(s.l == 0 and s.r == 20);
+    assert(span(circle(10, 10, 10), 20) == null);
+
+    // Triangle (0, 0), (8, 8), (0, 8) spans 0 to 4 at y = 4
+    const tri = [_]Point { .{ .x = 0, .y = 0 }, .{ .x = 8, .y = 8 }, .{ .x = 0, .y = 8 } };
+    const t = span(.{ .polygon = &tri }, 4).?;
+    assert(t.l == 0 and t.r == 4);
+
+    // Rounded Rectangle is inset only in its Corners
+    const rr = Shape { .round_rect = .{ .x = 0, .y = 0, .w = 20, .h = 20, .r = 4 } };
+    assert(span(rr, 10).?.l == 0);
+    assert(span(rr, 0).?.l == 4);
+
+    // Shapes without Area are skipped
+    assert(isEmpty(circle(10, 10, 0)));
+    assert(isEmpty(.{ .ellipse = .{ .cx = 10, .cy = 10, .rx = 10, .ry = 0 } }));
+    assert(isEmpty(.{ .polygon = tri[0..2] }));
+    assert(!isEmpty(circle(10, 10, 10)) and !isEmpty(rr) and !isEmpty(.{ .polygon = &tri }));
+
+    // Half of a pixel covered on every Sub-Scanline
+    const half = [_]?Span { Span { .l = 0.5, .r = 4 } } ** SUBSAMPLES;
+    assert(coverage(&half, 0) == 0.5);
+}
+
+/// Aliases for Zig Standard Library
+const assert = std.debug.assert;
+const debug  = std.log.debug;
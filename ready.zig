@@ -0,0 +1,216 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! Readiness Waits for the Display Bring-Up on Apache NuttX RTOS.
+//! Instead of sleeping for the worst case, each Stage of the Bring-Up polls the
+//! Hardware until it's ready (like the LOCK Bit of a PLL), with a Timeout.
+//! Where the Hardware has no Ready Signal (like the On-chip LDOs), we wait for
+//! the minimum in the Spec, counted from the moment the Stage started, so that
+//! any work done in between is not waited for again.
+//! The Wait Time of every Stage is recorded: Read it with bringup_getwaits (ioctl)
+//! or dump it to the Log with bringup_dump.
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Import the Register Access Module
+const mmio = @import("./mmio.zig");
+
+/// Import the Monotonic Clock Module
+const clock = @import("./clock.zig");
+
+/// Import NuttX Functions from C
+const c = @cImport({
+    // NuttX Defines
+    @cDefine("__NuttX__",  "");
+    @cDefine("NDEBUG",     "");
+    @cDefine("FAR",        "");
+
+    // NuttX Header Files
+    @cInclude("arch/types.h");
+    @cInclude("../../nuttx/include/limits.h");
+    @cInclude("nuttx/config.h");
+    @cInclude("errno.h");
+    @cInclude("unistd.h");
+});
+
+/// Stages of the Display Bring-Up that wait for the Hardware, in order
+pub const Stage = enum {
+    /// Video PLL locked (PLL_VIDEO0_CTRL_REG LOCK, tcon.zig)
+    pll_video0,
+    /// On-chip LDOs for the MIPI PLL settled (no Signal: Spec Minimum, tcon.zig)
+    mipi_ldo,
+    /// MIPI PLL locked (PLL_MIPI_CTRL_REG LOCK, tcon.zig)
+    pll_mipi,
+    /// DLDO2 Power Supply for the MIPI DSI Connector settled (no Signal: Spec Minimum, pmic.zig)
+    dldo2,
+    /// LCD Panel answers DCS Get Power Mode after Reset (panel.zig)
+    panel_reset,
+    /// LCD Panel woke up after Sleep Out (no Signal: Spec Minimum, display.zig)
+    sleep_out,
+    /// Display Engine PLL locked (PLL_DE_CTRL_REG LOCK, render.zig)
+    pll_de,
+    /// TCON0 signalled Vertical Blanking after Display Engine Init (render.zig)
+    de_vblank,
+};
+
+/// Number of Stages
+pub const STAGES = @typeInfo(Stage).Enum.fields.len;
+
+/// Wait Times of the last Bring-Up.
+/// Same layout as `struct fb_bringup_s` in C, for ioctl.
+pub const Waits = extern struct {
+    /// Microseconds waited in each Stage (indexed by Stage)
+    us: [STAGES]u32,
+    /// Bit `i` is set if Stage `i` gave up at its Timeout
+    timeouts: u32,
+};
+
+/// Wait Times recorded so far
+var waits = std.mem.zeroes(Waits);
+
+/// Interval (microseconds) between polls of a Ready Function
+const POLL_INTERVAL_US = 1000;
+
+/// Spin on the Register at `addr` until all Bits in `mask` are 1, or until `timeout_us`
+/// has passed. For Hardware that's ready within microseconds, like PLL LOCK.
+/// Returns true if ready, false if timed out.
+pub fn pollReg(comptime stage: Stage, addr: u64, mask: u32, timeout_us: u32) bool {
+    const start = clock.now_us();
+    while (getreg32(addr) & mask != mask) {
+        if (clock.now_us() - start >= timeout_us) {
+            return record(stage, start, false);
+        }
+    }
+    return record(stage, start, true);
+}
+
+/// Spin until `isReady` returns true, or until `timeout_us` has passed. Like `pollReg`,
+/// for Hardware that's watched by another Module (like Vertical Blanking in health.zig).
+/// Returns true if ready, false if timed out.
+pub fn spinUntil(comptime stage: Stage, timeout_us: u32, comptime isReady: fn () bool) bool {
+    const start = clock.now_us();
+    while (!isReady()) {
+        if (clock.now_us() - start >= timeout_us) {
+            return record(stage, start, false);
+        }
+    }
+    return record(stage, start, true);
+}
+
+/// Wait until `min_us` has passed since `since`, then call `isReady` every
+/// POLL_INTERVAL_US until it returns true, or until `timeout_us` has passed since `since`.
+/// For Hardware that takes milliseconds and must be asked over a Bus, like the LCD Panel.
+/// Returns true if ready, false if timed out.
+pub fn pollUntil(
+    comptime stage: Stage,
+    since: u64,         // Timestamp (microseconds) when the Stage started
+    min_us: u32,        // Minimum Wait from the Spec, before asking
+    timeout_us: u32,    // Give up at this time after `since`
+    comptime isReady: fn () bool  // Returns true if the Hardware is ready
+) bool {
+    const start = clock.now_us();
+    clock.sleepUntil(since + min_us);
+    while (!isReady()) {
+        if (clock.now_us() - since >= timeout_us) {
+            return record(stage, start, false);
+        }
+        _ = c.usleep(POLL_INTERVAL_US);
+    }
+    return record(stage, start, true);
+}
+
+/// Wait until `min_us` has passed since `since`. For Hardware without a Ready Signal:
+/// the Spec Minimum is the best we can do. Work done since `since` is not waited for again.
+pub fn waitMin(comptime stage: Stage, since: u64, min_us: u32) void {
+    const start = clock.now_us();
+    clock.sleepUntil(since + min_us);
+    _ = record(stage, start, true);
+}
+
+/// Return a copy of the Wait Times
+pub fn get() Waits {
+    return waits;
+}
+
+/// Forget the Wait Times, before a new Bring-Up
+pub fn reset() void {
+    waits = std.mem.zeroes(Waits);
+}
+
+/// Write the Wait Times to the Log
+pub fn dump() void {
+    var total: u64 = 0;
+    inline for (@typeInfo(Stage).Enum.fields) |f| {
+        const i = f.value;
+        const timed_out = waits.timeouts & (@as(u32, 1) << i) != 0;
+        std.log.info("bringup: {s}: {} us{s}", .{ f.name, waits.us[i], if (timed_out) " (timeout)" else "" });
+        total += waits.us[i];
+    }
+    std.log.info("bringup: total wait {} us", .{ total });
+}
+
+/// Record the Wait Time of the Stage that started waiting at `start`. Returns `ok`.
+fn record(comptime stage: Stage, start: u64, ok: bool) bool {
+    const i = @enumToInt(stage);
+    waits.us[i] = @intCast(u32, std.math.min(clock.now_us() - start, std.math.maxInt(u32)));
+    if (ok) {
+        waits.timeouts &= ~(@as(u32, 1) << i);
+    } else {
+        waits.timeouts |= @as(u32, 1) << i;
+        std.log.err("bringup: {s} not ready after {} us", .{ @tagName(stage), waits.us[i] });
+    }
+    return ok;
+}
+
+comptime {
+    assert(STAGES <= 32);  // One Bit per Stage in `timeouts`
+    assert(@sizeOf(Waits) == (STAGES + 1) * 4);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Exported Functions
+
+/// Copy the Wait Times of the last Bring-Up to `out`.
+/// Called by the NuttX Framebuffer Driver for ioctl FBIOGET_BRINGUP.
+/// Returns 0 if OK, or -EINVAL if `out` is null.
+pub export fn bringup_getwaits(
+    vtable: ?*anyopaque,  // Framebuffer Driver (Unused)
+    out: ?*Waits          // Returned Wait Times
+) c_int {
+    _ = vtable;
+    const p = out orelse return -c.EINVAL;
+    p.* = get();
+    return c.OK;
+}
+
+/// Write the Wait Times of the last Bring-Up to the Log
+pub export fn bringup_dump() void {
+    dump();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Read and Write Registers
+
+/// Read and Write Registers (see mmio.zig)
+const getreg32 = mmio.getreg32;
+
+/// Aliases for Zig Standard Library
+const assert = std.debug.assert;
+const debug  = std.log.debug;
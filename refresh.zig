@@ -0,0 +1,219 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! Dynamic Refresh Rate for the PinePhone Display on Apache NuttX RTOS.
+//! When the Framebuffers haven't been updated for a while, the Governor lowers
+//! the Refresh Rate from 60 Hz to 40 Hz and then 30 Hz, by adding Lines of
+//! Vertical Blanking to the MIPI DSI Timing (Video_VT). The Pixel Clock stays
+//! the same, so the PLLs are untouched. The next Framebuffer Update restores
+//! 60 Hz. The Timing is changed only during Vertical Blanking, so the Panel
+//! never sees a Frame with mixed Timings.
+//! TCON0 runs in CPU Trigger Mode with Auto Sync, so it follows the DSI Frame
+//! and its Timing Registers don't need to change.
+//! Waiting for Vertical Blanking happens only in `refresh_tick` (or `refresh_force`),
+//! never in `refresh_activity`, which is called on every Framebuffer Update.
+//! The Governor is off by default (fixed 60 Hz) until it's verified on PinePhone:
+//! Call `refresh_force(0)` to turn it on.
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Import the Register Access Module
+const mmio = @import("./mmio.zig");
+
+/// Import the MIPI Display Serial Interface Module, for the DSI Timing
+const dsi = @import("./display.zig");
+
+/// Import the Display Engine Module, for the Panel Size
+const render = @import("./render.zig");
+
+/// Import the Display Pipeline Health Module, for the Latency of Framebuffer Updates
+const health = @import("./health.zig");
+
+/// Import the Monotonic Clock Module
+const clock = @import("./clock.zig");
+
+/// Import NuttX Functions from C
+const c = @cImport({
+    // NuttX Defines
+    @cDefine("__NuttX__",  "");
+    @cDefine("NDEBUG",     "");
+    @cDefine("FAR",        "");
+
+    // NuttX Header Files
+    @cInclude("arch/types.h");
+    @cInclude("../../nuttx/include/limits.h");
+    @cInclude("nuttx/config.h");
+    @cInclude("errno.h");
+    @cInclude("unistd.h");
+});
+
+/// Refresh Rates (Hz) selected by the Governor, from the fastest
+pub const RATES = [_]u8 { 60, 40, 30 };
+
+/// Idle Time (milliseconds) without Framebuffer Updates before each Rate in RATES is selected.
+/// Lowering the Rate takes much longer than raising it (which happens on the next Update),
+/// so the Rate won't flip back and forth while an App updates the Screen now and then.
+const IDLE_MS = [RATES.len]u32 { 0, 1_000, 5_000 };
+
+/// Minimum Time (milliseconds) between two steps down, so that we pass through every Rate
+const DWELL_MS = 500;
+
+/// Vertical Total (Lines per Frame) for each Rate in RATES: Same Line Time, longer Vertical Blanking
+const VT = blk: {
+    var vt: [RATES.len]u32 = undefined;
+    for (RATES) |hz, i| { vt[i] = @as(u32, dsi.VIDEO_VT) * RATES[0] / hz; }
+    break :blk vt;
+};
+
+comptime {
+    assert(VT[0] == dsi.VIDEO_VT);
+    assert(VT[1] == 2227 and VT[2] == 2970);
+    for (VT) |vt| { assert(vt < 1 << 13); }  // Video_VT has 13 Bits
+}
+
+/// Index of the current Rate in RATES
+var rate_index: usize = 0;
+
+/// Index of the Rate forced by refresh_force, or null if the Governor decides.
+/// Initially 60 Hz: The Governor is off until `refresh_force(0)`.
+var forced: ?usize = 0;
+
+/// Index of the Rate requested by a Framebuffer Update, to be set by the next `update`
+var pending: ?usize = null;
+
+/// Timestamps (microseconds) of the last Framebuffer Update and the last change of Rate
+var last_activity_us: u64 = 0;
+var last_change_us:   u64 = 0;
+
+/// Number of times the Rate has changed, for Diagnostics
+pub var changes: u32 = 0;
+
+/// Report a Framebuffer Update. Restores the fastest Rate at the next `refresh_tick`
+/// if the Governor had lowered it, so the Caller never waits for Vertical Blanking.
+/// Called by the Display Drivers whenever they change the pixels or the Layers on the Screen.
+pub export fn refresh_activity() void {
+    const now = clock.now_us();
+    health.submit(now);
+    activity(now);
+}
+
+/// Run the Governor: Restores the fastest Rate after a Framebuffer Update, or lowers the Rate
+/// if the Framebuffers have been idle long enough. Should be called periodically, like every
+/// 100 milliseconds, from a Worker or Timer Thread: Changing the Rate waits up to 2 Frames
+/// for Vertical Blanking.
+pub export fn refresh_tick() void {
+    update(clock.now_us());
+}
+
+/// Force the Refresh Rate to `hz` (one of RATES), or return control to the Governor if `hz` is 0.
+/// Returns 0 if OK, or -EINVAL if the Rate is not supported.
+pub export fn refresh_force(hz: c_int) c_int {
+    debug("refresh_force: hz={}", .{ hz });
+    const now = clock.now_us();
+    if (hz == 0) {
+        forced = null;
+        pending = null;
+        last_activity_us = now;  // Restart the Idle Time
+        return c.OK;
+    }
+    for (RATES) |r, i| {
+        if (r == hz) {
+            forced = i;
+            setRate(i, now);
+            return c.OK;
+        }
+    }
+    return -c.EINVAL;
+}
+
+/// Return the current Refresh Rate (Hz)
+pub export fn refresh_rate() c_int {
+    return RATES[rate_index];
+}
+
+/// Handle a Framebuffer Update at Time `now` (microseconds): Request the fastest Rate
+/// for the next `update`
+pub fn activity(now: u64) void {
+    last_activity_us = now;
+    if (forced == null and rate_index != 0) { pending = 0; }
+}
+
+/// Run the Governor at Time `now` (microseconds): Set the Rate requested by `activity`.
+/// Otherwise step down one Rate if the Framebuffers have been idle for IDLE_MS,
+/// and the last change was DWELL_MS ago.
+pub fn update(now: u64) void {
+    if (forced != null) { pending = null; return; }
+    if (pending) |index| {
+        pending = null;
+        setRate(index, now);
+        return;
+    }
+    if (rate_index + 1 >= RATES.len) { return; }
+    const idle_ms = (now -| last_activity_us) / 1000;
+    const dwell_ms = (now -| last_change_us) / 1000;
+    if (idle_ms >= IDLE_MS[rate_index + 1] and dwell_ms >= DWELL_MS) {
+        setRate(rate_index + 1, now);
+    }
+}
+
+/// Program the DSI Timing for the Rate RATES[index] at the next Vertical Blanking
+fn setRate(index: usize, now: u64) void {
+    if (index == rate_index) { return; }
+    debug("setRate: {} Hz, VT={}", .{ RATES[index], VT[index] });
+    if (!waitVblank()) { debug("setRate: no vblank", .{}); }
+
+    // DSI_BASIC_SIZE1_REG: DSI Offset 0x1c
+    // Set Video_VT (Bits 16 to 28) to the Vertical Total for the Rate
+    // Set Video_VACT (Bits 0 to 11) to 1440 (unchanged)
+    putreg32(VT[index] << 16 | render.PANEL_HEIGHT, dsi.DSI_BASIC_SIZE1_REG);  // TODO: DMB
+    rate_index = index;
+    last_change_us = now;
+    changes += 1;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Vertical Blanking
+
+/// Poll the Vertical Blanking Flag for up to 2 Frames at 30 Hz
+const VBLANK_POLL_US = 100;
+const VBLANK_POLLS   = 2 * 1_000_000 / 30 / VBLANK_POLL_US;
+
+/// Wait for the next Vertical Blanking. Returns false if TCON0 didn't signal it in time
+/// (e.g. the Display is off), in which case the caller may change the Timing anyway.
+/// The Vertical Blanking Flag belongs to health.zig, so we watch its Count.
+fn waitVblank() bool {
+    const start = health.pollVblank();  // Count any earlier Vertical Blanking first
+    var i: usize = 0;
+    while (i < VBLANK_POLLS) : (i += 1) {
+        if (health.pollVblank() != start) { return true; }
+        _ = c.usleep(VBLANK_POLL_US);
+    }
+    return false;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Read and Write Registers
+
+/// Read and Write Registers (see mmio.zig)
+const putreg32 = mmio.putreg32;
+
+/// Aliases for Zig Standard Library
+const assert = std.debug.assert;
+const debug  = std.log.debug;
@@ -26,6 +26,9 @@
 /// Import the Zig Standard Library
 const std = @import("std");
 
+/// Import the Register Access Module
+const mmio = @import("./mmio.zig");
+
 /// Import the MIPI Display Serial Interface Module
 const dsi = @import("./display.zig");
 
@@ -44,6 +47,39 @@ const pmic = @import("./pmic.zig");
 /// Import the LCD Panel Module
 const panel = @import("./panel.zig");
 
+/// Import the Parallel Rendering Module
+const parallel = @import("./parallel.zig");
+
+/// Import the 2D Graphics Operations Module
+const accel = @import("./accel.zig");
+
+/// Import the Framebuffer Console Module
+const console = @import("./console.zig");
+
+/// Import the Display Suspend and Resume Module
+const standby = @import("./standby.zig");
+
+/// Import the Hardware Cursor Module
+const cursor = @import("./cursor.zig");
+
+/// Import the Dynamic Refresh Rate Module
+const refresh = @import("./refresh.zig");
+
+/// Import the Scanline Rasterizer Module
+const raster = @import("./raster.zig");
+
+/// Import the Boot Splash Screen Module
+const splash = @import("./splash.zig");
+
+/// Import the Readiness Waits Module
+const ready = @import("./ready.zig");
+
+/// Import the Atomic Plane Commits Module
+const planes = @import("./planes.zig");
+
+/// Import the Display Pipeline Health Module, which owns the Vertical Blanking Flag
+const health = @import("./health.zig");
+
 /// Import NuttX Functions from C
 const c = @cImport({
     // NuttX Defines
@@ -53,6 +89,7 @@ const c = @cImport({
 
     // NuttX Framebuffer Defines
     @cDefine("CONFIG_FB_OVERLAY", "");
+    @cDefine("CONFIG_FB_OVERLAY_BLIT", "");
 
     // NuttX Header Files
     @cInclude("arch/types.h");
@@ -64,6 +101,7 @@ const c = @cImport({
     @cInclude("stdlib.h");
     @cInclude("stdio.h");
     @cInclude("fcntl.h");
+    @cInclude("errno.h");
     @cInclude("nuttx/leds/userled.h");
 
     // NuttX Framebuffer Header Files
@@ -73,7 +111,7 @@ const c = @cImport({
 /// Render a Test Pattern on PinePhone's Display.
 /// Calls Allwinner A64 Display Engine, Timing Controller and MIPI Display Serial Interface.
 /// See https://lupyuen.github.io/articles/de#appendix-programming-the-allwinner-a64-display-engine
-fn renderGraphics(
+pub fn renderGraphics(
     comptime channels: u8  // Number of UI Channels to render: 1 or 3
 ) void {
     debug("renderGraphics: start", .{});
@@ -92,58 +130,8 @@ fn renderGraphics(
         assert(overlayInfo[1].stride == overlayInfo[1].sarea.w * 4);
     }
 
-    // TODO: Handle DMB non-relaxed write
-    // https://developer.arm.com/documentation/dui0489/c/arm-and-thumb-instructions/miscellaneous-instructions/dmb--dsb--and-isb
-
-    // Init Framebuffer 0:
-    // Fill with Blue, Green and Red
-    var i: usize = 0;
-    while (i < fb0.len) : (i += 1) {
-        // Colours are in XRGB 8888 format
-        if (i < fb0.len / 4) {
-            // Blue for top quarter
-            fb0[i] = 0x8000_0080;
-        } else if (i < fb0.len / 2) {
-            // Green for next quarter
-            fb0[i] = 0x8000_8000;
-        } else {
-            // Red for lower half
-            fb0[i] = 0x8080_0000;
-        }
-    }
-
-    // Init Framebuffer 1:
-    // Fill with Semi-Transparent Blue
-    i = 0;
-    while (i < fb1.len) : (i += 1) {
-        // Colours are in ARGB 8888 format
-        fb1[i] = 0x8000_0080;
-    }
-
-    // Init Framebuffer 2:
-    // Fill with Semi-Transparent Green Circle
-    var y: usize = 0;
-    while (y < PANEL_HEIGHT) : (y += 1) {
-        var x: usize = 0;
-        while (x < PANEL_WIDTH) : (x += 1) {
-            // Get pixel index
-            const p = (y * PANEL_WIDTH) + x;
-            assert(p < fb2.len);
-
-            // Shift coordinates so that centre of screen is (0,0)
-            const half_width  = PANEL_WIDTH  / 2;
-            const half_height = PANEL_HEIGHT / 2;
-            const x_shift = @intCast(isize, x) - half_width;
-            const y_shift = @intCast(isize, y) - half_height;
-
-            // If x^2 + y^2 < radius^2, set the pixel to Semi-Transparent Green
-            if (x_shift*x_shift + y_shift*y_shift < half_width*half_width) {
-                fb2[p] = 0x8000_8000;  // Semi-Transparent Green in ARGB 8888 Format
-            } else {  // Otherwise set to Transparent Black
-                fb2[p] = 0x0000_0000;  // Transparent Black in ARGB 8888 Format
-            }
-        }
-    }
+    // Fill the Framebuffers with the Test Pattern
+    initFramebuffers();
 
     // Init the UI Blender for PinePhone's A64 Display Engine
     initUiBlender();
@@ -176,6 +164,58 @@ fn renderGraphics(
 
     // Set UI Blender Route, enable Blender Pipes and apply the settings
     applySettings(channels);
+    overlaysEnabled = (channels == 3);
+
+    // First Overlay is Semi-Transparent Blue: a Solid Overlay, so Framebuffer 1 isn't filled or read
+    if (channels == 3) {
+        _ = setOverlaySource(0, .{ .solid = FB1_COLOR });
+    }
+}
+
+/// Fill Framebuffers 0 and 2 with the Test Pattern. Framebuffer 1 isn't filled,
+/// the First Overlay is shown as a Solid Overlay of FB1_COLOR instead.
+/// The Rows are rendered in parallel on the 4 Cortex-A53 Cores.
+/// Called by renderGraphics() and by the Host Benchmark (bench.zig).
+pub fn initFramebuffers() void {
+    debug("initFramebuffers: start", .{});
+    defer { debug("initFramebuffers: end", .{}); }
+
+    // Init Framebuffer 0:
+    // Fill with Blue, Green and Red, unless the Splash Screen has been decoded into it
+    if (!splash.shown) {
+        parallel.renderRows(&fb0, PANEL_WIDTH, PANEL_HEIGHT, fb0Row);
+    }
+
+    // Init Framebuffer 2:
+    // Fill with Semi-Transparent Green Circle
+    parallel.renderRows(&fb2, PANEL_WIDTH, PANEL_HEIGHT, fb2Row);
+}
+
+/// Render Row `y` of Framebuffer 0: Blue, Green and Red
+fn fb0Row(row: []u32, y: usize) void {
+    // Quarters of the Framebuffer must begin on a Row
+    comptime{ assert(PANEL_HEIGHT % 4 == 0); }
+
+    // Colours are in XRGB 8888 format
+    const color: u32 =
+        if (y < PANEL_HEIGHT / 4) 0x8000_0080       // Blue for top quarter
+        else if (y < PANEL_HEIGHT / 2) 0x8000_8000  // Green for next quarter
+        else 0x8080_0000;                           // Red for lower half
+    std.mem.set(u32, row, color);
+}
+
+/// Colour of the First Overlay: Semi-Transparent Blue (ARGB 8888)
+const FB1_COLOR = 0x8000_0080;
+
+/// Green Circle in Framebuffer 2, at the centre of the Screen
+const FB2_CIRCLE = raster.circle(PANEL_WIDTH / 2, PANEL_HEIGHT / 2, PANEL_WIDTH / 2);
+
+/// Render Row `y` of Framebuffer 2: Semi-Transparent Green Circle with Anti-Aliased Edges.
+/// The Rasterizer fills only the Span of the Circle, the rest is Transparent Black.
+fn fb2Row(row: []u32, y: usize) void {
+    assert(row.len == PANEL_WIDTH);
+    std.mem.set(u32, row, 0x0000_0000);  // Transparent Black in ARGB 8888 Format
+    raster.fillRow(row, y, FB2_CIRCLE, 0x8000_8000);  // Semi-Transparent Green in ARGB 8888 Format
 }
 
 /// Render a Test Pattern on PinePhone's Display.
@@ -191,35 +231,55 @@ pub export fn test_render(
         backlight.backlight_enable(90);
     }
 
+    // Record the Wait Times of this Bring-Up (see ready.zig)
+    ready.reset();
+
     // Init PMIC not needed. Maybe already done by U-Boot?
     // https://megous.com/git/p-boot/tree/src/pmic.c#n279
 
     // Init Timing Controller TCON0
     tcon.tcon0_init();
+    feedSplash();
 
     // Init Power Mgmt IC
     pmic.display_board_init();
+    feedSplash();
 
     // Enable MIPI DSI Block
     dsi.enable_dsi_block();
+    feedSplash();
 
     // Enable MIPI Display Physical Layer
     dphy.dphy_enable();
+    feedSplash();
 
     // Reset LCD Panel
     panel.panel_reset();
+    feedSplash();
 
     // Init LCD Panel
     dsi.panel_init();
+    feedSplash();
 
     // Start MIPI DSI HSC and HSD
     dsi.start_dsi();
+    feedSplash();
 
     // Init Display Engine
     de2_init();
-
-    // Wait a while
-    _ = c.usleep(160000);
+    feedSplash();
+
+    // Wait for the Display Pipeline to run (instead of 160 milliseconds)
+    waitFirstVblank();
+    ready.dump();
+
+    // Decode the rest of the Splash Screen
+    if (splashing) {
+        splashChunk = splashImage.len;
+        feedSplash();
+        _ = splash.splash_end();
+        splashing = false;
+    }
 
     // Render Graphics with Display Engine
     switch (channels) {
@@ -230,6 +290,61 @@ pub export fn test_render(
     }
 }
 
+/// Render a QOI Splash Screen on PinePhone's Display with 1 UI Channel. The Image is decoded
+/// into Framebuffer 0 in chunks between the stages of Display Bring-Up, while they wait for the Panel.
+pub export fn test_splash(
+    image: [*]const u8,  // QOI Image
+    len: usize           // Length of the Image (bytes)
+) void {
+    debug("test_splash: len={}", .{ len });
+    splash.splash_begin();
+    splashing = true;
+    splashImage = image[0..len];
+    splashChunk = (len + BRINGUP_STAGES - 1) / BRINGUP_STAGES;
+    test_render(1);
+}
+
+/// Number of Display Bring-Up stages in test_render that call feedSplash
+const BRINGUP_STAGES = 8;
+
+/// Splash Screen is being decoded by test_splash
+var splashing = false;
+
+/// Bytes of the Splash Screen not yet decoded, and the number of bytes to decode at each stage
+var splashImage: []const u8 = &.{};
+var splashChunk: usize = 0;
+
+/// Decode the next chunk of the Splash Screen, if test_splash was called
+fn feedSplash() void {
+    if (!splashing) { return; }
+    const n = std.math.min(splashChunk, splashImage.len);
+    if (n == 0) { return; }
+    _ = splash.splash_feed(splashImage.ptr, n);
+    splashImage = splashImage[n..];
+}
+
+/// Give up waiting for the Display Pipeline after this time (microseconds), the time we used to wait
+const FIRST_VBLANK_TIMEOUT_US = 160_000;
+
+/// Give up waiting for Display Engine PLL LOCK after this time (microseconds)
+const PLL_DE_TIMEOUT_US = 10_000;
+
+/// Wait for TCON0 to signal Vertical Blanking after de2_init: The Display Engine
+/// has latched its Registers and the Display Pipeline is running.
+/// The Vertical Blanking Flag belongs to health.zig, so we watch its Count.
+fn waitFirstVblank() void {
+    first_vblank_start = health.pollVblank();  // Count any earlier Vertical Blanking first
+    _ = ready.spinUntil(.de_vblank, FIRST_VBLANK_TIMEOUT_US, newVblank);
+}
+
+/// Vertical Blanking Count when waitFirstVblank started
+var first_vblank_start: u32 = 0;
+
+/// Return true if TCON0 has signalled Vertical Blanking since waitFirstVblank started
+fn newVblank() bool {
+    return health.pollVblank() != first_vblank_start;
+}
+
 /// Hardware Registers for PinePhone's A64 Display Engine.
 /// See https://lupyuen.github.io/articles/de#appendix-overview-of-allwinner-a64-display-engine
 /// Display Engine Base Address is 0x0100 0000 (DE Page 24)
@@ -393,6 +508,7 @@ fn applySettings(
     const GLB_DBUFFER = GLB_BASE_ADDRESS + 0x008;
     comptime{ assert(GLB_DBUFFER == 0x110_0008); }
     putreg32(DOUBLE_BUFFER_RDY, GLB_DBUFFER);  // TODO: DMB
+    planes.invalidate();  // Atomic Commits must read back the Registers
 }
 
 /// Initialise a UI Channel for PinePhone's A64 Display Engine.
@@ -642,8 +758,8 @@ fn initUiChannel(
 }
 
 /// LCD Panel Width and Height (pixels)
-const PANEL_WIDTH  = 720;
-const PANEL_HEIGHT = 1440;
+pub const PANEL_WIDTH  = 720;
+pub const PANEL_HEIGHT = 1440;
 
 /// NuttX Video Controller for PinePhone (3 UI Channels)
 const videoInfo = c.fb_videoinfo_s {
@@ -658,7 +774,7 @@ const videoInfo = c.fb_videoinfo_s {
 /// Fullscreen 720 x 1440 (4 bytes per XRGB 8888 pixel)
 const planeInfo = c.fb_planeinfo_s {
     .fbmem   = &fb0,     // Start of frame buffer memory
-    .fblen   = @sizeOf( @TypeOf(fb0) ),  // Length of frame buffer memory in bytes
+    .fblen   = PANEL_WIDTH * PANEL_HEIGHT * 4,  // Length of frame buffer memory in bytes
     .stride  = PANEL_WIDTH * 4,  // Length of a line in bytes (4 bytes per pixel)
     .display = 0,        // Display number (Unused)
     .bpp     = 32,       // Bits per pixel (XRGB 8888)
@@ -668,54 +784,777 @@ const planeInfo = c.fb_planeinfo_s {
     .yoffset      = 0,     // Offset from virtual to visible resolution
 };
 
+/// 2D Graphics Operations supported by the Overlays (see accel.zig):
+/// Fill (FBIOSET_AREA + FBIOSET_COLOR), Blit (FBIOSET_BLIT), Blend (FBIOSET_BLEND).
+/// Transparency (FBIOSET_TRANSP) and Chroma Key (FBIOSET_CHROMAKEY) are done by the Blender.
+const OVERLAY_ACCL = c.FB_ACCL_AREA
+    | c.FB_ACCL_COLOR
+    | c.FB_ACCL_BLIT
+    | c.FB_ACCL_BLEND
+    | c.FB_ACCL_TRANSP
+    | c.FB_ACCL_CHROMA;
+
 /// NuttX Overlays for PinePhone (2 Overlay UI Channels)
 const overlayInfo = [2] c.fb_overlayinfo_s {
     // First Overlay UI Channel:
     // Square 600 x 600 (4 bytes per ARGB 8888 pixel)
     .{
         .fbmem     = &fb1,     // Start of frame buffer memory
-        .fblen     = @sizeOf( @TypeOf(fb1) ),  // Length of frame buffer memory in bytes
+        .fblen     = 600 * 600 * 4,  // Length of frame buffer memory in bytes
         .stride    = 600 * 4,  // Length of a line in bytes
         .overlay   = 0,        // Overlay number (First Overlay)
         .bpp       = 32,       // Bits per pixel (ARGB 8888)
         .blank     = 0,        // TODO: Blank or unblank
-        .chromakey = 0,        // TODO: Chroma key argb8888 formatted
-        .color     = 0,        // TODO: Color argb8888 formatted
-        .transp    = c.fb_transp_s { .transp = 0, .transp_mode = 0 },  // TODO: Transparency
+        .chromakey = 0,        // Chroma key argb8888 formatted (0 for None)
+        .color     = 0,        // Color argb8888 formatted (Current Colour in overlay_getinfo)
+        .transp    = c.fb_transp_s { .transp = 0xFF, .transp_mode = c.FB_PIXELALPHA },  // Opaque, Pixel Alpha
         .sarea     = c.fb_area_s { .x = 52, .y = 52, .w = 600, .h = 600 },  // Selected area within the overlay
-        .accl      = 0,        // TODO: Supported hardware acceleration
+        .accl      = OVERLAY_ACCL,  // Supported hardware acceleration
     },
     // Second Overlay UI Channel:
     // Fullscreen 720 x 1440 (4 bytes per ARGB 8888 pixel)
     .{
         .fbmem     = &fb2,     // Start of frame buffer memory
-        .fblen     = @sizeOf( @TypeOf(fb2) ),  // Length of frame buffer memory in bytes
+        .fblen     = PANEL_WIDTH * PANEL_HEIGHT * 4,  // Length of frame buffer memory in bytes
         .stride    = PANEL_WIDTH * 4,  // Length of a line in bytes
         .overlay   = 1,        // Overlay number (Second Overlay)
         .bpp       = 32,       // Bits per pixel (ARGB 8888)
         .blank     = 0,        // TODO: Blank or unblank
-        .chromakey = 0,        // TODO: Chroma key argb8888 formatted
-        .color     = 0,        // TODO: Color argb8888 formatted
-        .transp    = c.fb_transp_s { .transp = 0, .transp_mode = 0 },  // TODO: Transparency
+        .chromakey = 0,        // Chroma key argb8888 formatted (0 for None)
+        .color     = 0,        // Color argb8888 formatted (Current Colour in overlay_getinfo)
+        .transp    = c.fb_transp_s { .transp = 0x7F, .transp_mode = c.FB_PIXELALPHA },  // Semi-Transparent, Pixel Alpha
         .sarea     = c.fb_area_s { .x = 0, .y = 0, .w = PANEL_WIDTH, .h = PANEL_HEIGHT },  // Selected area within the overlay
-        .accl      = 0,        // TODO: Supported hardware acceleration
+        .accl      = OVERLAY_ACCL,  // Supported hardware acceleration
     },
 };
 
 // Framebuffer 0: (Base UI Channel)
 // Fullscreen 720 x 1440 (4 bytes per XRGB 8888 pixel)
 // TODO: Does alignment prevent flickering?
-var fb0 align(0x1000) = std.mem.zeroes([PANEL_WIDTH * PANEL_HEIGHT] u32);
+var fb0 align(FB_PAGE_SIZE) = std.mem.zeroes([fbWords(PANEL_WIDTH * PANEL_HEIGHT)] u32);
 
 // Framebuffer 1: (First Overlay UI Channel)
 // Square 600 x 600 (4 bytes per ARGB 8888 pixel)
 // TODO: Does alignment prevent flickering?
-var fb1 align(0x1000) = std.mem.zeroes([600 * 600] u32);
+var fb1 align(FB_PAGE_SIZE) = std.mem.zeroes([fbWords(600 * 600)] u32);
 
 // Framebuffer 2: (Second Overlay UI Channel)
 // Fullscreen 720 x 1440 (4 bytes per ARGB 8888 pixel)
 // TODO: Does alignment prevent flickering?
-var fb2 align(0x1000) = std.mem.zeroes([PANEL_WIDTH * PANEL_HEIGHT] u32);
+var fb2 align(FB_PAGE_SIZE) = std.mem.zeroes([fbWords(PANEL_WIDTH * PANEL_HEIGHT)] u32);
+
+/// Framebuffers are aligned and padded to whole Pages, so that the Host Framebuffer
+/// Backend (hostfb.zig) can map their Pages to Files without touching other Variables
+pub const FB_PAGE_SIZE = 0x1000;
+
+/// Return the number of 32-bit Words for `pixels`, padded to whole Pages
+fn fbWords(comptime pixels: usize) usize {
+    return std.mem.alignForward(pixels * 4, FB_PAGE_SIZE) / 4;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  2D Graphics Operations
+
+/// Overlay that's taken over by the Hardware Cursor (UI Channel 3, see cursor.zig)
+pub const CURSOR_OVERLAY = 1;
+
+/// True if the Overlay is reserved by another Module, like the Hardware Cursor.
+/// A Reserved Overlay can't be drawn or configured through the Framebuffer Driver,
+/// and is left out of the Composition State (getLayers) and the Atomic Commits.
+var overlayReserved = [overlayInfo.len]bool { false, false };
+
+/// Reserve the Overlay for the exclusive use of the Caller
+pub fn reserveOverlay(
+    overlay: u8  // Overlay Number (0 or 1)
+) void {
+    assert(overlay < overlayInfo.len);
+    overlayReserved[overlay] = true;
+}
+
+/// Return true if the Overlay is reserved by another Module
+pub fn isOverlayReserved(
+    overlay: u8  // Overlay Number (0 or 1)
+) bool {
+    return overlay < overlayInfo.len and overlayReserved[overlay];
+}
+
+/// Selected Area of each Overlay, set by FBIOSET_AREA and filled by FBIOSET_COLOR.
+/// Initially the entire Overlay.
+var overlayArea = [overlayInfo.len] c.fb_area_s {
+    c.fb_area_s { .x = 0, .y = 0, .w = overlayInfo[0].sarea.w, .h = overlayInfo[0].sarea.h },
+    c.fb_area_s { .x = 0, .y = 0, .w = overlayInfo[1].sarea.w, .h = overlayInfo[1].sarea.h },
+};
+
+/// Colour of each Overlay: The last Colour filled by FBIOSET_COLOR, or the Solid Colour
+var overlayColor = [overlayInfo.len] u32 { overlayInfo[0].color, overlayInfo[1].color };
+
+/// Return the Overlay Info with the current Colour, Chroma Key and Transparency.
+/// Called by the NuttX Framebuffer Driver for ioctl FBIOGET_OVERLAYINFO.
+/// Returns 0 if OK, or -EINVAL if the Overlay doesn't exist.
+pub export fn overlay_getinfo(
+    vtable: ?*anyopaque,  // Framebuffer Driver (Unused)
+    overlay: u8,          // Overlay Number (0 or 1)
+    oinfo: ?*c.fb_overlayinfo_s  // Returned Overlay Info
+) c_int {
+    _ = vtable;
+    if (overlay >= overlayInfo.len) { return -c.EINVAL; }
+    const p = oinfo orelse return -c.EINVAL;
+    p.* = overlayInfo[overlay];
+    p.color     = overlayColor[overlay];
+    p.chromakey = overlayChromakey[overlay];
+    p.transp    = overlayTransp[overlay];
+    return c.OK;
+}
+
+/// Set the Selected Area of the Overlay.
+/// Called by the NuttX Framebuffer Driver for ioctl FBIOSET_AREA.
+pub export fn overlay_setarea(
+    vtable: ?*anyopaque,  // Framebuffer Driver (Unused)
+    oinfo: [*c]const c.fb_overlayinfo_s  // Overlay and Selected Area
+) c_int {
+    _ = vtable;
+    debug("overlay_setarea: overlay={}", .{ oinfo.*.overlay });
+    if (getOverlay(oinfo.*.overlay, oinfo.*.sarea) == null) { return -c.EINVAL; }
+    overlayArea[oinfo.*.overlay] = oinfo.*.sarea;
+    return c.OK;
+}
+
+/// Fill the Selected Area of the Overlay with the Colour.
+/// Called by the NuttX Framebuffer Driver for ioctl FBIOSET_COLOR.
+pub export fn overlay_setcolor(
+    vtable: ?*anyopaque,  // Framebuffer Driver (Unused)
+    oinfo: [*c]const c.fb_overlayinfo_s  // Overlay and Colour (ARGB 8888)
+) c_int {
+    _ = vtable;
+    debug("overlay_setcolor: overlay={}, color=0x{x}", .{ oinfo.*.overlay, oinfo.*.color });
+    if (oinfo.*.overlay >= overlayInfo.len) { return -c.EINVAL; }
+    const area = overlayArea[oinfo.*.overlay];
+    const surface = getOverlay(oinfo.*.overlay, area) orelse return -c.EINVAL;
+    accel.fill(surface, toRect(area), oinfo.*.color);
+    flushArea(surface, toRect(area));
+    overlayColor[oinfo.*.overlay] = oinfo.*.color;
+    refresh.refresh_activity();
+    return c.OK;
+}
+
+/// Copy an Area from one Overlay to another (or the same) Overlay.
+/// Called by the NuttX Framebuffer Driver for ioctl FBIOSET_BLIT.
+pub export fn overlay_blit(
+    vtable: ?*anyopaque,  // Framebuffer Driver (Unused)
+    blit: [*c]const c.fb_overlayblit_s  // Destination and Source Areas
+) c_int {
+    _ = vtable;
+    const dest = blit.*.dest;
+    const src  = blit.*.src;
+    debug("overlay_blit: dest={}, src={}", .{ dest.overlay, src.overlay });
+
+    // Source and Destination must be the same size
+    if (dest.area.w != src.area.w or dest.area.h != src.area.h) { return -c.EINVAL; }
+    const dest_surface = getOverlay(dest.overlay, dest.area) orelse return -c.EINVAL;
+    const src_surface  = getOverlay(src.overlay,  src.area)  orelse return -c.EINVAL;
+    accel.copy(dest_surface, toRect(dest.area), src_surface, src.area.x, src.area.y);
+    flushArea(dest_surface, toRect(dest.area));
+    refresh.refresh_activity();
+    return c.OK;
+}
+
+/// Blend the Foreground Area over the Background Area, and write to the Destination Area.
+/// Called by the NuttX Framebuffer Driver for ioctl FBIOSET_BLEND.
+pub export fn overlay_blend(
+    vtable: ?*anyopaque,  // Framebuffer Driver (Unused)
+    blend: [*c]const c.fb_overlayblend_s  // Destination, Foreground and Background Areas
+) c_int {
+    _ = vtable;
+    const dest = blend.*.dest;
+    const fg   = blend.*.foreground;
+    const bg   = blend.*.background;
+    debug("overlay_blend: dest={}, fg={}, bg={}", .{ dest.overlay, fg.overlay, bg.overlay });
+
+    // Foreground, Background and Destination must be the same size
+    if (fg.area.w != dest.area.w or fg.area.h != dest.area.h or
+        bg.area.w != dest.area.w or bg.area.h != dest.area.h) { return -c.EINVAL; }
+    const dest_surface = getOverlay(dest.overlay, dest.area) orelse return -c.EINVAL;
+    const fg_surface   = getOverlay(fg.overlay,   fg.area)   orelse return -c.EINVAL;
+    const bg_surface   = getOverlay(bg.overlay,   bg.area)   orelse return -c.EINVAL;
+    accel.blend(
+        dest_surface, toRect(dest.area),
+        fg_surface, fg.area.x, fg.area.y,
+        bg_surface, bg.area.x, bg.area.y
+    );
+    flushArea(dest_surface, toRect(dest.area));
+    refresh.refresh_activity();
+    return c.OK;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Overlay Transparency
+
+/// Set the Transparency of the Overlay. Called by the NuttX Framebuffer Driver for ioctl FBIOSET_TRANSP.
+/// FB_CONSTALPHA: Every pixel has Alpha `transp`, the Pixel Alpha is ignored.
+/// FB_PIXELALPHA: Pixel Alpha is scaled by `transp`, so 0xFF uses the Pixel Alpha as is.
+/// Fading a whole Overlay costs one Register Write, instead of rewriting the Alpha of every pixel.
+/// Returns -EBUSY if the Overlay is reserved (like the Hardware Cursor).
+pub export fn overlay_settransp(
+    vtable: ?*anyopaque,  // Framebuffer Driver (Unused)
+    oinfo: [*c]const c.fb_overlayinfo_s  // Overlay and Transparency
+) c_int {
+    _ = vtable;
+    const transp = oinfo.*.transp;
+    debug("overlay_settransp: overlay={}, transp=0x{x}, mode={}", .{ oinfo.*.overlay, transp.transp, transp.transp_mode });
+    if (isOverlayReserved(oinfo.*.overlay)) { return -c.EBUSY; }
+
+    // LAY_ALPHA_MODE (Bits 1 to 2) = 1 (Global Alpha) or 2 (Global Alpha mixed with Pixel Alpha)
+    const alpha_mode: u2 = switch (transp.transp_mode) {
+        c.FB_CONSTALPHA => 1,
+        c.FB_PIXELALPHA => 2,
+        else => return -c.EINVAL,
+    };
+    switch (oinfo.*.overlay) {
+        0 => setOverlayAlpha(2, alpha_mode, transp.transp),
+        1 => setOverlayAlpha(3, alpha_mode, transp.transp),
+        else => return -c.EINVAL,
+    }
+    overlayTransp[oinfo.*.overlay] = transp;
+    latchSettings();
+    return c.OK;
+}
+
+/// Current Transparency of each Overlay
+var overlayTransp = [overlayInfo.len] c.fb_transp_s { overlayInfo[0].transp, overlayInfo[1].transp };
+
+/// Current Chroma Key of each Overlay (0 for None)
+var overlayChromakey = [overlayInfo.len] u32 { overlayInfo[0].chromakey, overlayInfo[1].chromakey };
+
+/// Set the Chroma Key of the Overlay. Pixels of the Overlay that match the Chroma Key (RGB only)
+/// are keyed out by the Blender, and the Channels underneath show through.
+/// Chroma Key 0 disables keying. Called by the NuttX Framebuffer Driver for ioctl FBIOSET_CHROMAKEY.
+/// Returns -EBUSY if the Overlay is reserved (like the Hardware Cursor).
+pub export fn overlay_setchromakey(
+    vtable: ?*anyopaque,  // Framebuffer Driver (Unused)
+    oinfo: [*c]const c.fb_overlayinfo_s  // Overlay and Chroma Key (ARGB 8888)
+) c_int {
+    _ = vtable;
+    const key = oinfo.*.chromakey;
+    debug("overlay_setchromakey: overlay={}, chromakey=0x{x}", .{ oinfo.*.overlay, key });
+    if (isOverlayReserved(oinfo.*.overlay)) { return -c.EBUSY; }
+
+    // Key N sits between Pipe N and Pipe N+1. Overlay 0 is Pipe 1, Overlay 1 is Pipe 2.
+    switch (oinfo.*.overlay) {
+        0 => setChromaKey(0, key),
+        1 => setChromaKey(1, key),
+        else => return -c.EINVAL,
+    }
+    overlayChromakey[oinfo.*.overlay] = key;
+    latchSettings();
+    return c.OK;
+}
+
+/// Tell the Blender whether the pixels of the Overlay are Premultiplied by their Alpha.
+/// Premultiplied pixels are blended as is, otherwise the Blender multiplies them by the Pixel Alpha.
+/// Returns 0 if OK, -EINVAL if the Overlay doesn't exist, or -EBUSY if it's reserved.
+pub export fn overlay_setpremultiplied(
+    overlay: u8,  // Overlay Number (0 or 1)
+    enable: bool  // True if the pixels are Premultiplied
+) c_int {
+    debug("overlay_setpremultiplied: overlay={}, enable={}", .{ overlay, enable });
+    if (isOverlayReserved(overlay)) { return -c.EBUSY; }
+    switch (overlay) {
+        0 => setPremultiplied(1, enable),
+        1 => setPremultiplied(2, enable),
+        else => return -c.EINVAL,
+    }
+    latchSettings();
+    return c.OK;
+}
+
+/// Set the Alpha Mode and Global Alpha of the UI Channel, preserving the other Attributes
+fn setOverlayAlpha(
+    comptime channel: u8,  // UI Channel Number: 2 or 3
+    alpha_mode: u2,        // 1 for Global Alpha, 2 for Global Alpha mixed with Pixel Alpha
+    global_alpha: u8       // Global Alpha Value
+) void {
+    const ATTR = OVL_UI_ATTR_CTL(channel);
+    var attr = ATTR.read();
+    attr.LAY_ALPHA_MODE = alpha_mode;
+    attr.LAY_GLBALPHA   = global_alpha;
+    ATTR.write(attr);
+}
+
+/// Enable Blender Key `key` for the RGB Colour of `chromakey`, or disable it if `chromakey` is 0.
+/// Matching pixels of the upper Pipe are replaced by the lower Pipe.
+fn setChromaKey(
+    comptime key: u2,  // Key Number: 0 or 1
+    chromakey: u32     // Chroma Key (ARGB 8888)
+) void {
+    const rgb = chromakey & 0xFF_FFFF;
+
+    // Match Red, Green and Blue between Min and Max, which are the same Colour
+    if (chromakey != 0) {
+        putreg32(rgb, BLD_KEY_MAX_BASE + @as(u64, key) * 4);
+        putreg32(rgb, BLD_KEY_MIN_BASE + @as(u64, key) * 4);
+    }
+    const shift = @as(u5, key) * 8;
+    modreg32(
+        if (chromakey != 0) (@as(u32, 0b111) << shift) else 0,  // KEYn_B_MATCH, KEYn_G_MATCH, KEYn_R_MATCH
+        @as(u32, 0b111) << shift,
+        BLD_KEY_CON.addr
+    );
+
+    // KEYn_EN (Bit 4n) and KEYn_MATCH_DIR (Bits 4n+1 to 4n+2) = 1 (Match the upper Pipe)
+    const key_shift = @as(u5, key) * 4;
+    modreg32(
+        if (chromakey != 0) (@as(u32, 0b011) << key_shift) else 0,
+        @as(u32, 0b111) << key_shift,
+        BLD_KEY_CTL.addr
+    );
+}
+
+/// Set or clear the Premultiplied Alpha Mode of the Blender Pipe
+fn setPremultiplied(
+    comptime pipe: u2,  // Blender Pipe: 1 or 2
+    enable: bool        // True if the pixels are Premultiplied
+) void {
+    const mask: u32 = 1 << pipe;  // Pn_ALPHA_MODE (Bit n)
+    modreg32(if (enable) mask else 0, mask, BLD_PREMUL_CTL.addr);
+}
+
+/// Apply the Display Engine Settings at the next Vertical Blanking
+fn latchSettings() void {
+    // GLB_DBUFFER (Global Double Buffer Control) at GLB Offset 0x008
+    // DOUBLE_BUFFER_RDY (Bit 0) = 1 (Register Value is ready for update)
+    // (DE Page 93, 0x110 0008)
+    const DOUBLE_BUFFER_RDY: u1 = 1 << 0;
+    const GLB_DBUFFER = GLB_BASE_ADDRESS + 0x008;
+    comptime{ assert(GLB_DBUFFER == 0x110_0008); }
+    putreg32(DOUBLE_BUFFER_RDY, GLB_DBUFFER);  // TODO: DMB
+    planes.invalidate();  // Atomic Commits must read back the Registers
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Solid Overlays
+
+/// Source of the pixels for an Overlay
+pub const OverlaySource = union(enum) {
+    /// Pixels come from the Overlay's Framebuffer (fb1 or fb2)
+    buffer,
+    /// Every pixel in the Overlay Area is this Colour (ARGB 8888). The Blender Pipe
+    /// generates the Colour, so the UI Channel is disabled and its Framebuffer isn't read.
+    solid: u32,
+};
+
+/// Current Source of each Overlay
+var overlaySource = [overlayInfo.len] OverlaySource { .buffer, .buffer };
+
+/// Show the Overlay as a Solid Rectangle of the Colour (ARGB 8888), covering the Overlay Area.
+/// Needs no Framebuffer Memory, no fill and no Memory Bandwidth for scanning out.
+/// Returns 0 if OK, -EINVAL if the Overlay doesn't exist, or -EBUSY if it's reserved.
+pub export fn overlay_setsolid(
+    overlay: u8,  // Overlay Number (0 or 1)
+    color: u32    // Colour (ARGB 8888)
+) c_int {
+    debug("overlay_setsolid: overlay={}, color=0x{x}", .{ overlay, color });
+    if (isOverlayReserved(overlay)) { return -c.EBUSY; }
+    if (!setOverlaySource(overlay, .{ .solid = color })) { return -c.EINVAL; }
+    return c.OK;
+}
+
+/// Show the Overlay's Framebuffer again, after overlay_setsolid.
+/// Returns 0 if OK, -EINVAL if the Overlay doesn't exist, or -EBUSY if it's reserved.
+pub export fn overlay_setbuffer(
+    overlay: u8  // Overlay Number (0 or 1)
+) c_int {
+    debug("overlay_setbuffer: overlay={}", .{ overlay });
+    if (isOverlayReserved(overlay)) { return -c.EBUSY; }
+    if (!setOverlaySource(overlay, .buffer)) { return -c.EINVAL; }
+    return c.OK;
+}
+
+/// Set the Source of the Overlay's pixels: its Framebuffer or a Solid Colour.
+/// 2D Graphics Operations still draw into the Framebuffer, which is shown again
+/// when the Source is set back to `buffer`. Returns false if the Overlay doesn't exist.
+pub fn setOverlaySource(
+    overlay: u8,            // Overlay Number (0 or 1)
+    source: OverlaySource   // Framebuffer or Solid Colour
+) bool {
+    switch (overlay) {
+        0 => applyOverlaySource(2, source),
+        1 => applyOverlaySource(3, source),
+        else => return false,
+    }
+    overlaySource[overlay] = source;
+    switch (source) {
+        .solid  => |color| overlayColor[overlay] = color,
+        .buffer => {},
+    }
+    latchSettings();
+    return true;
+}
+
+/// Program the Blender Pipe and UI Channel for the Source
+fn applyOverlaySource(
+    comptime channel: u8,  // UI Channel Number: 2 or 3
+    source: OverlaySource  // Framebuffer or Solid Colour
+) void {
+    const pipe = channel - 1;
+    const ATTR = OVL_UI_ATTR_CTL(channel);
+    const fcen: u32 = 1 << pipe;        // Pn_FCEN (Bit n): Pipe n takes the Fill Color
+    const en:   u32 = 1 << (pipe + 8);  // Pn_EN (Bit n+8): Enable Pipe n
+    var attr = ATTR.read();
+    switch (source) {
+        .solid => |color| {
+            // Fill the Pipe with the Colour, then stop fetching the Framebuffer
+            BLD_FILL_COLOR(pipe).write(@bitCast(BLD_FILL_COLOR(pipe).Fields, color));
+            modreg32(fcen | en, fcen | en, BLD_FILL_COLOR_CTL.addr);
+            attr.LAY_EN = 0;
+        },
+        .buffer => {
+            // Fetch the Framebuffer again, then stop filling the Pipe
+            modreg32(en, fcen | en, BLD_FILL_COLOR_CTL.addr);
+            attr.LAY_EN = 1;
+        },
+    }
+    ATTR.write(attr);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Composition State
+
+/// Layer of the Composited Frame, as configured in the Blender.
+/// Used by the Writeback Simulation on the Host Computer (see writeback.zig).
+pub const Layer = struct {
+    surface: ?accel.Surface,  // Framebuffer, or null for a Solid Layer
+    color:   u32,    // Colour of a Solid Layer (ARGB 8888)
+    area:    accel.Rect,  // Position and Size on the Screen
+    global_alpha: u8,     // Global Alpha Value
+    pixel_alpha:  bool,   // True if the Global Alpha is mixed with the Pixel Alpha
+};
+
+/// Maximum number of Layers: Base UI Channel plus the Overlays
+pub const MAX_LAYERS = 1 + overlayInfo.len;
+
+/// True if the Overlays are enabled, set by renderGraphics
+var overlaysEnabled = false;
+
+/// Return the enabled Layers from bottom to top: Base UI Channel, then the Overlays.
+/// Chroma Keys and Reserved Overlays (like the Hardware Cursor) are not included.
+pub fn getLayers(layers: *[MAX_LAYERS]Layer) []const Layer {
+    layers[0] = Layer {
+        .surface = getPlane(),
+        .color   = 0,
+        .area    = .{ .x = 0, .y = 0, .w = PANEL_WIDTH, .h = PANEL_HEIGHT },
+        .global_alpha = 0xFF,
+        .pixel_alpha  = false,  // XRGB 8888
+    };
+    if (!overlaysEnabled) { return layers[0..1]; }
+    var n: usize = 1;
+    for (overlayInfo) |ov, i| {
+        if (overlayReserved[i]) { continue; }
+        const transp = overlayTransp[i];
+        layers[n] = Layer {
+            .surface = switch (overlaySource[i]) {
+                .buffer => getOverlay(@intCast(u8, i), .{ .x = 0, .y = 0, .w = ov.sarea.w, .h = ov.sarea.h }).?,
+                .solid  => null,
+            },
+            .color = switch (overlaySource[i]) {
+                .buffer => 0,
+                .solid  => |color| color,
+            },
+            .area = toRect(ov.sarea),
+
+            // Fill Colour of a Solid Layer has its own Alpha, because the UI Channel is disabled
+            .global_alpha = if (overlaySource[i] == .solid) 0xFF else transp.transp,
+            .pixel_alpha  = (overlaySource[i] == .solid or transp.transp_mode == c.FB_PIXELALPHA),
+        };
+        n += 1;
+    }
+    return layers[0..n];
+}
+
+/// Memory and Geometry of a Framebuffer, for the Host Framebuffer Backend (hostfb.zig)
+pub const Framebuffer = struct {
+    name:   []const u8,  // "fb0", "fb1" or "fb2"
+    mem:    []align(FB_PAGE_SIZE) u8,  // Framebuffer Memory, padded to whole Pages
+    width:  usize,  // Horizontal resolution in pixel columns
+    height: usize,  // Vertical resolution in pixel rows
+    stride: usize,  // Length of a line in bytes
+};
+
+/// Return Framebuffer 0 (Base UI Channel), then the Framebuffers of the Overlays
+pub fn getFramebuffers() [MAX_LAYERS]Framebuffer {
+    return .{
+        .{
+            .name   = "fb0",
+            .mem    = @ptrCast([*]align(FB_PAGE_SIZE) u8, &fb0)[0..@sizeOf(@TypeOf(fb0))],
+            .width  = planeInfo.xres_virtual,
+            .height = planeInfo.yres_virtual,
+            .stride = planeInfo.stride,
+        },
+        .{
+            .name   = "fb1",
+            .mem    = @ptrCast([*]align(FB_PAGE_SIZE) u8, &fb1)[0..@sizeOf(@TypeOf(fb1))],
+            .width  = overlayInfo[0].sarea.w,
+            .height = overlayInfo[0].sarea.h,
+            .stride = overlayInfo[0].stride,
+        },
+        .{
+            .name   = "fb2",
+            .mem    = @ptrCast([*]align(FB_PAGE_SIZE) u8, &fb2)[0..@sizeOf(@TypeOf(fb2))],
+            .width  = overlayInfo[1].sarea.w,
+            .height = overlayInfo[1].sarea.h,
+            .stride = overlayInfo[1].stride,
+        },
+    };
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Blender and Overlay Registers
+
+/// OVL_UI_ATTR_CTL (UI Overlay Attribute Control): OVL_UI Offset 0x00 (DE Page 102)
+fn OVL_UI_ATTR_CTL(comptime channel: u8) type {
+    return mmio.Register(packed struct {
+        LAY_EN:           u1  = 0,  // Bit 0
+        LAY_ALPHA_MODE:   u2  = 0,  // Bits 1 to 2
+        _3:               u1  = 0,
+        LAY_FILLCOLOR_EN: u1  = 0,  // Bit 4
+        _5:               u3  = 0,
+        LAY_FBFMT:        u5  = 0,  // Bits 8 to 12
+        _13:              u11 = 0,
+        LAY_GLBALPHA:     u8  = 0,  // Bits 24 to 31
+    }, OVL_UI_CH1_BASE_ADDRESS + @as(u64, channel - 1) * 0x1000);
+}
+
+/// BLD_FILL_COLOR_CTL (Blender Fill Color Control): BLD Offset 0x000 (DE Page 106)
+const BLD_FILL_COLOR_CTL = mmio.Register(packed struct {
+    P0_FCEN: u1  = 0,  // Bit 0
+    P1_FCEN: u1  = 0,  // Bit 1
+    P2_FCEN: u1  = 0,  // Bit 2
+    P3_FCEN: u1  = 0,  // Bit 3
+    P4_FCEN: u1  = 0,  // Bit 4
+    _5:      u3  = 0,
+    P0_EN:   u1  = 0,  // Bit 8
+    P1_EN:   u1  = 0,  // Bit 9
+    P2_EN:   u1  = 0,  // Bit 10
+    P3_EN:   u1  = 0,  // Bit 11
+    P4_EN:   u1  = 0,  // Bit 12
+    _13:     u19 = 0,
+}, BLD_BASE_ADDRESS + 0x000);
+
+/// BLD_FILL_COLOR (Blender Fill Color): BLD Offset 0x004 + N*0x10 (DE Page 107)
+fn BLD_FILL_COLOR(comptime pipe: u8) type {
+    return mmio.Register(packed struct {
+        BLUE:  u8 = 0,  // Bits 0 to 7
+        GREEN: u8 = 0,  // Bits 8 to 15
+        RED:   u8 = 0,  // Bits 16 to 23
+        ALPHA: u8 = 0,  // Bits 24 to 31
+    }, BLD_BASE_ADDRESS + 0x004 + @as(u64, pipe) * 0x10);
+}
+
+/// BLD_PREMUL_CTL (Blender Pre-Multiply Control): BLD Offset 0x084 (DE Page 109)
+const BLD_PREMUL_CTL = mmio.Register(packed struct {
+    P0_ALPHA_MODE: u1  = 0,  // Bit 0
+    P1_ALPHA_MODE: u1  = 0,  // Bit 1
+    P2_ALPHA_MODE: u1  = 0,  // Bit 2
+    P3_ALPHA_MODE: u1  = 0,  // Bit 3
+    _4:            u28 = 0,
+}, BLD_BASE_ADDRESS + 0x084);
+
+/// BLD_KEY_CTL (Blender Color Key Control): BLD Offset 0x0B0 (DE Page 110)
+const BLD_KEY_CTL = mmio.Register(packed struct {
+    KEY0_EN:        u1  = 0,  // Bit 0
+    KEY0_MATCH_DIR: u2  = 0,  // Bits 1 to 2
+    _3:             u1  = 0,
+    KEY1_EN:        u1  = 0,  // Bit 4
+    KEY1_MATCH_DIR: u2  = 0,  // Bits 5 to 6
+    _7:             u25 = 0,
+}, BLD_BASE_ADDRESS + 0x0B0);
+
+/// BLD_KEY_CON (Blender Color Key Configuration): BLD Offset 0x0B4 (DE Page 110)
+const BLD_KEY_CON = mmio.Register(packed struct {
+    KEY0_B_MATCH: u1  = 0,  // Bit 0
+    KEY0_G_MATCH: u1  = 0,  // Bit 1
+    KEY0_R_MATCH: u1  = 0,  // Bit 2
+    _3:           u5  = 0,
+    KEY1_B_MATCH: u1  = 0,  // Bit 8
+    KEY1_G_MATCH: u1  = 0,  // Bit 9
+    KEY1_R_MATCH: u1  = 0,  // Bit 10
+    _11:          u21 = 0,
+}, BLD_BASE_ADDRESS + 0x0B4);
+
+/// BLD_KEY_MAX (Blender Color Key Max): BLD Offset 0x0C0 + N*4 (DE Page 111)
+/// BLD_KEY_MIN (Blender Color Key Min): BLD Offset 0x0E0 + N*4 (DE Page 111)
+const BLD_KEY_MAX_BASE = BLD_BASE_ADDRESS + 0x0C0;
+const BLD_KEY_MIN_BASE = BLD_BASE_ADDRESS + 0x0E0;
+
+comptime {
+    assert(OVL_UI_ATTR_CTL(3).addr == 0x110_5000);
+    assert(OVL_UI_ATTR_CTL(2).init(.{ .LAY_EN = 1, .LAY_ALPHA_MODE = 2, .LAY_GLBALPHA = 0xFF }).val == 0xFF00_0005);
+    assert(BLD_FILL_COLOR_CTL.set(.{ .P1_FCEN = 1, .P1_EN = 1 }).mask == 0x202);
+    assert(BLD_FILL_COLOR(2).addr == 0x110_1024);
+    assert(BLD_PREMUL_CTL.addr == 0x110_1084);
+    assert(BLD_KEY_CTL.set(.{ .KEY1_EN = 1, .KEY1_MATCH_DIR = 1 }).val == 0b011 << 4);
+    assert(BLD_KEY_CON.set(.{ .KEY1_B_MATCH = 1, .KEY1_G_MATCH = 1, .KEY1_R_MATCH = 1 }).val == 0b111 << 8);
+    assert(BLD_KEY_MIN_BASE == 0x110_10E0);
+}
+
+/// Rotation of the Base UI Channel. PinePhone's Display Engine can't rotate, so for
+/// Landscape Apps we rotate in software: the App renders into fbRotate and calls
+/// FBIO_UPDATE, which rotates the Updated Area into Framebuffer 0.
+var planeRotation = accel.Rotation.rotate0;
+
+/// Unrotated Framebuffer for the Base UI Channel: Landscape 1440 x 720 for 90 and 270 degrees,
+/// Portrait 720 x 1440 for 180 degrees (4 bytes per XRGB 8888 pixel)
+var fbRotate align(0x1000) = std.mem.zeroes([PANEL_WIDTH * PANEL_HEIGHT] u32);
+
+/// Set the Rotation of the Base UI Channel: 0, 90, 180 or 270 degrees (clockwise).
+/// Returns the Unrotated Framebuffer that the App should render into, or null if invalid.
+pub export fn plane_setrotation(
+    degrees: c_int  // Clockwise Rotation
+) ?*anyopaque {
+    debug("plane_setrotation: degrees={}", .{ degrees });
+    planeRotation = switch (degrees) {
+        0   => .rotate0,
+        90  => .rotate90,
+        180 => .rotate180,
+        270 => .rotate270,
+        else => return null,
+    };
+    if (planeRotation == .rotate0) { return planeInfo.fbmem; }
+
+    // Rotate the entire Framebuffer once, so that the Display matches
+    const full = getRotateSurface();
+    accel.rotate(getPlane(), full, accel.Rect { .x = 0, .y = 0, .w = full.width, .h = full.height }, planeRotation);
+    parallel.flushBand(getPlane().pixels[0..(PANEL_WIDTH * PANEL_HEIGHT)]);
+    return &fbRotate;
+}
+
+/// Rotate the Updated Area of the Unrotated Framebuffer into Framebuffer 0.
+/// Only the 8 x 8 Tiles that overlap the Updated Area are rotated.
+/// Called by the NuttX Framebuffer Driver for ioctl FBIO_UPDATE.
+pub export fn plane_updatearea(
+    vtable: ?*anyopaque,  // Framebuffer Driver (Unused)
+    area: [*c]const c.fb_area_s  // Updated Area in the Unrotated Framebuffer
+) c_int {
+    _ = vtable;
+    refresh.refresh_activity();
+    if (planeRotation == .rotate0) { return c.OK; }
+    const src  = getRotateSurface();
+    const rect = toRect(area.*);
+    if (!accel.contains(src, rect)) { return -c.EINVAL; }
+    accel.rotate(getPlane(), src, rect, planeRotation);
+
+    // Flush the rotated Tiles from the Data Cache
+    flushArea(getPlane(), accel.rotatedRect(src, rect, planeRotation));
+    return c.OK;
+}
+
+/// Pan the Base UI Channel to the Visible Area of a Virtual Framebuffer that's taller than
+/// the Panel. We move the Start Address of UI Channel 1 to the Visible Area, so no pixels
+/// are copied. Called by the NuttX Framebuffer Driver for ioctl FBIOPAN_DISPLAY.
+pub export fn plane_pandisplay(
+    vtable: ?*anyopaque,  // Framebuffer Driver (Unused)
+    pinfo: [*c]const c.fb_planeinfo_s  // Virtual Framebuffer, `yoffset` is the top of the Visible Area
+) c_int {
+    _ = vtable;
+    const p = pinfo.*;
+    debug("plane_pandisplay: yoffset={}", .{ p.yoffset });
+
+    // Virtual Framebuffer must be as wide as the Panel, and the Visible Area must lie inside.
+    // Display Engine can't pan horizontally without changing the Pitch, so `xoffset` must be 0.
+    if (p.fbmem == null or
+        p.xres_virtual != PANEL_WIDTH or
+        p.stride != PANEL_WIDTH * 4 or
+        p.xoffset != 0) { return -c.EINVAL; }
+    if (@intCast(usize, p.yoffset) + PANEL_HEIGHT > p.yres_virtual or
+        p.fblen < @intCast(usize, p.stride) * p.yres_virtual) { return -c.EINVAL; }
+
+    const fb = @ptrCast([*]const u32, @alignCast(4, p.fbmem))[0..(p.fblen / 4)];
+    panPlane(fb, p.yoffset);
+    return c.OK;
+}
+
+/// Pan the Base UI Channel to Row `yoffset` of the Virtual Framebuffer `fb`,
+/// which is PANEL_WIDTH pixels wide. Takes effect at the next Vertical Blanking.
+pub fn panPlane(
+    fb: []const u32,  // Virtual Framebuffer
+    yoffset: usize    // Row at the top of the Visible Area
+) void {
+    assert(fb.len >= (yoffset + PANEL_HEIGHT) * PANEL_WIDTH);
+
+    // OVL_UI_TOP_LADD (UI Overlay Top Field Memory Block Low Address) at OVL_UI Offset 0x10
+    // Set to Framebuffer Address + yoffset * stride
+    // (DE Page 104, 0x110 3010)
+    const ptr = @ptrToInt(fb.ptr) + yoffset * PANEL_WIDTH * 4;
+    const OVL_UI_TOP_LADD = OVL_UI_CH1_BASE_ADDRESS + 0x10;
+    comptime{ assert(OVL_UI_TOP_LADD == 0x110_3010); }
+    putreg32(@intCast(u32, ptr), OVL_UI_TOP_LADD);
+    refresh.refresh_activity();
+
+    // Apply Settings at the next Vertical Blanking
+    // GLB_DBUFFER (Global Double Buffer Control) at GLB Offset 0x008
+    // DOUBLE_BUFFER_RDY (Bit 0) = 1
+    // (Register Value is ready for update)
+    // (DE Page 93, 0x110 0008)
+    const DOUBLE_BUFFER_RDY: u1 = 1 << 0;  // Register Value is ready for update
+    const GLB_DBUFFER = GLB_BASE_ADDRESS + 0x008;
+    comptime{ assert(GLB_DBUFFER == 0x110_0008); }
+    putreg32(DOUBLE_BUFFER_RDY, GLB_DBUFFER);  // TODO: DMB
+    planes.invalidate();  // Atomic Commits must read back the Registers
+}
+
+/// Return Framebuffer 0 (Base UI Channel)
+pub fn getPlane() accel.Surface {
+    return accel.Surface {
+        .pixels = &fb0,
+        .stride = PANEL_WIDTH,
+        .width  = PANEL_WIDTH,
+        .height = PANEL_HEIGHT,
+    };
+}
+
+/// Return the Unrotated Framebuffer for the current Rotation
+fn getRotateSurface() accel.Surface {
+    const landscape = (planeRotation == .rotate90 or planeRotation == .rotate270);
+    const width: usize = if (landscape) PANEL_HEIGHT else PANEL_WIDTH;
+    return accel.Surface {
+        .pixels = &fbRotate,
+        .stride = width,
+        .width  = width,
+        .height = if (landscape) PANEL_WIDTH else PANEL_HEIGHT,
+    };
+}
+
+/// Return the Framebuffer for the Overlay, or null if the Overlay doesn't exist,
+/// if it's reserved (like the Hardware Cursor), or if the Area lies outside the Overlay
+fn getOverlay(
+    overlay: u8,         // Overlay Number (0 or 1)
+    area: c.fb_area_s    // Area within the Overlay
+) ?accel.Surface {
+    if (overlay >= overlayInfo.len or overlayReserved[overlay]) { return null; }
+    const ov = overlayInfo[overlay];
+    const surface = accel.Surface {
+        .pixels = @ptrCast([*]u32, @alignCast(4, ov.fbmem)),
+        .stride = ov.stride / 4,
+        .width  = ov.sarea.w,
+        .height = ov.sarea.h,
+    };
+    if (!accel.contains(surface, toRect(area))) { return null; }
+    return surface;
+}
+
+/// Convert the NuttX Framebuffer Area to a Rectangle
+fn toRect(area: c.fb_area_s) accel.Rect {
+    return accel.Rect { .x = area.x, .y = area.y, .w = area.w, .h = area.h };
+}
+
+/// Flush the Rows of the Area from the Data Cache after drawing, so that the
+/// Display Engine will see the pixels (or waits for the Writes to drain, if the
+/// Framebuffer is Write-Combining)
+fn flushArea(surface: accel.Surface, area: accel.Rect) void {
+    if (area.w == 0 or area.h == 0) { return; }
+    const start = area.y * surface.stride + area.x;
+    const end   = (area.y + area.h - 1) * surface.stride + area.x + area.w;
+    parallel.flushBand(surface.pixels[start..end]);
+}
 
 ///////////////////////////////////////////////////////////////////////////////
 //  Init Display Engine
@@ -801,7 +1640,7 @@ pub export fn de2_init() void {
     // Poll PLL_DE_CTRL_REG (from above) until LOCK (Bit 28) is 1
     // (PLL is Locked and Stable)
     debug("Wait for Display Engine PLL to be stable", .{});
-    while (getreg32(PLL_DE_CTRL_REG) & (1 << 28) == 0) {}
+    _ = ready.pollReg(.pll_de, PLL_DE_CTRL_REG, 1 << 28, PLL_DE_TIMEOUT_US);
 
     // Set Special Clock to Display Engine PLL
     // Clear DE_CLK_REG bits 0x0300 0000
@@ -906,9 +1745,9 @@ pub export fn de2_init() void {
     var i: usize = 0;
     while (i < 0x6000) : (i += 4) {
         putreg32(0, MIXER0_BASE_ADDRESS + i);
-        enableLog = false;
+        mmio.enableLog = false;
     }
-    enableLog = true;
+    mmio.enableLog = true;
     debug("  to *0x{x} = 0x0", .{ MIXER0_BASE_ADDRESS + i - 1 });
 
     // Disable MIXER0 Video Scaler (VSU)
@@ -1046,37 +1885,10 @@ pub export fn export_dsi_functions() void {
     panel.panel_reset();
 }
 
-/// Modify the specified bits in a memory mapped register.
-/// Based on https://github.com/apache/nuttx/blob/master/arch/arm64/src/common/arm64_arch.h#L473
-fn modreg32(
-    comptime val: u32,   // Bits to set, like (1 << bit)
-    comptime mask: u32,  // Bits to clear, like (1 << bit)
-    addr: u64  // Address to modify
-) void {
-    comptime{ assert(val & mask == val); }
-    debug("  *0x{x}: clear 0x{x}, set 0x{x}", .{ addr, mask, val & mask });
-    putreg32(
-        (getreg32(addr) & ~(mask))
-            | ((val) & (mask)),
-        (addr)
-    );
-}
-
-/// Get the 32-bit value at the address
-fn getreg32(addr: u64) u32 {
-    const ptr = @intToPtr(*const volatile u32, addr);
-    return ptr.*;
-}
-
-/// Set the 32-bit value at the address
-fn putreg32(val: u32, addr: u64) void {
-    if (enableLog) { debug("  *0x{x} = 0x{x}", .{ addr, val }); }
-    const ptr = @intToPtr(*volatile u32, addr);
-    ptr.* = val;
-}
-
-/// Set to False to disable log 
-var enableLog = true;
+/// Read and Write Registers (see mmio.zig)
+const getreg32 = mmio.getreg32;
+const putreg32 = mmio.putreg32;
+const modreg32 = mmio.modreg32;
 
 ///////////////////////////////////////////////////////////////////////////////
 //  Main Function
@@ -1136,12 +1948,40 @@ pub export fn hello_main(
             // Init Display Engine (in Zig)
             de2_init();
 
-            // Wait a while
-            _ = c.usleep(160000);
+            // Wait for the Display Pipeline to run
+            waitFirstVblank();
 
             // Render Graphics with Display Engine (in Zig)
             renderGraphics(3);  // Render 3 UI Channels
 
+        } else if (std.mem.eql(u8, cmd, "j")) {
+            // Show the Framebuffer Console and scroll some text (after "hello i")
+            console.console_init();
+            var i: usize = 0;
+            while (i < 200) : (i += 1) {
+                var buf: [64]u8 = undefined;
+                const line = std.fmt.bufPrint(&buf, "PinePhone NuttX Console: Line {}\n", .{ i }) catch unreachable;
+                _ = console.console_write(line.ptr, line.len);
+            }
+
+        } else if (std.mem.eql(u8, cmd, "k")) {
+            // Suspend the Display for 5 seconds then Resume (after "hello 3")
+            standby.display_suspend();
+            _ = c.sleep(5);
+            if (standby.display_resume() != 0) {
+                // Panel lost its state, do the full Display Init
+                test_render(3);
+            }
+
+        } else if (std.mem.eql(u8, cmd, "l")) {
+            // Move the Hardware Cursor diagonally across the Screen and off the edges (after "hello 3")
+            _ = cursor.cursor_init(&cursor.arrow, cursor.ARROW_WIDTH, cursor.ARROW_HEIGHT);
+            var i: c_int = -cursor.ARROW_HEIGHT;
+            while (i < PANEL_HEIGHT) : (i += 4) {
+                cursor.cursor_move(@divTrunc(i, 2), i);
+                _ = c.usleep(16_000);
+            }
+
         } else if (std.mem.eql(u8, cmd, "0")) {
             // Render 3 UI Channels in Zig and C
 
@@ -1188,8 +2028,8 @@ pub export fn hello_main(
             // https://github.com/lupyuen2/wip-pinephone-nuttx/blob/tcon2/arch/arm64/src/a64/a64_de.c
             _ = a64_de_init();
 
-            // Wait 160 milliseconds
-            up_mdelay(160);
+            // Wait for the Display Pipeline to run
+            waitFirstVblank();
 
             // Render Graphics with Display Engine (in C)
             // https://github.com/lupyuen/pinephone-nuttx/blob/main/test/test_a64_de.c
@@ -1237,6 +2077,12 @@ fn usage() void {
     err(" Start MIPI DSI HSC and HSD (a64_mipi_dsi_start)", .{});
     err("hello i", .{});
     err(" Render Graphics with Display Engine (in Zig)", .{});
+    err("hello j", .{});
+    err(" Scroll Text on the Framebuffer Console (in Zig)", .{});
+    err("hello k", .{});
+    err(" Suspend and Resume the Display (in Zig)", .{});
+    err("hello l", .{});
+    err(" Move the Hardware Cursor (in Zig)", .{});
 
     // Calibrate CONFIG_BOARD_LOOPSPERMSEC (default is 5000)
     debug("Calibrate CONFIG_BOARD_LOOPSPERMSEC", .{});
@@ -1246,62 +2092,11 @@ fn usage() void {
 }
 
 ///////////////////////////////////////////////////////////////////////////////
-//  Panic Handler
-
-/// Called by Zig when it hits a Panic. We print the Panic Message, Stack Trace and halt. See 
-/// https://andrewkelley.me/post/zig-stack-traces-kernel-panic-bare-bones-os.html
-/// https://github.com/ziglang/zig/blob/master/lib/std/builtin.zig#L763-L847
-pub fn panic(
-    message: []const u8, 
-    _stack_trace: ?*std.builtin.StackTrace
-) noreturn {
-    // Print the Panic Message
-    _ = _stack_trace;
-    _ = puts("\n!ZIG PANIC!");
-    _ = puts(@ptrCast([*c]const u8, message));
-
-    // Print the Stack Trace
-    _ = puts("Stack Trace:");
-    var it = std.debug.StackIterator.init(@returnAddress(), null);
-    while (it.next()) |return_address| {
-        _ = printf("%p\n", return_address);
-    }
+//  Panic Handler and Logging
 
-    // Halt
-    c.exit(1);
-}
-
-///////////////////////////////////////////////////////////////////////////////
-//  Logging
-
-/// Called by Zig for `std.log.debug`, `std.log.info`, `std.log.err`, ...
-/// https://gist.github.com/leecannon/d6f5d7e5af5881c466161270347ce84d
-pub fn log(
-    comptime _message_level: std.log.Level,
-    comptime _scope: @Type(.EnumLiteral),
-    comptime format: []const u8,
-    args: anytype,
-) void {
-    _ = _message_level;
-    _ = _scope;
-
-    // Format the message
-    var buf: [100]u8 = undefined;  // Limit to 100 chars
-    var slice = std.fmt.bufPrint(&buf, format, args)
-        catch { _ = puts("*** log error: buf too small"); return; };
-    
-    // Terminate the formatted message with a null
-    var buf2: [buf.len + 1 : 0]u8 = undefined;
-    std.mem.copy(
-        u8, 
-        buf2[0..slice.len], 
-        slice[0..slice.len]
-    );
-    buf2[slice.len] = 0;
-
-    // Print the formatted message
-    _ = puts(&buf2);
-}
+/// Called by Zig when it hits a Panic, and for `std.log.debug`, `std.log.err`, ... (see mmio.zig)
+pub const panic = mmio.panic;
+pub const log   = mmio.log;
 
 ///////////////////////////////////////////////////////////////////////////////
 //  Imported Functions and Variables
@@ -1317,11 +2112,6 @@ extern fn pinephone_pmic_init() c_int;
 extern fn pinephone_render_graphics() c_int;
 extern fn up_mdelay(milliseconds: c_uint) void;
 
-/// For safety, we import these functions ourselves to enforce Null-Terminated Strings.
-/// We changed `[*c]const u8` to `[*:0]const u8`
-extern fn printf(format: [*:0]const u8, ...) c_int;
-extern fn puts(str: [*:0]const u8) c_int;
-
 /// Aliases for Zig Standard Library
 const assert = std.debug.assert;
 const debug  = std.log.debug;
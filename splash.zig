@@ -0,0 +1,324 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! Boot Splash Screen for PinePhone on Apache NuttX RTOS.
+//! Decodes a QOI Image (Quite OK Image Format, https://qoiformat.org/qoi-specification.pdf)
+//! straight into Framebuffer 0 as the bytes arrive, without Intermediate Buffers or Heap.
+//! A Splash Screen with flat colours is a few KB in QOI, instead of 4 MB of raw pixels.
+//! The Image may be fed in chunks of any size (like Blocks read from Flash), so it can be
+//! decoded between the stages of Display Bring-Up while they wait for the Panel.
+//! Runs of pixels are stored with std.mem.set, which compiles to Vector Stores.
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Import the 2D Graphics Operations Module, for the Framebuffer Surface
+const accel = @import("./accel.zig");
+
+/// Import the Display Engine Module, for Framebuffer 0
+const render = @import("./render.zig");
+
+/// Import the Parallel Rendering Module, for flushing the Data Cache
+const parallel = @import("./parallel.zig");
+
+/// Import NuttX Functions from C
+const c = @cImport({
+    // NuttX Defines
+    @cDefine("__NuttX__",  "");
+    @cDefine("NDEBUG",     "");
+    @cDefine("FAR",        "");
+
+    // NuttX Header Files
+    @cInclude("arch/types.h");
+    @cInclude("../../nuttx/include/limits.h");
+    @cInclude("nuttx/config.h");
+    @cInclude("errno.h");
+});
+
+/// Errors while decoding the Splash Screen
+pub const Error = error {
+    InvalidHeader,  // Not a QOI Image
+    TooLarge,       // Image is larger than the Framebuffer
+    Truncated,      // Image ended before the last pixel
+};
+
+/// Colour of the Framebuffer around an Image that's smaller than the Panel (XRGB 8888)
+const BACKGROUND = 0xFF00_0000;
+
+/// QOI Header: Magic "qoif", Width and Height (Big Endian), Channels and Colour Space
+const HEADER_SIZE = 14;
+
+/// QOI Ops: 8-bit Tags, and 2-bit Tags in the upper 2 bits of the first byte
+const QOI_OP_RGB   = 0xFE;  // Followed by Red, Green, Blue
+const QOI_OP_RGBA  = 0xFF;  // Followed by Red, Green, Blue, Alpha
+const QOI_OP_INDEX = 0;     // 6-bit Index into the Colour Table
+const QOI_OP_DIFF  = 1;     // 2-bit differences of Red, Green, Blue (bias 2)
+const QOI_OP_LUMA  = 2;     // 6-bit difference of Green (bias 32), then 4-bit Red and Blue relative to Green (bias 8)
+const QOI_OP_RUN   = 3;     // 6-bit Run Length (bias 1), repeats the previous pixel
+
+/// Largest QOI Op (QOI_OP_RGBA)
+const MAX_OP_SIZE = 5;
+
+/// QOI Pixel
+const Rgba = struct {
+    r: u8,
+    g: u8,
+    b: u8,
+    a: u8,
+};
+
+/// Return the size of the QOI Op that begins with the byte
+fn opSize(tag: u8) usize {
+    if (tag == QOI_OP_RGB)  { return 4; }
+    if (tag == QOI_OP_RGBA) { return 5; }
+    return if (tag >> 6 == QOI_OP_LUMA) 2 else 1;
+}
+
+/// Return the Position of the pixel in the Colour Table
+fn hash(px: Rgba) usize {
+    return (@as(usize, px.r) * 3 + @as(usize, px.g) * 5 + @as(usize, px.b) * 7 + @as(usize, px.a) * 11) % 64;
+}
+
+/// Convert the QOI Pixel to ARGB 8888
+fn toArgb(px: Rgba) u32 {
+    return @as(u32, px.a) << 24 | @as(u32, px.r) << 16 | @as(u32, px.g) << 8 | px.b;
+}
+
+comptime {
+    assert(opSize(QOI_OP_RGBA) == MAX_OP_SIZE);
+    assert(opSize(0xC0) == 1 and opSize(0x80) == 2);
+    assert(hash(.{ .r = 0, .g = 0, .b = 0, .a = 255 }) == 53);
+    assert(toArgb(.{ .r = 0x12, .g = 0x34, .b = 0x56, .a = 0xFF }) == 0xFF12_3456);
+}
+
+/// Streaming QOI Decoder that writes the pixels into a Framebuffer.
+/// The Image is centred in the Framebuffer, and the rest is filled with BACKGROUND.
+pub const Decoder = struct {
+    /// Framebuffer to be written
+    dest: accel.Surface,
+    /// Header has been decoded
+    started: bool = false,
+    /// Header or QOI Op carried over from the previous chunk
+    buf: [HEADER_SIZE]u8 = undefined,
+    buf_len: usize = 0,
+    /// Image Size (pixels)
+    width:  usize = 0,
+    height: usize = 0,
+    /// Top Left of the Image in the Framebuffer
+    x0: usize = 0,
+    y0: usize = 0,
+    /// Position of the next pixel in the Image
+    col: usize = 0,
+    row: usize = 0,
+    /// Image Rows that have been flushed from the Data Cache
+    flushed: usize = 0,
+    /// Previous pixel and Colour Table
+    px: Rgba = .{ .r = 0, .g = 0, .b = 0, .a = 255 },
+    index: [64]Rgba = std.mem.zeroes([64]Rgba),
+
+    /// Return a Decoder that writes into the Framebuffer
+    pub fn init(dest: accel.Surface) Decoder {
+        return .{ .dest = dest };
+    }
+
+    /// Decode the next chunk of the Image. Complete Rows are flushed to RAM,
+    /// so the Display Engine may show them already.
+    pub fn feed(self: *Decoder, data: []const u8) Error!void {
+        var i: usize = 0;
+
+        // Collect the Header, which may be split across chunks
+        if (!self.started) {
+            i = std.math.min(HEADER_SIZE - self.buf_len, data.len);
+            std.mem.copy(u8, self.buf[self.buf_len..], data[0..i]);
+            self.buf_len += i;
+            if (self.buf_len < HEADER_SIZE) { return; }
+            try self.start();
+            self.buf_len = 0;
+        }
+
+        while (i < data.len and self.row < self.height) {
+            if (self.buf_len == 0 and data.len - i >= MAX_OP_SIZE) {
+                // Whole Op is in this chunk
+                i += self.decodeOp(data[i..]);
+            } else {
+                // Collect the Op across chunks
+                self.buf[self.buf_len] = data[i];
+                self.buf_len += 1;
+                i += 1;
+                if (self.buf_len == opSize(self.buf[0])) {
+                    _ = self.decodeOp(self.buf[0..self.buf_len]);
+                    self.buf_len = 0;
+                }
+            }
+        }
+        // Bytes after the last pixel are the End Marker, which we don't check
+        self.flushRows();
+    }
+
+    /// Check that every pixel of the Image has been decoded
+    pub fn finish(self: *Decoder) Error!void {
+        if (!self.started or self.row < self.height) { return error.Truncated; }
+    }
+
+    /// Check the Header, place the Image and fill the Background
+    fn start(self: *Decoder) Error!void {
+        const h = self.buf;
+        if (!std.mem.eql(u8, h[0..4], "qoif") or h[12] < 3 or h[12] > 4 or h[13] > 1) {
+            return error.InvalidHeader;
+        }
+        self.width  = std.mem.readIntBig(u32, h[4..8]);
+        self.height = std.mem.readIntBig(u32, h[8..12]);
+        debug("start: {} x {}", .{ self.width, self.height });
+        if (self.width == 0 or self.height == 0) { return error.InvalidHeader; }
+        if (self.width > self.dest.width or self.height > self.dest.height) { return error.TooLarge; }
+        self.x0 = (self.dest.width  - self.width)  / 2;
+        self.y0 = (self.dest.height - self.height) / 2;
+        self.started = true;
+
+        // Fill the Background above, below, left and right of the Image
+        if (self.width < self.dest.width or self.height < self.dest.height) {
+            const d = self.dest;
+            const y1 = self.y0 + self.height;
+            accel.fill(d, .{ .x = 0, .y = 0,  .w = d.width, .h = self.y0 }, BACKGROUND);
+            accel.fill(d, .{ .x = 0, .y = y1, .w = d.width, .h = d.height - y1 }, BACKGROUND);
+            accel.fill(d, .{ .x = 0, .y = self.y0, .w = self.x0, .h = self.height }, BACKGROUND);
+            accel.fill(d, .{ .x = self.x0 + self.width, .y = self.y0, .w = d.width - self.x0 - self.width, .h = self.height }, BACKGROUND);
+            parallel.flushBand(d.pixels[0..(d.height * d.stride)]);
+        }
+    }
+
+    /// Decode the QOI Op at the start of `op`, which has at least opSize(op[0]) bytes.
+    /// Returns the size of the Op.
+    fn decodeOp(self: *Decoder, op: []const u8) usize {
+        const tag = op[0];
+        var px = self.px;
+        var size: usize = 1;
+        var count: usize = 1;
+        if (tag == QOI_OP_RGB) {
+            px = .{ .r = op[1], .g = op[2], .b = op[3], .a = px.a };
+            size = 4;
+        } else if (tag == QOI_OP_RGBA) {
+            px = .{ .r = op[1], .g = op[2], .b = op[3], .a = op[4] };
+            size = 5;
+        } else switch (tag >> 6) {
+            QOI_OP_INDEX => px = self.index[tag & 0x3F],
+            QOI_OP_DIFF => {
+                px.r = px.r +% ((tag >> 4) & 3) -% 2;
+                px.g = px.g +% ((tag >> 2) & 3) -% 2;
+                px.b = px.b +% (tag & 3) -% 2;
+            },
+            QOI_OP_LUMA => {
+                const dg = (tag & 0x3F) -% 32;
+                px.r = px.r +% dg -% 8 +% (op[1] >> 4);
+                px.g = px.g +% dg;
+                px.b = px.b +% dg -% 8 +% (op[1] & 0xF);
+                size = 2;
+            },
+            QOI_OP_RUN => count = (tag & 0x3F) + 1,
+            else => unreachable,
+        }
+        self.px = px;
+        self.index[hash(px)] = px;
+        self.put(toArgb(px), count);
+        return size;
+    }
+
+    /// Write `count` pixels of the Colour at the next Position. Runs may wrap to the next Row.
+    fn put(self: *Decoder, color: u32, count: usize) void {
+        var n = count;
+        while (n > 0 and self.row < self.height) {
+            const start = (self.y0 + self.row) * self.dest.stride + self.x0 + self.col;
+            const k = std.math.min(n, self.width - self.col);
+            if (k == 1) {
+                self.dest.pixels[start] = color;
+            } else {
+                std.mem.set(u32, self.dest.pixels[start..(start + k)], color);
+            }
+            n -= k;
+            self.col += k;
+            if (self.col == self.width) {
+                self.col = 0;
+                self.row += 1;
+            }
+        }
+    }
+
+    /// Flush the Rows completed since the last flush from the Data Cache
+    fn flushRows(self: *Decoder) void {
+        if (self.row == self.flushed) { return; }
+        const stride = self.dest.stride;
+        const first = (self.y0 + self.flushed) * stride + self.x0;
+        const last  = (self.y0 + self.row - 1) * stride + self.x0 + self.width;
+        parallel.flushBand(self.dest.pixels[first..last]);
+        self.flushed = self.row;
+    }
+};
+
+///////////////////////////////////////////////////////////////////////////////
+//  Exported Functions
+
+/// Decoder for the Splash Screen in Framebuffer 0, between splash_begin and splash_end
+var decoder: ?Decoder = null;
+
+/// True if the Splash Screen has been decoded into Framebuffer 0.
+/// initFramebuffers (render.zig) won't overwrite it with the Test Pattern.
+pub var shown = false;
+
+/// Start decoding a QOI Splash Screen into Framebuffer 0.
+/// Then call splash_feed with each chunk of the Image, and splash_end.
+pub export fn splash_begin() void {
+    debug("splash_begin", .{});
+    decoder = Decoder.init(render.getPlane());
+    shown = false;
+}
+
+/// Decode the next chunk of the Splash Screen. May be called between the stages of
+/// Display Bring-Up. Returns 0 if OK, or -EINVAL if the Image is invalid.
+pub export fn splash_feed(
+    data: [*]const u8,  // Next chunk of the QOI Image
+    len: usize          // Length of the chunk (bytes)
+) c_int {
+    if (decoder) |*d| {
+        d.feed(data[0..len]) catch |err| {
+            std.log.err("splash_feed: {}", .{ err });
+            decoder = null;
+            return -c.EINVAL;
+        };
+        return c.OK;
+    }
+    return -c.EINVAL;
+}
+
+/// Finish decoding the Splash Screen. Returns 0 if every pixel has been decoded,
+/// or -EINVAL if the Image was truncated or invalid.
+pub export fn splash_end() c_int {
+    debug("splash_end", .{});
+    var d = decoder orelse return -c.EINVAL;
+    decoder = null;
+    d.finish() catch |err| {
+        std.log.err("splash_end: {}", .{ err });
+        return -c.EINVAL;
+    };
+    shown = true;
+    return c.OK;
+}
+
+/// Aliases for Zig Standard Library
+const assert = std.debug.assert;
+const debug  = std.log.debug;
@@ -0,0 +1,304 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! Display Suspend and Resume for Apache NuttX RTOS on PinePhone.
+//! Suspend turns off the Backlight, puts the ST7703 Panel to sleep, stops
+//! MIPI DSI HSC / HSD, saves the MIPI DSI, TCON0 and Display Engine Configuration
+//! Registers and gates their Clocks. Resume restores only that state and wakes the Panel,
+//! instead of repeating the whole Display Init (test_render).
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Import the Register Access Module
+const mmio = @import("./mmio.zig");
+
+/// Import the MIPI Display Serial Interface Module
+const dsi = @import("./display.zig");
+
+/// Import the Backlight Module
+const backlight = @import("./backlight.zig");
+
+/// Import the Atomic Plane Commits Module, to rewrite the restored Registers
+const planes = @import("./planes.zig");
+
+/// Import the Monotonic Clock Module
+const clock = @import("./clock.zig");
+
+/// Import NuttX Functions from C
+const c = @cImport({
+    // NuttX Defines
+    @cDefine("__NuttX__",  "");
+    @cDefine("NDEBUG",     "");
+    @cDefine("FAR",        "");
+
+    // NuttX Header Files
+    @cInclude("arch/types.h");
+    @cInclude("../../nuttx/include/limits.h");
+    @cInclude("nuttx/config.h");
+    @cInclude("errno.h");
+    @cInclude("unistd.h");
+});
+
+/// Resume should complete within 150 milliseconds: 120 milliseconds
+/// for the Panel to leave Sleep Mode, plus restoring the Registers
+pub const RESUME_BUDGET_US = 150_000;
+
+/// Microseconds taken by the last Resume
+pub var last_resume_us: u64 = 0;
+
+/// Suspend the Display: Backlight Off, Panel Sleep In, MIPI DSI back to
+/// Low Power Mode, then save the Display Registers and gate their Clocks.
+/// The Framebuffers are left untouched in RAM.
+pub export fn display_suspend() void {
+    debug("display_suspend: start", .{});
+    defer { debug("display_suspend: end", .{}); }
+    if (suspended) { return; }
+
+    // Turn off Display Backlight
+    backlight.backlight_disable();
+
+    // Stop MIPI DSI HSC and HSD, so that we may send DCS Commands
+    dsi.stop_dsi();
+
+    // Display Off and Sleep In
+    dsi.panel_sleep();
+    sleep_in_at = clock.now_us();
+
+    // Save the Registers while their Clocks are running
+    saveRegisters(&dsi_ranges,     &dsi_saved);
+    saveRegisters(&display_ranges, &display_saved);
+
+    // Gate the Clocks for MIPI DSI, TCON0 and Display Engine
+    gateClocks(false);
+    suspended = true;
+}
+
+/// Resume the Display after display_suspend. Returns 0 if the Display was
+/// resumed. Returns a negative error code if the Display wasn't suspended or
+/// the Panel doesn't respond (e.g. it lost power), in which case the caller
+/// should do the full Display Init (test_render).
+pub export fn display_resume() c_int {
+    debug("display_resume: start", .{});
+    defer { debug("display_resume: end", .{}); }
+    if (!suspended) { return -c.EINVAL; }
+    const start = clock.now_us();
+
+    // Ungate the Clocks and restore MIPI DSI, still in Low Power Mode
+    gateClocks(true);
+    suspended = false;
+    restoreRegisters(&dsi_ranges, &dsi_saved);
+
+    // Panel must be asleep (not reset) and answering DCS Commands
+    const mode = dsi.getPowerMode() orelse {
+        std.log.err("display_resume: panel not responding", .{});
+        return -c.EIO;
+    };
+    debug("display_resume: power_mode=0x{x}", .{ mode });
+
+    // Panel needs SLEEP_IN_DELAY_MS after Sleep In before the next Command
+    clock.waitSince(sleep_in_at, dsi.SLEEP_IN_DELAY_MS * 1000);
+
+    // Sleep Out. Restore TCON0 and Display Engine while the Panel wakes up.
+    dsi.panel_sleep_out();
+    const sleep_out_at = clock.now_us();
+    restoreRegisters(&display_ranges, &display_saved);
+
+    // Apply the restored Display Engine Registers
+    // GLB_DBUFFER (Global Double Buffer Control) at MIXER0 Offset 0x0008 (DE Page 93)
+    // Set DOUBLE_BUFFER_RDY (Bit 0) to 1
+    const GLB_DBUFFER = 0x110_0008;
+    const DOUBLE_BUFFER_RDY: u1 = 1 << 0;
+    putreg32(DOUBLE_BUFFER_RDY, GLB_DBUFFER);  // TODO: DMB
+    planes.invalidate();
+
+    // Display On only after SLEEP_OUT_DELAY_MS, counting the time spent above
+    clock.waitSince(sleep_out_at, dsi.SLEEP_OUT_DELAY_MS * 1000);
+    dsi.panel_display_on();
+
+    // Start MIPI DSI HSC and HSD, then turn on Display Backlight
+    dsi.start_dsi();
+    backlight.backlight_enable(90);
+
+    last_resume_us = clock.now_us() - start;
+    if (last_resume_us > RESUME_BUDGET_US) {
+        std.log.warn("display_resume: took {} us, budget is {} us", .{ last_resume_us, RESUME_BUDGET_US });
+    } else {
+        debug("display_resume: took {} us", .{ last_resume_us });
+    }
+    return 0;
+}
+
+/// True if the Display has been suspended and not resumed
+var suspended = false;
+
+/// Timestamp of Sleep In (microseconds)
+var sleep_in_at: u64 = 0;
+
+///////////////////////////////////////////////////////////////////////////////
+//  Saved Registers
+
+/// Range of consecutive 32-bit Registers
+const Range = struct {
+    addr: u64,     // Address of the first Register
+    words: usize,  // Number of Registers
+    mask: u32 = 0xFFFF_FFFF,  // Bits to be restored: Trigger Bits are excluded
+};
+
+/// MIPI DSI and D-PHY Configuration Registers, restored before waking the Panel.
+/// Only the Registers written by the Display Init are restored. Interrupt Status,
+/// Instru_En (Bit 0 of DSI_BASIC_CTL0_REG), DSI_INST_JUMP_SEL_REG and
+/// DSI_TRANS_START_REG start a Transmission, and are left to `start_dsi`.
+/// DSI_CMD_CTL_REG and the Command FIFOs at DSI Offset 0x200 onwards are excluded too.
+/// The D-PHY Analog Registers must be powered up in sequence with delays, and keep
+/// their values while only the Clock is gated, so they are not replayed.
+const dsi_ranges = [_]Range {
+    .{ .addr = 0x1CA_0000, .words = 1 },  // DSI_CTL_REG (A31 Page 843)
+    .{ .addr = 0x1CA_000C, .words = 1 },  // DSI_BASIC_CTL_REG
+    .{ .addr = 0x1CA_0010, .words = 1, .mask = ~@as(u32, Instru_En) },  // DSI_BASIC_CTL0_REG: CRC_En, ECC_En
+    .{ .addr = 0x1CA_0014, .words = 3 },  // DSI_BASIC_CTL1_REG, DSI_BASIC_SIZE0_REG, DSI_BASIC_SIZE1_REG
+    .{ .addr = 0x1CA_0020, .words = 10 }, // DSI_INST_FUNC_REG(0 to 7), DSI_INST_LOOP_SEL_REG, DSI_INST_LOOP_NUM_REG(0)
+    .{ .addr = 0x1CA_004C, .words = 1 },  // DSI_INST_JUMP_CFG_REG
+    .{ .addr = 0x1CA_0054, .words = 1 },  // DSI_INST_LOOP_NUM_REG(1)
+    .{ .addr = 0x1CA_0078, .words = 3 },  // DSI_TRANS_ZERO_REG, DSI_TCON_DRQ_REG, DSI_PIXEL_CTL0_REG
+    .{ .addr = 0x1CA_0090, .words = 1 },  // DSI_PIXEL_PH_REG
+    .{ .addr = 0x1CA_0098, .words = 2 },  // DSI_PIXEL_PF0_REG, DSI_PIXEL_PF1_REG
+    .{ .addr = 0x1CA_00B0, .words = 10 }, // DSI_SYNC_HSS/HSE/VSS/VSE_REG, DSI_BLK_HSA/HBP/HFP(0,1)_REG
+    .{ .addr = 0x1CA_00E0, .words = 4 },  // DSI_BLK_HBLK(0,1)_REG, DSI_BLK_VBLK(0,1)_REG
+    .{ .addr = 0x1CA_1004, .words = 1 },  // DPHY_TX_CTL_REG
+    .{ .addr = 0x1CA_1010, .words = 5 },  // DPHY_TX_TIME(0 to 4)_REG
+    .{ .addr = 0x1CA_1000, .words = 1 },  // DPHY_GCTL_REG (Enable D-PHY)
+};
+
+/// Instru_En (Bit 0) of DSI_BASIC_CTL0_REG starts the DSI Instructions
+const Instru_En = 1 << 0;
+
+/// TCON0 and Display Engine Configuration Registers, restored while the Panel wakes up.
+/// DE Top comes first, so that the Mixer is out of reset before its Registers are written.
+/// TCON_GINT0_REG (Interrupt Flags), TCON0_CPU_WR_REG (starts a CPU Write),
+/// TCON0_CPU_RD0/RD1_REG and TCON_DEBUG_REG (Status) are not replayed, and TCON_GCTL_REG
+/// (TCON_En) is restored last. GLB_STS is Status and GLB_DBUFFER is set after restoring.
+const display_ranges = [_]Range {
+    .{ .addr = 0x100_0000, .words = 0x014 / 4 },  // DE Top: SCLK_GATE, HCLK_GATE, AHB_RESET, DE2TCON_MUX (DE Page 25)
+    .{ .addr = 0x110_0000, .words = 1 },          // MIXER0 GLB_CTL (DE Page 90)
+    .{ .addr = 0x110_000C, .words = 1 },          // MIXER0 GLB_SIZE
+    .{ .addr = 0x110_1000, .words = 0x100 / 4 },  // MIXER0 BLD, including Color Keys (DE Page 106)
+    .{ .addr = 0x110_3000, .words = 0x090 / 4 },  // MIXER0 OVL_UI Channel 1 (DE Page 102)
+    .{ .addr = 0x110_4000, .words = 0x090 / 4 },  // MIXER0 OVL_UI Channel 2
+    .{ .addr = 0x110_5000, .words = 0x090 / 4 },  // MIXER0 OVL_UI Channel 3
+    .{ .addr = 0x114_0000, .words = 1 },          // MIXER0 UI_SCALER1 Control (DE Page 90)
+    .{ .addr = 0x115_0000, .words = 1 },          // MIXER0 UI_SCALER2 Control
+    .{ .addr = 0x116_0000, .words = 1 },          // MIXER0 UI_SCALER3 Control
+    .{ .addr = 0x1C0_C008, .words = 0x05C / 4 },  // TCON0 Offset 0x008 to 0x060 (A64 Page 500)
+    .{ .addr = 0x1C0_C070, .words = 0x08C / 4 },  // TCON0 Offset 0x070 to 0x0F8
+    .{ .addr = 0x1C0_C100, .words = 0x100 / 4 },  // TCON0 Offset 0x100 to 0x1FC
+    .{ .addr = 0x1C0_C000, .words = 1 },          // TCON_GCTL_REG (TCON_En): Last
+};
+
+comptime {
+    // DE Top, then the Mixer, then TCON0, and TCON_En last: TCON0 must not scan out
+    // from a Mixer that's still in reset or half-restored
+    assert(display_ranges[0].addr == 0x100_0000);
+    assert(display_ranges[display_ranges.len - 1].addr == 0x1C0_C000);
+    var seen_tcon = false;
+    for (display_ranges) |r| {
+        const is_tcon = r.addr >= 0x1C0_C000 and r.addr < 0x1C0_D000;
+        assert(is_tcon or !seen_tcon);  // No Display Engine Range after TCON0
+        seen_tcon = seen_tcon or is_tcon;
+    }
+}
+
+/// Saved Register Values
+var dsi_saved:     [countWords(&dsi_ranges)]u32     = undefined;
+var display_saved: [countWords(&display_ranges)]u32 = undefined;
+
+/// Return the total number of Registers in the Ranges
+fn countWords(comptime ranges: []const Range) usize {
+    var n: usize = 0;
+    for (ranges) |r| { n += r.words; }
+    return n;
+}
+
+/// Read the Registers in the Ranges into `saved`
+fn saveRegisters(comptime ranges: []const Range, saved: []u32) void {
+    var i: usize = 0;
+    inline for (ranges) |r| {
+        var n: usize = 0;
+        while (n < r.words) : (n += 1) {
+            saved[i] = getreg32(r.addr + n * 4);
+            i += 1;
+        }
+    }
+}
+
+/// Write the Registers in the Ranges from `saved`, in order. Bits outside the
+/// Mask of each Range are written as 0.
+fn restoreRegisters(comptime ranges: []const Range, saved: []const u32) void {
+    var i: usize = 0;
+    inline for (ranges) |r| {
+        var n: usize = 0;
+        while (n < r.words) : (n += 1) {
+            putreg32(saved[i] & r.mask, r.addr + n * 4);  // TODO: DMB
+            i += 1;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Clock Gating
+
+/// Clock Gating Bits in the Clock Control Unit (CCU Base Address 0x01C2 0000)
+const Gate = struct {
+    addr: u64,  // CCU Register
+    mask: u32,  // Gating Bits
+};
+
+/// Clocks for MIPI DSI, TCON0 and Display Engine. The PLLs keep running,
+/// so that Resume doesn't wait for them to lock again.
+const clock_gates = [_]Gate {
+    // BUS_CLK_GATING_REG0 at CCU Offset 0x0060 (A64 Page 100): MIPIDSI_GATING (Bit 1)
+    .{ .addr = 0x1C2_0060, .mask = 1 << 1 },
+    // BUS_CLK_GATING_REG1 at CCU Offset 0x0064 (A64 Page 102): DE_GATING (Bit 12), TCON0_GATING (Bit 3)
+    .{ .addr = 0x1C2_0064, .mask = (1 << 12) | (1 << 3) },
+    // DE_CLK_REG at CCU Offset 0x0104 (A64 Page 117): SCLK_GATING (Bit 31)
+    .{ .addr = 0x1C2_0104, .mask = 1 << 31 },
+    // TCON0_CLK_REG at CCU Offset 0x0118 (A64 Page 117): SCLK_GATING (Bit 31)
+    .{ .addr = 0x1C2_0118, .mask = 1 << 31 },
+    // MIPI_DSI_CLK_REG at CCU Offset 0x0168 (A64 Page 122): DSI_DPHY_GATING (Bit 15)
+    .{ .addr = 0x1C2_0168, .mask = 1 << 15 },
+};
+
+/// Pass the Clocks (`on` = true) or mask the Clocks (`on` = false)
+fn gateClocks(on: bool) void {
+    inline for (clock_gates) |g| {
+        const val = getreg32(g.addr);
+        putreg32(if (on) val | g.mask else val & ~@as(u32, g.mask), g.addr);  // TODO: DMB
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Read and Write Registers
+
+/// Read and Write Registers (see mmio.zig)
+const getreg32 = mmio.getreg32;
+const putreg32 = mmio.putreg32;
+
+/// Aliases for Zig Standard Library
+const assert = std.debug.assert;
+const debug  = std.log.debug;
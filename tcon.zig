@@ -24,6 +24,15 @@
 /// Import the Zig Standard Library
 const std = @import("std");
 
+/// Import the Register Access Module
+const mmio = @import("./mmio.zig");
+
+/// Import the Readiness Waits Module
+const ready = @import("./ready.zig");
+
+/// Import the Monotonic Clock Module
+const clock = @import("./clock.zig");
+
 /// Import NuttX Functions from C
 const c = @cImport({
     // NuttX Defines
@@ -51,6 +60,10 @@ const TCON0_BASE_ADDRESS = 0x01C0_C000;
 /// Base Address of Allwinner A64 CCU Controller (A64 Page 82)
 const CCU_BASE_ADDRESS = 0x01C2_0000;
 
+/// Give up waiting for PLL LOCK after this time (microseconds).
+/// The PLLs normally lock within tens of microseconds.
+const PLL_TIMEOUT_US = 10_000;
+
 /// Init Timing Controller TCON0
 /// Based on https://lupyuen.github.io/articles/de#appendix-timing-controller-tcon0
 pub export fn tcon0_init() void {
@@ -68,49 +81,27 @@ pub export fn tcon0_init() void {
     // Set PLL_FACTOR_N (Bits 8 to 14) to 0x62 (PLL Factor N)
     // Set PLL_PREDIV_M (Bits 0 to 3) to 7 (PLL Pre Divider)
     debug("Configure PLL_VIDEO0", .{});
-    const PLL_VIDEO0_CTRL_REG = CCU_BASE_ADDRESS + 0x10;
-    comptime{ assert(PLL_VIDEO0_CTRL_REG == 0x1c20010); }
-    {
-        const PLL_ENABLE:   u32 = 1    << 31;
-        const PLL_MODE:     u31 = 0    << 30;
-        const LOCK:         u29 = 0    << 28;
-        const FRAC_CLK_OUT: u26 = 0    << 25;
-        const PLL_MODE_SEL: u25 = 1    << 24;
-        const PLL_SDM_EN:   u21 = 0    << 20;
-        const PLL_FACTOR_N: u15 = 0x62 << 8;
-        const PLL_PREDIV_M: u4  = 7    << 0;
-        const PLL_VIDEO0_CTRL = PLL_ENABLE
-            | PLL_MODE
-            | LOCK
-            | FRAC_CLK_OUT
-            | PLL_MODE_SEL
-            | PLL_SDM_EN
-            | PLL_FACTOR_N
-            | PLL_PREDIV_M;
-        comptime{ assert(PLL_VIDEO0_CTRL == 0x81006207); }
-        putreg32(PLL_VIDEO0_CTRL, PLL_VIDEO0_CTRL_REG);  // TODO: DMB        
-    }
+    comptime{ assert(PLL_VIDEO0_CTRL_REG.addr == 0x1c20010); }
+    const PLL_VIDEO0_CTRL = PLL_VIDEO0_CTRL_REG.init(.{
+        .PLL_ENABLE   = 1,
+        .PLL_MODE_SEL = 1,
+        .PLL_FACTOR_N = 0x62,
+        .PLL_PREDIV_M = 7,
+    });
+    comptime{ assert(PLL_VIDEO0_CTRL.val == 0x81006207); }
 
     // Enable LDO1 and LDO2
     // PLL_MIPI_CTRL_REG: CCU Offset 0x40 (A64 Page 94)
     // Set LDO1_EN (Bit 23) to 1 (Enable On-chip LDO1)
     // Set LDO2_EN (Bit 22) to 1 (Enable On-chip LDO2)
-    debug("Enable LDO1 and LDO2", .{});
-    const PLL_MIPI_CTRL_REG = CCU_BASE_ADDRESS + 0x40;
-    comptime{ assert(PLL_MIPI_CTRL_REG == 0x1c20040); }
-    {
-        const LDO1_EN: u24 = 1 << 23;
-        const LDO2_EN: u23 = 1 << 22;
-        const PLL_MIPI_CTRL = LDO1_EN
-            | LDO2_EN;
-        comptime{ assert(PLL_MIPI_CTRL == 0xc00000); }
-        putreg32(PLL_MIPI_CTRL, PLL_MIPI_CTRL_REG);  // TODO: DMB
-    }
-
-    // Wait 100 microseconds
-    _ = c.usleep(100);
-
-    // Configure MIPI PLL
+    comptime{ assert(PLL_MIPI_CTRL_REG.addr == 0x1c20040); }
+    const PLL_MIPI_LDO = PLL_MIPI_CTRL_REG.init(.{
+        .LDO1_EN = 1,
+        .LDO2_EN = 1,
+    });
+    comptime{ assert(PLL_MIPI_LDO.val == 0xc00000); }
+
+    // Configure MIPI PLL after 100 microseconds
     // PLL_MIPI_CTRL_REG: CCU Offset 0x40 (A64 Page 94)
     // Set PLL_ENABLE (Bit 31) to 1 (Enable MIPI PLL)
     // Set LOCK (Bit 28) to 0 (Unlocked)
@@ -126,134 +117,109 @@ pub export fn tcon0_init() void {
     // Set PLL_FACTOR_N (Bits 8 to 11) to 7 (PLL Factor N)
     // Set PLL_FACTOR_K (Bits 4 to 5) to 1 (PLL Factor K)
     // Set PLL_PRE_DIV_M (Bits 0 to 3) to 10 (PLL Pre Divider)
-    debug("Configure MIPI PLL", .{});
-    comptime{ assert(PLL_MIPI_CTRL_REG == 0x1c20040); }
-    {
-        const PLL_ENABLE:       u32 = 1  << 31;
-        const LOCK:             u29 = 0  << 28;
-        const SINT_FRAC:        u28 = 0  << 27;
-        const SDIV2:            u27 = 0  << 26;
-        const S6P25_7P5:        u26 = 0  << 25;
-        const LDO1_EN:          u24 = 1  << 23;
-        const LDO2_EN:          u23 = 1  << 22;
-        const PLL_SRC:          u22 = 0  << 21;
-        const PLL_SDM_EN:       u21 = 0  << 20;
-        const PLL_FEEDBACK_DIV: u18 = 0  << 17;
-        const VFB_SEL:          u17 = 0  << 16;
-        const PLL_FACTOR_N:     u12 = 7  << 8;
-        const PLL_FACTOR_K:     u6  = 1  << 4;
-        const PLL_PRE_DIV_M:    u6  = 10 << 0;
-        const PLL_MIPI_CTRL = PLL_ENABLE
-            | LOCK
-            | SINT_FRAC
-            | SDIV2
-            | S6P25_7P5
-            | LDO1_EN
-            | LDO2_EN
-            | PLL_SRC
-            | PLL_SDM_EN
-            | PLL_FEEDBACK_DIV
-            | VFB_SEL
-            | PLL_FACTOR_N
-            | PLL_FACTOR_K
-            | PLL_PRE_DIV_M;
-        comptime{ assert(PLL_MIPI_CTRL == 0x80c0071a); }
-        putreg32(PLL_MIPI_CTRL, PLL_MIPI_CTRL_REG);  // TODO: DMB
-    }
+    const PLL_MIPI_CTRL = PLL_MIPI_CTRL_REG.init(.{
+        .PLL_ENABLE    = 1,
+        .LDO1_EN       = 1,
+        .LDO2_EN       = 1,
+        .PLL_FACTOR_N  = 7,
+        .PLL_FACTOR_K  = 1,
+        .PLL_PRE_DIV_M = 10,
+    });
+    comptime{ assert(PLL_MIPI_CTRL.val == 0x80c0071a); }
 
     // Set TCON0 Clock Source to MIPI PLL
     // TCON0_CLK_REG: CCU Offset 0x118 (A64 Page 117)
     // Set SCLK_GATING (Bit 31) to 1 (Special Clock is On)
     // Set CLK_SRC_SEL (Bits 24 to 26) to 0 (Clock Source is MIPI PLL)
-    debug("Set TCON0 Clock Source to MIPI PLL", .{});
-    const TCON0_CLK_REG = CCU_BASE_ADDRESS + 0x118;
-    comptime{ assert(TCON0_CLK_REG == 0x1c20118); }
-
-    const SCLK_GATING: u32 = 1 << 31;
-    const CLK_SRC_SEL: u27 = 0 << 24;
-    const TCON0_CLK = SCLK_GATING
-        | CLK_SRC_SEL;
-    comptime{ assert(TCON0_CLK == 0x80000000); }
-    putreg32(TCON0_CLK, TCON0_CLK_REG);  // TODO: DMB
+    comptime{ assert(TCON0_CLK_REG.addr == 0x1c20118); }
+    const TCON0_CLK = TCON0_CLK_REG.init(.{
+        .SCLK_GATING = 1,
+        .CLK_SRC_SEL = 0,
+    });
+    comptime{ assert(TCON0_CLK.val == 0x80000000); }
 
     // Enable TCON0 Clock
     // BUS_CLK_GATING_REG1: CCU Offset 0x64 (A64 Page 102)
     // Set TCON0_GATING (Bit 3) to 1 (Pass Clock for TCON0)
-    debug("Enable TCON0 Clock", .{});
-    const BUS_CLK_GATING_REG1 = CCU_BASE_ADDRESS + 0x64;
-    comptime{ assert(BUS_CLK_GATING_REG1 == 0x1c20064); }
-
-    const TCON0_GATING: u4 = 1 << 3;
-    const BUS_CLK_GATING = TCON0_GATING;
-    comptime{ assert(BUS_CLK_GATING == 0x8); }
-    putreg32(BUS_CLK_GATING, BUS_CLK_GATING_REG1);  // TODO: DMB
+    comptime{ assert(BUS_CLK_GATING_REG1.addr == 0x1c20064); }
+    const BUS_CLK_GATING = BUS_CLK_GATING_REG1.init(.{ .TCON0_GATING = 1 });
+    comptime{ assert(BUS_CLK_GATING.val == 0x8); }
 
     // Deassert TCON0 Reset
     // BUS_SOFT_RST_REG1: CCU Offset 0x2c4 (A64 Page 140)
     // Set TCON0_RST (Bit 3) to 1 (Deassert TCON0 Reset)
-    debug("Deassert TCON0 Reset", .{});
-    const BUS_SOFT_RST_REG1 = CCU_BASE_ADDRESS + 0x2c4;
-    comptime{ assert(BUS_SOFT_RST_REG1 == 0x1c202c4); }
-
-    const TCON0_RST: u4 = 1 << 3;
-    const BUS_SOFT_RST = TCON0_RST;
-    comptime{ assert(BUS_SOFT_RST == 0x8); }
-    putreg32(BUS_SOFT_RST, BUS_SOFT_RST_REG1);  // TODO: DMB
+    comptime{ assert(BUS_SOFT_RST_REG1.addr == 0x1c202c4); }
+    const BUS_SOFT_RST = BUS_SOFT_RST_REG1.init(.{ .TCON0_RST = 1 });
+    comptime{ assert(BUS_SOFT_RST.val == 0x8); }
+
+    debug("Configure PLL_VIDEO0, MIPI PLL and TCON0 Clock", .{});
+    mmio.commit(&.{
+        PLL_VIDEO0_CTRL,
+        PLL_MIPI_LDO,
+    });
+    const ldo_on = clock.now_us();
+
+    // MIPI PLL is clocked by PLL_VIDEO0: Wait for PLL_VIDEO0 LOCK (Bit 28).
+    // The LDOs have no Ready Bit, so we wait for the rest of the 100 microseconds.
+    _ = ready.pollReg(.pll_video0, PLL_VIDEO0_CTRL_REG.addr, 1 << 28, PLL_TIMEOUT_US);
+    ready.waitMin(.mipi_ldo, ldo_on, 100);
+    mmio.commit(&.{ PLL_MIPI_CTRL });
+
+    // Wait for MIPI PLL LOCK (Bit 28) before switching TCON0 to the MIPI PLL
+    _ = ready.pollReg(.pll_mipi, PLL_MIPI_CTRL_REG.addr, 1 << 28, PLL_TIMEOUT_US);
+    mmio.commit(&.{
+        TCON0_CLK,
+        BUS_CLK_GATING,
+        BUS_SOFT_RST,
+    });
 
     // Disable TCON0 and Interrupts
     // TCON_GCTL_REG: TCON0 Offset 0x00 (A64 Page 508)
     // Set TCON_En (Bit 31) to 0 (Disable TCON0)
-    debug("Disable TCON0 and Interrupts", .{});
-    const TCON_GCTL_REG = TCON0_BASE_ADDRESS + 0x00;
-    comptime{ assert(TCON_GCTL_REG == 0x1c0c000); }
-    {
-        const TCON_En: u32 = 0 << 31;
-        const TCON_GCTL = TCON_En;
-        comptime{ assert(TCON_GCTL == 0x0); }
-        putreg32(TCON_GCTL, TCON_GCTL_REG);  // TODO: DMB
-    }
+    comptime{ assert(TCON_GCTL_REG.addr == 0x1c0c000); }
+    const TCON_GCTL_DISABLE = TCON_GCTL_REG.init(.{ .TCON_En = 0 });
+    comptime{ assert(TCON_GCTL_DISABLE.val == 0x0); }
 
     // TCON_GINT0_REG: TCON0 Offset 0x04 (A64 Page 509)
     // Set to 0 (Disable TCON0 Interrupts)
     const TCON_GINT0_REG = TCON0_BASE_ADDRESS + 0x04;
     comptime{ assert(TCON_GINT0_REG == 0x1c0c004); }
-    putreg32(0x0, TCON_GINT0_REG);
 
     // TCON_GINT1_REG: TCON0 Offset 0x08 (A64 Page 510)
     // Set to 0 (Disable TCON0 Interrupts)
     const TCON_GINT1_REG = TCON0_BASE_ADDRESS + 0x08;
     comptime{ assert(TCON_GINT1_REG == 0x1c0c008); }
-    putreg32(0x0, TCON_GINT1_REG);
 
     // Enable Tristate Output
     // TCON0_IO_TRI_REG: TCON0 Offset 0x8c (A64 Page 520)
     // Set to 0xffff ffff to Enable TCON0 Tristate Output
-    debug("Enable Tristate Output", .{});
-    const TCON0_IO_TRI_REG = TCON0_BASE_ADDRESS + 0x8c;
-    comptime{ assert(TCON0_IO_TRI_REG == 0x1c0c08c); }
-    putreg32(0xffffffff, TCON0_IO_TRI_REG);
+    comptime{ assert(TCON0_IO_TRI_REG.addr == 0x1c0c08c); }
 
     // TCON1_IO_TRI_REG: TCON0 Offset 0xf4
     // Set to 0xffff ffff to Enable TCON1 Tristate Output
     // Note: TCON1_IO_TRI_REG is actually in TCON0 Address Range, not in TCON1 Address Range as stated in A64 User Manual
     const TCON1_IO_TRI_REG = TCON0_BASE_ADDRESS + 0xf4;
     comptime{ assert(TCON1_IO_TRI_REG == 0x1c0c0f4); }
-    putreg32(0xffffffff, TCON1_IO_TRI_REG);
+
+    debug("Disable TCON0 and Interrupts, Enable Tristate Output", .{});
+    mmio.commit(&.{
+        TCON_GCTL_DISABLE,
+        mmio.store(TCON_GINT0_REG, 0x0),
+        mmio.store(TCON_GINT1_REG, 0x0),
+        mmio.store(TCON0_IO_TRI_REG.addr, 0xffffffff),
+        mmio.store(TCON1_IO_TRI_REG, 0xffffffff),
+    });
 
     // Set DCLK to MIPI PLL / 6
     // TCON0_DCLK_REG: TCON0 Offset 0x44 (A64 Page 513)
     // Set TCON0_Dclk_En (Bits 28 to 31) to 8 (Enable TCON0 Clocks: DCLK, DCLK1, DCLK2, DCLKM2)
     // Set TCON0_Dclk_Div (Bits 0 to 6) to 6 (DCLK Divisor)
-    debug("Set DCLK to MIPI PLL / 6", .{});
-    const TCON0_DCLK_REG = TCON0_BASE_ADDRESS + 0x44;
-    comptime{ assert(TCON0_DCLK_REG == 0x1c0c044); }
-
-    const TCON0_Dclk_En:  u32 = 8 << 28;
-    const TCON0_Dclk_Div: u7 = 6 << 0;
-    const TCON0_DCLK = TCON0_Dclk_En
-        | TCON0_Dclk_Div;
-    comptime{ assert(TCON0_DCLK == 0x80000006); }
-    putreg32(TCON0_DCLK, TCON0_DCLK_REG);
+    comptime{ assert(TCON0_DCLK_REG.addr == 0x1c0c044); }
+    const TCON0_DCLK = TCON0_DCLK_REG.init(.{
+        .TCON0_Dclk_En  = 8,
+        .TCON0_Dclk_Div = 6,
+    });
+    comptime{ assert(TCON0_DCLK.val == 0x80000006); }
 
     // TCON0_CTL_REG: TCON0 Offset 0x40 (A64 Page 512)
     // Set TCON0_En (Bit 31) to 1 (Enable TCON0)
@@ -263,44 +229,32 @@ pub export fn tcon0_init() void {
     // Set TCON0_FIFO1_Rst (Bit 21) to 0 (No FIFO1 Reset)
     // Set TCON0_Start_Delay (Bits 4 to 8) to 0 (No STA Delay)
     // Set TCON0_SRC_SEL (Bits 0 to 2) to 0 (TCON0 Source is DE0)
-    const TCON0_CTL_REG = TCON0_BASE_ADDRESS + 0x40;
-    comptime{ assert(TCON0_CTL_REG == 0x1c0c040); }
-
-    const TCON0_En:          u32 = 1 << 31;
-    const TCON0_Work_Mode:   u29 = 0 << 28;
-    const TCON0_IF:          u26 = 1 << 24;
-    const TCON0_RB_Swap:     u24 = 0 << 23;
-    const TCON0_FIFO1_Rst:   u22 = 0 << 21;
-    const TCON0_Start_Delay: u9  = 0 << 4;
-    const TCON0_SRC_SEL:     u3  = 0 << 0;
-    const TCON0_CTL = TCON0_En
-        | TCON0_Work_Mode
-        | TCON0_IF
-        | TCON0_RB_Swap
-        | TCON0_FIFO1_Rst
-        | TCON0_Start_Delay
-        | TCON0_SRC_SEL;
-    comptime{ assert(TCON0_CTL == 0x81000000); }
-    putreg32(TCON0_CTL, TCON0_CTL_REG);
+    comptime{ assert(TCON0_CTL_REG.addr == 0x1c0c040); }
+    const TCON0_CTL = TCON0_CTL_REG.init(.{
+        .TCON0_En          = 1,
+        .TCON0_Work_Mode   = 0,
+        .TCON0_IF          = 1,
+        .TCON0_RB_Swap     = 0,
+        .TCON0_FIFO1_Rst   = 0,
+        .TCON0_Start_Delay = 0,
+        .TCON0_SRC_SEL     = 0,
+    });
+    comptime{ assert(TCON0_CTL.val == 0x81000000); }
 
     // TCON0_BASIC0_REG: TCON0 Offset 0x48 (A64 Page 514)
     // Set TCON0_X (Bits 16 to 27) to 719 (Panel Width - 1)
     // Set TCON0_Y (Bits 0 to 11) to 1439 (Panel Height - 1)
-    const TCON0_BASIC0_REG = TCON0_BASE_ADDRESS + 0x48;
-    comptime{ assert(TCON0_BASIC0_REG == 0x1c0c048); }
-
-    const TCON0_X: u28 = (PANEL_WIDTH  - 1) << 16;
-    const TCON0_Y: u12 = (PANEL_HEIGHT - 1) << 0;
-    const TCON0_BASIC0 = TCON0_X
-        | TCON0_Y;
-    comptime{ assert(TCON0_BASIC0 == 0x2cf059f); }
-    putreg32(TCON0_BASIC0, TCON0_BASIC0_REG);
+    comptime{ assert(TCON0_BASIC0_REG.addr == 0x1c0c048); }
+    const TCON0_BASIC0 = TCON0_BASIC0_REG.init(.{
+        .TCON0_X = PANEL_WIDTH  - 1,
+        .TCON0_Y = PANEL_HEIGHT - 1,
+    });
+    comptime{ assert(TCON0_BASIC0.val == 0x2cf059f); }
 
     // TCON0_ECC_FIFO: TCON0 Offset 0xf8 (Undocumented)
     // Set to 8
     const TCON0_ECC_FIFO = TCON0_BASE_ADDRESS + 0xf8;
     comptime{ assert(TCON0_ECC_FIFO == 0x1c0c0f8); }
-    putreg32(0x8, TCON0_ECC_FIFO);
 
     // TCON0_CPU_IF_REG: TCON0 Offset 0x60 (A64 Page 516)
     // Set CPU_Mode (Bits 28 to 31) to 1 (24-bit DSI)
@@ -309,88 +263,73 @@ pub export fn tcon0_init() void {
     // Set Trigger_FIFO_Bist_En (Bit 3) to 0 (Disable FIFO Bist Trigger)
     // Set Trigger_FIFO_En (Bit 2) to 1 (Enable FIFO Trigger)
     // Set Trigger_En (Bit 0) to 1 (Enable Trigger Mode)
-    const TCON0_CPU_IF_REG = TCON0_BASE_ADDRESS + 0x60;
-    comptime{ assert(TCON0_CPU_IF_REG == 0x1c0c060); }
-
-    const CPU_Mode:             u32 = 1 << 28;
-    const AUTO:                 u18 = 0 << 17;
-    const FLUSH:                u17 = 1 << 16;
-    const Trigger_FIFO_Bist_En: u4  = 0 << 3;
-    const Trigger_FIFO_En:      u3  = 1 << 2;
-    const Trigger_En:           u1  = 1 << 0;
-    const TCON0_CPU_IF = CPU_Mode
-        | AUTO
-        | FLUSH
-        | Trigger_FIFO_Bist_En
-        | Trigger_FIFO_En
-        | Trigger_En;
-    comptime{ assert(TCON0_CPU_IF == 0x10010005); }
-    putreg32(TCON0_CPU_IF, TCON0_CPU_IF_REG);
+    comptime{ assert(TCON0_CPU_IF_REG.addr == 0x1c0c060); }
+    const TCON0_CPU_IF = TCON0_CPU_IF_REG.init(.{
+        .CPU_Mode             = 1,
+        .AUTO                 = 0,
+        .FLUSH                = 1,
+        .Trigger_FIFO_Bist_En = 0,
+        .Trigger_FIFO_En      = 1,
+        .Trigger_En           = 1,
+    });
+    comptime{ assert(TCON0_CPU_IF.val == 0x10010005); }
+
+    debug("Set DCLK to MIPI PLL / 6", .{});
+    mmio.commit(&.{
+        TCON0_DCLK,
+        TCON0_CTL,
+        TCON0_BASIC0,
+        mmio.store(TCON0_ECC_FIFO, 0x8),
+        TCON0_CPU_IF,
+    });
 
     // Set CPU Panel Trigger
     // TCON0_CPU_TRI0_REG: TCON0 Offset 0x160 (A64 Page 521)
     // Set Block_Space (Bits 16 to 27) to 47 (Block Space)
     // Set Block_Size (Bits 0 to 11) to 719 (Panel Width - 1)
-    debug("Set CPU Panel Trigger", .{});
-    const TCON0_CPU_TRI0_REG = TCON0_BASE_ADDRESS + 0x160;
-    comptime{ assert(TCON0_CPU_TRI0_REG == 0x1c0c160); }
-
-    const Block_Space: u28 = 47  << 16;  // TODO: Compute this based on Panel Width and Height 
-    const Block_Size:  u12 = (PANEL_WIDTH - 1) << 0;
-    const TCON0_CPU_TRI0 = Block_Space
-        | Block_Size;
-    comptime{ assert(TCON0_CPU_TRI0 == 0x2f02cf); }
-    putreg32(TCON0_CPU_TRI0, TCON0_CPU_TRI0_REG);
+    comptime{ assert(TCON0_CPU_TRI0_REG.addr == 0x1c0c160); }
+    const TCON0_CPU_TRI0 = TCON0_CPU_TRI0_REG.init(.{
+        .Block_Space = 47,  // TODO: Compute this based on Panel Width and Height
+        .Block_Size  = PANEL_WIDTH - 1,
+    });
+    comptime{ assert(TCON0_CPU_TRI0.val == 0x2f02cf); }
 
     // TCON0_CPU_TRI1_REG: TCON0 Offset 0x164 (A64 Page 522)
     // Set Block_Current_Num (Bits 16 to 31) to 0 (Block Current Number)
     // Set Block_Num (Bits 0 to 15) to 1439 (Panel Height - 1)
-    const TCON0_CPU_TRI1_REG = TCON0_BASE_ADDRESS + 0x164;
-    comptime{ assert(TCON0_CPU_TRI1_REG == 0x1c0c164); }
-
-    const Block_Current_Num: u32 = 0    << 16;
-    const Block_Num:         u16 = (PANEL_HEIGHT - 1) << 0;
-    const TCON0_CPU_TRI1 = Block_Current_Num
-        | Block_Num;
-    comptime{ assert(TCON0_CPU_TRI1 == 0x59f); }
-    putreg32(TCON0_CPU_TRI1, TCON0_CPU_TRI1_REG);
+    comptime{ assert(TCON0_CPU_TRI1_REG.addr == 0x1c0c164); }
+    const TCON0_CPU_TRI1 = TCON0_CPU_TRI1_REG.init(.{
+        .Block_Current_Num = 0,
+        .Block_Num         = PANEL_HEIGHT - 1,
+    });
+    comptime{ assert(TCON0_CPU_TRI1.val == 0x59f); }
 
     // TCON0_CPU_TRI2_REG: TCON0 Offset 0x168 (A64 Page 522)
     // Set Start_Delay (Bits 16 to 31) to 7106 (Start Delay)
     // Set Trans_Start_Mode (Bit 15) to 0 (Trans Start Mode is ECC FIFO + TRI FIFO)
     // Set Sync_Mode (Bits 13 to 14) to 0 (Sync Mode is Auto)
     // Set Trans_Start_Set (Bits 0 to 12) to 10 (Trans Start Set)
-    const TCON0_CPU_TRI2_REG = TCON0_BASE_ADDRESS + 0x168;
-    comptime{ assert(TCON0_CPU_TRI2_REG == 0x1c0c168); }
-
-    const Start_Delay:      u32 = 7106 << 16;
-    const Trans_Start_Mode: u16 = 0    << 15;
-    const Sync_Mode:        u15 = 0    << 13;
-    const Trans_Start_Set:  u13 = 10   << 0;
-    const TCON0_CPU_TRI2 = Start_Delay
-        | Trans_Start_Mode
-        | Sync_Mode
-        | Trans_Start_Set;
-    comptime{ assert(TCON0_CPU_TRI2 == 0x1bc2000a); }
-    putreg32(TCON0_CPU_TRI2, TCON0_CPU_TRI2_REG);
+    comptime{ assert(TCON0_CPU_TRI2_REG.addr == 0x1c0c168); }
+    const TCON0_CPU_TRI2 = TCON0_CPU_TRI2_REG.init(.{
+        .Start_Delay      = 7106,
+        .Trans_Start_Mode = 0,
+        .Sync_Mode        = 0,
+        .Trans_Start_Set  = 10,
+    });
+    comptime{ assert(TCON0_CPU_TRI2.val == 0x1bc2000a); }
 
     // Set Safe Period
     // TCON_SAFE_PERIOD_REG: TCON0 Offset 0x1f0 (A64 Page 525)
     // Set Safe_Period_FIFO_Num (Bits 16 to 28) to 3000
     // Set Safe_Period_Line (Bits 4 to 15) to 0
     // Set Safe_Period_Mode (Bits 0 to 2) to 3 (Safe Period Mode: Safe at 2 and safe at sync active)
-    debug("Set Safe Period", .{});
-    const TCON_SAFE_PERIOD_REG = TCON0_BASE_ADDRESS + 0x1f0;
-    comptime{ assert(TCON_SAFE_PERIOD_REG == 0x1c0c1f0); }
-
-    const Safe_Period_FIFO_Num: u29 = 3000 << 16;
-    const Safe_Period_Line:     u16 = 0    << 4;
-    const Safe_Period_Mode:     u3  = 3    << 0;
-    const TCON_SAFE_PERIOD = Safe_Period_FIFO_Num
-        | Safe_Period_Line
-        | Safe_Period_Mode;
-    comptime{ assert(TCON_SAFE_PERIOD == 0xbb80003); }
-    putreg32(TCON_SAFE_PERIOD, TCON_SAFE_PERIOD_REG);
+    comptime{ assert(TCON_SAFE_PERIOD_REG.addr == 0x1c0c1f0); }
+    const TCON_SAFE_PERIOD = TCON_SAFE_PERIOD_REG.init(.{
+        .Safe_Period_FIFO_Num = 3000,
+        .Safe_Period_Line     = 0,
+        .Safe_Period_Mode     = 3,
+    });
+    comptime{ assert(TCON_SAFE_PERIOD.val == 0xbb80003); }
 
     // Enable Output Triggers
     // TCON0_IO_TRI_REG: TCON0 Offset 0x8c (A64 Page 520)
@@ -401,137 +340,202 @@ pub export fn tcon0_init() void {
     // Set IO1_Output_Tri_En (Bit 25) to 0 (Enable IO1 Output Tri)
     // Set IO0_Output_Tri_En (Bit 24) to 0 (Enable IO0 Output Tri)
     // Set Data_Output_Tri_En (Bits 0 to 23) to 0 (Enable TCON0 Output Port)
-    debug("Enable Output Triggers", .{});
-    comptime{ assert(TCON0_IO_TRI_REG == 0x1c0c08c); }
-
-    const Reserved:           u32 = 0b111 << 29;
-    const RGB_Endian:         u29 = 0     << 28;
-    const IO3_Output_Tri_En:  u28 = 0     << 27;
-    const IO2_Output_Tri_En:  u27 = 0     << 26;
-    const IO1_Output_Tri_En:  u26 = 0     << 25;
-    const IO0_Output_Tri_En:  u25 = 0     << 24;
-    const Data_Output_Tri_En: u24 = 0     << 0;
-    const TCON0_IO_TRI = Reserved
-        | RGB_Endian
-        | IO3_Output_Tri_En
-        | IO2_Output_Tri_En
-        | IO1_Output_Tri_En
-        | IO0_Output_Tri_En
-        | Data_Output_Tri_En;
-    comptime{ assert(TCON0_IO_TRI == 0xe0000000); }
-    putreg32(TCON0_IO_TRI, TCON0_IO_TRI_REG);  // TODO: DMB
+    const TCON0_IO_TRI = TCON0_IO_TRI_REG.init(.{
+        .Reserved           = 0b111,
+        .RGB_Endian         = 0,
+        .IO3_Output_Tri_En  = 0,
+        .IO2_Output_Tri_En  = 0,
+        .IO1_Output_Tri_En  = 0,
+        .IO0_Output_Tri_En  = 0,
+        .Data_Output_Tri_En = 0,
+    });
+    comptime{ assert(TCON0_IO_TRI.val == 0xe0000000); }
 
     // Enable TCON0
     // TCON_GCTL_REG: TCON0 Offset 0x00 (A64 Page 508)
     // Set TCON_En (Bit 31) to 1 (Enable TCON0)
-    debug("Enable TCON0", .{});
-    comptime{ assert(TCON_GCTL_REG == 0x1c0c000); }
-    {
-        const TCON_En: u32 = 1 << 31;
-        const TCON_GCTL = TCON_En;
-        comptime{ assert(TCON_GCTL == 0x80000000); }
-        modreg32(TCON_GCTL, TCON_GCTL, TCON_GCTL_REG);  // TODO: DMB
-    }
-}
-
-/// Modify the specified bits in a memory mapped register.
-/// Based on https://github.com/apache/nuttx/blob/master/arch/arm64/src/common/arm64_arch.h#L473
-fn modreg32(
-    comptime val: u32,   // Bits to set, like (1 << bit)
-    comptime mask: u32,  // Bits to clear, like (1 << bit)
-    addr: u64  // Address to modify
-) void {
-    comptime { assert(val & mask == val); }
-    debug("  *0x{x}: clear 0x{x}, set 0x{x}", .{ addr, mask, val & mask });
-    putreg32(
-        (getreg32(addr) & ~(mask))
-            | ((val) & (mask)),
-        (addr)
-    );
+    // The other Bits were cleared above, so we store instead of read-modify-write
+    const TCON_GCTL_ENABLE = TCON_GCTL_REG.init(.{ .TCON_En = 1 });
+    comptime{ assert(TCON_GCTL_ENABLE.val == 0x80000000); }
+
+    debug("Set CPU Panel Trigger, Safe Period, Enable Output Triggers and TCON0", .{});
+    mmio.commit(&.{
+        TCON0_CPU_TRI0,
+        TCON0_CPU_TRI1,
+        TCON0_CPU_TRI2,
+        TCON_SAFE_PERIOD,
+        TCON0_IO_TRI,
+        TCON_GCTL_ENABLE,
+    });
 }
 
-/// Get the 32-bit value at the address
-fn getreg32(addr: u64) u32 {
-    const ptr = @intToPtr(*const volatile u32, addr);
-    return ptr.*;
-}
-
-/// Set the 32-bit value at the address
-fn putreg32(val: u32, addr: u64) void {
-    if (enableLog) { debug("  *0x{x} = 0x{x}", .{ addr, val }); }
-    const ptr = @intToPtr(*volatile u32, addr);
-    ptr.* = val;
-}
-
-/// Set to False to disable log 
-var enableLog = true;
-
 ///////////////////////////////////////////////////////////////////////////////
-//  Panic Handler
-
-/// Called by Zig when it hits a Panic. We print the Panic Message, Stack Trace and halt. See 
-/// https://andrewkelley.me/post/zig-stack-traces-kernel-panic-bare-bones-os.html
-/// https://github.com/ziglang/zig/blob/master/lib/std/builtin.zig#L763-L847
-pub fn panic(
-    message: []const u8, 
-    _stack_trace: ?*std.builtin.StackTrace
-) noreturn {
-    // Print the Panic Message
-    _ = _stack_trace;
-    _ = puts("\n!ZIG PANIC!");
-    _ = puts(@ptrCast([*c]const u8, message));
-
-    // Print the Stack Trace
-    _ = puts("Stack Trace:");
-    var it = std.debug.StackIterator.init(@returnAddress(), null);
-    while (it.next()) |return_address| {
-        _ = printf("%p\n", return_address);
-    }
-
-    // Halt
-    c.exit(1);
-}
+//  TCON0 and CCU Registers
+
+/// PLL_VIDEO0_CTRL_REG: CCU Offset 0x10 (A64 Page 86)
+const PLL_VIDEO0_CTRL_REG = mmio.Register(packed struct {
+    PLL_PREDIV_M: u4  = 0,  // Bits 0 to 3
+    _4:           u4  = 0,
+    PLL_FACTOR_N: u7  = 0,  // Bits 8 to 14
+    _15:          u5  = 0,
+    PLL_SDM_EN:   u1  = 0,  // Bit 20
+    _21:          u3  = 0,
+    PLL_MODE_SEL: u1  = 0,  // Bit 24
+    FRAC_CLK_OUT: u1  = 0,  // Bit 25
+    _26:          u2  = 0,
+    LOCK:         u1  = 0,  // Bit 28
+    _29:          u1  = 0,
+    PLL_MODE:     u1  = 0,  // Bit 30
+    PLL_ENABLE:   u1  = 0,  // Bit 31
+}, CCU_BASE_ADDRESS + 0x10);
+
+/// PLL_MIPI_CTRL_REG: CCU Offset 0x40 (A64 Page 94)
+const PLL_MIPI_CTRL_REG = mmio.Register(packed struct {
+    PLL_PRE_DIV_M:    u4  = 0,  // Bits 0 to 3
+    PLL_FACTOR_K:     u2  = 0,  // Bits 4 to 5
+    _6:               u2  = 0,
+    PLL_FACTOR_N:     u4  = 0,  // Bits 8 to 11
+    _12:              u4  = 0,
+    VFB_SEL:          u1  = 0,  // Bit 16
+    PLL_FEEDBACK_DIV: u1  = 0,  // Bit 17
+    _18:              u2  = 0,
+    PLL_SDM_EN:       u1  = 0,  // Bit 20
+    PLL_SRC:          u1  = 0,  // Bit 21
+    LDO2_EN:          u1  = 0,  // Bit 22
+    LDO1_EN:          u1  = 0,  // Bit 23
+    _24:              u1  = 0,
+    S6P25_7P5:        u1  = 0,  // Bit 25
+    SDIV2:            u1  = 0,  // Bit 26
+    SINT_FRAC:        u1  = 0,  // Bit 27
+    LOCK:             u1  = 0,  // Bit 28
+    _29:              u2  = 0,
+    PLL_ENABLE:       u1  = 0,  // Bit 31
+}, CCU_BASE_ADDRESS + 0x40);
+
+/// TCON0_CLK_REG: CCU Offset 0x118 (A64 Page 117)
+const TCON0_CLK_REG = mmio.Register(packed struct {
+    _0:          u24 = 0,
+    CLK_SRC_SEL: u3  = 0,  // Bits 24 to 26
+    _27:         u4  = 0,
+    SCLK_GATING: u1  = 0,  // Bit 31
+}, CCU_BASE_ADDRESS + 0x118);
+
+/// BUS_CLK_GATING_REG1: CCU Offset 0x64 (A64 Page 102)
+const BUS_CLK_GATING_REG1 = mmio.Register(packed struct {
+    _0:           u3  = 0,
+    TCON0_GATING: u1  = 0,  // Bit 3
+    _4:           u28 = 0,
+}, CCU_BASE_ADDRESS + 0x64);
+
+/// BUS_SOFT_RST_REG1: CCU Offset 0x2c4 (A64 Page 140)
+const BUS_SOFT_RST_REG1 = mmio.Register(packed struct {
+    _0:        u3  = 0,
+    TCON0_RST: u1  = 0,  // Bit 3
+    _4:        u28 = 0,
+}, CCU_BASE_ADDRESS + 0x2c4);
+
+/// TCON_GCTL_REG: TCON0 Offset 0x00 (A64 Page 508)
+const TCON_GCTL_REG = mmio.Register(packed struct {
+    _0:      u31 = 0,
+    TCON_En: u1  = 0,  // Bit 31
+}, TCON0_BASE_ADDRESS + 0x00);
+
+/// TCON0_CTL_REG: TCON0 Offset 0x40 (A64 Page 512)
+const TCON0_CTL_REG = mmio.Register(packed struct {
+    TCON0_SRC_SEL:     u3  = 0,  // Bits 0 to 2
+    _3:                u1  = 0,
+    TCON0_Start_Delay: u5  = 0,  // Bits 4 to 8
+    _9:                u12 = 0,
+    TCON0_FIFO1_Rst:   u1  = 0,  // Bit 21
+    _22:               u1  = 0,
+    TCON0_RB_Swap:     u1  = 0,  // Bit 23
+    TCON0_IF:          u2  = 0,  // Bits 24 to 25
+    _26:               u2  = 0,
+    TCON0_Work_Mode:   u1  = 0,  // Bit 28
+    _29:               u2  = 0,
+    TCON0_En:          u1  = 0,  // Bit 31
+}, TCON0_BASE_ADDRESS + 0x40);
+
+/// TCON0_DCLK_REG: TCON0 Offset 0x44 (A64 Page 513)
+const TCON0_DCLK_REG = mmio.Register(packed struct {
+    TCON0_Dclk_Div: u7  = 0,  // Bits 0 to 6
+    _7:             u21 = 0,
+    TCON0_Dclk_En:  u4  = 0,  // Bits 28 to 31
+}, TCON0_BASE_ADDRESS + 0x44);
+
+/// TCON0_BASIC0_REG: TCON0 Offset 0x48 (A64 Page 514)
+const TCON0_BASIC0_REG = mmio.Register(packed struct {
+    TCON0_Y: u12 = 0,  // Bits 0 to 11
+    _12:     u4  = 0,
+    TCON0_X: u12 = 0,  // Bits 16 to 27
+    _28:     u4  = 0,
+}, TCON0_BASE_ADDRESS + 0x48);
+
+/// TCON0_CPU_IF_REG: TCON0 Offset 0x60 (A64 Page 516)
+const TCON0_CPU_IF_REG = mmio.Register(packed struct {
+    Trigger_En:           u1  = 0,  // Bit 0
+    _1:                   u1  = 0,
+    Trigger_FIFO_En:      u1  = 0,  // Bit 2
+    Trigger_FIFO_Bist_En: u1  = 0,  // Bit 3
+    _4:                   u12 = 0,
+    FLUSH:                u1  = 0,  // Bit 16
+    AUTO:                 u1  = 0,  // Bit 17
+    _18:                  u10 = 0,
+    CPU_Mode:             u4  = 0,  // Bits 28 to 31
+}, TCON0_BASE_ADDRESS + 0x60);
+
+/// TCON0_IO_TRI_REG: TCON0 Offset 0x8c (A64 Page 520)
+const TCON0_IO_TRI_REG = mmio.Register(packed struct {
+    Data_Output_Tri_En: u24 = 0,  // Bits 0 to 23
+    IO0_Output_Tri_En:  u1  = 0,  // Bit 24
+    IO1_Output_Tri_En:  u1  = 0,  // Bit 25
+    IO2_Output_Tri_En:  u1  = 0,  // Bit 26
+    IO3_Output_Tri_En:  u1  = 0,  // Bit 27
+    RGB_Endian:         u1  = 0,  // Bit 28
+    Reserved:           u3  = 0,  // Bits 29 to 31
+}, TCON0_BASE_ADDRESS + 0x8c);
+
+/// TCON0_CPU_TRI0_REG: TCON0 Offset 0x160 (A64 Page 521)
+const TCON0_CPU_TRI0_REG = mmio.Register(packed struct {
+    Block_Size:  u12 = 0,  // Bits 0 to 11
+    _12:         u4  = 0,
+    Block_Space: u12 = 0,  // Bits 16 to 27
+    _28:         u4  = 0,
+}, TCON0_BASE_ADDRESS + 0x160);
+
+/// TCON0_CPU_TRI1_REG: TCON0 Offset 0x164 (A64 Page 522)
+const TCON0_CPU_TRI1_REG = mmio.Register(packed struct {
+    Block_Num:         u16 = 0,  // Bits 0 to 15
+    Block_Current_Num: u16 = 0,  // Bits 16 to 31
+}, TCON0_BASE_ADDRESS + 0x164);
+
+/// TCON0_CPU_TRI2_REG: TCON0 Offset 0x168 (A64 Page 522)
+const TCON0_CPU_TRI2_REG = mmio.Register(packed struct {
+    Trans_Start_Set:  u13 = 0,  // Bits 0 to 12
+    Sync_Mode:        u2  = 0,  // Bits 13 to 14
+    Trans_Start_Mode: u1  = 0,  // Bit 15
+    Start_Delay:      u16 = 0,  // Bits 16 to 31
+}, TCON0_BASE_ADDRESS + 0x168);
+
+/// TCON_SAFE_PERIOD_REG: TCON0 Offset 0x1f0 (A64 Page 525)
+const TCON_SAFE_PERIOD_REG = mmio.Register(packed struct {
+    Safe_Period_Mode:     u3  = 0,  // Bits 0 to 2
+    _3:                   u1  = 0,
+    Safe_Period_Line:     u12 = 0,  // Bits 4 to 15
+    Safe_Period_FIFO_Num: u13 = 0,  // Bits 16 to 28
+    _29:                  u3  = 0,
+}, TCON0_BASE_ADDRESS + 0x1f0);
 
 ///////////////////////////////////////////////////////////////////////////////
-//  Logging
-
-/// Called by Zig for `std.log.debug`, `std.log.info`, `std.log.err`, ...
-/// https://gist.github.com/leecannon/d6f5d7e5af5881c466161270347ce84d
-pub fn log(
-    comptime _message_level: std.log.Level,
-    comptime _scope: @Type(.EnumLiteral),
-    comptime format: []const u8,
-    args: anytype,
-) void {
-    _ = _message_level;
-    _ = _scope;
-
-    // Format the message
-    var buf: [100]u8 = undefined;  // Limit to 100 chars
-    var slice = std.fmt.bufPrint(&buf, format, args)
-        catch { _ = puts("*** log error: buf too small"); return; };
-    
-    // Terminate the formatted message with a null
-    var buf2: [buf.len + 1 : 0]u8 = undefined;
-    std.mem.copy(
-        u8, 
-        buf2[0..slice.len], 
-        slice[0..slice.len]
-    );
-    buf2[slice.len] = 0;
-
-    // Print the formatted message
-    _ = puts(&buf2);
-}
+//  Panic Handler and Logging
+
+/// Called by Zig when it hits a Panic, and for `std.log.debug`, `std.log.err`, ... (see mmio.zig)
+pub const panic = mmio.panic;
+pub const log   = mmio.log;
 
 ///////////////////////////////////////////////////////////////////////////////
 //  Imported Functions and Variables
 
-/// For safety, we import these functions ourselves to enforce Null-Terminated Strings.
-/// We changed `[*c]const u8` to `[*:0]const u8`
-extern fn printf(format: [*:0]const u8, ...) c_int;
-extern fn puts(str: [*:0]const u8) c_int;
-
 /// Aliases for Zig Standard Library
 const assert = std.debug.assert;
 const debug  = std.log.debug;
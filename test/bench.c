@@ -0,0 +1,205 @@
+// Host Benchmark for the C Display Stack
+// Runs the same C paths as test.c against the Stub Registers in test.c,
+// and writes the results as JSON. See bench.sh
+
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Reuse the Stub Registers and the Test Harness, but not its Main Function
+#define main test_main
+#include "test.c"
+#undef main
+
+// Payload of the Long Packet for ST7703 Command E9 (same as test_mipi_dsi.c)
+static const uint8_t long_pkt[] = {
+  0xe9, 0x82, 0x10, 0x06, 0x05, 0xa2, 0x0a, 0xa5,
+  0x12, 0x31, 0x23, 0x37, 0x83, 0x04, 0xbc, 0x27,
+  0x38, 0x0c, 0x00, 0x03, 0x00, 0x00, 0x00, 0x0c,
+  0x00, 0x03, 0x00, 0x00, 0x00, 0x75, 0x75, 0x31,
+  0x88, 0x88, 0x88, 0x88, 0x88, 0x88, 0x13, 0x88,
+  0x64, 0x64, 0x20, 0x88, 0x88, 0x88, 0x88, 0x88,
+  0x88, 0x02, 0x88, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+};
+
+// Packet Buffer shared by the MIPI DSI Packet Cases
+static uint8_t pkt_buf[128];
+
+// Result of a Benchmark Case
+struct bench_result_s
+{
+  const char *name;        // Name of the Benchmark Case
+  unsigned long iterations;   // Number of times the Case was run
+  unsigned long ns_per_op;    // Wall Time per iteration (nanoseconds)
+  unsigned long mmio_reads;   // Register Reads per iteration
+  unsigned long mmio_writes;  // Register Writes per iteration
+};
+
+static void bench_short_packet(void)
+{
+  const uint8_t buf[] = { 0x11 };
+  ssize_t ret = mipi_dsi_short_packet(pkt_buf, sizeof(pkt_buf), 0,
+                                      MIPI_DSI_DCS_SHORT_WRITE,
+                                      buf, sizeof(buf));
+  DEBUGASSERT(ret == 4);
+}
+
+static void bench_short_packet_param(void)
+{
+  const uint8_t buf[] = { 0xbc, 0x4e };
+  ssize_t ret = mipi_dsi_short_packet(pkt_buf, sizeof(pkt_buf), 0,
+                                      MIPI_DSI_DCS_SHORT_WRITE_PARAM,
+                                      buf, sizeof(buf));
+  DEBUGASSERT(ret == 4);
+}
+
+static void bench_long_packet(void)
+{
+  ssize_t ret = mipi_dsi_long_packet(pkt_buf, sizeof(pkt_buf), 0,
+                                     MIPI_DSI_DCS_LONG_WRITE,
+                                     long_pkt, sizeof(long_pkt));
+  DEBUGASSERT(ret == sizeof(long_pkt) + 6);
+}
+
+static void bench_crc16ccitt(void)
+{
+  volatile uint16_t crc = crc16ccittpart(long_pkt, sizeof(long_pkt), 0xffff);
+  (void)crc;
+}
+
+static void bench_tcon0_init(void)
+{
+  int ret = a64_tcon0_init(PANEL_WIDTH, PANEL_HEIGHT);
+  DEBUGASSERT(ret == OK);
+}
+
+static void bench_mipi_dsi_enable(void)
+{
+  int ret = a64_mipi_dsi_enable();
+  DEBUGASSERT(ret == OK);
+}
+
+static void bench_mipi_dphy_enable(void)
+{
+  int ret = a64_mipi_dphy_enable();
+  DEBUGASSERT(ret == OK);
+}
+
+static void bench_panel_init(void)
+{
+  int ret = pinephone_panel_init();
+  DEBUGASSERT(ret == OK);
+}
+
+static void bench_mipi_dsi_start(void)
+{
+  int ret = a64_mipi_dsi_start();
+  DEBUGASSERT(ret == OK);
+}
+
+static void bench_de_init(void)
+{
+  int ret = a64_de_init();
+  DEBUGASSERT(ret == OK);
+}
+
+static void bench_render_graphics(void)
+{
+  int ret = pinephone_render_graphics();
+  DEBUGASSERT(ret == OK);
+}
+
+// Run the Benchmark Case for the number of iterations.
+// The Stub Registers log every write with printf, so we send stdout to
+// /dev/null while measuring.
+static struct bench_result_s run_case(const char *name,
+                                      unsigned long iterations,
+                                      void (*func)(void))
+{
+  struct bench_result_s result;
+  struct timespec start;
+  struct timespec end;
+  unsigned long i;
+  int saved_stdout;
+  int null_fd;
+
+  fflush(stdout);
+  saved_stdout = dup(STDOUT_FILENO);
+  null_fd = open("/dev/null", O_WRONLY);
+  dup2(null_fd, STDOUT_FILENO);
+
+  // Warm up the caches before measuring
+  func();
+
+  mmio_reads = 0;
+  mmio_writes = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (i = 0; i < iterations; i++)
+    {
+      func();
+    }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  fflush(stdout);
+  dup2(saved_stdout, STDOUT_FILENO);
+  close(saved_stdout);
+  close(null_fd);
+
+  result.name = name;
+  result.iterations = iterations;
+  result.ns_per_op = ((end.tv_sec - start.tv_sec) * 1000000000ul +
+                      end.tv_nsec - start.tv_nsec) / iterations;
+  result.mmio_reads = mmio_reads / iterations;
+  result.mmio_writes = mmio_writes / iterations;
+  return result;
+}
+
+// Run the Benchmark Cases and write the results as JSON to the file
+// specified on the command line (default: bench_c.json)
+int main(int argc, char *argv[])
+{
+  const char *path = (argc > 1) ? argv[1] : "bench_c.json";
+  struct bench_result_s results[] =
+  {
+    // MIPI DSI Packets
+    run_case("c.mipi_dsi_short_packet",       1000000, bench_short_packet),
+    run_case("c.mipi_dsi_short_packet_param", 1000000,
+             bench_short_packet_param),
+    run_case("c.mipi_dsi_long_packet",        1000000, bench_long_packet),
+    run_case("c.crc16ccittpart",              1000000, bench_crc16ccitt),
+
+    // Display Drivers against Stub Registers
+    run_case("c.a64_tcon0_init",        20, bench_tcon0_init),
+    run_case("c.a64_mipi_dsi_enable",   20, bench_mipi_dsi_enable),
+    run_case("c.a64_mipi_dphy_enable",  20, bench_mipi_dphy_enable),
+    run_case("c.pinephone_panel_init",  20, bench_panel_init),
+    run_case("c.a64_mipi_dsi_start",    20, bench_mipi_dsi_start),
+    run_case("c.a64_de_init",           20, bench_de_init),
+
+    // Framebuffer Fills plus Display Engine Registers
+    run_case("c.pinephone_render_graphics", 20, bench_render_graphics),
+  };
+
+  const int count = sizeof(results) / sizeof(results[0]);
+  FILE *f = fopen(path, "w");
+  DEBUGASSERT(f != NULL);
+
+  // Write the results as a JSON Array
+  fprintf(f, "[\n");
+  for (int i = 0; i < count; i++)
+    {
+      fprintf(f,
+              "  { \"name\": \"%s\", \"iterations\": %lu, "
+              "\"ns_per_op\": %lu, \"mmio_reads\": %lu, "
+              "\"mmio_writes\": %lu }%s\n",
+              results[i].name, results[i].iterations,
+              results[i].ns_per_op, results[i].mmio_reads,
+              results[i].mmio_writes, (i + 1 < count) ? "," : "");
+    }
+
+  fprintf(f, "]\n");
+  fclose(f);
+  return 0;
+}
@@ -0,0 +1,91 @@
+#!/usr/bin/env bash
+## Benchmark Locally: Run the Zig and C Host Benchmarks, then compare with the Baseline
+## ./bench.sh          Compare with bench_baseline.json. Fails if there is no Baseline,
+##                     or if a Case in the Baseline hasn't been recorded yet.
+## ./bench.sh update   Save the results as the new bench_baseline.json (then commit it)
+## BENCH_THRESHOLD=20  Fail if any Case is more than 20% slower than the Baseline
+## PINEPHONE_HOSTFB=dir Write the Framebuffers to dir/fb0.pam, fb1.pam, fb2.pam (see hostfb.zig)
+
+set -e  #  Exit when any command fails
+set -x  #  Echo commands
+
+threshold=${BENCH_THRESHOLD:-20}
+
+## Compile the Zig Benchmark for the Host Computer
+zig build-exe \
+    -O ReleaseFast \
+    -lc \
+    -isystem ../../nuttx/include \
+    -I ../../apps/include \
+    -femit-bin=bench_zig \
+    ../bench.zig
+
+## Compile the C Benchmark (same sources as run.sh)
+gcc \
+    -O2 \
+    -o bench_c \
+    -I . \
+    -I ../../nuttx/arch/arm64/src/a64 \
+    bench.c \
+    ../../nuttx/arch/arm64/src/a64/a64_de.c \
+    ../../nuttx/arch/arm64/src/a64/a64_mipi_dphy.c \
+    ../../nuttx/arch/arm64/src/a64/a64_mipi_dsi.c \
+    ../../nuttx/arch/arm64/src/a64/a64_rsb.c \
+    ../../nuttx/arch/arm64/src/a64/a64_tcon0.c \
+    ../../nuttx/arch/arm64/src/a64/mipi_dsi.c
+
+## Run the Benchmarks and merge the results
+./bench_zig bench_zig.json >/dev/null
+./bench_c   bench_c.json
+jq -s 'add' bench_zig.json bench_c.json >bench.json
+
+## Save the Baseline only if requested
+if [ "$1" == "update" ]; then
+    cp bench.json bench_baseline.json
+    exit 0
+fi
+
+## Without a Baseline we can't find a Regression
+if [ ! -f bench_baseline.json ]; then
+    echo "No bench_baseline.json: Record one with ./bench.sh update"
+    exit 2
+fi
+
+## Compare with the Baseline:
+## Wall Time may be up to $threshold percent slower,
+## Register Reads and Writes must not increase
+set +x  #  Don't echo commands
+jq -r -n \
+    --argjson threshold "$threshold" \
+    --slurpfile base bench_baseline.json \
+    --slurpfile cur  bench.json \
+    '
+    ($base[0] | map({ (.name): . }) | add) as $b
+    | $cur[0][]
+    | . as $r
+    | $b[$r.name] as $o
+    | if $o == null then
+        "NEW   \($r.name): \($r.ns_per_op) ns"
+      elif $o.ns_per_op == null or $o.mmio_reads == null or $o.mmio_writes == null then
+        "UNSET \($r.name): \($r.ns_per_op) ns, not recorded in the Baseline"
+      elif $r.ns_per_op > $o.ns_per_op * (100 + $threshold) / 100
+        or $r.mmio_reads  > $o.mmio_reads
+        or $r.mmio_writes > $o.mmio_writes then
+        "SLOW  \($r.name): \($o.ns_per_op) => \($r.ns_per_op) ns, reads \($o.mmio_reads) => \($r.mmio_reads), writes \($o.mmio_writes) => \($r.mmio_writes)"
+      else
+        "OK    \($r.name): \($o.ns_per_op) => \($r.ns_per_op) ns"
+      end
+    ' \
+    | tee bench.log
+
+## Fail if any Case has regressed
+if grep -q "^SLOW" bench.log; then
+    echo "Benchmark regressed by more than $threshold%"
+    exit 1
+fi
+
+## Fail if any Case couldn't be compared
+if grep -q "^UNSET" bench.log; then
+    echo "Baseline is incomplete: Record it with ./bench.sh update on the Reference Machine"
+    exit 2
+fi
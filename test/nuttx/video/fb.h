@@ -1,4 +1,14 @@
 #define FB_FMT_RGBA32         21          /* BPP=32 Raw RGB with alpha */
+
+#define FB_ACCL_TRANSP        0x01        /* Hardware transparency support */
+#define FB_ACCL_CHROMA        0x02        /* Hardware chromakey support */
+#define FB_ACCL_COLOR         0x04        /* Hardware color support */
+#define FB_ACCL_AREA          0x08        /* Hardware support area */
+#define FB_ACCL_BLIT          0x10        /* Hardware blit support */
+#define FB_ACCL_BLEND         0x20        /* Hardware blend support */
+
+#define FB_CONSTALPHA         0x00        /* Constant transparency */
+#define FB_PIXELALPHA         0x01        /* Pixel transparency */
 typedef uint16_t fb_coord_t;
 
 struct fb_videoinfo_s
@@ -56,3 +66,74 @@ struct fb_overlayinfo_s
   struct fb_area_s sarea;     /* Selected area within the overlay */
   uint32_t   accl;            /* Supported hardware acceleration */
 };
+
+/* Display Pipeline Health Counters of PinePhone (health.zig) */
+
+#define FBIOGET_HEALTH        _FBIOC(0x0030)  /* Get Health Counters
+                                               * Argument: writable struct
+                                               *           fb_health_s */
+#define FBIORESET_HEALTH      _FBIOC(0x0031)  /* Reset Health Counters
+                                               * Argument: none */
+
+#define FB_HEALTH_BUCKETS     8               /* Latency Histogram Buckets */
+
+struct fb_health_s
+{
+  uint32_t vblanks;           /* Vertical Blanking Periods seen */
+  uint32_t missed_vblanks;    /* Frames without Vertical Blanking */
+  uint32_t late_vblanks;      /* Late Vertical Blanking */
+  uint32_t tcon0_underflows;  /* TCON0 ran out of pixels */
+  uint32_t dsi_rx_overflows;  /* DSI Receive FIFO overflowed */
+  uint32_t submissions;       /* Framebuffer Updates */
+  uint32_t latency[FB_HEALTH_BUCKETS];  /* Latency Histogram (ms):
+                                         * <2, <4, <8, <17, <33, <50, <100, >=100 */
+};
+
+/* Atomic Plane Commits of PinePhone (planes.zig) */
+
+#define FBIOGET_PLANESTATE    _FBIOC(0x0032)  /* Get State of the last Commit
+                                               * Argument: writable struct
+                                               *           fb_planestate_s */
+#define FBIOSET_COMMIT        _FBIOC(0x0033)  /* Commit Planes at the next
+                                               * Vertical Blanking
+                                               * Argument: read-only struct
+                                               *           fb_commit_s */
+
+#define FB_COMMIT_PLANES      3               /* UI Channels 1 to 3 */
+
+#define FB_PLANE_ARGB8888     0               /* Input Data Formats */
+#define FB_PLANE_XRGB8888     4
+
+#define FB_COMMIT_PLANE(n)    (1 << (n))      /* Bits of fb_commit_s changes */
+#define FB_COMMIT_ZORDER      (1 << FB_COMMIT_PLANES)
+#define FB_COMMIT_BACKGROUND  (1 << (FB_COMMIT_PLANES + 1))
+
+struct fb_plane_s
+{
+  uint32_t addr;          /* Framebuffer Address, 4-byte aligned */
+  uint32_t pitch;         /* Length of a line in bytes */
+  uint16_t width;         /* Horizontal resolution in pixel columns */
+  uint16_t height;        /* Vertical resolution in pixel rows */
+  uint16_t x;             /* Position on the Screen */
+  uint16_t y;
+  uint8_t  format;        /* FB_PLANE_ARGB8888 or FB_PLANE_XRGB8888 */
+  uint8_t  alpha_mode;    /* 0 Pixel, 1 Global, 2 Global mixed with Pixel */
+  uint8_t  global_alpha;  /* Global Alpha Value */
+  uint8_t  enable;        /* 1 to show the Plane, 0 to hide it */
+};
+
+struct fb_planestate_s
+{
+  struct fb_plane_s planes[FB_COMMIT_PLANES];  /* UI Channels 1 to 3 */
+  uint8_t  zorder[FB_COMMIT_PLANES];  /* Plane of each Blender Pipe,
+                                       * from bottom to top */
+  uint8_t  pad;
+  uint32_t background;    /* Background Colour (XRGB 8888) */
+};
+
+struct fb_commit_s
+{
+  uint32_t changes;       /* FB_COMMIT_PLANE(n), FB_COMMIT_ZORDER and
+                           * FB_COMMIT_BACKGROUND */
+  struct fb_planestate_s state;
+};
@@ -149,6 +149,10 @@ void dump_buffer(const uint8_t *data, size_t len)
 	}
 }
 
+// Number of Register Reads and Writes, for the Host Benchmark (bench.c)
+unsigned long mmio_reads;
+unsigned long mmio_writes;
+
 /// Modify the specified bits in a memory mapped register.
 /// Based on https://github.com/apache/nuttx/blob/master/arch/arm64/src/common/arm64_arch.h#L473
 void modreg32(
@@ -159,6 +163,8 @@ void modreg32(
 {
   ginfo("  *0x%lx: clear 0x%x, set 0x%x\n", addr, mask, val & mask);
   assert((val & mask) == val);
+  mmio_reads++;
+  mmio_writes++;
 }
 
 #define PLL_DE_CTRL_REG 0x1C20048
@@ -180,11 +186,13 @@ static bool log_enabled = true;
 
 uint8_t getreg8(unsigned long addr)
 {
+  mmio_reads++;
   return 0;
 }
 
 uint32_t getreg32(unsigned long addr)
 {
+  mmio_reads++;
   if (addr == PLL_DE_CTRL_REG)
     {
       return (1 << 28);
@@ -198,6 +206,7 @@ uint32_t getreg32(unsigned long addr)
 
 void putreg32(uint32_t data, unsigned long addr)
 {
+  mmio_writes++;
   for (int i = 0; i < PREV_ADDR_LEN - 1; i++)
     {
       prev_addr[i] = prev_addr[i + 1];
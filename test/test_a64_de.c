@@ -8,10 +8,17 @@
 #define PANEL_WIDTH  720
 #define PANEL_HEIGHT 1440
 
+#include <errno.h>
+#include <pthread.h>
 #include <nuttx/video/fb.h>
+#ifdef __NuttX__
+#include <nuttx/cache.h>
+#endif // __NuttX__
 #include "a64_tcon0.h"
 
 static void test_pattern(void);
+static int pinephone_settransp(const struct fb_overlayinfo_s *oinfo);
+static int pinephone_setchromakey(const struct fb_overlayinfo_s *oinfo);
 
 /// NuttX Video Controller for PinePhone (3 UI Channels)
 static struct fb_videoinfo_s videoInfo =
@@ -64,11 +71,11 @@ static struct fb_overlayinfo_s overlayInfo[2] =
     .overlay   = 0,        // Overlay number (First Overlay)
     .bpp       = 32,       // Bits per pixel (ARGB 8888)
     .blank     = 0,        // TODO: Blank or unblank
-    .chromakey = 0,        // TODO: Chroma key argb8888 formatted
-    .color     = 0,        // TODO: Color argb8888 formatted
-    .transp    = { .transp = 0, .transp_mode = 0 },  // TODO: Transparency
+    .chromakey = 0,        // Chroma key argb8888 formatted (0 for None)
+    .color     = 0,        // Color argb8888 formatted
+    .transp    = { .transp = 0xFF, .transp_mode = FB_PIXELALPHA },  // Opaque, Pixel Alpha
     .sarea     = { .x = 52, .y = 52, .w = FB1_WIDTH, .h = FB1_HEIGHT },  // Selected area within the overlay
-    .accl      = 0         // TODO: Supported hardware acceleration
+    .accl      = FB_ACCL_TRANSP | FB_ACCL_CHROMA  // Supported hardware acceleration
   },
   // Second Overlay UI Channel:
   // Fullscreen 720 x 1440 (4 bytes per ARGB 8888 pixel)
@@ -79,11 +86,11 @@ static struct fb_overlayinfo_s overlayInfo[2] =
     .overlay   = 1,        // Overlay number (Second Overlay)
     .bpp       = 32,       // Bits per pixel (ARGB 8888)
     .blank     = 0,        // TODO: Blank or unblank
-    .chromakey = 0,        // TODO: Chroma key argb8888 formatted
-    .color     = 0,        // TODO: Color argb8888 formatted
-    .transp    = { .transp = 0, .transp_mode = 0 },  // TODO: Transparency
+    .chromakey = 0,        // Chroma key argb8888 formatted (0 for None)
+    .color     = 0,        // Color argb8888 formatted
+    .transp    = { .transp = 0x7F, .transp_mode = FB_PIXELALPHA },  // Semi-Transparent, Pixel Alpha
     .sarea     = { .x = 0, .y = 0, .w = PANEL_WIDTH, .h = PANEL_HEIGHT },  // Selected area within the overlay
-    .accl      = 0         // TODO: Supported hardware acceleration
+    .accl      = FB_ACCL_TRANSP | FB_ACCL_CHROMA  // Supported hardware acceleration
   },
 };
 
@@ -148,6 +155,18 @@ int pinephone_render_graphics(void)
   ret = a64_de_enable(CHANNELS);
   DEBUGASSERT(ret == OK);    
 
+  // Apply the Transparency and Chroma Key of the Overlays
+  if (CHANNELS == 3)
+    {
+      for (i = 0; i < sizeof(overlayInfo) / sizeof(overlayInfo[0]); i++)
+        {
+          ret = pinephone_settransp(&overlayInfo[i]);
+          DEBUGASSERT(ret == OK);
+          ret = pinephone_setchromakey(&overlayInfo[i]);
+          DEBUGASSERT(ret == OK);
+        }
+    }
+
   // Fill Framebuffer with Test Pattern.
   // Must be called after Display Engine is Enabled, or black rows will appear.
   test_pattern();
@@ -155,88 +174,290 @@ int pinephone_render_graphics(void)
   return OK;
 }
 
-// Fill the Framebuffers with a Test Pattern.
-// Must be called after Display Engine is Enabled, or black rows will appear.
-static void test_pattern(void)
+// Number of Workers for rendering the Test Pattern:
+// One per Cortex-A53 Core in Allwinner A64
+#define RENDER_WORKERS 4
+
+// Number of Rows in a Band. Each Worker claims a Band at a time,
+// so that the Workers stay balanced until the Framebuffer is done.
+// BAND_ROWS x Row Bytes is a multiple of the 64-byte Cache Line
+// (16 x 720 x 4 and 16 x 600 x 4 bytes, checked in render_rows),
+// so a Band never shares a Cache Line with another Band.
+// For simplicity the Workers claim Bands from one shared Counter, instead of
+// Per-Worker Queues with Work Stealing like parallel.zig: every Band costs
+// about the same, so the shared Counter balances the Workers just as well.
+#define BAND_ROWS 16
+
+// Render a Row of Pixels
+typedef void (*render_row_t)(uint32_t *row, int y);
+
+// Framebuffer that is being rendered by the Workers
+struct render_job_s
 {
-  // Zero the Framebuffers
-  memset(fb0, 0, sizeof(fb0));
-  memset(fb1, 0, sizeof(fb1));
-  memset(fb2, 0, sizeof(fb2));
+  uint32_t *fb;         // Framebuffer to be rendered
+  int width;            // Width of the Framebuffer (pixels)
+  int height;           // Height of the Framebuffer (pixels)
+  render_row_t row_fn;  // Function that renders a Row
+  int next_band;        // Next Band to be claimed (atomic)
+};
 
-  // Init Framebuffer 0:
-  // Fill with Blue, Green and Red
-  int i;
-  const int fb0_len = sizeof(fb0) / sizeof(fb0[0]);
-  for (i = 0; i < fb0_len; i++)
+// Fill Framebuffer 0: Blue, Green and Red
+static void fb0_row(uint32_t *row, int y)
+{
+  int x;
+  uint32_t color;
+
+  // Colours are in XRGB 8888 format
+  if (y < PANEL_HEIGHT / 4)
+    {
+      // Blue for top quarter
+      color = 0x80000080;
+    }
+  else if (y < PANEL_HEIGHT / 2)
+    {
+      // Green for next quarter
+      color = 0x80008000;
+    }
+  else
+    {
+      // Red for lower half
+      color = 0x80800000;
+    }
+
+  for (x = 0; x < PANEL_WIDTH; x++)
+    {
+      row[x] = color;
+    }
+}
+
+// Fill Framebuffer 1: Semi-Transparent White
+static void fb1_row(uint32_t *row, int y)
+{
+  int x;
+
+  UNUSED(y);  // Every Row is the same
+  for (x = 0; x < FB1_WIDTH; x++)
+    {
+      // Colours are in ARGB 8888 format
+      row[x] = 0x40FFFFFF;
+    }
+}
+
+// Fill Framebuffer 2: Semi-Transparent Green Circle.
+// Like the Scanline Rasterizer (raster.zig), we compute the Span of the Circle
+// on each Row and fill it, instead of testing every pixel. The Circle has no
+// Anti-Aliasing here: the pixels are the same as x^2 + y^2 < radius^2.
+static void fb2_row(uint32_t *row, int y)
+{
+  // Shift coordinates so that centre of screen is (0,0)
+  const int half_width  = PANEL_WIDTH  / 2;
+  const int half_height = PANEL_HEIGHT / 2;
+  const int y_shift = y - half_height;
+
+  // Pixels with x_shift^2 < d are inside the Circle
+  const int d = half_width*half_width - y_shift*y_shift;
+  int start = 0;
+  int end   = 0;
+  int h;
+  int x;
+
+  if (d > 0)
+    {
+      // Largest h with h^2 < d, so the Span is -h to h.
+      // Binary Search, since d < half_width^2 + 1.
+      int lo = 0;
+      int hi = half_width;
+      while (lo < hi)
+        {
+          const int mid = (lo + hi + 1) / 2;
+          if (mid*mid < d) { lo = mid; } else { hi = mid - 1; }
+        }
+
+      h = lo;
+      start = (half_width - h < 0) ? 0 : half_width - h;
+      end   = (half_width + h + 1 > PANEL_WIDTH) ? PANEL_WIDTH : half_width + h + 1;
+    }
+
+  for (x = 0; x < PANEL_WIDTH; x++)
+    {
+      row[x] = 0x00000000;  // Transparent Black in ARGB 8888 Format
+    }
+
+  for (x = start; x < end; x++)
+    {
+      row[x] = 0x80008000;  // Semi-Transparent Green in ARGB 8888 Format
+    }
+}
+
+// Worker that claims the next Band, renders the Rows and flushes the Band
+// from the Data Cache, until all Bands are done
+static void *render_worker(void *arg)
+{
+  struct render_job_s *job = arg;
+
+  for (; ; )
     {
-      // Colours are in XRGB 8888 format
-      if (i < fb0_len / 4)
+      const int band = __atomic_fetch_add(&job->next_band, 1,
+                                          __ATOMIC_RELAXED);
+      const int y_start = band * BAND_ROWS;
+      int y_end = y_start + BAND_ROWS;
+      int y;
+
+      if (y_start >= job->height)
         {
-          // Blue for top quarter
-          fb0[i] = 0x80000080;
+          break;
         }
-      else if (i < fb0_len / 2)
+
+      if (y_end > job->height)
         {
-          // Green for next quarter
-          fb0[i] = 0x80008000;
+          y_end = job->height;
         }
-      else
+
+      for (y = y_start; y < y_end; y++)
         {
-          // Red for lower half
-          fb0[i] = 0x80800000;
+          job->row_fn(&job->fb[y * job->width], y);
         }
 
-      // Needed to fix black rows, not sure why
-      ARM64_DMB();
-      ARM64_DSB();
-      ARM64_ISB();
+      // Flush the Band from the Data Cache, or black rows will appear
+#ifdef __NuttX__
+      up_flush_dcache((uintptr_t)&job->fb[y_start * job->width],
+                      (uintptr_t)&job->fb[y_end * job->width]);
+#endif // __NuttX__
     }
 
-  // Init Framebuffer 1:
-  // Fill with Semi-Transparent White
-  const int fb1_len = sizeof(fb1) / sizeof(fb1[0]);
-  for (i = 0; i < fb1_len; i++)
+  ARM64_DSB();
+  return NULL;
+}
+
+// Render the Framebuffer on all Cortex-A53 Cores.
+// The Calling Thread works as one of the Workers. If the other Workers
+// can't be started, the Calling Thread renders all the Bands.
+static void render_rows(uint32_t *fb, int width, int height,
+                        render_row_t row_fn)
+{
+  struct render_job_s job =
+  {
+    .fb        = fb,
+    .width     = width,
+    .height    = height,
+    .row_fn    = row_fn,
+    .next_band = 0
+  };
+
+  pthread_t threads[RENDER_WORKERS - 1];
+  int started = 0;
+  int i;
+
+  DEBUGASSERT((width * 4 * BAND_ROWS) % 64 == 0);
+  for (i = 0; i < RENDER_WORKERS - 1; i++)
     {
-      // Colours are in ARGB 8888 format
-      fb1[i] = 0x40FFFFFF;
+      if (pthread_create(&threads[i], NULL, render_worker, &job) != 0)
+        {
+          break;
+        }
+
+      started++;
+    }
 
-      // Needed to fix black rows, not sure why
-      ARM64_DMB();
-      ARM64_DSB();
-      ARM64_ISB();
+  render_worker(&job);
+
+  for (i = 0; i < started; i++)
+    {
+      pthread_join(threads[i], NULL);
     }
+}
+
+// Fill the Framebuffers with a Test Pattern.
+// Must be called after Display Engine is Enabled, or black rows will appear.
+static void test_pattern(void)
+{
+  // Init Framebuffer 0:
+  // Fill with Blue, Green and Red
+  render_rows(fb0, PANEL_WIDTH, PANEL_HEIGHT, fb0_row);
+
+  // Init Framebuffer 1:
+  // Fill with Semi-Transparent White
+  render_rows(fb1, FB1_WIDTH, FB1_HEIGHT, fb1_row);
 
   // Init Framebuffer 2:
   // Fill with Semi-Transparent Green Circle
-  const int fb2_len = sizeof(fb2) / sizeof(fb2[0]);
-  int y;
-  for (y = 0; y < PANEL_HEIGHT; y++)
+  render_rows(fb2, PANEL_WIDTH, PANEL_HEIGHT, fb2_row);
+}
+
+// Blender Color Key Registers (DE Page 110)
+#define BLD_KEY_CTL      0x11010B0  // Blender Color Key Control
+#define BLD_KEY_CON      0x11010B4  // Blender Color Key Configuration
+#define BLD_KEY_MAX(key) (0x11010C0 + (key) * 4)  // Blender Color Key Max
+#define BLD_KEY_MIN(key) (0x11010E0 + (key) * 4)  // Blender Color Key Min
+
+// Set the Transparency of the Overlay (FBIOSET_TRANSP), like overlay_settransp in render.zig.
+// FB_CONSTALPHA: Every pixel has Alpha `transp`, the Pixel Alpha is ignored.
+// FB_PIXELALPHA: Pixel Alpha is scaled by `transp`.
+static int pinephone_settransp(const struct fb_overlayinfo_s *oinfo)
+{
+  const int channel = oinfo->overlay + 2;  // UI Channels 2 and 3
+  uint32_t alpha_mode;
+
+  if (oinfo->overlay >= sizeof(overlayInfo) / sizeof(overlayInfo[0]))
     {
-      int x;
-      for (x = 0; x < PANEL_WIDTH; x++)
-        {
-          // Get pixel index
-          const int p = (y * PANEL_WIDTH) + x;
-          DEBUGASSERT(p < fb2_len);
-
-          // Shift coordinates so that centre of screen is (0,0)
-          const int half_width  = PANEL_WIDTH  / 2;
-          const int half_height = PANEL_HEIGHT / 2;
-          const int x_shift = x - half_width;
-          const int y_shift = y - half_height;
-
-          // If x^2 + y^2 < radius^2, set the pixel to Semi-Transparent Green
-          if (x_shift*x_shift + y_shift*y_shift < half_width*half_width) {
-              fb2[p] = 0x80008000;  // Semi-Transparent Green in ARGB 8888 Format
-          } else {  // Otherwise set to Transparent Black
-              fb2[p] = 0x00000000;  // Transparent Black in ARGB 8888 Format
-          }
-
-          // Needed to fix black rows, not sure why
-          ARM64_DMB();
-          ARM64_DSB();
-          ARM64_ISB();
-        }
+      return -EINVAL;
+    }
+
+  // LAY_ALPHA_MODE: 1 for Global Alpha, 2 for Global Alpha mixed with Pixel Alpha
+  switch (oinfo->transp.transp_mode)
+    {
+      case FB_CONSTALPHA:
+        alpha_mode = 1;
+        break;
+
+      case FB_PIXELALPHA:
+        alpha_mode = 2;
+        break;
+
+      default:
+        return -EINVAL;
     }
+
+  // OVL_UI_ATTR_CTL: Set LAY_GLBALPHA (Bits 24 to 31) and LAY_ALPHA_MODE (Bits 1 to 2)
+  modreg32(((uint32_t)oinfo->transp.transp << 24) | (alpha_mode << 1),
+           0xFF000006, OVL_UI_ATTR_CTL(channel));
+
+  // Apply the settings at the next Vertical Blanking
+  putreg32(DOUBLE_BUFFER_RDY, GLB_DBUFFER);
+  overlayInfo[oinfo->overlay].transp = oinfo->transp;
+  return OK;
+}
+
+// Set the Chroma Key of the Overlay (FBIOSET_CHROMAKEY), like overlay_setchromakey
+// in render.zig. Matching pixels (RGB only) of the Overlay are replaced by the
+// Blender Pipe underneath. Chroma Key 0 disables keying.
+static int pinephone_setchromakey(const struct fb_overlayinfo_s *oinfo)
+{
+  // Key N sits between Pipe N and Pipe N+1. Overlay 0 is Pipe 1, Overlay 1 is Pipe 2.
+  const int key = oinfo->overlay;
+  const uint32_t rgb = oinfo->chromakey & 0xFFFFFF;
+  const int enable = (oinfo->chromakey != 0);
+
+  if (oinfo->overlay >= sizeof(overlayInfo) / sizeof(overlayInfo[0]))
+    {
+      return -EINVAL;
+    }
+
+  // Match Red, Green and Blue between Min and Max, which are the same Colour
+  if (enable)
+    {
+      putreg32(rgb, BLD_KEY_MAX(key));
+      putreg32(rgb, BLD_KEY_MIN(key));
+    }
+
+  // BLD_KEY_CON: KEYn_R_MATCH, KEYn_G_MATCH, KEYn_B_MATCH (Bits 8n to 8n+2)
+  modreg32(enable ? (0x7 << (key * 8)) : 0, 0x7 << (key * 8), BLD_KEY_CON);
+
+  // BLD_KEY_CTL: KEYn_EN (Bit 4n) and KEYn_MATCH_DIR (Bits 4n+1 to 4n+2) = 1 (Match the upper Pipe)
+  modreg32(enable ? (0x3 << (key * 4)) : 0, 0x7 << (key * 4), BLD_KEY_CTL);
+
+  // Apply the settings at the next Vertical Blanking
+  putreg32(DOUBLE_BUFFER_RDY, GLB_DBUFFER);
+  overlayInfo[oinfo->overlay].chromakey = oinfo->chromakey;
+  return OK;
 }
@@ -0,0 +1,310 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! Display Writeback for Apache NuttX RTOS on PinePhone.
+//! Captures the Composited Frame of MIXER0 into a Memory Buffer with the
+//! Writeback (WB) Block of the A64 Display Engine, for Screenshots and Screen
+//! Streaming without composing the Framebuffers on the CPU. The Capture may be
+//! converted to RGB 565 and downscaled by 2 or 4. It completes asynchronously:
+//! `writeback_poll` reports completion and calls the Completion Callback.
+//! On the Host Computer there's no Writeback Block, so we simulate it by
+//! composing the Layers of the Blender in software (see render.getLayers).
+//! The Writeback Registers are not in the DE 2.0 Spec, the Offsets follow
+//! the Allwinner BSP Driver (de_wb).
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Import the Zig Compiler Info, to check whether we're running on PinePhone
+const builtin = @import("builtin");
+
+/// Import the Register Access Module
+const mmio = @import("./mmio.zig");
+
+/// Import the Display Engine Module
+const render = @import("./render.zig");
+
+/// Import the Parallel Rendering Module, for flushing the Data Cache
+const parallel = @import("./parallel.zig");
+
+/// Import NuttX Functions from C
+const c = @cImport({
+    // NuttX Defines
+    @cDefine("__NuttX__",  "");
+    @cDefine("NDEBUG",     "");
+    @cDefine("FAR",        "");
+
+    // NuttX Header Files
+    @cInclude("arch/types.h");
+    @cInclude("../../nuttx/include/limits.h");
+    @cInclude("nuttx/config.h");
+    @cInclude("errno.h");
+});
+
+/// Pixel Format of the Capture (WB_FORMAT)
+pub const Format = enum(u8) {
+    argb8888 = 0x00,  // 4 bytes per pixel
+    rgb565   = 0x0A,  // 2 bytes per pixel
+};
+
+/// Completion Callback: `result` is 0 if the Capture is complete, or -EIO if the Writeback overflowed
+pub const Callback = *const fn (arg: ?*anyopaque, result: c_int) callconv(.C) void;
+
+/// Capture in progress
+const Capture = struct {
+    buf: []u8,        // Memory Buffer for the Capture
+    format: Format,   // Pixel Format
+    scale: usize,     // Downscale Factor: 1, 2 or 4
+    width: usize,     // Width of the Capture (pixels)
+    height: usize,    // Height of the Capture (pixels)
+    callback: ?Callback,  // Called when the Capture is complete
+    arg: ?*anyopaque,     // Argument for the Callback
+};
+
+/// Capture in progress, or null if the Writeback is idle
+var pending: ?Capture = null;
+
+/// Capture the next Composited Frame into `buf`, which needs (720 / scale) x (1440 / scale)
+/// pixels in the Pixel Format. Returns 0 if the Capture has started, -EBUSY if a Capture is
+/// in progress, or -EINVAL if the parameters are invalid. Call writeback_poll to complete it.
+pub export fn writeback_start(
+    buf: ?*anyopaque,      // Memory Buffer for the Capture, aligned to 4 bytes
+    len: usize,            // Size of the Memory Buffer (bytes)
+    format: u8,            // Pixel Format (see Format)
+    scale: u8,             // Downscale Factor: 1, 2 or 4
+    callback: ?Callback,   // Called when the Capture is complete (optional)
+    arg: ?*anyopaque       // Argument for the Callback
+) c_int {
+    debug("writeback_start: len={}, format={}, scale={}", .{ len, format, scale });
+    if (pending != null) { return -c.EBUSY; }
+    const fmt = std.meta.intToEnum(Format, format) catch return -c.EINVAL;
+    if (scale != 1 and scale != 2 and scale != 4) { return -c.EINVAL; }
+
+    const width  = render.PANEL_WIDTH  / @as(usize, scale);
+    const height = render.PANEL_HEIGHT / @as(usize, scale);
+    const size   = width * height * bytesPerPixel(fmt);
+    if (buf == null or len < size or @ptrToInt(buf) % 4 != 0) { return -c.EINVAL; }
+
+    const cap = Capture {
+        .buf      = @ptrCast([*]u8, buf.?)[0..size],
+        .format   = fmt,
+        .scale    = scale,
+        .width    = width,
+        .height   = height,
+        .callback = callback,
+        .arg      = arg,
+    };
+    pending = cap;
+
+    // Clean the Buffer from the Data Cache, so that dirty Cache Lines won't overwrite the Capture
+    parallel.flushBand(@ptrCast([*]u32, @alignCast(4, cap.buf.ptr))[0..(size / 4)]);
+    startWriteback(cap);
+
+    // On the Host Computer, compose the Frame now. writeback_poll completes it.
+    if (builtin.os.tag != .freestanding) { simulate(cap); }
+    return c.OK;
+}
+
+/// Complete the Capture if the Writeback is done, and call the Completion Callback.
+/// Returns 0 if the Capture is complete, -EBUSY if it's still in progress,
+/// -EIO if the Writeback overflowed, or -EINVAL if there's no Capture.
+pub export fn writeback_poll() c_int {
+    const cap = pending orelse return -c.EINVAL;
+    var result: c_int = c.OK;
+    if (builtin.os.tag == .freestanding) {
+        const status = getreg32(WB_STATUS);
+        if (status & (WB_FINISH | WB_OVERFLOW | WB_TIMEOUT) == 0) { return -c.EBUSY; }
+
+        // Clear the Status by writing 1, and discard stale Cache Lines of the Buffer
+        putreg32(status, WB_STATUS);
+        if (status & (WB_OVERFLOW | WB_TIMEOUT) != 0) { result = -c.EIO; }
+        const start = @ptrToInt(cap.buf.ptr);
+        up_invalidate_dcache(start, start + cap.buf.len);
+    }
+    debug("writeback_poll: result={}", .{ result });
+    pending = null;
+    if (cap.callback) |cb| { cb(cap.arg, result); }
+    return result;
+}
+
+/// Return the number of bytes per pixel for the Pixel Format
+fn bytesPerPixel(format: Format) usize {
+    return switch (format) {
+        .argb8888 => 4,
+        .rgb565   => 2,
+    };
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Writeback Registers
+
+/// WB (Writeback) is at DE Offset 0x01 0000 (0x101 0000)
+const WB_BASE_ADDRESS = 0x0101_0000;
+
+/// WB_GCTRL (Writeback Global Control) at WB Offset 0x000:
+/// WB_START (Bit 0), SOFT_RESET (Bit 4), IN_PORT_SEL (Bits 16 to 17, 0 for MIXER0)
+const WB_GCTRL = WB_BASE_ADDRESS + 0x000;
+const WB_START: u32 = 1 << 0;
+
+/// WB_SIZE, WB_CROP_COORD, WB_CROP_SIZE: Input Size and Crop Window, (height-1) << 16 + (width-1)
+const WB_SIZE       = WB_BASE_ADDRESS + 0x004;
+const WB_CROP_COORD = WB_BASE_ADDRESS + 0x008;
+const WB_CROP_SIZE  = WB_BASE_ADDRESS + 0x00C;
+
+/// WB_A_CH0_ADDR, WB_A_HIGH_ADDR: Buffer Address, WB_CH0_PITCH: Bytes per Row
+const WB_A_CH0_ADDR  = WB_BASE_ADDRESS + 0x010;
+const WB_A_HIGH_ADDR = WB_BASE_ADDRESS + 0x01C;
+const WB_CH0_PITCH   = WB_BASE_ADDRESS + 0x024;
+
+/// WB_FORMAT: Output Pixel Format, WB_INT: Interrupt Enable (Bit 0)
+const WB_FORMAT = WB_BASE_ADDRESS + 0x034;
+const WB_INT    = WB_BASE_ADDRESS + 0x038;
+
+/// WB_STATUS: IRQ (Bit 0), FINISH (Bit 4), OVERFLOW (Bit 5), TIMEOUT (Bit 6). Write 1 to clear.
+const WB_STATUS   = WB_BASE_ADDRESS + 0x03C;
+const WB_FINISH:   u32 = 1 << 4;
+const WB_OVERFLOW: u32 = 1 << 5;
+const WB_TIMEOUT:  u32 = 1 << 6;
+
+/// WB_BYPASS: CS_EN (Bit 1) enables the Coarse Scaler.
+/// WB_CS_HORZ, WB_CS_VERT: Coarse Scaler Ratio, N (Bits 0 to 13) Output Pixels for every M (Bits 16 to 29) Input Pixels
+const WB_BYPASS  = WB_BASE_ADDRESS + 0x040;
+const WB_CS_HORZ = WB_BASE_ADDRESS + 0x044;
+const WB_CS_VERT = WB_BASE_ADDRESS + 0x048;
+const WB_CS_EN: u32 = 1 << 1;
+
+/// Program the Writeback Block and start capturing the next Frame of MIXER0
+fn startWriteback(cap: Capture) void {
+    debug("startWriteback: {} x {}", .{ cap.width, cap.height });
+
+    // Enable the Writeback Clocks and deassert its Reset
+    // SCLK_GATE, HCLK_GATE, AHB_RESET at DE Offset 0x000, 0x004, 0x008: WB (Bit 2)
+    // (DE Page 25, 0x100 0000 / 0x100 0004 / 0x100 0008)
+    const WB_GATE: u32 = 1 << 2;
+    modreg32(WB_GATE, WB_GATE, 0x100_0000);  // SCLK_GATE: Clock Pass
+    modreg32(WB_GATE, WB_GATE, 0x100_0008);  // AHB_RESET: Reset Off
+    modreg32(WB_GATE, WB_GATE, 0x100_0004);  // HCLK_GATE: Clock Pass
+
+    // Capture the whole Panel from MIXER0
+    const panel_size = (render.PANEL_HEIGHT - 1) << 16 | (render.PANEL_WIDTH - 1);
+    putreg32(0, WB_GCTRL);  // IN_PORT_SEL = 0 (MIXER0)
+    putreg32(panel_size, WB_SIZE);
+    putreg32(0, WB_CROP_COORD);
+    putreg32(panel_size, WB_CROP_SIZE);
+
+    // Output Buffer and Format. Display Engine takes 32-bit addresses.
+    putreg32(@intCast(u32, @ptrToInt(cap.buf.ptr)), WB_A_CH0_ADDR);
+    putreg32(0, WB_A_HIGH_ADDR);
+    putreg32(@intCast(u32, cap.width * bytesPerPixel(cap.format)), WB_CH0_PITCH);
+    putreg32(@enumToInt(cap.format), WB_FORMAT);
+
+    // Downscale with the Coarse Scaler: 1 Output Pixel for every `scale` Input Pixels
+    if (cap.scale > 1) {
+        const ratio = @intCast(u32, cap.scale) << 16 | 1;
+        putreg32(ratio, WB_CS_HORZ);
+        putreg32(ratio, WB_CS_VERT);
+        putreg32(WB_CS_EN, WB_BYPASS);
+    } else {
+        putreg32(0, WB_BYPASS);
+    }
+
+    // We poll WB_STATUS instead of taking the Interrupt. Start the Capture.
+    putreg32(0, WB_INT);
+    putreg32(WB_START, WB_GCTRL);  // TODO: DMB
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Host Simulation
+
+/// Compose the Layers of the Blender in software and store the Frame like the Writeback Block:
+/// Each Output Pixel is the average of `scale` x `scale` Composited Pixels.
+fn simulate(cap: Capture) void {
+    debug("simulate: {} x {}", .{ cap.width, cap.height });
+    var layers_buf: [render.MAX_LAYERS]render.Layer = undefined;
+    const layers = render.getLayers(&layers_buf);
+    const bpp = bytesPerPixel(cap.format);
+
+    var y: usize = 0;
+    while (y < cap.height) : (y += 1) {
+        var x: usize = 0;
+        while (x < cap.width) : (x += 1) {
+            var sum = [3]u32 { 0, 0, 0 };
+            var sy: usize = 0;
+            while (sy < cap.scale) : (sy += 1) {
+                var sx: usize = 0;
+                while (sx < cap.scale) : (sx += 1) {
+                    const px = composite(layers, x * cap.scale + sx, y * cap.scale + sy);
+                    sum[0] += (px >> 16) & 0xFF;
+                    sum[1] += (px >> 8)  & 0xFF;
+                    sum[2] += px & 0xFF;
+                }
+            }
+            const n = cap.scale * cap.scale;
+            const r = sum[0] / n;
+            const g = sum[1] / n;
+            const b = sum[2] / n;
+
+            const out = cap.buf[((y * cap.width + x) * bpp)..];
+            switch (cap.format) {
+                .argb8888 => std.mem.writeIntLittle(u32, out[0..4], 0xFF00_0000 | r << 16 | g << 8 | b),
+                .rgb565   => std.mem.writeIntLittle(u16, out[0..2], @intCast(u16, (r >> 3) << 11 | (g >> 2) << 5 | (b >> 3))),
+            }
+        }
+    }
+}
+
+/// Return the Composited Pixel at (x, y) in XRGB 8888: Each Layer is blended over the
+/// Layers below with Coefficients 1 and 1-A[s] (BLD_CTL), starting from the Black Background (BLD_BK_COLOR)
+fn composite(layers: []const render.Layer, x: usize, y: usize) u32 {
+    var rgb = [3]u32 { 0, 0, 0 };
+    for (layers) |l| {
+        if (x < l.area.x or x >= l.area.x + l.area.w or
+            y < l.area.y or y >= l.area.y + l.area.h) { continue; }
+        const px = if (l.surface) |s|
+            s.pixels[(y - l.area.y) * s.stride + (x - l.area.x)]
+            else l.color;
+
+        // Source Alpha is the Global Alpha, mixed with the Pixel Alpha if enabled
+        var a: u32 = l.global_alpha;
+        if (l.pixel_alpha) { a = a * (px >> 24) / 255; }
+        for (rgb) |*ch, i| {
+            const src = (px >> @intCast(u5, 16 - 8 * i)) & 0xFF;
+            ch.* = (src * a + ch.* * (255 - a)) / 255;
+        }
+    }
+    return 0xFF00_0000 | rgb[0] << 16 | rgb[1] << 8 | rgb[2];
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Read and Write Registers
+
+/// Read and Write Registers (see mmio.zig)
+const getreg32 = mmio.getreg32;
+const putreg32 = mmio.putreg32;
+const modreg32 = mmio.modreg32;
+
+///////////////////////////////////////////////////////////////////////////////
+//  Imported Functions and Variables
+
+/// Invalidate the Data Cache. From NuttX nuttx/cache.h
+extern fn up_invalidate_dcache(start: usize, end: usize) void;
+
+/// Aliases for Zig Standard Library
+const assert = std.debug.assert;
+const debug  = std.log.debug;
@@ -0,0 +1,416 @@
+//***************************************************************************
+//
+// Licensed to the Apache Software Foundation (ASF) under one or more
+// contributor license agreements.  See the NOTICE file distributed with
+// this work for additional information regarding copyright ownership.  The
+// ASF licenses this file to you under the Apache License, Version 2.0 (the
+// "License"); you may not use this file except in compliance with the
+// License.  You may obtain a copy of the License at
+//
+//   http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS, WITHOUT
+// WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.  See the
+// License for the specific language governing permissions and limitations
+// under the License.
+//
+//***************************************************************************
+
+//! YUV to RGB Conversion for PinePhone Framebuffers, the Software Fallback for
+//! Camera and Video Frames that can't be shown on a Hardware Video Plane.
+//! Converts YUV420p, NV12 and YUYV (Limited Range, BT.601 or BT.709) to ARGB 8888
+//! or RGB 565, 8 pixels at a time with Fixed-Point Vector Kernels, straight into
+//! a Region of the Framebuffer. For 4:2:0 Formats, two Rows share the same Chroma,
+//! so we convert the Rows in pairs and compute the Chroma Terms once.
+//! ARGB 8888 Frames may be converted in parallel on the 4 Cortex-A53 Cores.
+
+/// Import the Zig Standard Library
+const std = @import("std");
+
+/// Import the 2D Graphics Operations Module, for the Framebuffer Surface
+const accel = @import("./accel.zig");
+
+/// Import the Parallel Rendering Module
+const parallel = @import("./parallel.zig");
+
+/// Import the Display Engine Module, for the Framebuffers
+const render = @import("./render.zig");
+
+/// Import NuttX Functions from C
+const c = @cImport({
+    // NuttX Defines
+    @cDefine("__NuttX__",  "");
+    @cDefine("NDEBUG",     "");
+    @cDefine("FAR",        "");
+
+    // NuttX Header Files
+    @cInclude("arch/types.h");
+    @cInclude("../../nuttx/include/limits.h");
+    @cInclude("nuttx/config.h");
+    @cInclude("errno.h");
+});
+
+/// Layout of the YUV Frame
+pub const Format = enum(u32) {
+    /// 3 Planes: Y, then U and V at half width and half height
+    yuv420p = 0,
+    /// 2 Planes: Y, then interleaved U and V at half width and half height
+    nv12 = 1,
+    /// 1 Plane: Y0 U Y1 V for every 2 pixels (4:2:2)
+    yuyv = 2,
+    /// Formats from C are checked by yuv_blit
+    _,
+};
+
+/// Colour Matrix of the YUV Frame: BT.601 for SD Video and Cameras, BT.709 for HD Video
+pub const Matrix = enum(u32) {
+    bt601 = 0,
+    bt709 = 1,
+};
+
+/// YUV Frame to be converted. Same layout as `struct yuv_frame_s` in C.
+pub const Frame = extern struct {
+    format: Format,            // Layout of the Frame
+    width:  u32,               // Width (pixels)
+    height: u32,               // Height (pixels)
+    planes:  [3][*c]const u8,  // Start of each Plane (unused Planes may be null)
+    strides: [3]u32,           // Bytes per Row of each Plane
+};
+
+/// RGB 565 Framebuffer
+pub const Surface565 = struct {
+    pixels: [*]u16,  // Start of Framebuffer Memory
+    stride: usize,   // Pixels per Row
+    width:  usize,   // Horizontal resolution in pixel columns
+    height: usize,   // Vertical resolution in pixel rows
+};
+
+/// Fixed-Point Coefficients (scaled by 256) for Limited Range YUV (Y 16 to 235, U and V 16 to 240):
+///   R = Y' + rv * V
+///   G = Y' - gu * U - gv * V
+///   B = Y' + bu * U
+/// where Y' = y * (Y - 16), and U and V are centred on 128
+const Coeffs = struct {
+    y:  i32,
+    rv: i32,
+    gu: i32,
+    gv: i32,
+    bu: i32,
+};
+
+/// Return the Coefficients for the Colour Matrix
+fn coeffs(matrix: Matrix) Coeffs {
+    return switch (matrix) {
+        // 1.164, 1.596, 0.391, 0.813, 2.018
+        .bt601 => .{ .y = 298, .rv = 409, .gu = 100, .gv = 208, .bu = 516 },
+        // 1.164, 1.793, 0.213, 0.533, 2.112
+        .bt709 => .{ .y = 298, .rv = 459, .gu = 55,  .gv = 136, .bu = 541 },
+    };
+}
+
+/// Convert the YUV Frame to ARGB 8888 (Opaque), with the Top Left at (x, y) of the Framebuffer.
+/// If `threaded`, the Rows are converted in parallel on the 4 Cortex-A53 Cores.
+/// The converted Rows are flushed from the Data Cache.
+pub fn toArgb(
+    dest: accel.Surface,  // Framebuffer to be written
+    x: usize,             // Column of the Top Left Corner
+    y: usize,             // Row of the Top Left Corner
+    frame: Frame,         // YUV Frame
+    matrix: Matrix,       // Colour Matrix of the Frame
+    threaded: bool        // Convert in parallel
+) void {
+    debug("toArgb: {s} {} x {} at ({}, {})", .{ @tagName(frame.format), frame.width, frame.height, x, y });
+    assert(accel.contains(dest, .{ .x = x, .y = y, .w = frame.width, .h = frame.height }));
+    const region = dest.pixels[(y * dest.stride)..((y + frame.height) * dest.stride)];
+    if (threaded) {
+        // Thread Pool renders full-width Rows, we convert the Frame into the Region of each Row.
+        // `job` is shared, so it belongs to one Caller until the Thread Pool is done.
+        job_lock.lock();
+        defer job_lock.unlock();
+        job = .{ .frame = frame, .coeffs = coeffs(matrix), .x = x };
+        parallel.renderRows(region, dest.stride, frame.height, convertJobRow);
+        return;
+    }
+    convertFrame(u32, dest.pixels + y * dest.stride + x, dest.stride, frame, coeffs(matrix));
+    parallel.flushBand(region);
+}
+
+/// Convert the YUV Frame to RGB 565, with the Top Left at (x, y) of the Framebuffer
+pub fn toRgb565(
+    dest: Surface565,  // Framebuffer to be written
+    x: usize,          // Column of the Top Left Corner
+    y: usize,          // Row of the Top Left Corner
+    frame: Frame,      // YUV Frame
+    matrix: Matrix     // Colour Matrix of the Frame
+) void {
+    debug("toRgb565: {s} {} x {} at ({}, {})", .{ @tagName(frame.format), frame.width, frame.height, x, y });
+    assert(x + frame.width <= dest.width and y + frame.height <= dest.height);
+    convertFrame(u16, dest.pixels + y * dest.stride + x, dest.stride, frame, coeffs(matrix));
+}
+
+/// Conversion for the Thread Pool, which calls a Row Function without Context
+var job: struct {
+    frame: Frame,
+    coeffs: Coeffs,
+    x: usize,
+} = undefined;
+
+/// Held while a Thread owns `job`
+var job_lock: parallel.SpinLock = .{};
+
+/// Convert Row `y` of the Frame in `job`. Called by the Thread Pool, which may split
+/// a pair of Rows across Bands, so the Rows are converted one at a time.
+fn convertJobRow(row: []u32, y: usize) void {
+    const out = row[job.x..(job.x + job.frame.width)];
+    convertRows(u32, out, null, source(job.frame, y), null, job.coeffs);
+}
+
+/// Convert every Row of the Frame to Pixels at `dest`. Rows that share their Chroma are converted in pairs.
+fn convertFrame(comptime Pixel: type, dest: [*]Pixel, stride: usize, frame: Frame, k: Coeffs) void {
+    const w = frame.width;
+    const pairs = frame.format != .yuyv;
+    var y: usize = 0;
+    while (y < frame.height) {
+        const out0 = dest[(y * stride)..(y * stride + w)];
+        if (pairs and y + 1 < frame.height) {
+            const out1 = dest[((y + 1) * stride)..((y + 1) * stride + w)];
+            convertRows(Pixel, out0, out1, source(frame, y), source(frame, y + 1), k);
+            y += 2;
+        } else {
+            convertRows(Pixel, out0, null, source(frame, y), null, k);
+            y += 1;
+        }
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Vector Kernels
+
+/// Number of pixels converted at a time
+const LANES = 8;
+
+/// Vector of Samples or Channels
+const Lanes = @Vector(LANES, i32);
+
+/// Samples of a Row in the Frame: Y of pixel i is at y[i * y_step],
+/// U and V of pixels 2j and 2j + 1 are at u[j * c_step] and v[j * c_step]
+const Source = struct {
+    y: [*]const u8,
+    u: [*]const u8,
+    v: [*]const u8,
+    y_step: usize,
+    c_step: usize,
+};
+
+/// Return the number of Bytes read from each Row of Plane `plane`, for a Frame of `width` pixels.
+/// Chroma is shared by pairs of pixels, so an odd Width reads the Chroma of a whole pair.
+fn rowBytes(format: Format, plane: usize, width: usize) usize {
+    const pairs = (width + 1) / 2;
+    return switch (format) {
+        .yuv420p => if (plane == 0) width else pairs,
+        .nv12    => if (plane == 0) width else pairs * 2,
+        .yuyv    => pairs * 4,
+        _ => unreachable,
+    };
+}
+
+/// Return the Samples of Row `y` of the Frame
+fn source(frame: Frame, y: usize) Source {
+    const p = frame.planes;
+    const s = frame.strides;
+    return switch (frame.format) {
+        .yuv420p => .{
+            .y = p[0] + y * s[0],
+            .u = p[1] + (y / 2) * s[1],
+            .v = p[2] + (y / 2) * s[2],
+            .y_step = 1, .c_step = 1,
+        },
+        .nv12 => .{
+            .y = p[0] + y * s[0],
+            .u = p[1] + (y / 2) * s[1],
+            .v = p[1] + (y / 2) * s[1] + 1,
+            .y_step = 1, .c_step = 2,
+        },
+        .yuyv => .{
+            .y = p[0] + y * s[0],
+            .u = p[0] + y * s[0] + 1,
+            .v = p[0] + y * s[0] + 3,
+            .y_step = 2, .c_step = 4,
+        },
+        _ => unreachable,
+    };
+}
+
+/// Chroma Terms of 8 pixels, shared by the Rows of a pair
+const Chroma = struct {
+    r: Lanes,  // rv * V
+    g: Lanes,  // gu * U + gv * V
+    b: Lanes,  // bu * U
+};
+
+/// Convert the Rows `src0` and `src1` (which share their Chroma) to `out0` and `out1`.
+/// If `out1` is null, only `src0` is converted.
+fn convertRows(
+    comptime Pixel: type,  // u32 for ARGB 8888, u16 for RGB 565
+    out0: []Pixel,
+    out1: ?[]Pixel,
+    src0: Source,
+    src1: ?Source,
+    k: Coeffs
+) void {
+    var x: usize = 0;
+    while (x < out0.len) : (x += LANES) {
+        const n = std.math.min(LANES, out0.len - x);
+        const chroma = loadChroma(src0, x, n, k);
+        store(Pixel, out0[x..(x + n)], toRgb(loadY(src0, x, n), chroma, k));
+        if (out1) |o| {
+            store(Pixel, o[x..(x + n)], toRgb(loadY(src1.?, x, n), chroma, k));
+        }
+    }
+}
+
+/// Load the Y Samples of pixels x to x + n - 1 (n <= LANES)
+fn loadY(src: Source, x: usize, n: usize) Lanes {
+    var y = [_]i32 { 16 } ** LANES;
+    var i: usize = 0;
+    while (i < n) : (i += 1) {
+        y[i] = src.y[(x + i) * src.y_step];
+    }
+    return y;
+}
+
+/// Load the U and V Samples of pixels x to x + n - 1 (n <= LANES) and compute the Chroma Terms.
+/// x is even, so each U and V is shared by 2 adjacent pixels.
+fn loadChroma(src: Source, x: usize, n: usize, k: Coeffs) Chroma {
+    var u = [_]i32 { 0 } ** LANES;
+    var v = [_]i32 { 0 } ** LANES;
+    var i: usize = 0;
+    while (i < n) : (i += 1) {
+        const j = (x + i) / 2 * src.c_step;
+        u[i] = @as(i32, src.u[j]) - 128;
+        v[i] = @as(i32, src.v[j]) - 128;
+    }
+    const uv: Lanes = u;
+    const vv: Lanes = v;
+    return .{
+        .r = vv * @splat(LANES, k.rv),
+        .g = uv * @splat(LANES, k.gu) + vv * @splat(LANES, k.gv),
+        .b = uv * @splat(LANES, k.bu),
+    };
+}
+
+/// Red, Green and Blue of 8 pixels (0 to 255)
+const Rgb = struct {
+    r: Lanes,
+    g: Lanes,
+    b: Lanes,
+};
+
+/// Combine the Luma and Chroma Terms into Red, Green and Blue, rounded and clamped to 0 to 255
+fn toRgb(y: Lanes, chroma: Chroma, k: Coeffs) Rgb {
+    const luma = (y - @splat(LANES, @as(i32, 16))) * @splat(LANES, k.y) + @splat(LANES, @as(i32, 128));
+    return .{
+        .r = clamp(luma + chroma.r),
+        .g = clamp(luma - chroma.g),
+        .b = clamp(luma + chroma.b),
+    };
+}
+
+/// Scale down by 256 and clamp to 0 to 255
+fn clamp(v: Lanes) Lanes {
+    const zero = @splat(LANES, @as(i32, 0));
+    const max  = @splat(LANES, @as(i32, 255));
+    const s = v >> @splat(LANES, @as(u5, 8));
+    const lo = @select(i32, s < zero, zero, s);
+    return @select(i32, lo > max, max, lo);
+}
+
+/// Pack the pixels as ARGB 8888 (Opaque) or RGB 565, and store the first `out.len` pixels
+fn store(comptime Pixel: type, out: []Pixel, rgb: Rgb) void {
+    const r = @bitCast(@Vector(LANES, u32), rgb.r);
+    const g = @bitCast(@Vector(LANES, u32), rgb.g);
+    const b = @bitCast(@Vector(LANES, u32), rgb.b);
+    const packed_px: [LANES]u32 = switch (Pixel) {
+        u32 => @splat(LANES, @as(u32, 0xFF00_0000))
+            | r << @splat(LANES, @as(u5, 16))
+            | g << @splat(LANES, @as(u5, 8))
+            | b,
+        u16 => (r >> @splat(LANES, @as(u5, 3))) << @splat(LANES, @as(u5, 11))
+            | (g >> @splat(LANES, @as(u5, 2))) << @splat(LANES, @as(u5, 5))
+            | (b >> @splat(LANES, @as(u5, 3))),
+        else => @compileError("Pixel must be u32 or u16"),
+    };
+    if (Pixel == u32 and out.len == LANES) {
+        out[0..LANES].* = packed_px;
+        return;
+    }
+    for (out) |*p, i| { p.* = @truncate(Pixel, packed_px[i]); }
+}
+
+comptime {
+    // Coefficients are 256 times the BT.601 and BT.709 Matrices for Limited Range
+    assert(coeffs(.bt601).rv == 409 and coeffs(.bt709).bu == 541);
+
+    // Black (Y = 16) and White (Y = 235) with no Chroma
+    const none = Chroma { .r = @splat(LANES, @as(i32, 0)), .g = @splat(LANES, @as(i32, 0)), .b = @splat(LANES, @as(i32, 0)) };
+    assert(toRgb(@splat(LANES, @as(i32, 16)),  none, coeffs(.bt601)).g[0] == 0);
+    assert(toRgb(@splat(LANES, @as(i32, 235)), none, coeffs(.bt601)).g[0] == 255);
+
+    // Minimum Strides of a Frame 5 pixels wide
+    assert(rowBytes(.yuv420p, 0, 5) == 5 and rowBytes(.yuv420p, 2, 5) == 3);
+    assert(rowBytes(.nv12, 1, 5) == 6 and rowBytes(.yuyv, 0, 5) == 12);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+//  Exported Functions
+
+/// Convert the YUV Frame to ARGB 8888 in the Framebuffer of Layer `plane` (0 for the
+/// Base UI Channel, 1 and 2 for the Overlays), with the Top Left at (x, y).
+/// `matrix` is 0 for BT.601 or 1 for BT.709. If `threaded` is non-zero, the Rows are
+/// converted on the 4 Cortex-A53 Cores.
+/// Returns 0 if OK, or -EINVAL if the Frame is invalid (like a Stride shorter than a Row)
+/// or doesn't fit in the Framebuffer.
+pub export fn yuv_blit(
+    plane: c_int,              // Layer: 0, 1 or 2
+    frame: [*c]const Frame,    // YUV Frame
+    x: c_int,                  // Column of the Top Left Corner
+    y: c_int,                  // Row of the Top Left Corner
+    matrix: c_int,             // 0 for BT.601, 1 for BT.709
+    threaded: c_int            // Non-zero to convert in parallel
+) c_int {
+    debug("yuv_blit: plane={}, x={}, y={}, matrix={}", .{ plane, x, y, matrix });
+    if (frame == null or plane < 0 or plane >= render.MAX_LAYERS or x < 0 or y < 0) { return -c.EINVAL; }
+    const f = frame.*;
+    if (matrix < 0 or matrix > 1) { return -c.EINVAL; }
+
+    // Every Plane of the Format must be present
+    const num_planes: usize = switch (f.format) {
+        .yuv420p => 3,
+        .nv12    => 2,
+        .yuyv    => 1,
+        _ => return -c.EINVAL,
+    };
+    // Every Row must fit in the Stride of its Plane
+    for (f.planes[0..num_planes]) |p, i| {
+        if (p == null) { return -c.EINVAL; }
+        if (f.strides[i] < rowBytes(f.format, i, f.width)) { return -c.EINVAL; }
+    }
+
+    const fb = render.getFramebuffers()[@intCast(usize, plane)];
+    const dest = accel.Surface {
+        .pixels = @ptrCast([*]u32, fb.mem.ptr),
+        .stride = fb.stride / 4,
+        .width  = fb.width,
+        .height = fb.height,
+    };
+    const area = accel.Rect { .x = @intCast(usize, x), .y = @intCast(usize, y), .w = f.width, .h = f.height };
+    if (f.width == 0 or f.height == 0 or !accel.contains(dest, area)) { return -c.EINVAL; }
+
+    toArgb(dest, area.x, area.y, f, @intToEnum(Matrix, matrix), threaded != 0);
+    return c.OK;
+}
+
+/// Aliases for Zig Standard Library
+const assert = std.debug.assert;
+const debug  = std.log.debug;